@@ -0,0 +1,135 @@
+/**
+ * @file distributed.h
+ * @brief Multi-process N-body backend with a spatial domain per worker process
+ *
+ * start() launches worker processes and splits the bodies between them by orthogonal
+ * recursive bisection (ORB): the body set is cut at the weighted median of its longest
+ * axis until there is one domain per worker. The calling process (rank 0) only
+ * coordinates and owns no bodies.
+ *
+ * Every step each worker builds an octree over its own bodies and sends every other
+ * worker the part of it that peer needs: cells that are far enough from the peer's domain
+ * (size < openingAngle * distance) go out as a point mass at their centre of mass, the
+ * bodies of nearer leaves go out as ghosts. Own bodies interact exactly with each other,
+ * with the received ghosts and with the received cells. An opening angle of 0 sends every
+ * body as a ghost and reproduces the Euler path of Physics.
+ *
+ * The workers send their updated bodies back to rank 0 after every step, which writes them
+ * into the Body objects for rendering. If the interaction count of the busiest worker
+ * exceeds the mean by REBALANCE_THRESHOLD, rank 0 repartitions (at most every
+ * REBALANCE_INTERVAL steps) with the measured cost per body as the weight and sends every
+ * worker its new domain.
+ *
+ * Gravity and the ground bounce match the Euler path of Physics; sphere contacts are not
+ * handled here. Light sources stay in rank 0 and neither move nor attract, as in Physics.
+ * All communication goes through Transport; the built-in one connects processes of one
+ * machine over Unix domain sockets. The workers are new instances of the running executable:
+ * start() forks and execs it with WORKER_FLAG, and main() hands that command line to
+ * runWorker() before it creates anything else, so no worker inherits the OpenGL context or
+ * the threads of the calling process.
+ */
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Physics/transport.h"
+#include "body.h"
+
+/**
+ * @brief Load and communication of the last distributed step
+ */
+struct DistributedStats {
+    unsigned int workers = 0;    ///< Worker processes
+    unsigned int ghosts = 0;     ///< Remote bodies received as ghosts, summed over the workers
+    unsigned int cells = 0;      ///< Remote octree cells received as point masses, summed over the workers
+    float imbalance = 1.0f;      ///< Interactions of the busiest worker / mean interactions
+    unsigned int rebalances = 0; ///< Repartitions since start()
+    double seconds = 0.0;        ///< Wall time of the step, gathering the bodies included
+};
+
+class DistributedPhysics {
+public:
+    /** @brief Repartition when the busiest worker has this many times the mean interactions */
+    static constexpr float REBALANCE_THRESHOLD = 1.1f;
+
+    /** @brief Steps between two repartitions at least */
+    static constexpr unsigned int REBALANCE_INTERVAL = 10;
+
+    /** @brief First argument of the command line start() runs the worker processes with */
+    static constexpr const char *WORKER_FLAG = "--distributed-worker";
+
+    /**
+     * @brief Body of a worker process, for main() to call when argv[1] is WORKER_FLAG
+     *
+     * Serves its domain until rank 0 stops it or goes away.
+     *
+     * @return Exit code of the worker process
+     */
+    static int runWorker(int argc, char *argv[]);
+
+    DistributedPhysics() = default;
+    DistributedPhysics(const DistributedPhysics &) = delete;
+    DistributedPhysics &operator=(const DistributedPhysics &) = delete;
+    ~DistributedPhysics() { stop(); }
+
+    /**
+     * @brief Start @p workers worker processes and hand out the initial domains
+     *
+     * The workers run this executable again with WORKER_FLAG (see runWorker()). The order
+     * of @p bodies defines the body index used by push() and processFrame().
+     *
+     * @param bodies All bodies of the simulation (light sources included)
+     * @param workers Number of worker processes (at least 1)
+     * @param openingAngle Cell size / distance below which a remote cell is sent as a point mass
+     * @return false if the processes couldn't be started
+     */
+    bool start(const std::vector<Body *> &bodies, unsigned int workers, float openingAngle = 0.5f);
+
+    /**
+     * @brief Advance the simulation by one fixed timestep (global dt) on the workers
+     *
+     * Blocks until every worker has sent its bodies back into @p bodies, then
+     * repartitions if the load is out of balance.
+     *
+     * @param bodies The vector passed to start()
+     */
+    void processFrame(std::vector<Body *> &bodies);
+
+    /**
+     * @brief Queue an instantaneous velocity change for a body, applied on the next step
+     *
+     * @param bodyIndex Index of the body in the vector passed to start()
+     * @param impulse Velocity change
+     */
+    void push(unsigned int bodyIndex, glm::vec3 impulse);
+
+    /** @brief Communication and load of the last step */
+    const DistributedStats &getStats() const { return stats; }
+
+    bool isRunning() const { return transport != nullptr; }
+
+    /** @brief Stop the worker processes and wait for them to exit */
+    void stop();
+
+private:
+    std::unique_ptr<Transport> transport;
+    std::vector<int> processes; ///< Worker process ids
+    std::vector<unsigned int> owner; ///< Per body: worker rank, 0 for light sources
+    std::vector<float> cost; ///< Per body: interactions of its worker / bodies of its worker
+    std::vector<std::pair<unsigned int, glm::vec3>> impulses; ///< Body index and velocity change, queued since the last step
+    unsigned int stepsSinceRebalance = 0;
+    DistributedStats stats;
+
+    // 按加权中位数递归二分，给每个物体分配一个 worker
+    void partition(const std::vector<Body *> &bodies);
+
+    // 把每个 worker 的物体发给它
+    bool scatter(const std::vector<Body *> &bodies);
+};
+
+#endif
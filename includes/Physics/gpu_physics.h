@@ -0,0 +1,107 @@
+/**
+ * @file gpu_physics.h
+ * @brief Optional compute-shader backend for the N-body simulation
+ *
+ * Keeps the state of all bodies in shader storage buffers and advances it entirely on the
+ * GPU: one dispatch evaluates all-pairs gravity and sphere contacts in shared-memory tiles,
+ * a second one integrates the bodies in place and appends their positions to a trace ring
+ * buffer. The Renderer reads the body and trace buffers directly as vertex data, so body
+ * state never travels back to the CPU during the simulation.
+ *
+ * Buffer bindings (see shaders/cNBody.glsl):
+ * - 0: bodies   (GpuBody: position.xyz + mass, velocity.xyz + radius)
+ * - 1: deltas   (per-body acceleration, contact velocity change and position correction)
+ * - 2: impulses (pending Physics::push() style impulses, applied on the next step)
+ * - 3: trace    (vec4 positions, ring buffer of TRACE_CAPACITY entries)
+ */
+
+#ifndef GPU_PHYSICS_H
+#define GPU_PHYSICS_H
+
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <learnopengl/gl_resources.h>
+
+#include "Renderer/shader.h"
+#include "body.h"
+
+/**
+ * @brief Per-body layout of the body storage buffer (std430, 32 bytes)
+ *
+ * A negative radius marks a light source: it neither attracts other bodies nor moves,
+ * matching the CPU path which skips bodies with mesh.source set.
+ */
+struct GpuBody {
+    glm::vec4 position; ///< xyz: position, w: mass
+    glm::vec4 velocity; ///< xyz: velocity, w: radius (negative for light sources)
+};
+
+class GpuPhysics {
+public:
+    /** @brief Work group size of cNBody.glsl, bodies are processed in tiles of this size */
+    static constexpr unsigned int TILE_SIZE = 64;
+
+    /** @brief Number of vec4 entries in the trace ring buffer */
+    static constexpr unsigned int TRACE_CAPACITY = 4000000;
+
+    /**
+     * @brief Compile the N-body compute shader and upload the initial body state
+     *
+     * Requires a current OpenGL 4.3+ context. The order of @p bodies defines the body
+     * index used by push(), the Renderer and the trace buffer.
+     *
+     * @param bodies All bodies of the simulation (light sources included)
+     */
+    void init(const std::vector<Body *> &bodies);
+
+    /**
+     * @brief Advance the simulation by one fixed timestep (global dt) on the GPU
+     *
+     * Issues two dispatches separated by storage barriers; nothing is read back.
+     */
+    void processFrame();
+
+    /**
+     * @brief Queue an instantaneous velocity change for a body, applied on the next step
+     *
+     * @param bodyIndex Index of the body in the vector passed to init()
+     * @param impulse Velocity change
+     */
+    void push(unsigned int bodyIndex, glm::vec3 impulse);
+
+    /**
+     * @brief Copy the device state back into the Body objects
+     *
+     * Explicit round trip for debugging and benchmarks; not needed for rendering.
+     */
+    void readBack(std::vector<Body *> &bodies);
+
+    /** @brief Storage buffer holding one GpuBody per body */
+    const GLBuffer &getBodyBuffer() const { return bodyBuffer; }
+
+    /** @brief Storage buffer holding the trace ring (vec4 positions) */
+    const GLBuffer &getTraceBuffer() const { return traceBuffer; }
+
+    /** @brief Number of valid entries in the trace buffer */
+    unsigned int getTraceCount() const;
+
+    unsigned int getBodyCount() const { return bodyCount; }
+
+    /** @brief Release buffers and the compute program */
+    void cleanup();
+
+private:
+    Shader computeShader;
+    GLBuffer bodyBuffer;
+    GLBuffer deltaBuffer;
+    GLBuffer impulseBuffer; ///< the only buffer written from the CPU (dynamic storage)
+    GLBuffer traceBuffer;
+    unsigned int bodyCount = 0;
+    unsigned int stepCount = 0;
+
+    std::vector<glm::vec4> pendingImpulses; ///< impulses queued since the last step
+    bool hasImpulses = false;
+};
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file out_of_core.h
+ * @brief Out-of-core N-body backend for body counts whose state and trace don't fit in RAM
+ *
+ * The body state lives in a memory-mapped file of tiles. Every tile holds TILE_SIZE bodies
+ * as separate arrays (SoA): position x/y/z and mass, then velocity x/y/z and radius, so the
+ * data a force evaluation reads from a tile is one contiguous range. The trace history is a
+ * second mapped file, a ring of positions with one slot per body and step.
+ *
+ * Gravity is evaluated block by block: a block of target tiles sized by the memory budget
+ * stays resident while all source tiles stream past it, and the next source tile is
+ * prefetched (madvise(MADV_WILLNEED) plus an asynchronous read of its pages) while the
+ * current tile pair is computed. The physics follow the Euler path of Physics (gravity skipped
+ * below a distance of 1, ground bounce at y = -2, light sources left out); sphere contacts are
+ * not handled here.
+ *
+ * Without a directory the same code runs on anonymous memory. The app runs this backend with
+ * --out-of-core <directory>; --benchmark-out-of-core compares it with Physics.
+ */
+
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include <cstddef>
+#include <future>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include <learnopengl/mapped_file.h> // state and trace files
+
+#include "body.h"
+
+class OutOfCorePhysics {
+public:
+    /** @brief Bodies per tile */
+    static constexpr unsigned int TILE_SIZE = 4096;
+
+    /** @brief Bytes per tile in the state file (8 floats per body) */
+    static constexpr size_t TILE_BYTES = 8 * TILE_SIZE * sizeof(float);
+
+    /**
+     * @brief Create the state and trace files
+     *
+     * @param directory Directory for state.bin and trace.bin, empty to keep everything in memory
+     * @param bodyCount Number of bodies
+     * @param traceSteps Steps kept in the trace ring (0 = no trace)
+     * @param memoryBudget Bytes of target tiles kept resident per block (at least one tile)
+     * @return false if a file couldn't be created
+     */
+    bool create(const std::string &directory, unsigned int bodyCount, unsigned int traceSteps, size_t memoryBudget);
+
+    /**
+     * @brief create() for the bodies of a scene and copy their state in
+     *
+     * Light sources are left out, as in Physics. The order of @p bodies defines the body
+     * index used by push() and processFrame(bodies).
+     *
+     * @param directory Directory for state.bin and trace.bin, empty to keep everything in memory
+     * @param bodies All bodies of the simulation (light sources included)
+     * @param traceSteps Steps kept in the trace ring (0 = no trace)
+     * @param memoryBudget Bytes of target tiles kept resident per block
+     * @return false if a file couldn't be created
+     */
+    bool start(const std::string &directory, const std::vector<Body *> &bodies, unsigned int traceSteps, size_t memoryBudget);
+
+    /** @brief Set the initial state of one body */
+    void setBody(unsigned int index, const glm::vec3 &position, const glm::vec3 &velocity, float mass, float radius);
+
+    glm::vec3 getPosition(unsigned int index) const;
+    glm::vec3 getVelocity(unsigned int index) const;
+
+    /**
+     * @brief Advance all bodies by one timestep (global dt)
+     *
+     * Pass 1 applies gravity to the velocities, target block by target block; pass 2
+     * streams the tiles once more to move the bodies and append them to the trace.
+     */
+    void processFrame();
+
+    /**
+     * @brief processFrame(), then copy the new positions and velocities into @p bodies
+     *
+     * @param bodies The vector passed to start()
+     */
+    void processFrame(std::vector<Body *> &bodies);
+
+    /**
+     * @brief Instantaneous velocity change of a body (see Physics::push)
+     *
+     * @param bodyIndex Index of the body in the vector passed to start()
+     * @param impulse Velocity change
+     */
+    void push(unsigned int bodyIndex, glm::vec3 impulse);
+
+    /** @brief Whether start() succeeded and close() hasn't been called since */
+    bool isRunning() const { return running; }
+
+    /** @brief Drop the state and trace pages from the page cache after every step */
+    void setColdCache(bool cold) { coldCache = cold; }
+
+    unsigned int getBodyCount() const { return bodyCount; }
+    unsigned int getStepCount() const { return stepCount; }
+
+    /** @brief Size of the state file in bytes */
+    size_t getStateSize() const { return state.size(); }
+
+    /** @brief Size of the trace file in bytes */
+    size_t getTraceSize() const { return trace.size(); }
+
+    /** @brief Unmap both files */
+    void close();
+
+private:
+    // arrays of one tile, in file order
+    enum Array { PX, PY, PZ, MASS, VX, VY, VZ, RADIUS, ARRAY_COUNT };
+    static_assert(TILE_BYTES == ARRAY_COUNT * TILE_SIZE * sizeof(float), "tile layout and TILE_BYTES disagree");
+
+    MappedFile state;
+    MappedFile trace;
+    unsigned int bodyCount = 0;
+    unsigned int tileCount = 0;
+    unsigned int blockTiles = 1; ///< Target tiles per block
+    unsigned int traceSteps = 0;
+    unsigned int stepCount = 0;
+    bool coldCache = false;
+    bool running = false;
+    std::vector<int> slots; ///< Body index of start() -> state index, -1 for light sources
+
+    float *array(unsigned int tile, Array which) const;
+    unsigned int tileBodies(unsigned int tile) const;
+
+    // read every page of a source tile's positions and masses on a worker thread
+    std::future<void> prefetch(unsigned int tile) const;
+
+    // add the gravity of source tile `source` to the velocities of target tile `target`
+    void interact(unsigned int target, unsigned int source) const;
+};
+
+#endif
@@ -4,18 +4,40 @@
 
 #include <iostream>
 #include <future>
+#include <vector>
+#include <cstdint>
 #include <glm/vec3.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/epsilon.hpp>
 #include "body.h"
+#include "settings.h"
+#include "Physics/worker_pool.h"
 
 
 //牛顿引力常数等常用参数
-inline float dt;
+inline float dt = 1.0f / 60.0f; ///< Fixed timestep of the app loop and of the engines that aren't given one
 inline constexpr double GRAV_CONST = 6.67430e-11;
 inline const glm::vec3 GRAV_FORCE = glm::vec3(0.0f, 0.0f, 0.0f);
 inline constexpr double EPSILON = 1e-3;
 
+/**
+ * @brief Time integration scheme of the CPU engine
+ */
+enum class Integrator {
+    Euler,      ///< Semi-implicit Euler, gravity ignored below a distance of 1 (original model)
+    Verlet,     ///< Drift-kick-drift leapfrog with exact gravity
+    Regularized ///< Logarithmic Hamiltonian leapfrog: fixed steps in a regularized time, see setIntegrator()
+};
+
+/**
+ * @brief Timing and size of the last contact resolution stage
+ */
+struct ContactStats {
+    unsigned int contacts = 0; ///< Touching body pairs found in the step
+    unsigned int batches = 0;  ///< Independent batches (graph colors) they were split into
+    double seconds = 0.0;      ///< Wall time of detection, coloring and resolution
+};
+
 class Physics {
 public:
     /**
@@ -41,6 +63,8 @@ public:
      * Allows full control over both temporal accuracy and simulation speed.
      * Smaller timesteps improve accuracy but increase computational cost.
      *
+     * The other constructors step by the global dt, this one leaves it alone.
+     *
      * @param timeStep Physics update interval in seconds (e.g., 1/120 = 120 FPS physics)
      * @param speed Simulation speed multiplier applied to velocity calculations
      */
@@ -60,6 +84,7 @@ public:
      * 3. Exponential velocity damping: v *= e^(-λ*dt) (simulates drag/friction)
      * 4. Exponential acceleration damping: a *= e^(-λ*dt) (force decay)
      * 5. Boundary checking: terminate simulation if body crosses threshold
+     * 6. Sphere contacts, resolved for all bodies at once (see setContactSolver())
      *
      * Uses Euler integration for simplicity. Future versions may implement
      * RK4 or Verlet integration for improved numerical stability.
@@ -68,6 +93,46 @@ public:
      */
     void processFrame(std::vector<Body *> bodies);
 
+    /**
+     * @brief Configure the contact resolution stage of processFrame().
+     *
+     * Contacts are resolved after all bodies are integrated: the touching pairs are
+     * colored so that no two pairs of one color share a body, then every color batch
+     * is resolved in parallel on threads kept for the lifetime of the engine. The first iteration exchanges velocities (processCollision),
+     * further iterations only push still overlapping bodies apart.
+     *
+     * @param workers Threads per batch, 0 = std::thread::hardware_concurrency()
+     * @param iterations Solver iterations per step (at least 1)
+     */
+    void setContactSolver(unsigned int workers, unsigned int iterations);
+
+    /**
+     * @brief Select the integration scheme used by processFrame().
+     *
+     * Integrator::Regularized is the logarithmic Hamiltonian (algorithmic regularization)
+     * leapfrog of Mikkola & Tanikawa / Preto & Tremaine: every substep advances the time
+     * by h / (T + B) during drifts and h / -U during kicks (T kinetic, U potential energy,
+     * B = -(T + U)), so the physical step shrinks with the separation during close
+     * encounters and a two-body orbit is followed exactly up to a phase error.
+     * processFrame() runs substeps of h = (dt / substeps) * -U until the timestep has
+     * passed; an overshoot is carried into the next frame.
+     *
+     * @param scheme Integration scheme
+     * @param substeps Regularized substeps per frame for a system without close encounters
+     */
+    void setIntegrator(Integrator scheme, unsigned int substeps = 4);
+
+    Integrator getIntegrator() const { return integrator; }
+
+    /** @brief Physical time simulated so far */
+    double getSimulationTime() const { return simulationTime; }
+
+    /** @brief Number of gravity evaluations (all pairs once) so far */
+    unsigned long long getForceEvaluations() const { return forceEvaluations; }
+
+    /** @brief Contact count, batch count and time of the last step */
+    const ContactStats &getContactStats() const { return contactStats; }
+
     /**
      * @brief Check if the simulation should terminate.
      *
@@ -90,6 +155,53 @@ private:
     // Simulation parameters
     float Speed; ///< Global speed multiplier for all motion
     bool endSim; ///< Flag to terminate simulation when boundary reached
+    float timeStep; ///< Time processFrame() advances, see the constructors
+
+    // Integration
+    Integrator integrator = Integrator::Euler;
+    unsigned int regularizedSubsteps = 4; ///< Substeps per frame far from close encounters
+    double simulationTime = 0.0; ///< Physical time reached by the integrator
+    double targetTime = 0.0; ///< Time the frames so far asked for (regularized overshoot = simulationTime - targetTime)
+    unsigned long long forceEvaluations = 0;
+
+    // 精确引力加速度（无最小距离截断），写入 Acceleration，返回势能 U
+    double calculateAccelerations(std::vector<Body *> &bodies);
+
+    // 动能 T
+    double kineticEnergy(std::vector<Body *> &bodies);
+
+    // 蛙跳积分（漂移-冲量-漂移）
+    void stepVerlet(std::vector<Body *> &bodies);
+
+    // 对数哈密顿量正则化蛙跳积分，返回本帧的子步数
+    unsigned int stepRegularized(std::vector<Body *> &bodies);
+
+    // Contact resolution stage
+    struct Contact {
+        unsigned int one; ///< Later body of the pair (first argument of processCollision)
+        unsigned int two; ///< Earlier body of the pair
+    };
+
+    unsigned int workerCount = 1; ///< Threads per contact batch
+    WorkerPool pool; ///< workerCount - 1 threads, created by setContactSolver()
+    unsigned int solverIterations = CONTACT_ITERATIONS;
+    std::vector<unsigned int> bodyCell; ///< Per body: hash grid bucket
+    std::vector<unsigned int> cellStart; ///< Bucket b holds cellBodies[cellStart[b], cellStart[b + 1])
+    std::vector<unsigned int> cellBodies; ///< Body indices grouped by bucket
+    std::vector<std::vector<Contact>> touching; ///< Per body: contacts with later bodies
+    std::vector<Contact> contacts; ///< Contacts of the step, grouped by batch
+    std::vector<unsigned int> batchOffsets; ///< Batch b is contacts[batchOffsets[b], batchOffsets[b + 1])
+    std::vector<uint64_t> usedColors; ///< Per body: colors already taken by its contacts
+    ContactStats contactStats;
+
+    // 找出所有接触的物体对
+    void findContacts(std::vector<Body *> &bodies);
+
+    // 贪心着色：同一颜色（批次）内的接触不共享物体；最后一批需串行处理时返回 true
+    bool colorContacts(size_t bodyCount);
+
+    // 按批次并行处理接触
+    void resolveContacts(std::vector<Body *> &bodies);
 
     // 判断向量是否接近零向量
     bool isZero(glm::vec3 &vector);
@@ -118,6 +230,9 @@ private:
     // 处理两物体弹性碰撞
     void processCollision(Body &sphereOne, Body &sphereTwo);
 
+    // 将重叠的两物体各推开一半重叠距离
+    void separate(Body &sphereOne, Body &sphereTwo);
+
     /**
      * @brief Calculate Euclidean distance between centers of two bodies.
      *
@@ -0,0 +1,80 @@
+/**
+ * @file transport.h
+ * @brief Message transport between the processes of the distributed simulation
+ *
+ * Ranks are numbered 0 .. size() - 1 and every rank can reach every other one. Messages
+ * are opaque byte vectors and arrive in the order they were sent to a peer.
+ * DistributedPhysics only talks to this interface, so a cluster transport (MPI, TCP)
+ * can replace SocketTransport without touching the simulation.
+ */
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <cstddef>
+#include <vector>
+
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual unsigned int rank() const = 0;
+    virtual unsigned int size() const = 0;
+
+    /** @brief Send one message to @p peer, blocks until the transport took all of it */
+    virtual bool send(unsigned int peer, const std::vector<char> &message) = 0;
+
+    /** @brief Receive the next message from @p peer */
+    virtual bool receive(unsigned int peer, std::vector<char> &message) = 0;
+
+    /**
+     * @brief Send outgoing[i] to peers[i] and receive one message from each of them
+     *
+     * All peers call this at the same time with each other in their lists. Sends and
+     * receives overlap, so large messages can't deadlock the group.
+     */
+    virtual bool exchange(const std::vector<unsigned int> &peers, const std::vector<std::vector<char>> &outgoing,
+                          std::vector<std::vector<char>> &incoming) = 0;
+};
+
+/**
+ * @brief Transport between processes of one machine over Unix domain sockets
+ *
+ * createMesh() connects all ranks pairwise with socketpair() before the worker processes
+ * are forked; every process then keeps the sockets of its own rank (see release()).
+ * Messages are framed with a 64-bit length. Not available on Windows.
+ */
+class SocketTransport : public Transport {
+public:
+    /**
+     * @brief Connect @p size ranks pairwise
+     *
+     * @return sockets[rank][peer] is the socket of @p rank to @p peer (-1 on the diagonal),
+     *         empty if a socket couldn't be created
+     */
+    static std::vector<std::vector<int>> createMesh(unsigned int size);
+
+    /** @brief Close every socket of @p mesh except the ones of @p rank */
+    static void release(std::vector<std::vector<int>> &mesh, unsigned int rank);
+
+    SocketTransport(unsigned int rank, std::vector<int> peerSockets);
+    SocketTransport(const SocketTransport &) = delete;
+    SocketTransport &operator=(const SocketTransport &) = delete;
+    ~SocketTransport() override;
+
+    unsigned int rank() const override { return self; }
+    unsigned int size() const override { return static_cast<unsigned int>(sockets.size()); }
+
+    bool send(unsigned int peer, const std::vector<char> &message) override;
+    bool receive(unsigned int peer, std::vector<char> &message) override;
+
+    /** @brief Sends on a helper thread while poll() drains whichever peer has data */
+    bool exchange(const std::vector<unsigned int> &peers, const std::vector<std::vector<char>> &outgoing,
+                  std::vector<std::vector<char>> &incoming) override;
+
+private:
+    unsigned int self;
+    std::vector<int> sockets; ///< Per peer, -1 for this rank
+};
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file worker_pool.h
+ * @brief Threads that stay alive between the parallel loops of the CPU engine
+ *
+ * Physics splits its narrow phase and every contact batch of every solver iteration
+ * into chunks. Starting threads for each of those loops costs more than the small
+ * batches themselves, so the threads are created once with the solver and sleep on a
+ * condition variable in between. The calling thread works on the chunks too.
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+public:
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+    ~WorkerPool() { resize(0); }
+
+    /** @brief Keep @p threads threads besides the caller (stops and restarts them if the count changes) */
+    void resize(unsigned int threads);
+
+    /** @brief Threads besides the caller */
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+    /**
+     * @brief Call job(c) for every chunk c in [0, chunks) and return when all calls are done
+     *
+     * Chunks go to whichever thread asks next, the caller included. One caller at a time.
+     */
+    void run(size_t chunks, const std::function<void(size_t)> &job);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake; ///< a new run() or stopping
+    std::condition_variable idle; ///< the last helper of a run() finished
+    bool stopping = false;
+    uint64_t generation = 0; ///< counts run() calls
+    const std::function<void(size_t)> *job = nullptr;
+    size_t chunkCount = 0;
+    std::atomic<size_t> nextChunk{0};
+    unsigned int helpers = 0; ///< threads that take part in the current run()
+    unsigned int joined = 0; ///< of those, threads that woke up for it
+    unsigned int busy = 0; ///< of those, threads not done with it
+
+    void loop();
+    void take(const std::function<void(size_t)> &work, size_t chunks);
+};
+
+#endif
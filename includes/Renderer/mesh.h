@@ -2,19 +2,28 @@
 #define MESH_H
 
 #include <string>
+#include <learnopengl/gl_resources.h> // RAII buffer / vertex array wrappers (DSA)
 #include "Sphere3D.h"
 #include "Surface3D.h"
 
-// Simple GPU mesh container
+// Simple GPU mesh container (move-only, owns its GL objects)
 struct Mesh {
-    unsigned int VBO = 0;
-    unsigned int VAO = 0;
-    unsigned int EBO = 0;
+    GLBuffer      VBO;                // Immutable vertex storage, re-created on remake
+    GLVertexArray VAO;
+    GLBuffer      EBO;
     int          indexCount = 0;
     bool         source = false;      // True = treated as light/emissive
     bool         inactive = false;    // True = lighting won't be applied
     bool         remake = true;       // True = geometry changed, needs re-upload
     bool         isWireframe = false; // when true, renderer should draw GL_LINES
+
+    // Delete the GL objects while the context still exists; the next upload re-creates them
+    void release() {
+        VAO = GLVertexArray();
+        VBO = GLBuffer();
+        EBO = GLBuffer();
+        remake = true;
+    }
 };
 
 // Sphere instance: owns CPU geometry + its GPU mesh + render properties
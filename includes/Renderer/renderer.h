@@ -15,14 +15,18 @@
  * - Shader: Wrapper for vertex/fragment shader compilation and uniform management
  * 
  * Rendering pipeline:
- * 1. Process input (keyboard movement, mouse look)
- * 2. Update camera matrices (view/projection)
- * 3. For each registered sphere:
+ * 1. Wait for the last frame that used this frame's camera slot, so at most CAMERA_SLOTS - 1
+ *    earlier frames are ever on the GPU; with throttling on (MAX_FRAMES_IN_FLIGHT > 0) also
+ *    wait until at most MAX_FRAMES_IN_FLIGHT are
+ * 2. Gather and upload trace points, set the light uniforms
+ * 3. Poll events and process input (keyboard movement, mouse look), as late as possible
+ * 4. Write camera matrices (view/projection) into this frame's uniform buffer slot
+ * 5. For each registered sphere:
  *    - Set model matrix (position/scale transform)
- *    - Upload uniforms (MVP matrices, colors, lighting)
+ *    - Upload uniforms (colors)
  *    - Draw sphere geometry (VAO/VBO/EBO)
- * 4. Draw surface (wireframe grid or filled quad)
- * 5. Swap buffers and update frame timing
+ * 6. Draw surface (wireframe grid or filled quad) and trace points
+ * 7. Fence the frame and swap buffers
  * 
  * Lighting model:
  * - Single point light source (emissive sphere)
@@ -31,6 +35,8 @@
  * 
  * Performance considerations:
  * - Lazy vertex buffer upload (only generates mesh on first draw or geometry change)
+ * - Vertex buffers filled on an upload thread with a shared context, so geometry
+ *   arriving mid-session doesn't stall a frame
  * - Instanced rendering not yet implemented (future optimization for many bodies)
  * - Frame timing calculated each frame for FPS display
  * 
@@ -47,10 +53,15 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <memory>
+#include <vector>
+
+#include <learnopengl/upload_thread.h> // Shared-context thread for buffer uploads
 
 #include "shader.h"         // Shader wrapper (compile / link / uniform helpers)
 #include "camera.h"         // FPS style camera with mouse look
 #include "body.h"           // Body struct containing Sphere + physics state
+#include "Physics/gpu_physics.h" // Optional compute backend whose buffers are drawn directly
 #include "settings.h"       // Global settings (screen size, FOV, etc.)
 #include "config.h"         // CMake-generated configuration (shader paths, etc.)
 
@@ -102,16 +113,17 @@ public:
     /**
      * @brief Render a single frame with all registered objects
      *
-     * Main rendering function called once per frame:
-     * 1. Calculate frame time and update deltaTime
-     * 2. Process keyboard input (WASD movement, vertical controls)
-     * 3. Clear color and depth buffers
-     * 4. Update camera view/projection matrices
-     * 5. Render all registered spheres with lighting
-     * 6. Render surface (wireframe or filled)
-     * 7. Swap front/back buffers
-     * 8. Poll GLFW events (input callbacks)
-     * 9. Update FPS display in window title
+     * Main rendering function called once per frame, ordered so that input is
+     * sampled as late as possible:
+     * 1. Wait for the GPU to release this frame's camera slot (always), and if throttling is
+     *    on until at most maxFramesInFlight earlier frames are queued
+     * 2. Calculate frame time, update deltaTime and the FPS display
+     * 3. Gather and upload the trace points, upload the light uniforms
+     * 4. Poll GLFW events (mouse look) and process keyboard input (WASD movement);
+     *    without late latching this happens before step 3
+     * 5. Write the camera view/projection matrices into this frame's UBO slot
+     * 6. Clear, render all registered spheres with lighting, the surface and traces
+     * 7. Fence the frame and swap front/back buffers
      *
      * @param bodies Vector of all bodies in simulation (used for position sync)
      */
@@ -150,16 +162,63 @@ public:
     /**
      * @brief Release OpenGL and GLFW resources
      *
-     * Deletes VAOs, VBOs, EBOs for all spheres and surfaces, destroys
+     * Deletes VAOs, VBOs, EBOs for all spheres and surfaces (the meshes outlive
+     * the context, so their RAII wrappers are released here), destroys
      * shader program, terminates GLFW context. Should be called before
      * program exit to prevent resource leaks.
      */
     void cleanup();
 
+    /**
+     * @brief Draw bodies and traces straight from the GPU physics buffers
+     *
+     * Binds the body storage buffer as a per-instance position attribute (location 1)
+     * of every registered sphere VAO and creates a VAO over the trace ring buffer.
+     * From then on RenderFrame() ignores Body::Position and draws body i as instance i,
+     * so no body state is read back to the CPU. Call after all spheres are registered.
+     *
+     * @param gpu Initialized compute backend; must outlive the Renderer
+     */
+    void attachGpuPhysics(GpuPhysics &gpu);
+
+    /**
+     * @brief Limit how many frames the CPU may submit before the GPU has finished them
+     *
+     * Every frame is fenced; before sampling input, RenderFrame() waits for the
+     * fence of the frame @p frames back. Fewer queued frames mean input reaches
+     * the screen sooner at the cost of CPU/GPU overlap.
+     *
+     * @param frames 1 - 3, or 0 to leave queueing to the driver
+     */
+    void setMaxFramesInFlight(unsigned int frames);
+
+    /**
+     * @brief Sample input right before the draws instead of at the start of the frame
+     *
+     * With late latching the work that doesn't depend on the camera (gathering
+     * and uploading the trace points, the light) is done first; events are polled
+     * and the camera matrices written into their uniform buffer slot only then,
+     * right before the draw calls that read them are submitted.
+     */
+    void setLateLatch(bool enabled);
+
+    /**
+     * @brief Measure input-to-GPU latency and print it once per second
+     *
+     * Records the GL clock when the camera used by a frame was sampled and a
+     * timestamp query when the GPU has finished the frame's draws; the difference
+     * goes to the renderer_input_latency_seconds histogram and to stdout.
+     */
+    void setLatencyMode(bool enabled);
+
     void setupTraceBuffer();
 
     //VBO/VAO for trace
-    unsigned int traceVAO = 0, traceVBO = 0;
+    GLVertexArray traceVAO;
+    GLBuffer traceVBO;
+
+    /** @brief VAO reading trace points from the GPU physics trace buffer */
+    GLVertexArray gpuTraceVAO;
 
 private:
     // ===== Core OpenGL State =====
@@ -202,6 +261,19 @@ private:
      */
     Surface *baseSurface = nullptr;
 
+    /** @brief Every surface passed to drawSurface(), so cleanup() can release their meshes */
+    std::vector<Surface *> surfaces;
+
+    /** @brief Compute backend providing body positions and traces, nullptr for the CPU path */
+    GpuPhysics *gpuPhysics = nullptr;
+
+    /**
+     * @brief Thread with a context sharing objects with the window's, fills mesh buffers
+     *
+     * Polled at the start of every frame; completed uploads are attached to their VAOs then.
+     */
+    std::unique_ptr<UploadThread> uploads;
+
     // ===== Mouse Input State (for camera look controls) =====
 
     /** @brief Last recorded X mouse position in screen coordinates */
@@ -225,6 +297,47 @@ private:
     /** @brief Timestamp of last frame (from glfwGetTime()) */
     float lastFrame = 0.0f;
 
+    // ===== Camera Uniform Buffer and Frame Pacing =====
+
+    /** @brief Camera block as laid out in the shaders' std140 Camera uniform block (binding 0) */
+    struct CameraBlock {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::vec4 viewPos;
+    };
+
+    /** @brief Camera slots, one per frame that may be in flight plus the one being recorded */
+    static constexpr unsigned int CAMERA_SLOTS = 4;
+
+    /** @brief CAMERA_SLOTS slots of cameraSlotSize bytes, persistently mapped when GL 4.4 is available */
+    GLBuffer cameraUBO;
+
+    /** @brief Mapping of cameraUBO, nullptr when slots are written with subData */
+    char *cameraMapped = nullptr;
+
+    /** @brief Bytes per slot, rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT */
+    GLsizeiptr cameraSlotSize = 0;
+
+    /** @brief Frames rendered so far; frame n uses slot n % CAMERA_SLOTS */
+    unsigned long long frameIndex = 0;
+
+    /** @brief Fence of the last frame that used each slot, 0 once waited for */
+    GLsync frameFences[CAMERA_SLOTS] = {};
+
+    unsigned int maxFramesInFlight = MAX_FRAMES_IN_FLIGHT; ///< 0 = no extra wait, the camera slot wait in throttleFrames() always applies
+    bool lateLatch = LATE_LATCH; ///< Sample input right before the draws
+    bool latencyMode = false; ///< Measure and print input-to-GPU latency
+
+    /** @brief Timestamp query per slot, written when the GPU has finished the frame */
+    GLuint latencyQueries[CAMERA_SLOTS] = {};
+
+    /** @brief GL clock (ns) when the camera of the frame in each slot was sampled, 0 = nothing pending */
+    GLint64 inputSampleTime[CAMERA_SLOTS] = {};
+
+    double latencySum = 0.0; ///< Latencies measured since the last print (seconds)
+    unsigned int latencyCount = 0;
+    float timeSinceLatencyPrint = 0.0f;
+
     // ===== Private Helper Methods =====
 
     /**
@@ -258,21 +371,45 @@ private:
     void loadGLAD();
 
     /**
-     * @brief Update camera matrices and upload to shader uniforms
+     * @brief Update camera matrices and write them into the current UBO slot
      *
      * Calculates view matrix from camera position/orientation and projection
-     * matrix from FOV/aspect ratio. Uploads both to "view" and "projection"
-     * uniforms in currently bound shader program.
+     * matrix from FOV/aspect ratio and stores both, with the camera position,
+     * in slot frameIndex % CAMERA_SLOTS of cameraUBO, which RenderFrame() binds
+     * to uniform block binding 0. Through the mapping when there is one; the
+     * slot's previous frame has finished on the GPU (see throttleFrames()).
      */
     void generateCameraView();
 
+    /** @brief Allocate (and map) the camera slots and the latency queries */
+    void setupCameraBuffer();
+
+    /**
+     * @brief Wait for the frames that must be finished before this one starts
+     *
+     * Blocks on the fence of the frame maxFramesInFlight back and on the last
+     * user of the current camera slot, counting the time spent waiting.
+     */
+    void throttleFrames();
+
+    /** @brief Poll GLFW events (mouse look callbacks) and process keyboard input */
+    void sampleInput();
+
+    /**
+     * @brief Collect finished latency queries and print their average once per second
+     *
+     * @param deltaTime Time elapsed since last frame
+     */
+    void collectLatency(float deltaTime);
+
     /**
      * @brief Generate or update sphere's VAO/VBO/EBO on GPU
      *
      * @param sphere Sphere with mesh data (vertices, normals, indices)
      *
-     * Lazy upload: only generates buffers if mesh.VAO == 0 or geometry changed.
-     * Creates vertex array with interleaved position/normal attributes.
+     * Lazy upload: only generates buffers if mesh.VAO has no GL object yet or geometry changed.
+     * The VAO is created right away, the buffers are filled on the upload thread (see
+     * uploadMesh()); a remake keeps drawing the old buffers until the new ones are in.
      * Used for procedurally generated subdivision spheres.
      */
     void setupSphereVertexBuffer(Sphere &sphere);
@@ -283,10 +420,24 @@ private:
      * @param surface Surface with mesh data (vertices, indices, wireframe flag)
      *
      * Handles both wireframe grids (GL_LINES topology) and filled quads
-     * (GL_TRIANGLES). Only uploads if mesh.VAO == 0 or geometry changed.
+     * (GL_TRIANGLES). Only uploads if mesh.VAO has no GL object yet or geometry changed.
      */
     void setupSurfaceVertexBuffer(Surface &surface);
 
+    /**
+     * @brief Fill new vertex/index buffers for a mesh on the upload thread
+     *
+     * @param mesh Mesh whose VAO (created by the caller) gets the buffers
+     * @param vertices Positions, 3 floats per vertex (copied: the geometry may change meanwhile)
+     * @param indices Triangle or line indices
+     *
+     * Immutable storage is allocated and filled on the upload thread; once its fence
+     * has signaled the buffers replace the mesh's in the next frame, the VAO is pointed
+     * at them (VAOs aren't shared between contexts) and indexCount is set. Uploads of
+     * the same mesh complete in order, so the newest geometry wins.
+     */
+    void uploadMesh(Mesh &mesh, std::vector<float> vertices, std::vector<unsigned int> indices);
+
     /**
      * @brief GLFW callback for window resize events
      *
@@ -344,7 +495,8 @@ private:
      * @param deltaTime Time elapsed since last frame
      *
      * Calculates frames per second and updates GLFW window title string
-     * with formatted FPS display. Called each frame during RenderFrame().
+     * with formatted FPS display and the GL binds issued by the last frame
+     * (see glCallStats()). Called each frame during RenderFrame().
      */
     void displayFrameRate(float deltaTime) const;
 };
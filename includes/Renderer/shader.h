@@ -16,12 +16,15 @@ public:
     unsigned int ID;                        // OpenGL shader program handle
 
     void load(const char* vertexPath, const char* fragmentPath); // Compiles and links vertex + fragment shaders
+    void loadCompute(const char* computePath);                   // Compiles and links a compute shader
     void use();                              // Activates the shader program
     void terminate();                        // Deletes the shader program
 
     void setBool(const char* name, int value) const;             // Sets a boolean (int) uniform
     void setInt(std::string &name, int value) const;             // Sets an integer uniform
+    void setInt(const char* name, int value) const;              // Sets an integer uniform
     void setFloat(std::string &name, float value) const;         // Sets a float uniform
+    void setFloat(const char* name, float value) const;          // Sets a float uniform
     void setVec3(const char* name, const glm::vec3& vec3) const; // Sets a vec3 uniform
     void setMat4(const char* name, glm::mat4 mat) const;         // Sets a mat4 uniform
 
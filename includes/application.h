@@ -36,12 +36,81 @@
 
 #include "Renderer/renderer.h"
 #include "Physics/physics.h"
+#include "Physics/gpu_physics.h"
+#include "Physics/out_of_core.h"
+#include "Physics/distributed.h"
+#include <learnopengl/metrics.h>
 
 class App {
 public:
     App() : accumulator(0.0f), timeCount(0) {
     }
 
+    /**
+     * @brief Select the physics backend before run()
+     *
+     * @param gpu true = compute shader backend (GpuPhysics), false = CPU backend (Physics)
+     */
+    void setGpuPhysics(bool gpu) {
+        useGpu = gpu;
+    }
+
+    /**
+     * @brief Select the integration scheme of the CPU backend before run()
+     */
+    void setIntegrator(Integrator scheme) {
+        pEngine.setIntegrator(scheme);
+    }
+
+    /**
+     * @brief Run the CPU simulation in worker processes before run() (0 = in this process)
+     *
+     * See DistributedPhysics; ignored with the GPU backend.
+     */
+    void setProcesses(unsigned int count) {
+        processes = count;
+    }
+
+    /**
+     * @brief Run the CPU simulation out of core before run(), on files in @p directory
+     *
+     * See OutOfCorePhysics; empty = in memory with Physics. Ignored with the GPU backend
+     * and when worker processes are set.
+     */
+    void setOutOfCore(const std::string &directory) {
+        outOfCoreDirectory = directory;
+    }
+
+    /**
+     * @brief Dump metrics() to @p path once per second while run() is active
+     *
+     * .json / .jsonl files get one JSON line per dump, anything else the Prometheus text format.
+     */
+    void setMetricsFile(const std::string &path) {
+        metricsFile = path;
+    }
+
+    /**
+     * @brief Frames the renderer may queue ahead of the GPU (0 = driver default)
+     */
+    void setMaxFramesInFlight(unsigned int frames) {
+        rEngine.setMaxFramesInFlight(frames);
+    }
+
+    /**
+     * @brief Whether the renderer rewrites the camera right before the swap
+     */
+    void setLateLatch(bool enabled) {
+        rEngine.setLateLatch(enabled);
+    }
+
+    /**
+     * @brief Print the measured input-to-GPU latency once per second while run() is active
+     */
+    void setLatencyMode(bool enabled) {
+        rEngine.setLatencyMode(enabled);
+    }
+
     /**
      * @brief Main application loop - orchestrates rendering and physics
      *
@@ -62,6 +131,17 @@ public:
      */
     void run() {
         setupProgram();
+        if (!metricsFile.empty())
+            metricsWriter.start(metricsFile, MetricsWriter::formatFor(metricsFile));
+
+        if (useGpu) {
+            gEngine.init(bodies);
+            rEngine.attachGpuPhysics(gEngine);
+        } else if (processes > 0) {
+            dEngine.start(bodies, processes);
+        } else if (!outOfCoreDirectory.empty()) {
+            oEngine.start(outOfCoreDirectory, bodies, OUT_OF_CORE_TRACE_STEPS, size_t(OUT_OF_CORE_BUDGET_MB) << 20);
+        }
 
         float multiplier = 2.0f;
 
@@ -73,15 +153,22 @@ public:
 
                 // Demo: Apply impulse to red ball after 2 seconds (at 60Hz physics)
                 if (timeCount == 363) {
-                    Physics::push(ball_one, glm::vec3(multiplier * 1.0f, multiplier * -0.7071f, 0.0f));
-                    Physics::push(ball_two, glm::vec3(multiplier * -0.7071f, multiplier * -0.7071f, 0.0f));
-                    Physics::push(ball_three, glm::vec3(multiplier * 0.7071f, multiplier * 0.7071f, 0.0f));
+                    push(0, ball_one, glm::vec3(multiplier * 1.0f, multiplier * -0.7071f, 0.0f));
+                    push(1, ball_two, glm::vec3(multiplier * -0.7071f, multiplier * -0.7071f, 0.0f));
+                    push(2, ball_three, glm::vec3(multiplier * 0.7071f, multiplier * 0.7071f, 0.0f));
                 }
 
                 // Fixed timestep physics loop: process physics at constant rate
                 // regardless of rendering frame rate (ensures determinism)
                 while (accumulator >= dt) {
-                    pEngine.processFrame(bodies);
+                    if (useGpu)
+                        gEngine.processFrame();
+                    else if (dEngine.isRunning())
+                        dEngine.processFrame(bodies);
+                    else if (oEngine.isRunning())
+                        oEngine.processFrame(bodies);
+                    else
+                        pEngine.processFrame(bodies);
                     accumulator -= dt;
                 }
             }
@@ -96,6 +183,14 @@ private:
     // Core subsystems
     Renderer rEngine; ///< OpenGL rendering engine (camera, shaders, draw calls)
     Physics pEngine; ///< Physics engine (integration, forces, collisions)
+    GpuPhysics gEngine; ///< Compute shader physics engine, used instead of pEngine when useGpu is set
+    DistributedPhysics dEngine; ///< Multi-process engine, used instead of pEngine when processes > 0
+    OutOfCorePhysics oEngine; ///< File-backed engine, used instead of pEngine with an out-of-core directory
+    bool useGpu = GPU_PHYSICS; ///< Selected physics backend
+    unsigned int processes = 0; ///< Worker processes of dEngine
+    std::string outOfCoreDirectory; ///< State and trace files of oEngine, empty = not out of core
+    std::string metricsFile; ///< Metrics dump target, empty = no dump
+    MetricsWriter metricsWriter;
 
     // Scene objects
     std::vector<Body *> bodies; ///< All physical bodies in the simulation (rendered + physics)
@@ -187,7 +282,29 @@ private:
         rEngine.drawSurface(surface);
     }
 
+    /**
+     * @brief Apply an impulse through the active backend
+     *
+     * @param index Index of the body in the bodies vector (GPU buffer slot)
+     * @param body Body instance (CPU state)
+     * @param impulse Velocity change
+     */
+    void push(unsigned int index, Body &body, glm::vec3 impulse) {
+        if (useGpu)
+            gEngine.push(index, impulse);
+        else if (dEngine.isRunning())
+            dEngine.push(index, impulse);
+        else if (oEngine.isRunning())
+            oEngine.push(index, impulse);
+        else
+            Physics::push(body, impulse);
+    }
+
     void cleanup() {
+        if (useGpu) gEngine.cleanup();
+        dEngine.stop();
+        oEngine.close();
+        metricsWriter.stop();
         rEngine.cleanup();
         pEngine.cleanup();
     }
@@ -0,0 +1,88 @@
+/**
+ * @file benchmark.h
+ * @brief Command line benchmarks of the physics backends (--benchmark and friends)
+ *
+ * Every benchmark builds its own test scene and engines and shares nothing with App, so
+ * main() runs them without opening the app's window. Engines that need a timestep other
+ * than the global dt are given it explicitly (Physics(timeStep, speed)); dt is never changed.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+
+class Benchmark {
+public:
+    /**
+     * @brief Compare CPU and compute backend throughput on a random cluster
+     *
+     * Builds @p bodyCount bodies in a cube, then times @p steps physics steps
+     * with Physics::processFrame and with GpuPhysics::processFrame (synchronized
+     * with glFinish). Prints ms per step and pair interactions per second.
+     * Opens a Renderer for the OpenGL context; no frames are rendered.
+     *
+     * @param bodyCount Number of bodies in the test scene
+     * @param steps Number of timesteps measured per backend
+     */
+    void backends(unsigned int bodyCount, unsigned int steps);
+
+    /**
+     * @brief Measure how the CPU contact stage scales with the number of workers
+     *
+     * Packs @p bodyCount bodies in a lattice tight enough that every body touches
+     * its six neighbours, then times @p steps Physics::processFrame calls for
+     * 1, 2, 4, ... up to std::thread::hardware_concurrency() workers. Prints the
+     * contact count, the number of batches and the contact stage time per step.
+     *
+     * @param bodyCount Number of bodies in the test scene
+     * @param steps Number of timesteps measured per worker count
+     */
+    void contacts(unsigned int bodyCount, unsigned int steps);
+
+    /**
+     * @brief Steps-to-solution of the CPU integrators on an eccentric binary
+     *
+     * Two equal bodies start at apocenter of a Kepler orbit (a = 60) with eccentricity
+     * @p eccentricity, so the pericenter passage is a close encounter. Every integrator
+     * follows one orbital period with twice as many steps each round, until the
+     * separation vector stays within 0.1% of a of the analytic solution at 64 checkpoints.
+     * Prints the force evaluations and the time that took, per integrator.
+     *
+     * @param eccentricity Orbit eccentricity in [0, 1)
+     */
+    void integrators(double eccentricity);
+
+    /**
+     * @brief Compare the out-of-core backend with Physics on memory, a warm file and a cold file
+     *
+     * Runs a random cluster (as in backends(), with radii small enough that Physics
+     * resolves no contacts) through Physics, then through OutOfCorePhysics three times:
+     * on anonymous memory, on state/trace files in @p directory with the page cache kept,
+     * and on the same files with their pages evicted after every step. The memory budget
+     * is a quarter of the state, so the force pass streams the source tiles at least four
+     * times per step. Prints ms per step, the file sizes and the largest position
+     * difference to the Physics run.
+     *
+     * @param bodyCount Number of bodies in the test scene
+     * @param steps Number of timesteps measured per run
+     * @param directory Existing directory for state.bin and trace.bin
+     */
+    void outOfCore(unsigned int bodyCount, unsigned int steps, const std::string &directory);
+
+    /**
+     * @brief Compare the multi-process backend with the single-process Euler path
+     *
+     * Runs the random cluster of backends() with Physics, then with DistributedPhysics
+     * on 1, 2, 4, ... up to @p maxWorkers worker processes. Prints ms per step, the ghosts
+     * and tree cells exchanged, the load imbalance, the number of repartitions and the
+     * largest position difference to the single-process run.
+     *
+     * @param bodyCount Number of bodies in the test scene
+     * @param steps Number of timesteps measured per run
+     * @param maxWorkers Largest number of worker processes
+     */
+    void distributed(unsigned int bodyCount, unsigned int steps, unsigned int maxWorkers);
+};
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/model.h>
+#include <learnopengl/texture_loader.h>
+#include <learnopengl/metrics.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+
+// Models, textures and shaders shared by everything rendering with one GL context. Assets are keyed by
+// what they were loaded from and handed out as shared_ptr; asking again for one that is resident
+// returns the same object instead of loading it a second time:
+//
+//   AssetCache assets;
+//   std::shared_ptr<Model> backpack = assets.model(FileSystem::getPath("resources/objects/backpack/backpack.obj"), true);
+//   std::shared_ptr<Shader> shader = assets.shader("1.model_loading.vs", "1.model_loading.fs");
+//   while (!glfwWindowShouldClose(window))
+//   {
+//       assets.poll(); // uploads what finished loading, evicts what nobody used for long
+//       ...
+//
+// Models and textures load in the background (see ModelLoader and TextureLoader), so a model draws its
+// bounding box and a texture samples black for the first few frames. Assets nobody references any
+// more stay resident, so code that lets go of an asset and asks for it again later (a scene being left
+// and entered again) finds it loaded; only the least recently used beyond setUnusedLimit() are freed.
+class AssetCache
+{
+public:
+    struct Stats
+    {
+        size_t hits = 0, misses = 0, evictions = 0;
+        size_t resident = 0;  // assets loaded right now
+        size_t unused = 0;    // of those, the ones only the cache holds on to
+    };
+
+    explicit AssetCache(size_t unusedLimit = 16) : unusedLimit(unusedLimit)
+    {
+    }
+
+    ~AssetCache()
+    {
+        // models still loading cancel their jobs with the loader, which is destroyed after them
+        entries.clear();
+    }
+
+    AssetCache(const AssetCache &) = delete;
+    AssetCache &operator=(const AssetCache &) = delete;
+
+    // flipTextures: whether the model's textures are loaded upside down (stbi_set_flip_vertically_on_load)
+    std::shared_ptr<Model> model(const std::string &path, bool flipTextures = false, bool gamma = false)
+    {
+        const std::string key = "model:" + path + (flipTextures ? ":flip" : "") + (gamma ? ":srgb" : "");
+        std::shared_ptr<Model> cached = find<Model>(key);
+        if (cached)
+            return cached;
+        setFlip(flipTextures);
+        std::shared_ptr<Model> model = std::make_shared<Model>(path, models, gamma);
+        insert(key, model);
+        return model;
+    }
+
+    // a 2D texture with repeat wrapping and trilinear filtering, see TextureLoader::load()
+    std::shared_ptr<GLTexture> texture(const std::string &path, bool gammaCorrection = false, bool flip = false, GLint wrap = GL_REPEAT)
+    {
+        const std::string key = "texture:" + path + (gammaCorrection ? ":srgb" : "") + (flip ? ":flip" : "") + ":" + std::to_string(wrap);
+        std::shared_ptr<GLTexture> cached = find<GLTexture>(key);
+        if (cached)
+            return cached;
+        setFlip(flip);
+        std::shared_ptr<GLTexture> texture = std::make_shared<GLTexture>(textures.load(path, gammaCorrection, wrap));
+        insert(key, texture);
+        return texture;
+    }
+
+    // a cubemap from 6 faces in the order +X, -X, +Y, -Y, +Z, -Z, see TextureLoader::loadCubemap()
+    std::shared_ptr<GLTexture> cubemap(const std::vector<std::string> &faces)
+    {
+        std::string key = "cubemap";
+        for (const std::string &face : faces)
+            key += ":" + face;
+        std::shared_ptr<GLTexture> cached = find<GLTexture>(key);
+        if (cached)
+            return cached;
+        setFlip(false);
+        std::shared_ptr<GLTexture> texture = std::make_shared<GLTexture>(textures.loadCubemap(faces));
+        insert(key, texture);
+        return texture;
+    }
+
+    // the shader program built from these files, compiled and linked the first time it is asked for
+    std::shared_ptr<Shader> shader(const std::string &vertexPath, const std::string &fragmentPath, const std::string &geometryPath = "")
+    {
+        const std::string key = "shader:" + vertexPath + ":" + fragmentPath + ":" + geometryPath;
+        std::shared_ptr<Shader> cached = find<Shader>(key);
+        if (cached)
+            return cached;
+        // Shader leaves its program alone when it goes away
+        std::shared_ptr<Shader> shader(new Shader(vertexPath.c_str(), fragmentPath.c_str(), geometryPath.empty() ? nullptr : geometryPath.c_str()),
+                                       [](Shader *shader) { glDeleteProgram(shader->ID); delete shader; });
+        insert(key, shader);
+        return shader;
+    }
+
+    // once per frame on the GL thread: uploads the models and textures that finished loading and frees
+    // the least recently used unreferenced assets beyond the limit; returns true when nothing is loading
+    bool poll()
+    {
+        const bool modelsDone = models.poll();
+        const bool texturesDone = textures.poll();
+        texturesIdle = texturesDone;
+        collect();
+        return modelsDone && texturesDone;
+    }
+
+    // blocks until every asset asked for so far is uploaded
+    void finish()
+    {
+        models.finish();
+        textures.finish();
+    }
+
+    // uploads the models and textures asked for from now on on `thread` instead of in poll(); the
+    // upload thread must outlive the cache
+    void setUploadThread(UploadThread *thread)
+    {
+        models.setUploadThread(thread);
+        textures.setUploadThread(thread);
+    }
+
+    // how many unreferenced assets stay resident
+    void setUnusedLimit(size_t limit)
+    {
+        unusedLimit = limit;
+        collect();
+    }
+
+    const Stats &stats()
+    {
+        cacheStats.resident = entries.size();
+        cacheStats.unused = 0;
+        for (const auto &entry : entries)
+            if (entry.second.asset.use_count() == 1)
+                cacheStats.unused++;
+        return cacheStats;
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<void> asset;
+        uint64_t lastUsed = 0; // collect() call that last saw it referenced
+    };
+
+    // declared before the entries: models cancel their loads when they go, textures must be uploaded
+    // (or abandoned) while the loader is still around
+    ModelLoader models;
+    TextureLoader textures;
+    std::map<std::string, Entry> entries;
+    size_t unusedLimit;
+    uint64_t collections = 0;
+    bool flipping = false;
+    bool texturesIdle = true; // nothing the texture loader still uploads into may be freed
+    Stats cacheStats;
+
+    template<typename T>
+    std::shared_ptr<T> find(const std::string &key)
+    {
+        static MetricCounter &hits = metrics().counter("asset_cache_hits_total", "Assets found resident in the cache");
+        auto found = entries.find(key);
+        if (found == entries.end())
+            return nullptr;
+        found->second.lastUsed = collections;
+        cacheStats.hits++;
+        hits.add();
+        return std::static_pointer_cast<T>(found->second.asset);
+    }
+
+    void insert(const std::string &key, std::shared_ptr<void> asset)
+    {
+        static MetricCounter &misses = metrics().counter("asset_cache_misses_total", "Assets the cache had to load");
+        Entry &entry = entries[key];
+        entry.asset = std::move(asset);
+        entry.lastUsed = collections;
+        cacheStats.misses++;
+        misses.add();
+    }
+
+    // the loaders' workers read stbi's global flip flag, so it only changes between batches
+    void setFlip(bool flip)
+    {
+        if (flip == flipping)
+            return;
+        if (models.pending() > 0 || !textures.poll())
+            finish();
+        texturesIdle = true;
+        stbi_set_flip_vertically_on_load(flip);
+        flipping = flip;
+    }
+
+    void collect()
+    {
+        static MetricCounter &evictions = metrics().counter("asset_cache_evictions_total", "Unreferenced assets the cache freed");
+        static MetricGauge &resident = metrics().gauge("asset_cache_resident", "Assets resident in the cache");
+
+        collections++;
+        std::vector<std::map<std::string, Entry>::iterator> unused;
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+        {
+            if (it->second.asset.use_count() > 1)
+                it->second.lastUsed = collections;
+            else
+                unused.push_back(it);
+        }
+        if (unused.size() > unusedLimit && texturesIdle)
+        {
+            std::sort(unused.begin(), unused.end(), [](const std::map<std::string, Entry>::iterator &a, const std::map<std::string, Entry>::iterator &b) {
+                return a->second.lastUsed < b->second.lastUsed;
+            });
+            for (size_t i = 0; i < unused.size() - unusedLimit; i++)
+            {
+                entries.erase(unused[i]);
+                cacheStats.evictions++;
+                evictions.add();
+            }
+        }
+        resident.set((double)entries.size());
+    }
+};
+#endif
@@ -0,0 +1,908 @@
+#ifndef GL_RESOURCES_H
+#define GL_RESOURCES_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/metrics.h>
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+// Small RAII layer over OpenGL objects. Every wrapper owns exactly one GL object, deletes it in its
+// destructor and can only be moved, never copied. Objects are created and edited through direct state
+// access (GL 4.5): no object has to be bound just to be modified, so editing a buffer can never
+// disturb the currently bound vertex array. Buffers and textures use immutable storage; resizing
+// means re-creating the object through storage() again.
+//
+// Contexts without DSA (the 3.3 core contexts of the tutorials, macOS' 4.1) fall back to the classic
+// bind-to-edit path with the same results, so the wrappers can be used everywhere.
+
+// counts the GL calls issued through the wrappers; reset it once per frame to get per-frame numbers.
+// Kept per thread, so the calls of an UploadThread don't end up in the render thread's frames
+struct GLCallStats
+{
+    unsigned long long binds    = 0; // glBind* calls, including binds that were only needed to edit an object
+    unsigned long long dsaCalls = 0; // named (bind-free) object edits
+    unsigned long long created  = 0; // objects created
+
+    void reset()
+    {
+        *this = GLCallStats();
+    }
+};
+
+inline GLCallStats &glCallStats()
+{
+    static thread_local GLCallStats stats;
+    return stats;
+}
+
+// bytes uploaded to buffers and textures since start-up, published in metrics()
+inline MetricCounter &glUploadedBytes()
+{
+    static MetricCounter &bytes = metrics().counter("gl_uploaded_bytes_total", "Bytes uploaded to GL buffers and textures");
+    return bytes;
+}
+
+// size of one pixel of client data in the given format and type
+inline size_t glPixelSize(GLenum format, GLenum type)
+{
+    size_t channels = 4;
+    if (format == GL_RED || format == GL_DEPTH_COMPONENT)
+        channels = 1;
+    else if (format == GL_RG)
+        channels = 2;
+    else if (format == GL_RGB)
+        channels = 3;
+    if (type == GL_UNSIGNED_BYTE || type == GL_BYTE)
+        return channels;
+    if (type == GL_HALF_FLOAT || type == GL_UNSIGNED_SHORT || type == GL_SHORT)
+        return channels * 2;
+    return channels * 4;
+}
+
+inline bool glHasDirectStateAccess()
+{
+    return GLAD_GL_VERSION_4_5 != 0;
+}
+
+// ------------------------------------------------------------------------
+class GLBuffer
+{
+public:
+    GLBuffer() = default;
+    // flags: GL_DYNAMIC_STORAGE_BIT if the contents are updated with subData(), 0 for static data
+    GLBuffer(GLsizeiptr size, const void *data, GLbitfield flags = 0)
+    {
+        storage(size, data, flags);
+    }
+    ~GLBuffer()
+    {
+        release();
+    }
+    GLBuffer(GLBuffer &&other) noexcept : name(other.name), bytes(other.bytes)
+    {
+        other.name = 0;
+        other.bytes = 0;
+    }
+    GLBuffer &operator=(GLBuffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            std::swap(name, other.name);
+            std::swap(bytes, other.bytes);
+        }
+        return *this;
+    }
+    GLBuffer(const GLBuffer &) = delete;
+    GLBuffer &operator=(const GLBuffer &) = delete;
+
+    // (re-)creates the buffer with immutable storage of the given size
+    void storage(GLsizeiptr size, const void *data, GLbitfield flags = 0)
+    {
+        release();
+        bytes = size;
+        GLCallStats &stats = glCallStats();
+        stats.created++;
+        if (data)
+            glUploadedBytes().add(size);
+        if (glHasDirectStateAccess())
+        {
+            glCreateBuffers(1, &name);
+            if (size > 0)
+                glNamedBufferStorage(name, size, data, flags);
+            stats.dsaCalls++;
+            return;
+        }
+        glGenBuffers(1, &name);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+        stats.binds++;
+        if (size == 0)
+            return;
+        if (GLAD_GL_VERSION_4_4)
+            glBufferStorage(GL_COPY_WRITE_BUFFER, size, data, flags);
+        else
+            glBufferData(GL_COPY_WRITE_BUFFER, size, data, (flags & GL_DYNAMIC_STORAGE_BIT) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    }
+
+    void subData(GLintptr offset, GLsizeiptr size, const void *data)
+    {
+        glUploadedBytes().add(size);
+        if (glHasDirectStateAccess())
+        {
+            glNamedBufferSubData(name, offset, size, data);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        glCallStats().binds++;
+    }
+
+    void getSubData(GLintptr offset, GLsizeiptr size, void *data) const
+    {
+        if (glHasDirectStateAccess())
+        {
+            glGetNamedBufferSubData(name, offset, size, data);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, name);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, offset, size, data);
+        glCallStats().binds++;
+    }
+
+    // maps part of the buffer; persistent mappings need storage() with GL_MAP_PERSISTENT_BIT (GL 4.4)
+    void *mapRange(GLintptr offset, GLsizeiptr length, GLbitfield access) const
+    {
+        if (glHasDirectStateAccess())
+        {
+            glCallStats().dsaCalls++;
+            return glMapNamedBufferRange(name, offset, length, access);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+        glCallStats().binds++;
+        return glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, length, access);
+    }
+
+    // binds the buffer to an indexed target (GL_SHADER_STORAGE_BUFFER, GL_UNIFORM_BUFFER, ...)
+    void bindBase(GLenum target, GLuint index) const
+    {
+        glBindBufferBase(target, index, name);
+        glCallStats().binds++;
+    }
+
+    unsigned int id() const
+    {
+        return name;
+    }
+    GLsizeiptr size() const
+    {
+        return bytes;
+    }
+
+private:
+    unsigned int name = 0;
+    GLsizeiptr bytes = 0;
+
+    void release()
+    {
+        if (name)
+            glDeleteBuffers(1, &name);
+        name = 0;
+        bytes = 0;
+    }
+};
+
+// ------------------------------------------------------------------------
+// Buffer for data the CPU rewrites every frame (instance transforms, per-frame constants). It is split
+// into REGIONS regions that are written in turn: the CPU fills one region while the GPU may still read
+// the ones written before, and a fence per region makes write() wait only if the GPU falls REGIONS
+// writes behind. With GL 4.4 the buffer stays persistently mapped and write() is a memcpy; older
+// contexts upload with glBufferSubData and leave the synchronization to the driver.
+class GLStreamBuffer
+{
+public:
+    static constexpr unsigned int REGIONS = 3;
+
+    GLStreamBuffer() = default;
+    ~GLStreamBuffer()
+    {
+        release();
+    }
+    GLStreamBuffer(GLStreamBuffer &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+    GLStreamBuffer &operator=(GLStreamBuffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            // other takes over our buffer and fences and releases them
+            std::swap(storageBuffer, other.storageBuffer);
+            std::swap(mapped, other.mapped);
+            std::swap(regionSize, other.regionSize);
+            std::swap(current, other.current);
+            std::swap(written, other.written);
+            std::swap(fences, other.fences);
+        }
+        return *this;
+    }
+    GLStreamBuffer(const GLStreamBuffer &) = delete;
+    GLStreamBuffer &operator=(const GLStreamBuffer &) = delete;
+
+    // copies size bytes into the next region and returns the region's offset in buffer(); the data stays
+    // valid for the draws issued until REGIONS - 1 further writes
+    GLintptr write(const void *data, GLsizeiptr size)
+    {
+        if (size > regionSize)
+            reserve(size);
+        else if (written)
+        {
+            // the draws reading the current region have all been issued by now
+            fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            current = (current + 1) % REGIONS;
+        }
+        wait(fences[current]);
+        const GLintptr offset = current * regionSize;
+        if (mapped)
+        {
+            std::copy_n(static_cast<const char *>(data), size, mapped + offset);
+            glUploadedBytes().add(size);
+        }
+        else
+            storageBuffer.subData(offset, size, data);
+        written = true;
+        return offset;
+    }
+
+    const GLBuffer &buffer() const
+    {
+        return storageBuffer;
+    }
+
+private:
+    GLBuffer storageBuffer;
+    char *mapped = nullptr;
+    GLsizeiptr regionSize = 0;
+    unsigned int current = 0;
+    bool written = false;
+    GLsync fences[REGIONS] = {};
+
+    // regions start at multiples of 256 bytes, which satisfies every offset alignment GL asks for
+    void reserve(GLsizeiptr size)
+    {
+        regionSize = std::max<GLsizeiptr>((size + 255) / 256 * 256, regionSize * 2);
+        release();
+        if (GLAD_GL_VERSION_4_4)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            storageBuffer.storage(regionSize * REGIONS, nullptr, flags);
+            mapped = static_cast<char *>(storageBuffer.mapRange(0, regionSize * REGIONS, flags));
+        }
+        else
+            storageBuffer.storage(regionSize * REGIONS, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    static void wait(GLsync &fence)
+    {
+        static MetricCounter &stalls = metrics().counter("gl_stream_buffer_stalls_total", "Stream buffer writes that waited for the GPU");
+        if (!fence)
+            return;
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            stalls.add();
+            do
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            while (result == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    // a deleted buffer lives on until the GPU is done with it, so nothing has to be waited for
+    void release()
+    {
+        for (GLsync &fence : fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+        mapped = nullptr;
+        current = 0;
+        written = false;
+    }
+};
+
+// ------------------------------------------------------------------------
+// vertex layout in the GL 4.3+ form: attributes read from binding points, vertex buffers are attached
+// to binding points. On contexts without DSA the layout is recorded and every attribute is specified
+// with glVertexAttribPointer as soon as both its format and its buffer are known.
+class GLVertexArray
+{
+public:
+    GLVertexArray() = default;
+    ~GLVertexArray()
+    {
+        release();
+    }
+    GLVertexArray(GLVertexArray &&other) noexcept
+        : name(other.name), bindings(std::move(other.bindings)), attributes(std::move(other.attributes))
+    {
+        other.name = 0;
+    }
+    GLVertexArray &operator=(GLVertexArray &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            std::swap(name, other.name);
+            bindings.swap(other.bindings);
+            attributes.swap(other.attributes);
+        }
+        return *this;
+    }
+    GLVertexArray(const GLVertexArray &) = delete;
+    GLVertexArray &operator=(const GLVertexArray &) = delete;
+
+    // (re-)creates an empty vertex array
+    void create()
+    {
+        release();
+        glCallStats().created++;
+        if (glHasDirectStateAccess())
+            glCreateVertexArrays(1, &name);
+        else
+            glGenVertexArrays(1, &name);
+    }
+
+    void vertexBuffer(GLuint binding, const GLBuffer &buffer, GLintptr offset, GLsizei stride)
+    {
+        if (glHasDirectStateAccess())
+        {
+            glVertexArrayVertexBuffer(name, binding, buffer.id(), offset, stride);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        Binding &b = bindingAt(binding);
+        b.buffer = buffer.id();
+        b.offset = offset;
+        b.stride = stride;
+        specifyLegacy(binding);
+    }
+
+    void elementBuffer(const GLBuffer &buffer)
+    {
+        if (glHasDirectStateAccess())
+        {
+            glVertexArrayElementBuffer(name, buffer.id());
+            glCallStats().dsaCalls++;
+            return;
+        }
+        glBindVertexArray(name);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.id());
+        glBindVertexArray(0);
+        glCallStats().binds += 3;
+    }
+
+    // floating point attribute (normalized fixed point if requested)
+    void attribute(GLuint location, GLuint binding, GLint size, GLenum type, GLuint relativeOffset, GLboolean normalized = GL_FALSE)
+    {
+        setAttribute(location, binding, size, type, relativeOffset, normalized, false);
+    }
+
+    // integer attribute, read as int/ivec in the shader
+    void attributeI(GLuint location, GLuint binding, GLint size, GLenum type, GLuint relativeOffset)
+    {
+        setAttribute(location, binding, size, type, relativeOffset, GL_FALSE, true);
+    }
+
+    // 0 = per vertex, n = advance once every n instances
+    void bindingDivisor(GLuint binding, GLuint divisor)
+    {
+        if (glHasDirectStateAccess())
+        {
+            glVertexArrayBindingDivisor(name, binding, divisor);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        bindingAt(binding).divisor = divisor;
+        specifyLegacy(binding);
+    }
+
+    void bind() const
+    {
+        glBindVertexArray(name);
+        glCallStats().binds++;
+    }
+
+    unsigned int id() const
+    {
+        return name;
+    }
+
+private:
+    struct Binding
+    {
+        unsigned int buffer = 0;
+        GLintptr offset = 0;
+        GLsizei stride = 0;
+        GLuint divisor = 0;
+    };
+    struct Attribute
+    {
+        GLuint location;
+        GLuint binding;
+        GLint size;
+        GLenum type;
+        GLuint relativeOffset;
+        GLboolean normalized;
+        bool integer;
+    };
+
+    unsigned int name = 0;
+    // only used without DSA
+    std::vector<Binding> bindings;
+    std::vector<Attribute> attributes;
+
+    void release()
+    {
+        if (name)
+            glDeleteVertexArrays(1, &name);
+        name = 0;
+        bindings.clear();
+        attributes.clear();
+    }
+
+    Binding &bindingAt(GLuint binding)
+    {
+        if (binding >= bindings.size())
+            bindings.resize(binding + 1);
+        return bindings[binding];
+    }
+
+    void setAttribute(GLuint location, GLuint binding, GLint size, GLenum type, GLuint relativeOffset, GLboolean normalized, bool integer)
+    {
+        if (glHasDirectStateAccess())
+        {
+            glEnableVertexArrayAttrib(name, location);
+            if (integer)
+                glVertexArrayAttribIFormat(name, location, size, type, relativeOffset);
+            else
+                glVertexArrayAttribFormat(name, location, size, type, normalized, relativeOffset);
+            glVertexArrayAttribBinding(name, location, binding);
+            glCallStats().dsaCalls += 3;
+            return;
+        }
+        attributes.erase(std::remove_if(attributes.begin(), attributes.end(), [location](const Attribute &a) { return a.location == location; }), attributes.end());
+        attributes.push_back({ location, binding, size, type, relativeOffset, normalized, integer });
+        bindingAt(binding);
+        specifyLegacy(binding);
+    }
+
+    // re-specifies every attribute reading from the given binding whose buffer is already known
+    void specifyLegacy(GLuint binding)
+    {
+        const Binding &b = bindings[binding];
+        if (b.buffer == 0)
+            return;
+        bool bound = false;
+        for (const Attribute &a : attributes)
+        {
+            if (a.binding != binding)
+                continue;
+            if (!bound)
+            {
+                glBindVertexArray(name);
+                glBindBuffer(GL_ARRAY_BUFFER, b.buffer);
+                glCallStats().binds += 2;
+                bound = true;
+            }
+            const void *pointer = reinterpret_cast<const void *>(b.offset + a.relativeOffset);
+            if (a.integer)
+                glVertexAttribIPointer(a.location, a.size, a.type, b.stride, pointer);
+            else
+                glVertexAttribPointer(a.location, a.size, a.type, a.normalized, b.stride, pointer);
+            glVertexAttribDivisor(a.location, b.divisor);
+            glEnableVertexAttribArray(a.location);
+        }
+        if (bound)
+        {
+            glBindVertexArray(0);
+            glCallStats().binds++;
+        }
+    }
+};
+
+// ------------------------------------------------------------------------
+class GLTexture
+{
+public:
+    GLTexture() = default;
+    ~GLTexture()
+    {
+        release();
+    }
+    GLTexture(GLTexture &&other) noexcept : name(other.name), target(other.target)
+    {
+        other.name = 0;
+    }
+    GLTexture &operator=(GLTexture &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            std::swap(name, other.name);
+            std::swap(target, other.target);
+        }
+        return *this;
+    }
+    GLTexture(const GLTexture &) = delete;
+    GLTexture &operator=(const GLTexture &) = delete;
+
+    // (re-)creates the texture object without any storage yet (TextureLoader fills it in later)
+    void create(GLenum textureTarget)
+    {
+        release();
+        target = textureTarget;
+        glCallStats().created++;
+        if (glHasDirectStateAccess())
+            glCreateTextures(target, 1, &name);
+        else
+            glGenTextures(1, &name);
+    }
+
+    // (re-)creates the texture with immutable storage; target is GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+    void storage2D(GLenum textureTarget, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height)
+    {
+        release();
+        target = textureTarget;
+        GLCallStats &stats = glCallStats();
+        stats.created++;
+        if (glHasDirectStateAccess())
+        {
+            glCreateTextures(target, 1, &name);
+            glTextureStorage2D(name, levels, internalFormat, width, height);
+            stats.dsaCalls++;
+            return;
+        }
+        glGenTextures(1, &name);
+        glBindTexture(target, name);
+        stats.binds++;
+        if (GLAD_GL_VERSION_4_2)
+        {
+            glTexStorage2D(target, levels, internalFormat, width, height);
+            return;
+        }
+        // no immutable storage before 4.2: specify every level (and face) with matching formats instead
+        GLenum format = GL_RGBA, type = GL_UNSIGNED_BYTE;
+        if (internalFormat == GL_DEPTH_COMPONENT || internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24 || internalFormat == GL_DEPTH_COMPONENT32F)
+            format = GL_DEPTH_COMPONENT, type = GL_FLOAT;
+        else if (internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH_STENCIL)
+            format = GL_DEPTH_STENCIL, type = GL_UNSIGNED_INT_24_8;
+        else if (internalFormat == GL_R32UI)
+            format = GL_RED_INTEGER, type = GL_UNSIGNED_INT;
+        const unsigned int faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+        for (GLsizei level = 0; level < levels; ++level)
+        {
+            for (unsigned int face = 0; face < faces; ++face)
+            {
+                const GLenum imageTarget = faces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+                glTexImage2D(imageTarget, level, internalFormat, std::max(1, width >> level), std::max(1, height >> level), 0, format, type, nullptr);
+            }
+        }
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+
+    // (re-)creates a GL_TEXTURE_3D with immutable storage
+    void storage3D(GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei depth)
+    {
+        release();
+        target = GL_TEXTURE_3D;
+        GLCallStats &stats = glCallStats();
+        stats.created++;
+        if (glHasDirectStateAccess())
+        {
+            glCreateTextures(target, 1, &name);
+            glTextureStorage3D(name, levels, internalFormat, width, height, depth);
+            stats.dsaCalls++;
+            return;
+        }
+        glGenTextures(1, &name);
+        glBindTexture(target, name);
+        stats.binds++;
+        if (GLAD_GL_VERSION_4_2)
+        {
+            glTexStorage3D(target, levels, internalFormat, width, height, depth);
+            return;
+        }
+        for (GLsizei level = 0; level < levels; ++level)
+            glTexImage3D(target, level, internalFormat, std::max(1, width >> level), std::max(1, height >> level), std::max(1, depth >> level), 0,
+                         GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+
+    // uploads one level of a 2D texture, or of cube map face `face` (0 = +X ... 5 = -Z)
+    void subImage2D(GLint level, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels, unsigned int face = 0)
+    {
+        glUploadedBytes().add((size_t)width * height * glPixelSize(format, type));
+        if (glHasDirectStateAccess())
+        {
+            if (target == GL_TEXTURE_CUBE_MAP)
+                glTextureSubImage3D(name, level, 0, 0, face, width, height, 1, format, type, pixels);
+            else
+                glTextureSubImage2D(name, level, 0, 0, width, height, format, type, pixels);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        bindForEdit();
+        const GLenum imageTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+        glTexSubImage2D(imageTarget, level, 0, 0, width, height, format, type, pixels);
+    }
+
+    // uploads a rectangle of one level of a 2D texture
+    void subImage2D(GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels)
+    {
+        glUploadedBytes().add((size_t)width * height * glPixelSize(format, type));
+        if (glHasDirectStateAccess())
+        {
+            glTextureSubImage2D(name, level, x, y, width, height, format, type, pixels);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        bindForEdit();
+        glTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+    }
+
+    // uploads one whole level of a 3D texture
+    void subImage3D(GLint level, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels)
+    {
+        glUploadedBytes().add((size_t)width * height * depth * glPixelSize(format, type));
+        if (glHasDirectStateAccess())
+        {
+            glTextureSubImage3D(name, level, 0, 0, 0, width, height, depth, format, type, pixels);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        bindForEdit();
+        glTexSubImage3D(target, level, 0, 0, 0, width, height, depth, format, type, pixels);
+    }
+
+    void parameter(GLenum pname, GLint value)
+    {
+        if (glHasDirectStateAccess())
+        {
+            glTextureParameteri(name, pname, value);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        bindForEdit();
+        glTexParameteri(target, pname, value);
+    }
+
+    void generateMipmap()
+    {
+        if (glHasDirectStateAccess())
+        {
+            glGenerateTextureMipmap(name);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        bindForEdit();
+        glGenerateMipmap(target);
+    }
+
+    // binds the texture to texture unit `unit` (GL_TEXTURE0 + unit)
+    void bindUnit(GLuint unit) const
+    {
+        if (glHasDirectStateAccess())
+        {
+            glBindTextureUnit(unit, name);
+        }
+        else
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(target, name);
+        }
+        glCallStats().binds++;
+    }
+
+    unsigned int id() const
+    {
+        return name;
+    }
+
+private:
+    unsigned int name = 0;
+    GLenum target = GL_TEXTURE_2D;
+
+    void release()
+    {
+        if (name)
+            glDeleteTextures(1, &name);
+        name = 0;
+    }
+
+    void bindForEdit() const
+    {
+        glBindTexture(target, name);
+        glCallStats().binds++;
+    }
+};
+
+// mipmapped 2D texture with repeat wrapping and trilinear filtering from 8 bit pixels with 1 to 4
+// components; srgb stores color data as sRGB (grey+alpha stays linear, there is no sRGB RG format).
+// Any other component count is reported and gives an empty texture
+inline GLTexture TextureFromPixels(const unsigned char *pixels, int width, int height, int components, bool srgb = false)
+{
+    GLenum format, internalFormat;
+    if (components == 1)
+        format = GL_RED, internalFormat = GL_R8;
+    else if (components == 2)
+        format = GL_RG, internalFormat = GL_RG8;
+    else if (components == 3)
+        format = GL_RGB, internalFormat = srgb ? GL_SRGB8 : GL_RGB8;
+    else if (components == 4)
+        format = GL_RGBA, internalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    else
+    {
+        std::cout << "ERROR::TEXTURE:: Unsupported number of components: " << components << std::endl;
+        return GLTexture();
+    }
+
+    // immutable storage for the full mip chain, then upload level 0 and let GL fill in the rest
+    GLsizei levels = 1;
+    while ((std::max(width, height) >> levels) > 0)
+        levels++;
+    GLTexture texture;
+    texture.storage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows of RG and RGB images aren't 4 byte aligned
+    texture.subImage2D(0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    texture.generateMipmap();
+
+    texture.parameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+    texture.parameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
+    texture.parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    texture.parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return texture;
+}
+
+// ------------------------------------------------------------------------
+class GLFramebuffer
+{
+public:
+    GLFramebuffer() = default;
+    ~GLFramebuffer()
+    {
+        release();
+    }
+    GLFramebuffer(GLFramebuffer &&other) noexcept : name(other.name)
+    {
+        other.name = 0;
+    }
+    GLFramebuffer &operator=(GLFramebuffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            std::swap(name, other.name);
+        }
+        return *this;
+    }
+    GLFramebuffer(const GLFramebuffer &) = delete;
+    GLFramebuffer &operator=(const GLFramebuffer &) = delete;
+
+    void create()
+    {
+        release();
+        glCallStats().created++;
+        if (glHasDirectStateAccess())
+            glCreateFramebuffers(1, &name);
+        else
+            glGenFramebuffers(1, &name);
+    }
+
+    // attaches a whole texture level (all faces of a cube map, i.e. a layered attachment)
+    void texture(GLenum attachment, const GLTexture &texture, GLint level = 0)
+    {
+        if (glHasDirectStateAccess())
+        {
+            glNamedFramebufferTexture(name, attachment, texture.id(), level);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        bindForEdit();
+        glFramebufferTexture(GL_FRAMEBUFFER, attachment, texture.id(), level);
+        unbindAfterEdit();
+    }
+
+    void drawBuffers(GLsizei count, const GLenum *buffers)
+    {
+        if (glHasDirectStateAccess())
+        {
+            glNamedFramebufferDrawBuffers(name, count, buffers);
+            glCallStats().dsaCalls++;
+            return;
+        }
+        bindForEdit();
+        glDrawBuffers(count, buffers);
+        unbindAfterEdit();
+    }
+
+    // depth-only framebuffers: no color buffer is drawn or read
+    void noColorBuffer()
+    {
+        if (glHasDirectStateAccess())
+        {
+            glNamedFramebufferDrawBuffer(name, GL_NONE);
+            glNamedFramebufferReadBuffer(name, GL_NONE);
+            glCallStats().dsaCalls += 2;
+            return;
+        }
+        bindForEdit();
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        unbindAfterEdit();
+    }
+
+    // prints an error and returns false if the framebuffer can't be rendered to
+    bool checkComplete() const
+    {
+        GLenum status;
+        if (glHasDirectStateAccess())
+        {
+            status = glCheckNamedFramebufferStatus(name, GL_FRAMEBUFFER);
+            glCallStats().dsaCalls++;
+        }
+        else
+        {
+            bindForEdit();
+            status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+            unbindAfterEdit();
+        }
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete! (0x" << std::hex << status << std::dec << ")" << std::endl;
+        return status == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    void bind(GLenum target = GL_FRAMEBUFFER) const
+    {
+        glBindFramebuffer(target, name);
+        glCallStats().binds++;
+    }
+
+    unsigned int id() const
+    {
+        return name;
+    }
+
+private:
+    unsigned int name = 0;
+
+    void release()
+    {
+        if (name)
+            glDeleteFramebuffers(1, &name);
+        name = 0;
+    }
+
+    void bindForEdit() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, name);
+        glCallStats().binds++;
+    }
+
+    void unbindAfterEdit() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glCallStats().binds++;
+    }
+};
+#endif
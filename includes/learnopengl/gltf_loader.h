@@ -0,0 +1,958 @@
+#ifndef GLTF_LOADER_H
+#define GLTF_LOADER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/gl_resources.h>
+#include <learnopengl/animdata.h>
+#include <learnopengl/metrics.h>
+#include <learnopengl/mapped_file.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+// Loader for binary glTF 2.0 (.glb) files that skips Assimp. The file is memory mapped and every
+// buffer view holding vertex or index data is uploaded to a GL buffer of its own straight from the
+// mapping; the vertex arrays then read the accessors in place, whatever their component types and
+// strides, since glTF's vertex formats are all formats GL can read. Only what GL can't read as is gets
+// converted on the CPU: sparse accessors, accessors without buffer view, joint indices that need
+// remapping to bone ids, and the bitangents the Mesh layout wants next to glTF's signed tangents.
+//
+// Attributes land where Mesh puts them (0 position, 1 normal, 2 uv, 3 tangent, 4 bitangent, 5 bone ids,
+// 6 weights), materials become texture_diffuse (base color), texture_specular (metallic-roughness)
+// and texture_normal, and skins fill a BoneInfo map the way Model (model_animation.h) does, so
+// Animation works on the result. Like the Assimp path in Model, node transforms are not applied.
+// Texture coordinates are used as stored, which is right for images decoded without
+// stbi_set_flip_vertically_on_load.
+//
+// Model uses this for every path ending in .glb; loadGlb() can also be called directly. Loading has a
+// CPU half, import(), which maps and parses the file and decodes the images on any thread (ModelLoader
+// runs it on its workers), and a GL half, upload(), for the GL thread.
+
+// just enough JSON for glTF: a parsed value tree, where a missing key or index reads as null
+class GltfJson
+{
+public:
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    // parses [begin, end); on failure returns false and says where in `error`
+    static bool parse(const char *begin, const char *end, GltfJson &result, std::string &error)
+    {
+        Parser parser{ begin, begin, end, error };
+        if (!parser.value(result, 0))
+            return false;
+        parser.skipSpace();
+        if (parser.at != end)
+            return parser.fail("trailing characters");
+        return true;
+    }
+
+    Type type() const { return kind; }
+    bool isNull() const { return kind == NUL; }
+    size_t size() const { return items.size(); }
+
+    const GltfJson &operator[](size_t index) const
+    {
+        return kind == ARRAY && index < items.size() ? items[index] : null();
+    }
+    const GltfJson &operator[](const char *key) const
+    {
+        if (kind == OBJECT)
+            for (size_t i = 0; i < keys.size(); i++)
+                if (keys[i] == key)
+                    return items[i];
+        return null();
+    }
+
+    double number(double fallback = 0.0) const { return kind == NUMBER ? value : fallback; }
+    int integer(int fallback = -1) const { return kind == NUMBER ? (int)value : fallback; }
+    size_t offset() const { return kind == NUMBER ? (size_t)value : 0; }
+    bool boolean(bool fallback = false) const { return kind == BOOLEAN ? value != 0.0 : fallback; }
+    const std::string &string() const { return text; }
+
+private:
+    Type kind = NUL;
+    double value = 0.0;
+    std::string text;
+    std::vector<GltfJson> items;   // array elements, or object values
+    std::vector<std::string> keys; // object keys, parallel to items
+
+    static const GltfJson &null()
+    {
+        static const GltfJson none;
+        return none;
+    }
+
+    struct Parser
+    {
+        const char *begin, *at, *end;
+        std::string &error;
+
+        bool fail(const char *what)
+        {
+            error = std::string(what) + " at byte " + std::to_string(at - begin);
+            return false;
+        }
+
+        void skipSpace()
+        {
+            while (at < end && (*at == ' ' || *at == '\t' || *at == '\n' || *at == '\r'))
+                at++;
+        }
+
+        bool literal(const char *word)
+        {
+            const size_t length = std::strlen(word);
+            if ((size_t)(end - at) < length || std::strncmp(at, word, length) != 0)
+                return fail("invalid literal");
+            at += length;
+            return true;
+        }
+
+        bool value(GltfJson &out, int depth)
+        {
+            if (depth > 64)
+                return fail("nesting too deep");
+            skipSpace();
+            if (at == end)
+                return fail("unexpected end");
+            switch (*at)
+            {
+            case '{':
+                out.kind = OBJECT;
+                return members(out, depth);
+            case '[':
+                out.kind = ARRAY;
+                return elements(out, depth);
+            case '"':
+                out.kind = STRING;
+                return string(out.text);
+            case 't':
+                out.kind = BOOLEAN, out.value = 1.0;
+                return literal("true");
+            case 'f':
+                out.kind = BOOLEAN, out.value = 0.0;
+                return literal("false");
+            case 'n':
+                out.kind = NUL;
+                return literal("null");
+            default:
+                return number(out);
+            }
+        }
+
+        bool members(GltfJson &out, int depth)
+        {
+            at++; // {
+            skipSpace();
+            if (at < end && *at == '}')
+                return ++at, true;
+            for (;;)
+            {
+                skipSpace();
+                out.keys.emplace_back();
+                if (at == end || *at != '"' || !string(out.keys.back()))
+                    return fail("expected a key");
+                skipSpace();
+                if (at == end || *at++ != ':')
+                    return fail("expected ':'");
+                out.items.emplace_back();
+                if (!value(out.items.back(), depth + 1))
+                    return false;
+                skipSpace();
+                if (at < end && *at == ',')
+                {
+                    at++;
+                    continue;
+                }
+                if (at < end && *at == '}')
+                    return ++at, true;
+                return fail("expected ',' or '}'");
+            }
+        }
+
+        bool elements(GltfJson &out, int depth)
+        {
+            at++; // [
+            skipSpace();
+            if (at < end && *at == ']')
+                return ++at, true;
+            for (;;)
+            {
+                out.items.emplace_back();
+                if (!value(out.items.back(), depth + 1))
+                    return false;
+                skipSpace();
+                if (at < end && *at == ',')
+                {
+                    at++;
+                    continue;
+                }
+                if (at < end && *at == ']')
+                    return ++at, true;
+                return fail("expected ',' or ']'");
+            }
+        }
+
+        bool number(GltfJson &out)
+        {
+            char *stop = nullptr;
+            // strtod stops at the end of the number; the chunk is followed by padding or other chunks, never unterminated
+            const std::string digits(at, std::min<size_t>(end - at, 64));
+            out.kind = NUMBER;
+            out.value = std::strtod(digits.c_str(), &stop);
+            if (stop == digits.c_str())
+                return fail("invalid value");
+            at += stop - digits.c_str();
+            return true;
+        }
+
+        bool string(std::string &out)
+        {
+            at++; // "
+            while (at < end && *at != '"')
+            {
+                if (*at != '\\')
+                {
+                    out += *at++;
+                    continue;
+                }
+                if (++at == end)
+                    break;
+                const char escaped = *at++;
+                switch (escaped)
+                {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u':
+                {
+                    unsigned long code = 0;
+                    if (!hex(code))
+                        return false;
+                    // surrogate pair
+                    if (code >= 0xD800 && code < 0xDC00 && end - at >= 6 && at[0] == '\\' && at[1] == 'u')
+                    {
+                        unsigned long low = 0;
+                        at += 2;
+                        if (!hex(low))
+                            return false;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    utf8(code, out);
+                    break;
+                }
+                default: out += escaped; break; // \" \\ \/
+                }
+            }
+            if (at == end)
+                return fail("unterminated string");
+            at++; // "
+            return true;
+        }
+
+        bool hex(unsigned long &code)
+        {
+            if (end - at < 4)
+                return fail("invalid escape");
+            const std::string digits(at, 4);
+            char *stop = nullptr;
+            code = std::strtoul(digits.c_str(), &stop, 16);
+            if (stop != digits.c_str() + 4)
+                return fail("invalid escape");
+            at += 4;
+            return true;
+        }
+
+        static void utf8(unsigned long code, std::string &out)
+        {
+            if (code < 0x80)
+                out += (char)code;
+            else if (code < 0x800)
+                out += (char)(0xC0 | (code >> 6)), out += (char)(0x80 | (code & 0x3F));
+            else if (code < 0x10000)
+                out += (char)(0xE0 | (code >> 12)), out += (char)(0x80 | ((code >> 6) & 0x3F)), out += (char)(0x80 | (code & 0x3F));
+            else
+                out += (char)(0xF0 | (code >> 18)), out += (char)(0x80 | ((code >> 12) & 0x3F)), out += (char)(0x80 | ((code >> 6) & 0x3F)), out += (char)(0x80 | (code & 0x3F));
+        }
+    };
+};
+
+// what loading a .glb produces; Model moves these into its own members
+struct GlbModel
+{
+    std::vector<Mesh> meshes;
+    std::vector<Texture> textures;          // one per glTF texture in use, in order of first use
+    std::vector<GLTexture> textureObjects;  // owns the GL textures of `textures`
+    std::vector<GLBuffer> buffers;          // vertex and index data the meshes read
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+class GlbLoader
+{
+public:
+    // loads `path` into `result`; with `bones`, skins are added to it (ids counted by `boneCount`) and
+    // vertices carry bone ids and weights. Returns false (and logs) if the file can't be used.
+    static bool load(const std::string &path, GlbModel &result, bool gamma = false,
+                     std::map<std::string, BoneInfo> *bones = nullptr, int *boneCount = nullptr)
+    {
+        GlbLoader loader(path, gamma, bones, boneCount);
+        if (!loader.import())
+            return false;
+        loader.upload(result);
+        return true;
+    }
+
+    GlbLoader(const std::string &path, bool gamma = false, std::map<std::string, BoneInfo> *bones = nullptr, int *boneCount = nullptr)
+        : path(path), directory(path.substr(0, path.find_last_of('/'))), gamma(gamma), bones(bones), boneCount(boneCount),
+          start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~GlbLoader()
+    {
+        for (Image &image : images)
+            stbi_image_free(image.pixels);
+    }
+
+    GlbLoader(const GlbLoader &) = delete;
+    GlbLoader &operator=(const GlbLoader &) = delete;
+
+    // the CPU half: maps the file, parses it and decodes the images the textures use; no GL calls,
+    // so any thread will do. Returns false (and logs) if the file can't be used.
+    bool import()
+    {
+        if (!open())
+            return false;
+        const GltfJson &textures = json["textures"];
+        images.resize(json["images"].size());
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            const int image = textures[i]["source"].integer();
+            if (image >= 0 && image < (int)images.size() && !images[image].decoded)
+                decodeImage(image);
+        }
+        return true;
+    }
+
+    // the GL half, after import() succeeded: uploads the buffer views and textures and builds the meshes
+    void upload(GlbModel &model)
+    {
+        static MetricCounter &models = metrics().counter("loader_models_total", "Models loaded");
+        static MetricHistogram &loadTime = metrics().histogram("loader_glb_seconds", "Load time per .glb model, without Assimp",
+                                                               { 0.01, 0.05, 0.1, 0.5, 1.0, 5.0 });
+        loadScene();
+        model = std::move(result);
+
+        models.add();
+        loadTime.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    // Mesh's attribute locations; every attribute reads from its own binding, above the ones Mesh uses
+    enum Location { POSITION = 0, NORMAL, TEXCOORD, TANGENT, BITANGENT, BONE_IDS, WEIGHTS };
+    static constexpr GLuint FIRST_BINDING = 2;
+
+    struct View
+    {
+        const unsigned char *data = nullptr;
+        size_t length = 0;
+        size_t stride = 0;
+        int buffer = -1; // index into result.buffers once uploaded
+    };
+
+    // decoded by import(), uploaded by upload()
+    struct Image
+    {
+        unsigned char *pixels = nullptr;
+        int width = 0, height = 0, components = 0;
+        bool decoded = false;
+    };
+
+    std::string path;
+    std::string directory;
+    GlbModel result;
+    bool gamma;
+    std::map<std::string, BoneInfo> *bones;
+    int *boneCount;
+    std::chrono::steady_clock::time_point start;
+
+    MappedFile file;
+    std::vector<std::unique_ptr<MappedFile>> externalFiles;
+    GltfJson json;
+    std::vector<std::pair<const unsigned char *, size_t>> bufferData;
+    std::vector<View> views;
+    std::vector<int> textureSlots;                       // glTF texture -> index into result.textures, -1 until used
+    std::map<std::pair<int, int>, int> converted;        // (accessor, meaning) -> converted buffer
+    std::map<std::pair<int, int>, int> bitangentBuffers; // (normal, tangent accessor) -> computed buffer
+    std::vector<std::vector<int>> jointRemap;            // per skin: joint -> bone id
+    std::vector<Image> images;                           // per glTF image
+
+    bool error(const std::string &message)
+    {
+        std::cout << "ERROR::GLB:: " << path << ": " << message << std::endl;
+        return false;
+    }
+
+    static uint32_t readU32(const unsigned char *bytes)
+    {
+        return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+    }
+
+    // header, JSON chunk, binary chunk
+    bool open()
+    {
+        if (!file.open(path))
+            return error("can't open file");
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(file.data());
+        const size_t size = file.size();
+        if (size < 20 || readU32(bytes) != 0x46546C67 /* glTF */)
+            return error("not a binary glTF file");
+        if (readU32(bytes + 4) != 2)
+            return error("unsupported glTF version " + std::to_string(readU32(bytes + 4)));
+        const size_t total = std::min<size_t>(readU32(bytes + 8), size);
+
+        const unsigned char *binary = nullptr;
+        size_t binaryLength = 0;
+        bool haveJson = false;
+        for (size_t at = 12; at + 8 <= total;)
+        {
+            const size_t length = readU32(bytes + at);
+            const uint32_t type = readU32(bytes + at + 4);
+            const unsigned char *chunk = bytes + at + 8;
+            if (length > total - at - 8)
+                return error("truncated chunk");
+            if (type == 0x4E4F534A /* JSON */ && !haveJson)
+            {
+                std::string message;
+                if (!GltfJson::parse(reinterpret_cast<const char *>(chunk), reinterpret_cast<const char *>(chunk) + length, json, message))
+                    return error("invalid JSON, " + message);
+                haveJson = true;
+            }
+            else if (type == 0x004E4942 /* BIN */ && !binary)
+            {
+                binary = chunk;
+                binaryLength = length;
+            }
+            at += 8 + ((length + 3) & ~size_t(3));
+        }
+        if (!haveJson)
+            return error("no JSON chunk");
+
+        // buffer 0 without uri is the binary chunk, others are external files
+        const GltfJson &buffers = json["buffers"];
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            const std::string &uri = buffers[i]["uri"].string();
+            if (uri.empty())
+            {
+                bufferData.emplace_back(binary, binary ? std::min(binaryLength, buffers[i]["byteLength"].offset()) : 0);
+                continue;
+            }
+            if (uri.compare(0, 5, "data:") == 0)
+            {
+                error("data URIs are not supported, buffer " + std::to_string(i) + " is left empty");
+                bufferData.emplace_back(nullptr, 0);
+                continue;
+            }
+            externalFiles.emplace_back(new MappedFile(directory + '/' + uri));
+            if (!externalFiles.back()->isOpen())
+                error("can't open buffer " + uri);
+            bufferData.emplace_back(reinterpret_cast<const unsigned char *>(externalFiles.back()->data()), externalFiles.back()->size());
+        }
+
+        const GltfJson &bufferViews = json["bufferViews"];
+        views.resize(bufferViews.size());
+        for (size_t i = 0; i < views.size(); i++)
+        {
+            const GltfJson &view = bufferViews[i];
+            const int buffer = view["buffer"].integer();
+            const size_t offset = view["byteOffset"].offset(), length = view["byteLength"].offset();
+            if (buffer < 0 || buffer >= (int)bufferData.size() || !bufferData[buffer].first || offset + length > bufferData[buffer].second)
+                continue; // accessors on it read zeros
+            views[i].data = bufferData[buffer].first + offset;
+            views[i].length = length;
+            views[i].stride = view["byteStride"].offset();
+        }
+        textureSlots.assign(json["textures"].size(), -1);
+        return true;
+    }
+
+    void loadScene()
+    {
+        static MetricCounter &meshCount = metrics().counter("loader_meshes_total", "Meshes loaded by Model");
+
+        loadSkins();
+
+        // meshes are instantiated per node referencing them, like Assimp does
+        const GltfJson &scenes = json["scenes"];
+        const GltfJson &scene = scenes[(size_t)std::max(0, json["scene"].integer(0))];
+        bool first = true;
+        std::vector<int> stack;
+        if (scene.isNull())
+            for (size_t i = 0; i < json["nodes"].size(); i++)
+                stack.push_back((int)i);
+        else
+            for (size_t i = scene["nodes"].size(); i-- > 0;)
+                stack.push_back(scene["nodes"][i].integer());
+        // glTF nodes form trees, so a node seen twice (a cycle through children) or out of range means a
+        // malformed file; such nodes are skipped, which also keeps the walk finite
+        std::vector<char> visited(json["nodes"].size());
+        while (!stack.empty())
+        {
+            const int nodeIndex = stack.back();
+            stack.pop_back();
+            if (nodeIndex < 0 || nodeIndex >= (int)visited.size() || visited[nodeIndex])
+                continue;
+            visited[nodeIndex] = 1;
+            const GltfJson &node = json["nodes"][(size_t)nodeIndex];
+            const GltfJson &mesh = json["meshes"][(size_t)node["mesh"].integer()];
+            const GltfJson &primitives = mesh["primitives"];
+            for (size_t i = 0; i < primitives.size(); i++)
+            {
+                if (loadPrimitive(primitives[i], node["skin"].integer(), first))
+                    meshCount.add();
+            }
+            if (scene.isNull())
+                continue; // every node is visited anyway
+            const GltfJson &children = node["children"];
+            for (size_t i = children.size(); i-- > 0;)
+                stack.push_back(children[i].integer());
+        }
+    }
+
+    // bone ids for every joint of every skin; a new bone gets the next id and its inverse bind matrix
+    void loadSkins()
+    {
+        if (!bones)
+            return;
+        const GltfJson &skins = json["skins"];
+        jointRemap.resize(skins.size());
+        for (size_t s = 0; s < skins.size(); s++)
+        {
+            const GltfJson &joints = skins[s]["joints"];
+            std::vector<float> inverseBind;
+            const int matrices = skins[s]["inverseBindMatrices"].integer();
+            if (matrices >= 0)
+                readFloats(json["accessors"][(size_t)matrices], 16, inverseBind);
+            for (size_t j = 0; j < joints.size(); j++)
+            {
+                const int node = joints[j].integer();
+                const std::string name = nodeName(node);
+                auto bone = bones->find(name);
+                if (bone == bones->end())
+                {
+                    BoneInfo info;
+                    info.id = (*boneCount)++;
+                    info.offset = inverseBind.size() >= (j + 1) * 16 ? glm::make_mat4(&inverseBind[j * 16]) : glm::mat4(1.0f);
+                    bone = bones->emplace(name, info).first;
+                }
+                jointRemap[s].push_back(bone->second.id);
+            }
+        }
+    }
+
+    // Assimp's names for glTF nodes, so animations imported through it find the bones
+    std::string nodeName(int node) const
+    {
+        const std::string &name = json["nodes"][(size_t)node]["name"].string();
+        return name.empty() ? "nodes_" + std::to_string(node) : name;
+    }
+
+    bool loadPrimitive(const GltfJson &primitive, int skin, bool &first)
+    {
+        static MetricCounter &vertexCount = metrics().counter("loader_vertices_total", "Vertices loaded by Model");
+        if (primitive["mode"].integer(4) != 4)
+        {
+            error("skipping a primitive that isn't a triangle list");
+            return false;
+        }
+        const GltfJson &attributes = primitive["attributes"];
+        const GltfJson &accessors = json["accessors"];
+        const GltfJson &position = accessors[(size_t)attributes["POSITION"].integer()];
+        if (position.isNull())
+        {
+            error("skipping a primitive without positions");
+            return false;
+        }
+        const GLsizei vertices = (GLsizei)position["count"].offset();
+        vertexCount.add(vertices);
+
+        // positions have min and max by the spec
+        glm::vec3 low, high;
+        for (int c = 0; c < 3; c++)
+        {
+            low[c] = (float)position["min"][(size_t)c].number(0.0);
+            high[c] = (float)position["max"][(size_t)c].number(0.0);
+        }
+        result.boundsMin = first ? low : glm::min(result.boundsMin, low);
+        result.boundsMax = first ? high : glm::max(result.boundsMax, high);
+        first = false;
+
+        GLVertexArray vao;
+        vao.create();
+        attribute(vao, POSITION, attributes["POSITION"].integer());
+        attribute(vao, NORMAL, attributes["NORMAL"].integer());
+        attribute(vao, TEXCOORD, attributes["TEXCOORD_0"].integer());
+        attribute(vao, TANGENT, attributes["TANGENT"].integer());
+        if (!attributes["TANGENT"].isNull() && !attributes["NORMAL"].isNull())
+            bitangents(vao, attributes["NORMAL"].integer(), attributes["TANGENT"].integer());
+        if (bones && skin >= 0 && skin < (int)jointRemap.size() && !attributes["JOINTS_0"].isNull())
+        {
+            joints(vao, attributes["JOINTS_0"].integer(), skin);
+            attribute(vao, WEIGHTS, attributes["WEIGHTS_0"].integer());
+        }
+        else if (bones)
+            unskinned(vao, vertices);
+
+        // indices
+        GLsizei count = vertices;
+        GLenum indexType = 0;
+        GLintptr indexOffset = 0;
+        const int indexAccessor = primitive["indices"].integer();
+        if (indexAccessor >= 0)
+        {
+            const GltfJson &indices = accessors[(size_t)indexAccessor];
+            count = (GLsizei)indices["count"].offset();
+            if (inPlace(indexAccessor, 1))
+            {
+                vao.elementBuffer(viewBuffer(indices["bufferView"].integer()));
+                indexType = (GLenum)indices["componentType"].integer();
+                indexOffset = (GLintptr)indices["byteOffset"].offset();
+            }
+            else
+            {
+                std::vector<float> values;
+                readFloats(indices, 1, values);
+                std::vector<GLuint> converted(values.begin(), values.end());
+                result.buffers.emplace_back();
+                result.buffers.back().storage(converted.size() * sizeof(GLuint), converted.data());
+                vao.elementBuffer(result.buffers.back());
+                indexType = GL_UNSIGNED_INT;
+            }
+        }
+
+        result.meshes.emplace_back(std::move(vao), count, indexType, indexOffset, material(primitive["material"].integer()));
+        return true;
+    }
+
+    // binds an accessor to an attribute location, in place if GL can read it there
+    void attribute(GLVertexArray &vao, Location location, int index)
+    {
+        const GltfJson &accessor = json["accessors"][(size_t)index];
+        if (accessor.isNull())
+            return;
+        const int components = componentCount(accessor["type"].string());
+        // tangents are vec4, the sign in w isn't part of the attribute
+        const GLint size = location == TANGENT ? 3 : components;
+        const GLenum type = (GLenum)accessor["componentType"].integer();
+        const int viewIndex = accessor["bufferView"].integer();
+        const GLuint binding = FIRST_BINDING + location;
+        if (inPlace(index, components))
+        {
+            const size_t stride = views[viewIndex].stride ? views[viewIndex].stride : components * componentSize(type);
+            vao.vertexBuffer(binding, viewBuffer(viewIndex), (GLintptr)accessor["byteOffset"].offset(), (GLsizei)stride);
+            vao.attribute(location, binding, size, type, 0, accessor["normalized"].boolean() ? GL_TRUE : GL_FALSE);
+            return;
+        }
+        // sparse or implicitly zero: expand to floats
+        vao.vertexBuffer(binding, convertedFloats(index, components), 0, components * sizeof(float));
+        vao.attribute(location, binding, size, GL_FLOAT, 0);
+    }
+
+    // bone ids as ivec4: in place if the skin's joints are the first bone ids in order, else remapped
+    void joints(GLVertexArray &vao, int index, int skin)
+    {
+        const GltfJson &accessor = json["accessors"][(size_t)index];
+        if (accessor.isNull())
+            return;
+        const GLuint binding = FIRST_BINDING + BONE_IDS;
+        const std::vector<int> &remap = jointRemap[skin];
+        bool identity = true;
+        for (size_t j = 0; j < remap.size(); j++)
+            identity = identity && remap[j] == (int)j;
+        const int viewIndex = accessor["bufferView"].integer();
+        if (identity && inPlace(index, 4))
+        {
+            const GLenum type = (GLenum)accessor["componentType"].integer();
+            const size_t stride = views[viewIndex].stride ? views[viewIndex].stride : 4 * componentSize(type);
+            vao.vertexBuffer(binding, viewBuffer(viewIndex), (GLintptr)accessor["byteOffset"].offset(), (GLsizei)stride);
+            vao.attributeI(BONE_IDS, binding, 4, type, 0);
+            return;
+        }
+        auto cached = converted.find({ index, BONE_IDS * 64 + skin });
+        if (cached == converted.end())
+        {
+            std::vector<float> values;
+            readFloats(accessor, 4, values);
+            std::vector<GLint> ids(values.size());
+            for (size_t i = 0; i < values.size(); i++)
+                ids[i] = (size_t)values[i] < remap.size() ? remap[(size_t)values[i]] : 0;
+            result.buffers.emplace_back();
+            result.buffers.back().storage(ids.size() * sizeof(GLint), ids.data());
+            cached = converted.emplace(std::make_pair(index, BONE_IDS * 64 + skin), (int)result.buffers.size() - 1).first;
+        }
+        vao.vertexBuffer(binding, result.buffers[cached->second], 0, 4 * sizeof(GLint));
+        vao.attributeI(BONE_IDS, binding, 4, GL_INT, 0);
+    }
+
+    // no bones: ids -1 and weights 0, as Model (model_animation.h) gives vertices no bone touches
+    void unskinned(GLVertexArray &vao, GLsizei vertices)
+    {
+        std::vector<GLint> ids((size_t)vertices * 4, -1);
+        result.buffers.emplace_back();
+        result.buffers.back().storage(ids.size() * sizeof(GLint), ids.data());
+        vao.vertexBuffer(FIRST_BINDING + BONE_IDS, result.buffers.back(), 0, 4 * sizeof(GLint));
+        vao.attributeI(BONE_IDS, FIRST_BINDING + BONE_IDS, 4, GL_INT, 0);
+        std::vector<float> weights((size_t)vertices * 4, 0.0f);
+        result.buffers.emplace_back();
+        result.buffers.back().storage(weights.size() * sizeof(float), weights.data());
+        vao.vertexBuffer(FIRST_BINDING + WEIGHTS, result.buffers.back(), 0, 4 * sizeof(float));
+        vao.attribute(WEIGHTS, FIRST_BINDING + WEIGHTS, 4, GL_FLOAT, 0);
+    }
+
+    // bitangent = cross(normal, tangent.xyz) * tangent.w, the one attribute glTF doesn't store
+    void bitangents(GLVertexArray &vao, int normalIndex, int tangentIndex)
+    {
+        auto cached = bitangentBuffers.find({ normalIndex, tangentIndex });
+        if (cached == bitangentBuffers.end())
+        {
+            const GltfJson &accessors = json["accessors"];
+            std::vector<float> normals, tangents;
+            readFloats(accessors[(size_t)normalIndex], 3, normals);
+            readFloats(accessors[(size_t)tangentIndex], 4, tangents);
+            const size_t count = std::min(normals.size() / 3, tangents.size() / 4);
+            std::vector<glm::vec3> values(count);
+            for (size_t i = 0; i < count; i++)
+                values[i] = glm::cross(glm::make_vec3(&normals[i * 3]), glm::make_vec3(&tangents[i * 4])) * tangents[i * 4 + 3];
+            result.buffers.emplace_back();
+            result.buffers.back().storage(values.size() * sizeof(glm::vec3), values.data());
+            cached = bitangentBuffers.emplace(std::make_pair(normalIndex, tangentIndex), (int)result.buffers.size() - 1).first;
+        }
+        vao.vertexBuffer(FIRST_BINDING + BITANGENT, result.buffers[cached->second], 0, sizeof(glm::vec3));
+        vao.attribute(BITANGENT, FIRST_BINDING + BITANGENT, 3, GL_FLOAT, 0);
+    }
+
+    // true if GL can read the accessor where it is: not sparse, and with every one of its elements
+    // inside its buffer view (byteOffset + (count - 1) * stride + element size <= byteLength)
+    bool inPlace(int index, int components)
+    {
+        const GltfJson &accessor = json["accessors"][(size_t)index];
+        const int viewIndex = accessor["bufferView"].integer();
+        if (!accessor["sparse"].isNull() || viewIndex < 0 || viewIndex >= (int)views.size() || !views[viewIndex].data)
+            return false;
+        const View &view = views[viewIndex];
+        const size_t element = components * componentSize((GLenum)accessor["componentType"].integer());
+        const size_t stride = view.stride ? view.stride : element;
+        const size_t offset = accessor["byteOffset"].offset(), count = accessor["count"].offset();
+        if (offset <= view.length && (count == 0 || (element <= view.length - offset && count - 1 <= (view.length - offset - element) / stride)))
+            return true;
+        // read on the CPU instead, where what lies outside the view reads as zeros
+        error("accessor " + std::to_string(index) + " reaches past the end of buffer view " + std::to_string(viewIndex));
+        return false;
+    }
+
+    // the GL buffer holding a buffer view, uploaded from the mapping on first use
+    const GLBuffer &viewBuffer(int index)
+    {
+        View &view = views[index];
+        if (view.buffer < 0)
+        {
+            result.buffers.emplace_back();
+            result.buffers.back().storage((GLsizeiptr)view.length, view.data);
+            view.buffer = (int)result.buffers.size() - 1;
+        }
+        return result.buffers[view.buffer];
+    }
+
+    const GLBuffer &convertedFloats(int index, int components)
+    {
+        auto cached = converted.find({ index, 0 });
+        if (cached == converted.end())
+        {
+            std::vector<float> values;
+            readFloats(json["accessors"][(size_t)index], components, values);
+            result.buffers.emplace_back();
+            result.buffers.back().storage(values.size() * sizeof(float), values.data());
+            cached = converted.emplace(std::make_pair(index, 0), (int)result.buffers.size() - 1).first;
+        }
+        return result.buffers[cached->second];
+    }
+
+    static int componentCount(const std::string &type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4" || type == "MAT2") return 4;
+        if (type == "MAT3") return 9;
+        if (type == "MAT4") return 16;
+        return 1;
+    }
+
+    static size_t componentSize(GLenum type)
+    {
+        return type == GL_BYTE || type == GL_UNSIGNED_BYTE ? 1 : type == GL_SHORT || type == GL_UNSIGNED_SHORT ? 2 : 4;
+    }
+
+    // one component as float, normalizing fixed point if the accessor says so
+    static float readComponent(const unsigned char *at, GLenum type, bool normalized)
+    {
+        switch (type)
+        {
+        case GL_BYTE:           { int8_t v;   std::memcpy(&v, at, 1); return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+        case GL_UNSIGNED_BYTE:  { uint8_t v;  std::memcpy(&v, at, 1); return normalized ? v / 255.0f : v; }
+        case GL_SHORT:          { int16_t v;  std::memcpy(&v, at, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+        case GL_UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, at, 2); return normalized ? v / 65535.0f : v; }
+        case GL_UNSIGNED_INT:   { uint32_t v; std::memcpy(&v, at, 4); return (float)v; }
+        default:                { float v;    std::memcpy(&v, at, 4); return v; }
+        }
+    }
+
+    // reads `count` elements of `components` values starting at `data`, `stride` bytes apart
+    static void readElements(const unsigned char *data, size_t available, size_t count, size_t stride, int components,
+                             GLenum type, bool normalized, float *out, int outComponents)
+    {
+        const size_t size = componentSize(type);
+        for (size_t i = 0; i < count; i++)
+            for (int c = 0; c < std::min(components, outComponents); c++)
+            {
+                const size_t at = i * stride + c * size;
+                if (at + size <= available)
+                    out[i * outComponents + c] = readComponent(data + at, type, normalized);
+            }
+    }
+
+    // the slow path: an accessor as `components` floats per element, sparse values applied
+    void readFloats(const GltfJson &accessor, int components, std::vector<float> &out)
+    {
+        static MetricCounter &conversions = metrics().counter("loader_glb_converted_accessors_total", "glTF accessors converted on the CPU instead of read in place");
+        conversions.add();
+        const size_t count = accessor["count"].offset();
+        const int stored = componentCount(accessor["type"].string());
+        const GLenum type = (GLenum)accessor["componentType"].integer();
+        const bool normalized = accessor["normalized"].boolean();
+        out.assign(count * components, 0.0f);
+
+        const int viewIndex = accessor["bufferView"].integer();
+        if (viewIndex >= 0 && viewIndex < (int)views.size() && views[viewIndex].data)
+        {
+            const View &view = views[viewIndex];
+            const size_t offset = accessor["byteOffset"].offset();
+            const size_t stride = view.stride ? view.stride : stored * componentSize(type);
+            if (offset < view.length)
+                readElements(view.data + offset, view.length - offset, count, stride, stored, type, normalized, out.data(), components);
+        }
+
+        const GltfJson &sparse = accessor["sparse"];
+        if (sparse.isNull())
+            return;
+        const size_t sparseCount = sparse["count"].offset();
+        const GltfJson &indices = sparse["indices"], &values = sparse["values"];
+        const int indexView = indices["bufferView"].integer(), valueView = values["bufferView"].integer();
+        if (indexView < 0 || indexView >= (int)views.size() || !views[indexView].data || valueView < 0 || valueView >= (int)views.size() || !views[valueView].data)
+            return;
+        std::vector<float> targets(sparseCount), replacements(sparseCount * components);
+        const GLenum indexType = (GLenum)indices["componentType"].integer();
+        const size_t indexOffset = indices["byteOffset"].offset(), valueOffset = values["byteOffset"].offset();
+        if (indexOffset >= views[indexView].length || valueOffset >= views[valueView].length)
+            return;
+        readElements(views[indexView].data + indexOffset, views[indexView].length - indexOffset, sparseCount, componentSize(indexType), 1, indexType, false, targets.data(), 1);
+        readElements(views[valueView].data + valueOffset, views[valueView].length - valueOffset, sparseCount, stored * componentSize(type), stored, type, normalized, replacements.data(), components);
+        for (size_t i = 0; i < sparseCount; i++)
+        {
+            const size_t target = (size_t)targets[i];
+            if (target < count)
+                std::copy(&replacements[i * components], &replacements[(i + 1) * components], &out[target * components]);
+        }
+    }
+
+    std::vector<Texture> material(int index)
+    {
+        std::vector<Texture> textures;
+        const GltfJson &material = json["materials"][(size_t)index];
+        if (material.isNull())
+            return textures;
+        const GltfJson &pbr = material["pbrMetallicRoughness"];
+        addTexture(pbr["baseColorTexture"]["index"].integer(), "texture_diffuse", gamma, textures);
+        addTexture(pbr["metallicRoughnessTexture"]["index"].integer(), "texture_specular", false, textures);
+        addTexture(material["normalTexture"]["index"].integer(), "texture_normal", false, textures);
+        return textures;
+    }
+
+    void addTexture(int index, const char *type, bool srgb, std::vector<Texture> &textures)
+    {
+        if (index < 0 || index >= (int)textureSlots.size())
+            return;
+        if (textureSlots[index] < 0)
+        {
+            const int image = json["textures"][(size_t)index]["source"].integer();
+            result.textureObjects.push_back(loadImage(image, srgb));
+            result.textures.push_back({ result.textureObjects.back().id(), type, "glb:image" + std::to_string(image) });
+            textureSlots[index] = (int)result.textures.size() - 1;
+        }
+        Texture texture = result.textures[textureSlots[index]];
+        texture.type = type;
+        textures.push_back(texture);
+    }
+
+    // images are decoded straight from the mapping, or from a file next to the model
+    void decodeImage(int index)
+    {
+        Image &decoded = images[index];
+        decoded.decoded = true;
+        const GltfJson &image = json["images"][(size_t)index];
+        const int viewIndex = image["bufferView"].integer();
+        const std::string &uri = image["uri"].string();
+        if (viewIndex >= 0 && viewIndex < (int)views.size() && views[viewIndex].data)
+        {
+            const View &view = views[viewIndex];
+            decoded.pixels = stbi_load_from_memory(view.data, (int)view.length, &decoded.width, &decoded.height, &decoded.components, 0);
+        }
+        else if (!uri.empty() && uri.compare(0, 5, "data:") != 0)
+        {
+            const std::string filename = directory + '/' + uri;
+            decoded.pixels = stbi_load(filename.c_str(), &decoded.width, &decoded.height, &decoded.components, 0);
+        }
+    }
+
+    GLTexture loadImage(int index, bool srgb)
+    {
+        GLTexture texture;
+        const Image *image = index >= 0 && index < (int)images.size() ? &images[index] : nullptr;
+        if (image && image->pixels)
+            texture = TextureFromPixels(image->pixels, image->width, image->height, image->components, srgb);
+        else
+            std::cout << "Texture failed to load at path: " << path << " image " << index << std::endl;
+        return texture;
+    }
+};
+
+// loads a .glb without Assimp, see GlbLoader
+inline bool loadGlb(const std::string &path, GlbModel &result, bool gamma = false,
+                    std::map<std::string, BoneInfo> *bones = nullptr, int *boneCount = nullptr)
+{
+    return GlbLoader::load(path, result, gamma, bones, boneCount);
+}
+
+// true for paths GlbLoader should take instead of Assimp
+inline bool isGlbPath(const std::string &path)
+{
+    return path.size() > 4 && (path.compare(path.size() - 4, 4, ".glb") == 0 || path.compare(path.size() - 4, 4, ".GLB") == 0);
+}
+#endif
@@ -0,0 +1,263 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/gl_resources.h>
+#include <learnopengl/metrics.h>
+#include <learnopengl/model.h>
+#include <learnopengl/shader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Octahedral impostors: a model baked once into an atlas of frames x frames views, taken from directions
+// spread over the sphere (or only the upper hemisphere) by an octahedral mapping, so that a distant
+// instance is a single camera-facing quad instead of a full mesh. Each frame stores the model's albedo
+// and coverage, and its object space normal and depth in front of the frame's plane, so impostors are
+// lit like the mesh and intersect each other properly. At run time the quad blends the four frames
+// nearest to the direction it is seen from (10.4.impostor.vs/fs):
+//
+//   Impostor rockImpostor;
+//   rockImpostor.bake(rock, bakeShader);          // once the model is ready
+//   ImpostorSplit(transforms, rock, camera.Position, 60.0f, nearTransforms, farTransforms);
+//   rock.setInstances(nearTransforms);
+//   rock.DrawInstanced(shader);
+//   rockImpostor.setInstances(farTransforms);
+//   rockImpostor.DrawInstanced(impostorShader, 0);
+//
+// The bake shader writes albedo to output 0 and normal and depth to output 1 (10.4.impostor_bake.fs).
+
+// the direction of the octahedral map at uv in [0, 1]^2, y up; the hemi-octahedral map covers y >= 0
+inline glm::vec3 OctahedronToDirection(glm::vec2 uv, bool hemisphere)
+{
+    glm::vec2 p = uv * 2.0f - 1.0f;
+    if (hemisphere)
+    {
+        p = glm::vec2(p.x + p.y, p.x - p.y) * 0.5f;
+        return glm::normalize(glm::vec3(p.x, 1.0f - std::abs(p.x) - std::abs(p.y), p.y));
+    }
+    glm::vec3 n(p.x, 1.0f - std::abs(p.x) - std::abs(p.y), p.y);
+    if (n.y < 0.0f)
+    {
+        const float x = n.x, z = n.z;
+        n.x = (1.0f - std::abs(z)) * (x >= 0.0f ? 1.0f : -1.0f);
+        n.z = (1.0f - std::abs(x)) * (z >= 0.0f ? 1.0f : -1.0f);
+    }
+    return glm::normalize(n);
+}
+
+// ------------------------------------------------------------------------
+class Impostor
+{
+public:
+    glm::vec3 center = glm::vec3(0.0f); // bounding sphere of the baked model, in its own space
+    float radius = 0.0f;
+    int frames = 0;                     // views per side of the atlas
+    int frameSize = 0;                  // texels per side of one view
+    bool hemisphere = false;
+
+    // renders `model` from frames x frames directions into frameSize^2 texel frames of the atlas; the
+    // bake shader gets projection, view, model and impostorRadius. Only ready models can be baked
+    bool bake(Model &model, Shader &bakeShader, int framesPerSide = 12, int texelsPerFrame = 128, bool upperHemisphere = false)
+    {
+        static MetricHistogram &bakeTime = metrics().histogram("impostor_bake_seconds", "Time to issue the draws baking one impostor atlas",
+                                                               { 0.001, 0.005, 0.01, 0.05, 0.1, 0.5 });
+        if (!model.isReady() || framesPerSide < 2 || texelsPerFrame < 1)
+        {
+            std::cout << "ERROR::IMPOSTOR:: Only a loaded model can be baked, into at least 2 x 2 frames" << std::endl;
+            return false;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        frames = framesPerSide, frameSize = texelsPerFrame, hemisphere = upperHemisphere;
+        center = (model.boundsMin + model.boundsMax) * 0.5f;
+        radius = std::max(glm::length(model.boundsMax - model.boundsMin) * 0.5f, 1e-4f);
+
+        // mip levels down to 8 texels a frame: below that neighbouring frames would bleed into each other
+        const int size = frames * frameSize;
+        int levels = 1;
+        while ((frameSize >> levels) >= 8 && frameSize % (1 << levels) == 0)
+            levels++;
+        albedo.storage2D(GL_TEXTURE_2D, levels, GL_RGBA8, size, size);
+        normalDepth.storage2D(GL_TEXTURE_2D, levels, GL_RGBA8, size, size);
+        GLTexture depth;
+        depth.storage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, size, size);
+        GLFramebuffer target;
+        target.create();
+        target.texture(GL_COLOR_ATTACHMENT0, albedo);
+        target.texture(GL_COLOR_ATTACHMENT1, normalDepth);
+        target.texture(GL_DEPTH_ATTACHMENT, depth);
+        const GLenum buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        target.drawBuffers(2, buffers);
+        if (!target.checkComplete())
+            return false;
+
+        GLint previousFramebuffer, previousViewport[4];
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+        const GLboolean blending = glIsEnabled(GL_BLEND), depthTest = glIsEnabled(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+
+        target.bind();
+        const GLfloat empty[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, empty);
+        glClearBufferfv(GL_COLOR, 1, empty);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        // an orthographic camera on the bounding sphere per frame, looking at its center; the sphere
+        // spans the frame and depths 0 to 2 * radius
+        bakeShader.use();
+        bakeShader.setMat4("projection", glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius));
+        bakeShader.setMat4("model", glm::mat4(1.0f));
+        bakeShader.setFloat("impostorRadius", radius);
+        for (int y = 0; y < frames; ++y)
+        {
+            for (int x = 0; x < frames; ++x)
+            {
+                const glm::vec3 direction = frameDirection(x, y);
+                glm::vec3 right, up;
+                frameBasis(direction, right, up);
+                const glm::vec3 eye = center + direction * radius;
+                glm::mat4 view(1.0f);
+                for (int c = 0; c < 3; ++c)
+                {
+                    view[c][0] = right[c];
+                    view[c][1] = up[c];
+                    view[c][2] = direction[c];
+                }
+                view[3] = glm::vec4(-glm::dot(right, eye), -glm::dot(up, eye), -glm::dot(direction, eye), 1.0f);
+                bakeShader.setMat4("view", view);
+                glViewport(x * frameSize, y * frameSize, frameSize, frameSize);
+                model.Draw(bakeShader);
+            }
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+        if (blending)
+            glEnable(GL_BLEND);
+        if (!depthTest)
+            glDisable(GL_DEPTH_TEST);
+
+        for (GLTexture *texture : { &albedo, &normalDepth })
+        {
+            texture->parameter(GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            texture->parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            texture->parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            texture->parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            if (levels > 1)
+                texture->generateMipmap();
+        }
+        bakeTime.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        return true;
+    }
+
+    // the view direction (from the model's center toward the camera) of atlas frame (x, y); frames sit
+    // on the grid points of the octahedral map, so the outermost ones lie on its edges
+    glm::vec3 frameDirection(int x, int y) const
+    {
+        return OctahedronToDirection(glm::vec2(x, y) / (float)(frames - 1), hemisphere);
+    }
+
+    // the frame's image plane axes; matches impostorFrameBasis() in 10.4.impostor.vs
+    static void frameBasis(const glm::vec3 &direction, glm::vec3 &right, glm::vec3 &up)
+    {
+        const glm::vec3 reference = std::abs(direction.y) > 0.999f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        right = glm::normalize(glm::cross(reference, direction));
+        up = glm::cross(direction, right);
+    }
+
+    // instanced drawing, like Model: one model matrix per instance, read as a mat4 input at
+    // matrixLocation to matrixLocation + 3
+    void setInstanceLayout(GLuint location)
+    {
+        matrixLocation = location;
+        layoutChanged = true;
+    }
+
+    void setInstances(const glm::mat4 *transforms, GLsizei count)
+    {
+        instanceCount = count;
+        if (count == 0)
+            return;
+        if (!vertexArray.id() || layoutChanged)
+        {
+            vertexArray.create();
+            for (GLuint column = 0; column < 4; ++column)
+                vertexArray.attribute(matrixLocation + column, 0, 4, GL_FLOAT, column * (GLuint)sizeof(glm::vec4));
+            vertexArray.bindingDivisor(0, 1);
+            layoutChanged = false;
+        }
+        const GLintptr offset = instanceStream.write(transforms, (GLsizeiptr)count * sizeof(glm::mat4));
+        vertexArray.vertexBuffer(0, instanceStream.buffer(), offset, sizeof(glm::mat4));
+    }
+    void setInstances(const std::vector<glm::mat4> &transforms)
+    {
+        setInstances(transforms.data(), (GLsizei)transforms.size());
+    }
+
+    // binds the atlas to texture units `unit` and `unit + 1`, sets the impostor uniforms and draws a
+    // quad per instance
+    void DrawInstanced(Shader &shader, GLuint unit = 0)
+    {
+        if (instanceCount == 0 || frames == 0)
+            return;
+        shader.use();
+        albedo.bindUnit(unit);
+        normalDepth.bindUnit(unit + 1);
+        shader.setInt("impostorAlbedo", (int)unit);
+        shader.setInt("impostorNormalDepth", (int)unit + 1);
+        shader.setVec3("impostorCenter", center);
+        shader.setFloat("impostorRadius", radius);
+        shader.setFloat("impostorFrames", (float)frames);
+        shader.setBool("impostorHemisphere", hemisphere);
+        vertexArray.bind();
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount);
+        glBindVertexArray(0);
+    }
+
+    const GLTexture &albedoAtlas() const
+    {
+        return albedo;
+    }
+    const GLTexture &normalDepthAtlas() const
+    {
+        return normalDepth;
+    }
+
+private:
+    GLTexture albedo, normalDepth;
+    GLVertexArray vertexArray;
+    GLStreamBuffer instanceStream;
+    GLuint matrixLocation = 3;
+    bool layoutChanged = true;
+    GLsizei instanceCount = 0;
+};
+
+// sorts instance transforms of `model` into those whose bounding sphere center is within `distance` of
+// the eye, drawn as meshes, and the rest, drawn as impostors
+inline void ImpostorSplit(const std::vector<glm::mat4> &transforms, const Model &model, const glm::vec3 &eye, float distance,
+                          std::vector<glm::mat4> &nearTransforms, std::vector<glm::mat4> &farTransforms)
+{
+    static MetricGauge &impostors = metrics().gauge("impostor_instances", "Instances drawn as impostors in the last split");
+    const glm::vec4 center = glm::vec4((model.boundsMin + model.boundsMax) * 0.5f, 1.0f);
+    const float limit = distance * distance;
+    nearTransforms.clear();
+    farTransforms.clear();
+    for (const glm::mat4 &transform : transforms)
+    {
+        const glm::vec3 offset = glm::vec3(transform * center) - eye;
+        if (glm::dot(offset, offset) > limit)
+            farTransforms.push_back(transform);
+        else
+            nearTransforms.push_back(transform);
+    }
+    impostors.set((double)farTransforms.size());
+}
+#endif
@@ -0,0 +1,287 @@
+#ifndef IRRADIANCE_PROBES_H
+#define IRRADIANCE_PROBES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <learnopengl/gl_resources.h>
+#include <learnopengl/metrics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// A grid of irradiance probes baked on the CPU: every probe integrates the radiance arriving from all
+// directions into 9 L2 spherical harmonic coefficients per color channel, convolved with the cosine
+// lobe, so evaluating them for a normal gives the diffuse light a surface at the probe would receive.
+// Objects that move through the scene are lit by blending the 8 probes around them, which the GPU
+// does with trilinear filtering of a 3D texture (10.probe_grid.glsl):
+//
+//   IrradianceProbeGrid probes;
+//   probes.bake(roomMin, roomMax, glm::ivec3(8, 4, 8), traceScene); // traceScene(origin, direction)
+//   probes.upload();
+//   ...
+//   probes.bind(shader, 2);
+//   // fragment shader: diffuse += albedo * probeGridIrradiance(worldPos, normal);
+//
+// The radiance source is called from several threads at once. Probes inside geometry only see its
+// backfaces; if insideGeometry is given, those take the average of their neighbours instead.
+// Irradiance is stored divided by pi, like the IBL irradiance maps of 6.pbr: multiplied by the albedo
+// it's the reflected radiance.
+
+typedef std::function<glm::vec3(const glm::vec3 &origin, const glm::vec3 &direction)> ProbeRadianceSource;
+
+// 9 coefficients per color channel, bands 0 to 2
+struct SH9Color
+{
+    glm::vec3 c[9] = {};
+
+    SH9Color &operator+=(const SH9Color &other)
+    {
+        for (int i = 0; i < 9; ++i)
+            c[i] += other.c[i];
+        return *this;
+    }
+    SH9Color operator*(float scale) const
+    {
+        SH9Color result;
+        for (int i = 0; i < 9; ++i)
+            result.c[i] = c[i] * scale;
+        return result;
+    }
+};
+
+// the real spherical harmonic basis functions up to band 2 at unit direction d; the same order and
+// constants as probeGridIrradiance() in 10.probe_grid.glsl
+inline void SHBasis(const glm::vec3 &d, float basis[9])
+{
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * d.y;
+    basis[2] = 0.488603f * d.z;
+    basis[3] = 0.488603f * d.x;
+    basis[4] = 1.092548f * d.x * d.y;
+    basis[5] = 1.092548f * d.y * d.z;
+    basis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+    basis[7] = 1.092548f * d.x * d.z;
+    basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+}
+
+// projects radiance arriving from direction d, weighted by the solid angle it stands for
+inline void SHAddSample(SH9Color &sh, const glm::vec3 &d, const glm::vec3 &radiance, float weight)
+{
+    float basis[9];
+    SHBasis(d, basis);
+    for (int i = 0; i < 9; ++i)
+        sh.c[i] += radiance * (basis[i] * weight);
+}
+
+// radiance to irradiance / pi: the cosine lobe scales band l by pi, 2pi/3 and pi/4 (Ramamoorthi and
+// Hanrahan, "An Efficient Representation for Irradiance Environment Maps")
+inline SH9Color SHConvolveCosine(const SH9Color &radiance)
+{
+    const float band[3] = { 1.0f, 2.0f / 3.0f, 0.25f };
+    SH9Color result;
+    for (int i = 0; i < 9; ++i)
+        result.c[i] = radiance.c[i] * band[i == 0 ? 0 : (i < 4 ? 1 : 2)];
+    return result;
+}
+
+inline glm::vec3 SHEvaluate(const SH9Color &sh, const glm::vec3 &d)
+{
+    float basis[9];
+    SHBasis(d, basis);
+    glm::vec3 result(0.0f);
+    for (int i = 0; i < 9; ++i)
+        result += sh.c[i] * basis[i];
+    return glm::max(result, glm::vec3(0.0f));
+}
+
+// `count` directions spread evenly over the sphere on a spherical Fibonacci spiral
+inline std::vector<glm::vec3> SphereSampleDirections(int count)
+{
+    const float goldenAngle = 2.39996323f;
+    std::vector<glm::vec3> directions(count);
+    for (int i = 0; i < count; ++i)
+    {
+        const float z = 1.0f - (2.0f * i + 1.0f) / count;
+        const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        const float phi = goldenAngle * i;
+        directions[i] = glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+    }
+    return directions;
+}
+
+// ------------------------------------------------------------------------
+class IrradianceProbeGrid
+{
+public:
+    glm::vec3 boundsMin = glm::vec3(0.0f); // the corner probes sit on the bounds
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    glm::ivec3 counts = glm::ivec3(0);
+    std::vector<SH9Color> probes;          // irradiance / pi, x fastest
+
+    // traces `samples` rays from every probe of a counts.x x counts.y x counts.z grid spanning the
+    // bounds, spread over one task per core
+    bool bake(const glm::vec3 &minimum, const glm::vec3 &maximum, const glm::ivec3 &probeCounts, const ProbeRadianceSource &radiance,
+              int samples = 256, const std::function<bool(const glm::vec3 &)> &insideGeometry = nullptr)
+    {
+        static MetricHistogram &bakeTime = metrics().histogram("irradiance_probe_bake_seconds", "Time to bake a grid of irradiance probes",
+                                                               { 0.01, 0.05, 0.1, 0.5, 1.0, 5.0 });
+        static MetricGauge &probeCount = metrics().gauge("irradiance_probes", "Probes in the last baked irradiance grid");
+        if (glm::any(glm::lessThan(probeCounts, glm::ivec3(2))) || samples < 1)
+        {
+            std::cout << "ERROR::IRRADIANCE_PROBES:: A probe grid needs at least 2 probes along each axis" << std::endl;
+            return false;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        boundsMin = minimum, boundsMax = maximum, counts = probeCounts;
+        const int total = counts.x * counts.y * counts.z;
+        probes.assign(total, SH9Color());
+        std::vector<char> valid(total, 1);
+        const std::vector<glm::vec3> directions = SphereSampleDirections(samples);
+        const float weight = 4.0f * glm::pi<float>() / samples;
+
+        const int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::future<void>> tasks;
+        for (int first = 0; first < std::min(threads, total); ++first)
+        {
+            tasks.push_back(std::async(std::launch::async, [&, first]() {
+                for (int probe = first; probe < total; probe += threads)
+                {
+                    const glm::vec3 position = probePosition(probe);
+                    if (insideGeometry && insideGeometry(position))
+                    {
+                        valid[probe] = 0;
+                        continue;
+                    }
+                    SH9Color sh;
+                    for (const glm::vec3 &direction : directions)
+                        SHAddSample(sh, direction, radiance(position, direction), weight);
+                    probes[probe] = SHConvolveCosine(sh);
+                }
+            }));
+        }
+        for (std::future<void> &task : tasks)
+            task.get();
+        fillInvalid(valid);
+
+        probeCount.set((double)total);
+        bakeTime.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        return true;
+    }
+
+    glm::vec3 probePosition(int index) const
+    {
+        const glm::ivec3 cell(index % counts.x, (index / counts.x) % counts.y, index / (counts.x * counts.y));
+        return boundsMin + (boundsMax - boundsMin) * glm::vec3(cell) / glm::vec3(counts - 1);
+    }
+
+    // irradiance / pi at a position, interpolated between the 8 probes around it like the GPU does;
+    // positions outside the grid are clamped to it
+    glm::vec3 irradiance(const glm::vec3 &position, const glm::vec3 &normal) const
+    {
+        const glm::vec3 cell = glm::clamp((position - boundsMin) / (boundsMax - boundsMin), 0.0f, 1.0f) * glm::vec3(counts - 1);
+        const glm::ivec3 base = glm::min(glm::ivec3(cell), counts - 2);
+        const glm::vec3 f = cell - glm::vec3(base);
+        SH9Color sh;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const glm::ivec3 offset(corner & 1, (corner >> 1) & 1, corner >> 2);
+            const glm::vec3 w = glm::mix(glm::vec3(1.0f) - f, f, glm::vec3(offset));
+            sh += probes[index(base + offset)] * (w.x * w.y * w.z);
+        }
+        return SHEvaluate(sh, normal);
+    }
+
+    // the 27 coefficients of a probe go into 7 consecutive RGBA16F texels, one slab of counts.z layers
+    // per texel: (x, y, z + slab * counts.z). Filtering never mixes slabs as long as the shader keeps
+    // its coordinates half a texel inside the grid
+    void upload()
+    {
+        static MetricGauge &gridBytes = metrics().gauge("irradiance_probe_grid_bytes", "Size of the irradiance probe grid texture");
+        const int slabSize = counts.x * counts.y * counts.z;
+        std::vector<float> texels((size_t)slabSize * Slabs * 4, 0.0f);
+        for (int probe = 0; probe < slabSize; ++probe)
+        {
+            const float *coefficients = &probes[probe].c[0].x;
+            for (int i = 0; i < 27; ++i)
+                texels[((size_t)(i / 4) * slabSize + probe) * 4 + i % 4] = coefficients[i];
+        }
+        texture.storage3D(1, GL_RGBA16F, counts.x, counts.y, counts.z * Slabs);
+        texture.subImage3D(0, counts.x, counts.y, counts.z * Slabs, GL_RGBA, GL_FLOAT, texels.data());
+        texture.parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        texture.parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        texture.parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        texture.parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        texture.parameter(GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        gridBytes.set((double)slabSize * Slabs * 4 * 2);
+    }
+
+    // binds the grid to texture unit `unit` and sets probeGrid, probeGridMin, probeGridMax and
+    // probeGridCount
+    template <typename ShaderType>
+    void bind(const ShaderType &shader, GLuint unit) const
+    {
+        texture.bindUnit(unit);
+        shader.setInt("probeGrid", (int)unit);
+        shader.setVec3("probeGridMin", boundsMin);
+        shader.setVec3("probeGridMax", boundsMax);
+        shader.setVec3("probeGridCount", glm::vec3(counts));
+    }
+
+    const GLTexture &gridTexture() const
+    {
+        return texture;
+    }
+
+private:
+    static const int Slabs = 7;
+    GLTexture texture;
+
+    int index(const glm::ivec3 &cell) const
+    {
+        return (cell.z * counts.y + cell.y) * counts.x + cell.x;
+    }
+
+    // grows the valid probes into the invalid ones, a layer of neighbours at a time
+    void fillInvalid(std::vector<char> &valid)
+    {
+        static const glm::ivec3 neighbours[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            std::vector<char> next = valid;
+            for (int i = 0; i < (int)probes.size(); ++i)
+            {
+                if (valid[i])
+                    continue;
+                const glm::ivec3 cell(i % counts.x, (i / counts.x) % counts.y, i / (counts.x * counts.y));
+                SH9Color sum;
+                int found = 0;
+                for (const glm::ivec3 &step : neighbours)
+                {
+                    const glm::ivec3 neighbour = cell + step;
+                    if (glm::any(glm::lessThan(neighbour, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(neighbour, counts)) || !valid[index(neighbour)])
+                        continue;
+                    sum += probes[index(neighbour)];
+                    found++;
+                }
+                if (found)
+                {
+                    probes[i] = sum * (1.0f / found);
+                    next[i] = 1;
+                    changed = true;
+                }
+            }
+            valid.swap(next);
+        }
+    }
+};
+#endif
@@ -0,0 +1,221 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Memory mapping of a whole file: open() maps an existing file read-only (the .glb loader reads its
+// buffers in place), create() makes a new file of a given size, or anonymous memory without a path,
+// and maps it read/write (the out-of-core physics keeps its state and trace in these).
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path)
+    {
+        open(path);
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // maps an existing, non-empty file read-only; returns false (quietly, callers report) if it can't
+    bool open(const std::string &path)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            file = nullptr;
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+        {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping)
+                base = static_cast<char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            length = (size_t)fileSize.QuadPart;
+        }
+#else
+        descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return false;
+        struct stat status;
+        if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        {
+            void *address = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            base = address == MAP_FAILED ? nullptr : static_cast<char *>(address);
+            length = (size_t)status.st_size;
+        }
+#endif
+        if (!base)
+            close();
+        return base != nullptr;
+    }
+
+    // creates (or truncates) `path` with `size` bytes and maps it read/write; an empty path maps
+    // anonymous memory instead
+    bool create(const std::string &path, size_t size)
+    {
+        close();
+        if (size == 0)
+            return true;
+#ifdef _WIN32
+        if (path.empty())
+            base = static_cast<char *>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        else
+        {
+            file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                file = nullptr;
+            else
+            {
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)size, nullptr);
+                if (mapping)
+                    base = static_cast<char *>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+            }
+        }
+#else
+        if (path.empty())
+        {
+            void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            base = address == MAP_FAILED ? nullptr : static_cast<char *>(address);
+        }
+        else
+        {
+            descriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (descriptor >= 0 && ftruncate(descriptor, (off_t)size) == 0)
+            {
+                void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+                base = address == MAP_FAILED ? nullptr : static_cast<char *>(address);
+            }
+        }
+#endif
+        if (!base)
+        {
+            std::cout << "ERROR::MAPPED_FILE::MAPPING_FAILED: " << (path.empty() ? "<memory>" : path) << std::endl;
+            close();
+            return false;
+        }
+        length = size;
+        return true;
+    }
+
+    // unmaps and closes, the file keeps its contents
+    void close()
+    {
+#ifdef _WIN32
+        if (base)
+        {
+            if (mapping)
+                UnmapViewOfFile(base);
+            else
+                VirtualFree(base, 0, MEM_RELEASE);
+        }
+        if (mapping)
+            CloseHandle(mapping);
+        if (file)
+            CloseHandle(file);
+        mapping = nullptr;
+        file = nullptr;
+#else
+        if (base)
+            munmap(base, length);
+        if (descriptor >= 0)
+            ::close(descriptor);
+        descriptor = -1;
+#endif
+        base = nullptr;
+        length = 0;
+    }
+
+    // hint that [offset, offset + size) is needed soon
+    void willNeed(size_t offset, size_t size) const
+    {
+#ifndef _WIN32
+        if (!base || offset >= length)
+            return;
+        // madvise wants a page aligned start
+        const size_t start = offset / PAGE_BYTES * PAGE_BYTES;
+        madvise(base + start, std::min(length, offset + size) - start, MADV_WILLNEED);
+#endif
+    }
+
+    // starts writing back the dirty pages of the whole mapping, doesn't wait
+    void flush() const
+    {
+        if (!base)
+            return;
+#ifdef _WIN32
+        if (mapping)
+            FlushViewOfFile(base, 0);
+#else
+        if (descriptor >= 0)
+            msync(base, length, MS_ASYNC);
+#endif
+    }
+
+    // writes back and drops the file's pages from the page cache (simulates a cold cache)
+    void evict() const
+    {
+#ifndef _WIN32
+        if (!base || descriptor < 0)
+            return;
+        // pages still mapped by this process stay cached, so unmap them from it first
+        msync(base, length, MS_SYNC);
+        madvise(base, length, MADV_DONTNEED);
+        posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    }
+
+    bool isOpen() const
+    {
+        return base != nullptr;
+    }
+    char *data() const
+    {
+        return base;
+    }
+    size_t size() const
+    {
+        return length;
+    }
+
+    static constexpr size_t PAGE_BYTES = 4096;
+
+private:
+    char *base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = nullptr;
+    HANDLE mapping = nullptr;
+#else
+    int descriptor = -1;
+#endif
+};
+#endif
@@ -7,6 +7,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <learnopengl/shader.h>
+#include <learnopengl/gl_resources.h>
+#include <learnopengl/meshlets.h>
 
 #include <string>
 #include <vector>
@@ -37,13 +39,22 @@ struct Texture {
     string path;
 };
 
+// per-instance vertex attribute, read from the instance buffer (binding 1, advanced once per instance)
+struct InstanceAttribute {
+    GLuint location;
+    GLint  size;     // components, 1 - 4
+    GLenum type;     // GL_FLOAT, or an integer type for int/ivec inputs
+    GLuint offset;   // byte offset inside one instance
+};
+
 class Mesh {
 public:
     // mesh Data
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
-    unsigned int VAO;
+    unsigned int VAO; // name of vao, for code that sets up extra attributes (e.g. instancing) itself
+    vector<Meshlet>      meshlets; // clusters of indices, after buildMeshlets()
 
     // constructor
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
@@ -56,8 +67,113 @@ public:
         setupMesh();
     }
 
+    // mesh whose vertex and index buffers were filled elsewhere (on an UploadThread, see ModelLoader);
+    // only the vertex array is made here, vertex arrays aren't shared between contexts
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, GLBuffer vertexBuffer, GLBuffer indexBuffer)
+        : vertices(std::move(vertices)), indices(std::move(indices)), textures(textures), vbo(std::move(vertexBuffer)), ebo(std::move(indexBuffer))
+    {
+        setupVertexArray();
+    }
+
+    // mesh whose vertex array was set up elsewhere, over buffers owned by someone else (see gltf_loader.h);
+    // vertices and indices stay empty. indexType 0 draws `count` vertices without indices
+    Mesh(GLVertexArray vertexArray, GLsizei count, GLenum indexType, GLintptr indexOffset, vector<Texture> textures)
+        : textures(textures), vao(std::move(vertexArray)), drawCount(count), indexType(indexType), indexOffset(indexOffset)
+    {
+        VAO = vao.id();
+    }
+
     // render the mesh
     void Draw(Shader &shader) 
+    {
+        bindTextures(shader);
+        
+        // draw mesh
+        vao.bind();
+        if (indexType)
+            glDrawElements(GL_TRIANGLES, drawCount, indexType, reinterpret_cast<const void *>(indexOffset));
+        else
+            glDrawArrays(GL_TRIANGLES, 0, drawCount);
+        glBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // render the mesh `instances` times, reading the attributes given to setInstanceLayout() from the
+    // buffer attached with bindInstances()
+    void DrawInstanced(Shader &shader, GLsizei instances)
+    {
+        bindTextures(shader);
+        vao.bind();
+        if (indexType)
+            glDrawElementsInstanced(GL_TRIANGLES, drawCount, indexType, reinterpret_cast<const void *>(indexOffset), instances);
+        else
+            glDrawArraysInstanced(GL_TRIANGLES, 0, drawCount, instances);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // splits the triangles into meshlets for DrawCulled(), reordering (and re-uploading) the indices;
+    // needs the vertices and indices, so meshes over someone else's buffers keep drawing whole
+    void buildMeshlets(unsigned int maxTriangles = 124, unsigned int maxVertices = 64)
+    {
+        if (vertices.empty() || indices.empty())
+            return;
+        meshlets = ::buildMeshlets(&vertices[0].Position.x, sizeof(Vertex), indices, maxTriangles, maxVertices);
+        ebo.storage(indices.size() * sizeof(unsigned int), indices.data());
+        vao.elementBuffer(ebo);
+    }
+
+    // render the meshlets the culler doesn't reject, in one multi-draw; the culler must be set up for
+    // this mesh's transform. Meshes without meshlets are drawn whole
+    void DrawCulled(Shader &shader, MeshletCuller &culler)
+    {
+        if (meshlets.empty())
+        {
+            Draw(shader);
+            return;
+        }
+        culler.cull(meshlets);
+        if (culler.counts().empty())
+            return;
+        bindTextures(shader);
+        vao.bind();
+        glMultiDrawElements(GL_TRIANGLES, culler.counts().data(), GL_UNSIGNED_INT, culler.offsets().data(), (GLsizei)culler.counts().size());
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // adds per-instance attributes to the vertex layout; they replace vertex attributes at the same locations
+    void setInstanceLayout(const vector<InstanceAttribute> &attributes)
+    {
+        for (const InstanceAttribute &a : attributes)
+        {
+            if (a.type == GL_FLOAT || a.type == GL_HALF_FLOAT)
+                vao.attribute(a.location, INSTANCE_BINDING, a.size, a.type, a.offset);
+            else
+                vao.attributeI(a.location, INSTANCE_BINDING, a.size, a.type, a.offset);
+        }
+        vao.bindingDivisor(INSTANCE_BINDING, 1);
+    }
+
+    // the instances start at `offset` in `buffer`, `stride` bytes apart
+    void bindInstances(const GLBuffer &buffer, GLintptr offset, GLsizei stride)
+    {
+        vao.vertexBuffer(INSTANCE_BINDING, buffer, offset, stride);
+    }
+
+private:
+    static constexpr GLuint INSTANCE_BINDING = 1;
+
+    // render data 
+    GLVertexArray vao;
+    GLBuffer      vbo, ebo;
+    GLsizei       drawCount = 0;
+    GLenum        indexType = GL_UNSIGNED_INT;
+    GLintptr      indexOffset = 0;
+
+    void bindTextures(Shader &shader)
     {
         // bind appropriate textures
         unsigned int diffuseNr  = 1;
@@ -84,63 +200,45 @@ public:
             // and finally bind the texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
     }
 
-private:
-    // render data 
-    unsigned int VBO, EBO;
-
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
-        // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        // immutable buffers, filled once; nothing has to be bound to create or fill them.
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        vbo.storage(vertices.size() * sizeof(Vertex), vertices.data());
+        ebo.storage(indices.size() * sizeof(unsigned int), indices.data());
+        setupVertexArray();
+    }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    // the vertex array over vbo and ebo
+    void setupVertexArray()
+    {
+        vao.create();
+        vao.vertexBuffer(0, vbo, 0, sizeof(Vertex));
+        vao.elementBuffer(ebo);
 
-        // set the vertex attribute pointers
+        // set the vertex attribute formats, all read from binding 0
         // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        vao.attribute(0, 0, 3, GL_FLOAT, 0);
         // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        vao.attribute(1, 0, 3, GL_FLOAT, offsetof(Vertex, Normal));
         // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        vao.attribute(2, 0, 2, GL_FLOAT, offsetof(Vertex, TexCoords));
         // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+        vao.attribute(3, 0, 3, GL_FLOAT, offsetof(Vertex, Tangent));
         // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-		// ids
-		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-		// weights
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+        vao.attribute(4, 0, 3, GL_FLOAT, offsetof(Vertex, Bitangent));
+        // ids
+        vao.attributeI(5, 0, 4, GL_INT, offsetof(Vertex, m_BoneIDs));
+        // weights
+        vao.attribute(6, 0, 4, GL_FLOAT, offsetof(Vertex, m_Weights));
+
+        VAO = vao.id();
+        drawCount = static_cast<GLsizei>(indices.size());
     }
 };
 #endif
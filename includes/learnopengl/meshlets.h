@@ -0,0 +1,315 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/metrics.h>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+// Meshlets: a mesh's triangles split into small clusters that are culled as a whole. buildMeshlets()
+// groups neighbouring triangles (sharing as many vertices as possible) into clusters of at most
+// maxTriangles triangles and maxVertices distinct vertices and reorders the index buffer so every
+// cluster is one contiguous index range. Each cluster keeps a bounding sphere and a normal cone.
+//
+// MeshletCuller tests the clusters against the view frustum and, with the cone, whether all of a
+// cluster's triangles face away from the camera, and collects the surviving ranges (neighbours merged)
+// for one glMultiDrawElements call:
+//
+//   culler.setTransform(model, view, projection); // per object
+//   mesh.DrawCulled(shader, culler);              // or Model::DrawCulled
+//   culler.stats().trianglesRejected();           // per frame, then culler.resetStats()
+//
+// The cone test assumes model matrices without non-uniform scale.
+
+struct Meshlet
+{
+    glm::vec3 center;      // bounding sphere
+    float radius;
+    glm::vec3 coneApex;    // all triangles face away from a camera in the cone behind the apex:
+    glm::vec3 coneAxis;    // dot(normalize(coneApex - camera), coneAxis) >= coneCutoff
+    float coneCutoff;      // 1 if the normals spread too far for the test to ever cull
+    GLuint firstIndex;
+    GLuint indexCount;
+};
+
+// clusters the triangles of `indices` and reorders them cluster by cluster; positions are read as
+// 3 floats every `stride` bytes
+inline std::vector<Meshlet> buildMeshlets(const float *positions, size_t stride, std::vector<unsigned int> &indices,
+                                          unsigned int maxTriangles = 124, unsigned int maxVertices = 64)
+{
+    std::vector<Meshlet> meshlets;
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return meshlets;
+    maxVertices = std::max(maxVertices, 3u);
+    maxTriangles = std::max(maxTriangles, 1u);
+    unsigned int vertexCount = 0;
+    for (unsigned int index : indices)
+        vertexCount = std::max(vertexCount, index + 1);
+    auto position = [positions, stride](unsigned int vertex) {
+        const float *p = reinterpret_cast<const float *>(reinterpret_cast<const char *>(positions) + vertex * stride);
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    // triangles around every position: vertices split only for their normals or uvs (seams, hard
+    // edges) still connect their triangles, or clusters would stop growing at every seam
+    std::vector<unsigned int> welded(vertexCount);
+    {
+        std::unordered_map<uint64_t, unsigned int> first;
+        first.reserve(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++)
+        {
+            const glm::vec3 p = position(v);
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            const uint64_t key = (uint64_t)bits[0] * 73856093u ^ (uint64_t)bits[1] * 19349663u ^ (uint64_t)bits[2] * 83492791u ^ ((uint64_t)bits[0] << 32);
+            auto found = first.find(key);
+            welded[v] = found != first.end() && position(found->second) == p ? found->second : v;
+            if (found == first.end())
+                first.emplace(key, v);
+        }
+    }
+    std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0), adjacency(triangleCount * 3);
+    for (unsigned int index : indices)
+        adjacencyStart[welded[index] + 1]++;
+    for (unsigned int v = 0; v < vertexCount; v++)
+        adjacencyStart[v + 1] += adjacencyStart[v];
+    {
+        std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[welded[indices[i]]]++] = (unsigned int)(i / 3);
+    }
+
+    std::vector<glm::vec3> centroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        centroids[t] = (position(indices[t * 3]) + position(indices[t * 3 + 1]) + position(indices[t * 3 + 2])) / 3.0f;
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> owner(vertexCount, ~0u); // meshlet that last used the vertex
+    std::vector<unsigned int> reordered;
+    reordered.reserve(indices.size());
+    std::vector<unsigned int> triangles, candidates;
+    size_t seed = 0;
+
+    while (true)
+    {
+        while (seed < triangleCount && emitted[seed])
+            seed++;
+        if (seed == triangleCount)
+            break;
+
+        // grow a cluster from the seed, always taking the candidate adding the fewest new vertices,
+        // the one closest to the cluster's centroid among those
+        const unsigned int id = (unsigned int)meshlets.size();
+        unsigned int vertices = 0;
+        glm::vec3 centroidSum(0.0f);
+        triangles.clear();
+        candidates.clear();
+        candidates.push_back((unsigned int)seed);
+        while (triangles.size() < maxTriangles)
+        {
+            const glm::vec3 centroid = triangles.empty() ? centroids[seed] : centroidSum / (float)triangles.size();
+            int best = -1, bestNew = 4;
+            float bestDistance = FLT_MAX;
+            for (size_t c = 0; c < candidates.size();)
+            {
+                const unsigned int t = candidates[c];
+                if (emitted[t])
+                {
+                    candidates[c] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+                int added = 0;
+                for (int k = 0; k < 3; k++)
+                    added += owner[indices[t * 3 + k]] != id;
+                const float distance = glm::dot(centroids[t] - centroid, centroids[t] - centroid);
+                if (vertices + added <= maxVertices && (added < bestNew || (added == bestNew && distance < bestDistance)))
+                {
+                    best = (int)c;
+                    bestNew = added;
+                    bestDistance = distance;
+                }
+                c++;
+            }
+            if (best < 0)
+                break;
+            const unsigned int t = candidates[best];
+            emitted[t] = true;
+            triangles.push_back(t);
+            centroidSum += centroids[t];
+            for (int k = 0; k < 3; k++)
+            {
+                const unsigned int v = indices[t * 3 + k];
+                if (owner[v] == id)
+                    continue;
+                owner[v] = id;
+                vertices++;
+                for (unsigned int a = adjacencyStart[welded[v]]; a < adjacencyStart[welded[v] + 1]; a++)
+                    if (!emitted[adjacency[a]])
+                        candidates.push_back(adjacency[a]);
+            }
+        }
+
+        // bounds: sphere around the center of the box, cone from the triangle normals
+        Meshlet meshlet;
+        meshlet.firstIndex = (GLuint)reordered.size();
+        meshlet.indexCount = (GLuint)triangles.size() * 3;
+        glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+        glm::vec3 axis(0.0f);
+        for (unsigned int t : triangles)
+        {
+            const glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+            low = glm::min(low, glm::min(a, glm::min(b, c)));
+            high = glm::max(high, glm::max(a, glm::max(b, c)));
+            axis += glm::cross(b - a, c - a); // area weighted
+            reordered.insert(reordered.end(), { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] });
+        }
+        meshlet.center = (low + high) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (unsigned int t : triangles)
+            for (int k = 0; k < 3; k++)
+                meshlet.radius = std::max(meshlet.radius, glm::length(position(indices[t * 3 + k]) - meshlet.center));
+
+        const float axisLength = glm::length(axis);
+        meshlet.coneAxis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+        meshlet.coneApex = meshlet.center;
+        meshlet.coneCutoff = 1.0f;
+        float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+        for (unsigned int t : triangles)
+        {
+            const glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+            const glm::vec3 normal = glm::cross(b - a, c - a);
+            const float length = glm::length(normal);
+            if (length > 0.0f)
+                minDot = std::min(minDot, glm::dot(normal / length, meshlet.coneAxis));
+        }
+        // normals spread wider than ~84 degrees from the axis: some triangle always faces the camera
+        if (minDot > 0.1f)
+        {
+            // move the apex back along the axis until every triangle's plane lies in front of it
+            float back = 0.0f;
+            for (unsigned int t : triangles)
+            {
+                const glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+                const glm::vec3 normal = glm::cross(b - a, c - a);
+                const float length = glm::length(normal);
+                if (length == 0.0f)
+                    continue;
+                const float facing = glm::dot(meshlet.coneAxis, normal / length);
+                back = std::max(back, glm::dot(meshlet.center - a, normal / length) / facing);
+            }
+            meshlet.coneApex = meshlet.center - meshlet.coneAxis * back;
+            meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+        meshlets.push_back(meshlet);
+    }
+    indices.swap(reordered);
+    return meshlets;
+}
+
+class MeshletCuller
+{
+public:
+    struct Stats
+    {
+        size_t meshlets = 0, meshletsDrawn = 0;
+        size_t triangles = 0, frustumRejected = 0, backfaceRejected = 0;
+        size_t draws = 0; // multi-draw ranges after merging neighbours
+
+        size_t trianglesRejected() const { return frustumRejected + backfaceRejected; }
+    };
+
+    bool frustumCulling = true;
+    bool coneCulling = true;
+
+    // the object the next cull() calls are for; everything is tested in its model space
+    void setTransform(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection)
+    {
+        // frustum planes of projection * view * model (Gribb & Hartmann), in model space
+        const glm::mat4 m = glm::transpose(projection * view * model);
+        const glm::vec4 planeRows[6] = { m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2] };
+        for (int i = 0; i < 6; i++)
+            planes[i] = planeRows[i] / glm::length(glm::vec3(planeRows[i]));
+        camera = glm::vec3(glm::inverse(view * model) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+
+    // collects the index ranges of the visible meshlets, see counts()/offsets()
+    void cull(const std::vector<Meshlet> &meshlets)
+    {
+        static MetricCounter &submitted = metrics().counter("meshlet_triangles_total", "Triangles of meshlets given to the culler");
+        static MetricCounter &frustumCulled = metrics().counter("meshlet_triangles_frustum_culled_total", "Triangles rejected with meshlets outside the view frustum");
+        static MetricCounter &backfaceCulled = metrics().counter("meshlet_triangles_backface_culled_total", "Triangles rejected with meshlets facing away from the camera");
+
+        rangeCounts.clear();
+        rangeOffsets.clear();
+        size_t rangeEnd = ~size_t(0);
+        size_t frustum = 0, backface = 0, triangles = 0;
+        for (const Meshlet &meshlet : meshlets)
+        {
+            const size_t count = meshlet.indexCount / 3;
+            triangles += count;
+            if (frustumCulling && outsideFrustum(meshlet))
+            {
+                frustum += count;
+                continue;
+            }
+            if (coneCulling && glm::dot(glm::normalize(meshlet.coneApex - camera), meshlet.coneAxis) >= meshlet.coneCutoff)
+            {
+                backface += count;
+                continue;
+            }
+            current.meshletsDrawn++;
+            if (meshlet.firstIndex == rangeEnd)
+                rangeCounts.back() += (GLsizei)meshlet.indexCount;
+            else
+            {
+                rangeCounts.push_back((GLsizei)meshlet.indexCount);
+                rangeOffsets.push_back(reinterpret_cast<const void *>((size_t)meshlet.firstIndex * sizeof(GLuint)));
+            }
+            rangeEnd = meshlet.firstIndex + meshlet.indexCount;
+        }
+        current.meshlets += meshlets.size();
+        current.triangles += triangles;
+        current.frustumRejected += frustum;
+        current.backfaceRejected += backface;
+        current.draws += rangeCounts.size();
+        submitted.add(triangles);
+        frustumCulled.add(frustum);
+        backfaceCulled.add(backface);
+    }
+
+    // index counts and byte offsets of the last cull(), for glMultiDrawElements
+    const std::vector<GLsizei> &counts() const { return rangeCounts; }
+    const std::vector<const void *> &offsets() const { return rangeOffsets; }
+
+    // totals since the last resetStats(), e.g. per frame
+    const Stats &stats() const { return current; }
+    void resetStats() { current = Stats(); }
+
+private:
+    glm::vec4 planes[6];
+    glm::vec3 camera = glm::vec3(0.0f);
+    std::vector<GLsizei> rangeCounts;
+    std::vector<const void *> rangeOffsets;
+    Stats current;
+
+    bool outsideFrustum(const Meshlet &meshlet) const
+    {
+        for (const glm::vec4 &plane : planes)
+            if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius)
+                return true;
+        return false;
+    }
+};
+#endif
@@ -0,0 +1,365 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+// Always-on metrics: counters, gauges and histograms that the simulation, the renderer and the loaders
+// publish into, cheap enough to stay enabled in every build. A metric is registered once by name and
+// then updated through its handle without taking a lock:
+//
+//   static MetricCounter &drawCalls = metrics().counter("renderer_draw_calls_total", "Draw calls issued");
+//   drawCalls.add();
+//
+// Counters and histograms keep one cache line per thread slot and sum the slots when they are read, so
+// threads updating the same metric don't fight over a cache line (threads beyond METRIC_SLOTS share
+// slots, which stays correct, the updates are atomic). MetricsWriter dumps the registry periodically in
+// the Prometheus text format or as JSON lines.
+
+constexpr unsigned int METRIC_SLOTS = 16;
+
+// slot of the calling thread, handed out round robin on first use
+inline unsigned int metricSlot()
+{
+    static std::atomic<unsigned int> next{0};
+    thread_local const unsigned int slot = next.fetch_add(1, std::memory_order_relaxed) % METRIC_SLOTS;
+    return slot;
+}
+
+// monotonically increasing count
+class MetricCounter
+{
+public:
+    void add(uint64_t n = 1)
+    {
+        slots[metricSlot()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const
+    {
+        uint64_t sum = 0;
+        for (const Slot &slot : slots)
+            sum += slot.value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> value{0};
+    };
+    Slot slots[METRIC_SLOTS];
+};
+
+// last value set, e.g. a size
+class MetricGauge
+{
+public:
+    void set(double v)
+    {
+        current.store(v, std::memory_order_relaxed);
+    }
+
+    double value() const
+    {
+        return current.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> current{0.0};
+};
+
+// distribution of observed values over fixed buckets (upper bounds, ascending; +Inf is implicit)
+class MetricHistogram
+{
+public:
+    explicit MetricHistogram(std::vector<double> upperBounds) : upper(std::move(upperBounds))
+    {
+        std::sort(upper.begin(), upper.end());
+        for (Slot &slot : slots)
+            slot.counts.reset(new std::atomic<uint64_t>[upper.size() + 1]());
+    }
+
+    void observe(double v)
+    {
+        const size_t bucket = std::lower_bound(upper.begin(), upper.end(), v) - upper.begin();
+        Slot &slot = slots[metricSlot()];
+        slot.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        double sum = slot.sum.load(std::memory_order_relaxed);
+        while (!slot.sum.compare_exchange_weak(sum, sum + v, std::memory_order_relaxed))
+            ;
+    }
+
+    const std::vector<double> &bounds() const
+    {
+        return upper;
+    }
+
+    // observations per bucket (not cumulative), the last one is +Inf
+    std::vector<uint64_t> counts() const
+    {
+        std::vector<uint64_t> result(upper.size() + 1, 0);
+        for (const Slot &slot : slots)
+            for (size_t b = 0; b < result.size(); ++b)
+                result[b] += slot.counts[b].load(std::memory_order_relaxed);
+        return result;
+    }
+
+    double sum() const
+    {
+        double total = 0.0;
+        for (const Slot &slot : slots)
+            total += slot.sum.load(std::memory_order_relaxed);
+        return total;
+    }
+
+private:
+    struct alignas(64) Slot
+    {
+        std::unique_ptr<std::atomic<uint64_t>[]> counts;
+        std::atomic<double> sum{0.0};
+    };
+    std::vector<double> upper;
+    Slot slots[METRIC_SLOTS];
+};
+
+class MetricsRegistry
+{
+public:
+    // returns the metric registered under `name`, registering it on first use; keep the reference
+    // (in a function local static) instead of looking the name up on every update
+    MetricCounter &counter(const std::string &name, const std::string &help)
+    {
+        return *find(name, help, COUNTER, {}).counter;
+    }
+
+    MetricGauge &gauge(const std::string &name, const std::string &help)
+    {
+        return *find(name, help, GAUGE, {}).gauge;
+    }
+
+    MetricHistogram &histogram(const std::string &name, const std::string &help, std::vector<double> upperBounds)
+    {
+        return *find(name, help, HISTOGRAM, std::move(upperBounds)).histogram;
+    }
+
+    // Prometheus text exposition format (version 0.0.4)
+    void writePrometheus(std::ostream &out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        out << std::setprecision(10);
+        for (const Entry &entry : entries)
+        {
+            static const char *types[] = { "counter", "gauge", "histogram" };
+            out << "# HELP " << entry.name << ' ' << entry.help << '\n';
+            out << "# TYPE " << entry.name << ' ' << types[entry.kind] << '\n';
+            if (entry.kind == COUNTER)
+                out << entry.name << ' ' << entry.counter->value() << '\n';
+            else if (entry.kind == GAUGE)
+                out << entry.name << ' ' << entry.gauge->value() << '\n';
+            else
+            {
+                const std::vector<uint64_t> counts = entry.histogram->counts();
+                uint64_t cumulative = 0;
+                for (size_t b = 0; b < counts.size(); ++b)
+                {
+                    cumulative += counts[b];
+                    out << entry.name << "_bucket{le=\"";
+                    if (b < entry.histogram->bounds().size())
+                        out << entry.histogram->bounds()[b];
+                    else
+                        out << "+Inf";
+                    out << "\"} " << cumulative << '\n';
+                }
+                out << entry.name << "_sum " << entry.histogram->sum() << '\n';
+                out << entry.name << "_count " << cumulative << '\n';
+            }
+        }
+    }
+
+    // one JSON object on one line; histograms as {"sum", "count", "buckets": {upper bound: cumulative count}}
+    void writeJsonLine(std::ostream &out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+        out << std::setprecision(10) << "{\"timestamp_ms\":" << now.count();
+        for (const Entry &entry : entries)
+        {
+            out << ",\"" << entry.name << "\":";
+            if (entry.kind == COUNTER)
+                out << entry.counter->value();
+            else if (entry.kind == GAUGE)
+                out << entry.gauge->value();
+            else
+            {
+                const std::vector<uint64_t> counts = entry.histogram->counts();
+                uint64_t cumulative = 0;
+                out << "{\"buckets\":{";
+                for (size_t b = 0; b < counts.size(); ++b)
+                {
+                    cumulative += counts[b];
+                    out << (b > 0 ? "," : "") << '"';
+                    if (b < entry.histogram->bounds().size())
+                        out << entry.histogram->bounds()[b];
+                    else
+                        out << "+Inf";
+                    out << "\":" << cumulative;
+                }
+                out << "},\"sum\":" << entry.histogram->sum() << ",\"count\":" << cumulative << '}';
+            }
+        }
+        out << "}\n";
+    }
+
+private:
+    enum Kind { COUNTER, GAUGE, HISTOGRAM };
+
+    struct Entry
+    {
+        std::string name;
+        std::string help;
+        Kind kind;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<MetricHistogram> histogram;
+    };
+
+    // registration and export only, updates never lock
+    std::mutex mutex;
+    std::deque<Entry> entries; // a deque keeps references to the metrics valid while it grows
+    std::deque<Entry> detached; // name clashes, not exported
+
+    Entry &find(const std::string &name, const std::string &help, Kind kind, std::vector<double> upperBounds)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::deque<Entry> *list = &entries;
+        for (Entry &entry : entries)
+        {
+            if (entry.name != name)
+                continue;
+            if (entry.kind == kind)
+                return entry;
+            // keep the first registration, hand the caller a metric nobody exports
+            std::cout << "ERROR::METRICS:: " << name << " is already registered as another kind of metric" << std::endl;
+            list = &detached;
+            break;
+        }
+
+        list->push_back(Entry{ name, help, kind, nullptr, nullptr, nullptr });
+        Entry &entry = list->back();
+        if (kind == COUNTER)
+            entry.counter.reset(new MetricCounter());
+        else if (kind == GAUGE)
+            entry.gauge.reset(new MetricGauge());
+        else
+            entry.histogram.reset(new MetricHistogram(std::move(upperBounds)));
+        return entry;
+    }
+};
+
+inline MetricsRegistry &metrics()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+// Writes metrics() to a file on a background thread every `interval` and once more on stop(). The
+// Prometheus format rewrites the whole file (through a temporary file that is renamed over it, so a
+// collector never reads half a dump); JSON lines appends one line per dump.
+class MetricsWriter
+{
+public:
+    enum Format { PROMETHEUS, JSON_LINES };
+
+    MetricsWriter() = default;
+    MetricsWriter(const MetricsWriter &) = delete;
+    MetricsWriter &operator=(const MetricsWriter &) = delete;
+
+    ~MetricsWriter()
+    {
+        stop();
+    }
+
+    // JSON lines for .json / .jsonl files, Prometheus text otherwise
+    static Format formatFor(const std::string &path)
+    {
+        const size_t dot = path.find_last_of('.');
+        const std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+        return extension == ".json" || extension == ".jsonl" ? JSON_LINES : PROMETHEUS;
+    }
+
+    void start(const std::string &file, Format fileFormat, std::chrono::milliseconds interval = std::chrono::seconds(1))
+    {
+        stop();
+        path = file;
+        format = fileFormat;
+        stopping = false;
+        if (format == JSON_LINES)
+            std::ofstream(path, std::ios::trunc); // start a fresh series
+        thread = std::thread([this, interval]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, interval, [this]() { return stopping; }))
+                write();
+        });
+    }
+
+    void stop()
+    {
+        if (!thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        thread.join();
+        write();
+    }
+
+private:
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::string path;
+    Format format = PROMETHEUS;
+
+    void write()
+    {
+        if (format == JSON_LINES)
+        {
+            std::ofstream out(path, std::ios::app);
+            metrics().writeJsonLine(out);
+            return;
+        }
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            if (!out)
+            {
+                std::cout << "ERROR::METRICS:: Could not write " << temporary << std::endl;
+                return;
+            }
+            metrics().writePrometheus(out);
+        }
+#ifdef _WIN32
+        std::remove(path.c_str()); // rename doesn't replace files on Windows
+#endif
+        std::rename(temporary.c_str(), path.c_str());
+    }
+};
+#endif
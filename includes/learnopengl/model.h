@@ -12,6 +12,10 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/gl_resources.h>
+#include <learnopengl/gltf_loader.h>
+#include <learnopengl/upload_thread.h>
+#include <learnopengl/metrics.h>
 
 #include <string>
 #include <fstream>
@@ -19,54 +23,409 @@
 #include <iostream>
 #include <map>
 #include <vector>
+#include <chrono>
+#include <cfloat>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+GLTexture TextureFromFile(const char *path, const string &directory, bool gamma = false);
+
+// what importing a model produces before any GL object exists; filled on whichever thread imports it
+struct ModelData
+{
+    struct Image
+    {
+        string path;                  // as named by the material, relative to the model's directory
+        string type;                  // sampler type of its first use (texture_diffuse, ...)
+        int width = 0, height = 0, components = 0;
+        vector<unsigned char> pixels; // empty if the file couldn't be read
+    };
+    struct MeshData
+    {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        vector<unsigned int> images;  // indices into ModelData::images
+    };
+
+    string directory;
+    vector<MeshData> meshes;
+    vector<Image> images;             // every texture file once, in order of first use
+    glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+    glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+    bool imported = false;
+};
+
+// the GL objects made from a ModelData on an UploadThread, before the model's vertex arrays exist
+struct ModelBuffers
+{
+    vector<GLTexture> textures;      // one per ModelData::images, empty for images that couldn't be read
+    vector<GLBuffer> vertexBuffers;  // one per ModelData::meshes
+    vector<GLBuffer> indexBuffers;
+};
+
+class ModelLoader;
 
 class Model 
 {
 public:
     // model data 
     vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<GLTexture> textureObjects;   // owns the GL textures of textures_loaded, they are deleted together with the model
+    vector<GLBuffer> bufferObjects;     // vertex data shared by meshes that don't own theirs (.glb models)
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    glm::vec3 boundsMin = glm::vec3(0.0f); // bounding box of all vertices, valid once the model is imported
+    glm::vec3 boundsMax = glm::vec3(0.0f);
 
-    // constructor, expects a filepath to a 3D model.
+    // constructor, expects a filepath to a 3D model. .glb files are read by GlbLoader, the rest by Assimp
     Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
     {
-        loadModel(path);
+        if (isGlbPath(path))
+            loadGlbModel(path);
+        else
+            loadModel(path);
+    }
+
+    // asynchronous constructor: returns right away and leaves the import to the loader's threads and
+    // the upload to ModelLoader::poll(). In between, Draw() renders a grey box of the model's bounds
+    // (from the moment the import finished). The model must not move while it is loading.
+    Model(string const &path, ModelLoader &modelLoader, bool gamma = false);
+
+    ~Model();
+
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+
+    // true once all meshes and textures are uploaded
+    bool isReady() const
+    {
+        return ready;
     }
 
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        vector<Mesh> &drawn = drawnMeshes();
+        for(unsigned int i = 0; i < drawn.size(); i++)
+            drawn[i].Draw(shader);
     }
-    
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path)
+
+    // splits every mesh into meshlets of at most maxTriangles triangles and maxVertices vertices for
+    // DrawCulled(); a model that is still loading gets them once its meshes arrive. Asking again for the
+    // same sizes (a model shared through AssetCache, say) keeps the meshlets it has
+    void buildMeshlets(unsigned int maxTriangles = 124, unsigned int maxVertices = 64)
+    {
+        if (meshletTriangles == maxTriangles && meshletVertices == maxVertices)
+            return;
+        meshletTriangles = maxTriangles;
+        meshletVertices = maxVertices;
+        if (!ready)
+            return;
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].buildMeshlets(maxTriangles, maxVertices);
+    }
+
+    // draws the meshlets of every mesh that survive the culler, which must be set up with this
+    // model's transform (MeshletCuller::setTransform)
+    void DrawCulled(Shader &shader, MeshletCuller &culler)
+    {
+        vector<Mesh> &drawn = drawnMeshes();
+        for (unsigned int i = 0; i < drawn.size(); i++)
+            drawn[i].DrawCulled(shader, culler);
+    }
+
+    // instanced drawing: one instance is `stride` bytes of per-instance data, starting with its model
+    // matrix, which the shader reads as a mat4 input at matrixLocation (taking four locations); `extra`
+    // describes any further per-instance attributes behind it
+    void setInstanceLayout(GLuint matrixLocation, GLsizei stride = sizeof(glm::mat4), const vector<InstanceAttribute> &extra = {})
+    {
+        instanceLayout.clear();
+        for (GLuint column = 0; column < 4; column++)
+            instanceLayout.push_back({ matrixLocation + column, 4, GL_FLOAT, column * (GLuint)sizeof(glm::vec4) });
+        instanceLayout.insert(instanceLayout.end(), extra.begin(), extra.end());
+        instanceStride = stride;
+        vector<Mesh> &drawn = drawnMeshes();
+        for (unsigned int i = 0; i < drawn.size(); i++)
+            drawn[i].setInstanceLayout(instanceLayout);
+    }
+
+    // uploads `count` instances laid out as given to setInstanceLayout(); call it again whenever they
+    // change, every frame if need be, the upload goes through a stream buffer and doesn't stall
+    void setInstances(const void *data, GLsizei count)
+    {
+        if (instanceStride == 0)
+        {
+            cout << "ERROR::MODEL:: setInstances() before setInstanceLayout()" << endl;
+            return;
+        }
+        instanceCount = count;
+        if (count == 0)
+            return;
+        instanceOffset = instanceStream.write(data, (GLsizeiptr)count * instanceStride);
+        vector<Mesh> &drawn = drawnMeshes();
+        for (unsigned int i = 0; i < drawn.size(); i++)
+            drawn[i].bindInstances(instanceStream.buffer(), instanceOffset, instanceStride);
+    }
+    void setInstances(const vector<glm::mat4> &transforms)
+    {
+        setInstances(transforms.data(), (GLsizei)transforms.size());
+    }
+
+    // draws every mesh once per instance given to setInstances()
+    void DrawInstanced(Shader &shader)
+    {
+        if (instanceCount == 0)
+            return;
+        vector<Mesh> &drawn = drawnMeshes();
+        for(unsigned int i = 0; i < drawn.size(); i++)
+            drawn[i].DrawInstanced(shader, instanceCount);
+    }
+
+    // the CPU half of loading, safe on any thread as long as every thread has its own importer:
+    // reads the file, converts its meshes and decodes the textures they use
+    static bool importModel(string const &path, Assimp::Importer &importer, ModelData &data)
     {
         // read file via ASSIMP
-        Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            return false;
         }
         // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
+        data.directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        processNode(scene->mRootNode, scene, data);
+        importer.FreeScene();
+
+        for (ModelData::Image &image : data.images)
+        {
+            string filename = data.directory + '/' + image.path;
+            unsigned char *pixels = stbi_load(filename.c_str(), &image.width, &image.height, &image.components, 0);
+            if (pixels)
+                image.pixels.assign(pixels, pixels + (size_t)image.width * image.height * image.components);
+            else
+                std::cout << "Texture failed to load at path: " << image.path << std::endl;
+            stbi_image_free(pixels);
+        }
+        data.imported = true;
+        return true;
+    }
+    
+private:
+    friend class ModelLoader;
+
+    GLStreamBuffer instanceStream;
+    vector<InstanceAttribute> instanceLayout;
+    GLsizei instanceStride = 0;
+    GLsizei instanceCount = 0;
+    GLintptr instanceOffset = 0;
+    unsigned int meshletTriangles = 0; // set by buildMeshlets(), applied to meshes arriving later
+    unsigned int meshletVertices = 0;
+
+    // loading state; the synchronous constructor goes through the same steps in one go
+    bool ready = false;
+    ModelLoader *loader = nullptr;      // set while an asynchronous load is pending
+    shared_ptr<ModelData> staged;       // imported, not uploaded yet
+    vector<Mesh> uploaded;              // meshes uploaded so far, swapped into meshes when all are
+    vector<Mesh> placeholder;           // bounding box drawn while the model uploads
+    GLTexture placeholderTexture;
+    chrono::steady_clock::time_point loadStart;
+
+    vector<Mesh> &drawnMeshes()
+    {
+        return ready ? meshes : placeholder;
+    }
+
+    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+    void loadModel(string const &path)
+    {
+        loadStart = chrono::steady_clock::now();
+        Assimp::Importer importer;
+        shared_ptr<ModelData> data = make_shared<ModelData>();
+        if (!importModel(path, importer, *data))
+            return;
+        beginUpload(data);
+        while (!uploadStep())
+            ;
+    }
+
+    void loadGlbModel(string const &path)
+    {
+        GlbLoader loader(path, gammaCorrection);
+        if (loader.import())
+            uploadGlb(path, loader);
+    }
+
+    // the GL half of a .glb, imported by `loader`; its buffers are uploaded straight from the mapping, in one step
+    void uploadGlb(string const &path, GlbLoader &loader)
+    {
+        GlbModel glb;
+        loader.upload(glb);
+        directory = path.substr(0, path.find_last_of('/'));
+        meshes = std::move(glb.meshes);
+        textures_loaded = std::move(glb.textures);
+        textureObjects = std::move(glb.textureObjects);
+        bufferObjects = std::move(glb.buffers);
+        boundsMin = glb.boundsMin;
+        boundsMax = glb.boundsMax;
+        ready = true;
+        for (unsigned int i = 0; i < meshes.size(); i++)
+        {
+            applyInstancing(meshes[i]);
+            if (meshletTriangles)
+                meshes[i].buildMeshlets(meshletTriangles, meshletVertices);
+        }
+    }
+
+    // the GL half of loading, on the GL thread
+    void beginUpload(const shared_ptr<ModelData> &data)
+    {
+        staged = data;
+        directory = data->directory;
+        boundsMin = data->boundsMin;
+        boundsMax = data->boundsMax;
+    }
+
+    // uploads the next texture or mesh; returns true once the model is complete
+    bool uploadStep()
+    {
+        static MetricCounter &models = metrics().counter("loader_models_total", "Models loaded");
+        static MetricHistogram &loadTime = metrics().histogram("loader_model_seconds", "Import and upload time per model",
+                                                               { 0.01, 0.05, 0.1, 0.5, 1.0, 5.0 });
+        if (textureObjects.size() < staged->images.size())
+        {
+            const ModelData::Image &image = staged->images[textureObjects.size()];
+            if (image.pixels.empty())
+                textureObjects.emplace_back();
+            else
+                textureObjects.push_back(TextureFromPixels(image.pixels.data(), image.width, image.height, image.components));
+            textures_loaded.push_back({ textureObjects.back().id(), image.type, image.path });
+            return false;
+        }
+        if (uploaded.size() < staged->meshes.size())
+        {
+            ModelData::MeshData &data = staged->meshes[uploaded.size()];
+            vector<Texture> textures;
+            for (unsigned int image : data.images)
+                textures.push_back(textures_loaded[image]);
+            uploaded.emplace_back(std::move(data.vertices), std::move(data.indices), textures);
+            return false;
+        }
+
+        // every mesh at once, a partly uploaded model is never drawn
+        meshes = std::move(uploaded);
+        uploaded.clear();
+        staged.reset();
+        placeholder.clear();
+        placeholderTexture = GLTexture();
+        ready = true;
+        for (unsigned int i = 0; i < meshes.size(); i++)
+        {
+            applyInstancing(meshes[i]);
+            if (meshletTriangles)
+                meshes[i].buildMeshlets(meshletTriangles, meshletVertices);
+        }
+
+        models.add();
+        loadTime.observe(chrono::duration<double>(chrono::steady_clock::now() - loadStart).count());
+        return true;
+    }
+
+    // the GL half of loading when an UploadThread made the textures and buffers: the vertex arrays are
+    // all that is left to create on the GL thread
+    void completeUpload(ModelBuffers &buffers)
+    {
+        for (size_t i = 0; i < staged->images.size(); i++)
+        {
+            textureObjects.push_back(std::move(buffers.textures[i]));
+            textures_loaded.push_back({ textureObjects.back().id(), staged->images[i].type, staged->images[i].path });
+        }
+        for (size_t i = 0; i < staged->meshes.size(); i++)
+        {
+            ModelData::MeshData &data = staged->meshes[i];
+            vector<Texture> textures;
+            for (unsigned int image : data.images)
+                textures.push_back(textures_loaded[image]);
+            uploaded.emplace_back(std::move(data.vertices), std::move(data.indices), textures,
+                                  std::move(buffers.vertexBuffers[i]), std::move(buffers.indexBuffers[i]));
+        }
+        // nothing left to upload, this swaps the meshes in
+        uploadStep();
+    }
+
+    // runs on the upload thread
+    static void uploadBuffers(const ModelData &data, ModelBuffers &buffers)
+    {
+        for (const ModelData::Image &image : data.images)
+        {
+            if (image.pixels.empty())
+                buffers.textures.emplace_back();
+            else
+                buffers.textures.push_back(TextureFromPixels(image.pixels.data(), image.width, image.height, image.components));
+        }
+        for (const ModelData::MeshData &mesh : data.meshes)
+        {
+            buffers.vertexBuffers.emplace_back(mesh.vertices.size() * sizeof(Vertex), mesh.vertices.data());
+            buffers.indexBuffers.emplace_back(mesh.indices.size() * sizeof(unsigned int), mesh.indices.data());
+        }
+    }
+
+    void applyInstancing(Mesh &mesh)
+    {
+        if (!instanceLayout.empty())
+            mesh.setInstanceLayout(instanceLayout);
+        if (instanceCount > 0)
+            mesh.bindInstances(instanceStream.buffer(), instanceOffset, instanceStride);
+    }
+
+    // a box over the bounds, textured 1x1 grey as texture_diffuse1 so the model's own shader can draw it
+    void createPlaceholder()
+    {
+        if (staged->boundsMin.x > staged->boundsMax.x)
+            return; // no vertices
+        const unsigned char grey[4] = { 128, 128, 128, 255 };
+        placeholderTexture = TextureFromPixels(grey, 1, 1, 4);
+
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        for (int face = 0; face < 6; face++)
+        {
+            // face 2 * axis faces -axis, face 2 * axis + 1 faces +axis
+            const int axis = face / 2, u = (axis + 1) % 3, v = (axis + 2) % 3;
+            const bool positive = face % 2 == 1;
+            const unsigned int first = (unsigned int)vertices.size();
+            for (int corner = 0; corner < 4; corner++)
+            {
+                Vertex vertex = {};
+                vertex.Position[axis] = positive ? boundsMax[axis] : boundsMin[axis];
+                vertex.Position[u] = (corner & 1) ? boundsMax[u] : boundsMin[u];
+                vertex.Position[v] = (corner & 2) ? boundsMax[v] : boundsMin[v];
+                vertex.Normal[axis] = positive ? 1.0f : -1.0f;
+                vertex.TexCoords = glm::vec2(corner & 1, corner >> 1);
+                vertices.push_back(vertex);
+            }
+            // counter-clockwise seen from outside
+            if (positive)
+                indices.insert(indices.end(), { first, first + 1, first + 3, first, first + 3, first + 2 });
+            else
+                indices.insert(indices.end(), { first, first + 3, first + 1, first, first + 2, first + 3 });
+        }
+        placeholder.emplace_back(vertices, indices, vector<Texture>{ { placeholderTexture.id(), "texture_diffuse", "" } });
+        applyInstancing(placeholder.back());
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    static void processNode(aiNode *node, const aiScene *scene, ModelData &data)
     {
         // process each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -74,22 +433,27 @@ private:
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            data.meshes.push_back(processMesh(mesh, scene, data));
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, data);
         }
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    static ModelData::MeshData processMesh(aiMesh *mesh, const aiScene *scene, ModelData &data)
     {
+        static MetricCounter &meshCount = metrics().counter("loader_meshes_total", "Meshes loaded by Model");
+        static MetricCounter &vertexCount = metrics().counter("loader_vertices_total", "Vertices loaded by Model");
+        meshCount.add();
+        vertexCount.add(mesh->mNumVertices);
+
         // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        ModelData::MeshData result;
+        vector<Vertex> &vertices = result.vertices;
+        vector<unsigned int> &indices = result.indices;
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -101,6 +465,8 @@ private:
             vector.y = mesh->mVertices[i].y;
             vector.z = mesh->mVertices[i].z;
             vertex.Position = vector;
+            data.boundsMin = glm::min(data.boundsMin, vector);
+            data.boundsMax = glm::max(data.boundsMax, vector);
             // normals
             if (mesh->HasNormals())
             {
@@ -152,86 +518,297 @@ private:
         // normal: texture_normalN
 
         // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", data, result);
         // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", data, result);
         // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+        loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal", data, result);
         // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+        loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height", data, result);
         
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // return the mesh data extracted
+        return result;
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    // checks all material textures of a given type and adds the ones not seen yet to the images to load.
+    static void loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName, ModelData &data, ModelData::MeshData &mesh)
     {
-        vector<Texture> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            // check if texture was referenced before and if so, reuse it: every file is loaded once (optimization)
+            unsigned int image = 0;
+            while (image < data.images.size() && std::strcmp(data.images[image].path.data(), str.C_Str()) != 0)
+                image++;
+            if (image == data.images.size())
+            {
+                data.images.emplace_back();
+                data.images.back().path = str.C_Str();
+                data.images.back().type = typeName;
+            }
+            mesh.images.push_back(image);
+        }
+    }
+};
+
+// Loads models without blocking the frame: worker threads, each with an Assimp::Importer of its own
+// (importers aren't thread safe), import the files, convert the meshes and decode the textures; poll()
+// then uploads the results on the GL thread, one texture or mesh at a time until its time budget is
+// spent; with setUploadThread() the upload thread does that and poll() only creates the vertex arrays.
+// .glb files go through GlbLoader instead of Assimp: the workers map and parse them and decode their
+// images, and poll() uploads each in one step, straight from the mapping.
+// A model draws a grey box of its bounds from the end of its import until it is complete:
+//
+//   ModelLoader loader;
+//   Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"), loader);
+//   Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"), loader);
+//   while (!glfwWindowShouldClose(window))
+//   {
+//       loader.poll(); // or loader.finish() once to wait for all of them
+//       planet.Draw(shader);
+//       ...
+//
+// stbi_set_flip_vertically_on_load is read by the worker threads, so don't change it while models load.
+class ModelLoader
+{
+public:
+    // threads: number of import threads, 0 for all hardware threads but the one rendering
+    explicit ModelLoader(unsigned int threads = 0)
+    {
+        if (threads == 0)
+            threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        for (unsigned int i = 0; i < threads; i++)
+            workers.emplace_back([this]() { work(); });
+    }
+
+    ~ModelLoader()
+    {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread &worker : workers)
+            worker.join();
+        // models still loading stay empty
+        for (const shared_ptr<Job> &job : jobs)
+            job->model->loader = nullptr;
+    }
+
+    ModelLoader(const ModelLoader &) = delete;
+    ModelLoader &operator=(const ModelLoader &) = delete;
+
+    // uploads imported models until `budget` is spent (at least one step per call; duration::max() is
+    // no limit), or hands them to the upload thread; returns true once every model is complete
+    bool poll(chrono::steady_clock::duration budget = chrono::milliseconds(2))
+    {
+        const auto start = chrono::steady_clock::now();
+        if (uploads)
+            uploads->poll();
+        for (size_t i = 0; i < jobs.size();)
+        {
+            Job &job = *jobs[i];
+            if (!job.done.load(memory_order_acquire))
+            {
+                i++;
+                continue;
+            }
+            Model &model = *job.model;
+            if (!job.data->imported)
+            {
+                // the worker reported why; like the synchronous constructor, the model stays empty
+                model.loader = nullptr;
+                jobs.erase(jobs.begin() + i);
+                continue;
+            }
+            if (job.glb)
+            {
+                model.uploadGlb(job.path, *job.glb);
+                model.loader = nullptr;
+                jobs.erase(jobs.begin() + i);
+                continue;
+            }
+            if (!model.staged)
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
+                model.beginUpload(job.data);
+                model.createPlaceholder();
+                if (uploads)
                 {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
+                    // the job outlives a model destroyed in the meantime, and owns what was uploaded for it
+                    shared_ptr<Job> shared = jobs[i];
+                    uploads->submit([shared]() { Model::uploadBuffers(*shared->data, shared->buffers); },
+                                    [shared]() { shared->uploaded = true; });
+                    job.uploading = true;
                 }
             }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
+            if (job.uploading)
+            {
+                if (!job.uploaded)
+                {
+                    i++;
+                    continue;
+                }
+                model.completeUpload(job.buffers);
+            }
+            else
+            {
+                bool complete;
+                do
+                    complete = model.uploadStep();
+                while (!complete && chrono::steady_clock::now() - start < budget);
+                if (!complete)
+                    return false;
+            }
+            model.loader = nullptr;
+            jobs.erase(jobs.begin() + i);
+        }
+        return jobs.empty();
+    }
+
+    // blocks until every model is complete
+    void finish()
+    {
+        for (;;)
+        {
+            size_t seen;
+            {
+                lock_guard<mutex> lock(queueMutex);
+                seen = importsFinished;
+            }
+            // without a budget poll() uploads everything imported so far; what's left is still being
+            // imported, or uploaded on the upload thread
+            if (poll(chrono::steady_clock::duration::max()))
+                return;
+            unique_lock<mutex> lock(queueMutex);
+            imported.wait_for(lock, chrono::milliseconds(1), [this, seen]() { return importsFinished != seen; });
+        }
+    }
+
+    // models imported or uploading right now
+    size_t pending() const
+    {
+        return jobs.size();
+    }
+
+    // uploads the models imported from now on on `thread` (nullptr: on the GL thread, in poll());
+    // the upload thread must outlive the loader
+    void setUploadThread(UploadThread *thread)
+    {
+        uploads = thread;
+    }
+
+private:
+    friend class Model;
+
+    struct Job
+    {
+        Model *model = nullptr;
+        string path;
+        bool gamma = false;
+        shared_ptr<ModelData> data = make_shared<ModelData>();
+        unique_ptr<GlbLoader> glb;      // .glb files: imported by GlbLoader, data only says whether it worked
+        atomic<bool> done{ false };
+        ModelBuffers buffers;           // filled on the upload thread
+        bool uploading = false;         // handed to the upload thread
+        bool uploaded = false;          // and its completion ran
+    };
+
+    vector<shared_ptr<Job>> jobs;   // GL thread only, in order of creation
+    vector<thread> workers;
+    mutex queueMutex;
+    condition_variable wake;
+    condition_variable imported;    // a worker finished a job
+    size_t importsFinished = 0;
+    deque<shared_ptr<Job>> queue;   // not picked up by a worker yet
+    bool stopping = false;
+    UploadThread *uploads = nullptr;
+
+    void enqueue(Model *model, const string &path)
+    {
+        shared_ptr<Job> job = make_shared<Job>();
+        job->model = model;
+        job->path = path;
+        job->gamma = model->gammaCorrection;
+        jobs.push_back(job);
+        {
+            lock_guard<mutex> lock(queueMutex);
+            queue.push_back(job);
+        }
+        wake.notify_one();
+    }
+
+    // the model is destroyed before it completed; a worker importing it finishes into the orphaned job
+    void cancel(Model *model)
+    {
+        for (size_t i = 0; i < jobs.size(); i++)
+        {
+            if (jobs[i]->model != model)
+                continue;
+            {
+                lock_guard<mutex> lock(queueMutex);
+                queue.erase(std::remove(queue.begin(), queue.end(), jobs[i]), queue.end());
+            }
+            jobs.erase(jobs.begin() + i);
+            return;
+        }
+    }
+
+    void work()
+    {
+        Assimp::Importer importer;
+        for (;;)
+        {
+            shared_ptr<Job> job;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (stopping)
+                    return;
+                job = queue.front();
+                queue.pop_front();
+            }
+            if (isGlbPath(job->path))
+            {
+                job->glb.reset(new GlbLoader(job->path, job->gamma));
+                job->data->imported = job->glb->import();
             }
+            else
+                Model::importModel(job->path, importer, *job->data);
+            job->done.store(true, memory_order_release);
+            {
+                lock_guard<mutex> lock(queueMutex);
+                importsFinished++;
+            }
+            imported.notify_all();
         }
-        return textures;
     }
 };
 
+inline Model::Model(string const &path, ModelLoader &modelLoader, bool gamma) : gammaCorrection(gamma), loader(&modelLoader)
+{
+    loadStart = chrono::steady_clock::now();
+    modelLoader.enqueue(this, path);
+}
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+inline Model::~Model()
+{
+    if (loader)
+        loader->cancel(this);
+}
+
+GLTexture TextureFromFile(const char *path, const string &directory, bool gamma)
 {
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    GLTexture texture;
 
     int width, height, nrComponents;
     unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     if (data)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
+        texture = TextureFromPixels(data, width, height, nrComponents);
         stbi_image_free(data);
     }
     else
@@ -240,6 +817,6 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
         stbi_image_free(data);
     }
 
-    return textureID;
+    return texture;
 }
 #endif
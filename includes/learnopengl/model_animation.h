@@ -12,6 +12,8 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/gl_resources.h>
+#include <learnopengl/gltf_loader.h>
 
 #include <string>
 #include <fstream>
@@ -29,16 +31,21 @@ class Model
 public:
     // model data 
     vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<GLTexture> textureObjects;   // owns the GL textures of textures_loaded, they are deleted together with the model
+    vector<GLBuffer> bufferObjects;     // vertex data shared by meshes that don't own theirs (.glb models)
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
 	
 	
 
-    // constructor, expects a filepath to a 3D model.
+    // constructor, expects a filepath to a 3D model. .glb files are read by GlbLoader, the rest by Assimp
     Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
     {
-        loadModel(path);
+        if (isGlbPath(path))
+            loadGlbModel(path);
+        else
+            loadModel(path);
     }
 
     // draws the model, and thus all its meshes
@@ -76,6 +83,19 @@ private:
         processNode(scene->mRootNode, scene);
     }
 
+    // skins go into the same bone map as with Assimp, so Animation can be read from the same file
+    void loadGlbModel(string const &path)
+    {
+        GlbModel glb;
+        if (!loadGlb(path, glb, gammaCorrection, &m_BoneInfoMap, &m_BoneCounter))
+            return;
+        directory = path.substr(0, path.find_last_of('/'));
+        meshes = std::move(glb.meshes);
+        textures_loaded = std::move(glb.textures);
+        textureObjects = std::move(glb.textureObjects);
+        bufferObjects = std::move(glb.buffers);
+    }
+
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
     void processNode(aiNode *node, const aiScene *scene)
     {
@@ -203,34 +223,36 @@ private:
 	}
 
 
-	unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false)
+	GLTexture TextureFromFile(const char* path, const string& directory, bool gamma = false)
 	{
 		string filename = string(path);
 		filename = directory + '/' + filename;
 
-		unsigned int textureID;
-		glGenTextures(1, &textureID);
+		GLTexture texture;
 
 		int width, height, nrComponents;
 		unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
 		if (data)
 		{
-			GLenum format;
+			GLenum format, internalFormat;
 			if (nrComponents == 1)
-				format = GL_RED;
+				format = GL_RED, internalFormat = GL_R8;
 			else if (nrComponents == 3)
-				format = GL_RGB;
-			else if (nrComponents == 4)
-				format = GL_RGBA;
+				format = GL_RGB, internalFormat = GL_RGB8;
+			else
+				format = GL_RGBA, internalFormat = GL_RGBA8;
 
-			glBindTexture(GL_TEXTURE_2D, textureID);
-			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
+			GLsizei levels = 1;
+			while ((std::max(width, height) >> levels) > 0)
+				levels++;
+			texture.storage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+			texture.subImage2D(0, width, height, format, GL_UNSIGNED_BYTE, data);
+			texture.generateMipmap();
 
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			texture.parameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+			texture.parameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
+			texture.parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			texture.parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 			stbi_image_free(data);
 		}
@@ -240,7 +262,7 @@ private:
 			stbi_image_free(data);
 		}
 
-		return textureID;
+		return texture;
 	}
     
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -266,7 +288,8 @@ private:
             if(!skip)
             {   // if texture hasn't been loaded already, load it
                 Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
+                textureObjects.push_back(TextureFromFile(str.C_Str(), this->directory));
+                texture.id = textureObjects.back().id();
                 texture.type = typeName;
                 texture.path = str.C_Str();
                 textures.push_back(texture);
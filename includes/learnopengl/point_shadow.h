@@ -0,0 +1,170 @@
+#ifndef POINT_SHADOW_H
+#define POINT_SHADOW_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <array>
+#include <vector>
+#include <algorithm>
+
+// a shadow caster as seen by the omnidirectional shadow pass: its model matrix plus the radius
+// of a bounding sphere around its local-space origin (e.g. sqrt(3) for the unit cube of renderCube()).
+struct ShadowCaster
+{
+    glm::mat4 model;
+    float     localRadius;
+};
+
+// Culls shadow casters against the six 90 degree frusta of a point light's depth cubemap and keeps
+// track of which cube faces actually have to be re-rendered this frame. A face stays cached (its
+// depth is left untouched in the cubemap) as long as the light and every caster touching that face
+// did not move since the face was last rendered.
+class PointShadowCuller
+{
+public:
+    // per-frame statistics, counted in caster-face draws (one caster rendered into one face)
+    unsigned int facesRendered   = 0;
+    unsigned int casterFaceDraws = 0;
+    unsigned int casterFaceSaved = 0;
+
+    PointShadowCuller(float nearPlane, float farPlane, float aspect = 1.0f)
+        : nearPlane(nearPlane), farPlane(farPlane)
+    {
+        shadowProj = glm::perspective(glm::radians(90.0f), aspect, nearPlane, farPlane);
+    }
+
+    // classifies all casters against the six faces and determines the dirty faces; call once per frame
+    // before rendering the depth cubemap. Returns true if at least one face has to be re-rendered.
+    bool update(const glm::vec3 &lightPos, const std::vector<ShadowCaster> &casters)
+    {
+        dirty = 0;
+        transformsChanged = false;
+        if (!valid || lightPos != cachedLightPos)
+        {
+            rebuildTransforms(lightPos);
+            dirty = ALL_FACES;
+        }
+        if (casters.size() != cachedModels.size())
+        {
+            cachedModels.assign(casters.size(), glm::mat4(0.0f));
+            cachedMasks.assign(casters.size(), 0);
+            dirty = ALL_FACES;
+        }
+
+        masks.resize(casters.size());
+        for (size_t i = 0; i < casters.size(); ++i)
+        {
+            masks[i] = classify(casters[i]);
+            // a moving caster invalidates both the faces it left and the faces it entered
+            if (casters[i].model != cachedModels[i])
+                dirty |= masks[i] | cachedMasks[i];
+            cachedModels[i] = casters[i].model;
+            cachedMasks[i]  = masks[i];
+        }
+        valid = true;
+
+        facesRendered   = 0;
+        casterFaceDraws = 0;
+        for (unsigned int face = 0; face < 6; ++face)
+            if (dirty & (1u << face))
+                ++facesRendered;
+        for (size_t i = 0; i < casters.size(); ++i)
+            casterFaceDraws += popcount(masks[i] & dirty);
+        // the brute-force path renders every caster into all six faces through the geometry shader
+        casterFaceSaved = static_cast<unsigned int>(casters.size()) * 6 - casterFaceDraws;
+        return dirty != 0;
+    }
+
+    // bitmask of the cube faces (bit i = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i) that must be re-rendered
+    unsigned int dirtyFaces() const
+    {
+        return dirty;
+    }
+
+    // bitmask of the dirty faces the given caster overlaps; 0 means the caster can be skipped entirely
+    unsigned int drawMask(size_t caster) const
+    {
+        return masks[caster] & dirty;
+    }
+
+    // true if the face matrices were rebuilt this frame and have to be re-uploaded
+    bool matricesChanged() const
+    {
+        return transformsChanged;
+    }
+
+    const std::array<glm::mat4, 6> &shadowTransforms() const
+    {
+        return transforms;
+    }
+
+    // forces all faces to be re-rendered next frame (e.g. after the cubemap was re-created)
+    void invalidate()
+    {
+        valid = false;
+    }
+
+private:
+    static constexpr unsigned int ALL_FACES = 0x3F;
+
+    float nearPlane;
+    float farPlane;
+    glm::mat4 shadowProj;
+    glm::vec3 cachedLightPos = glm::vec3(0.0f);
+    std::array<glm::mat4, 6> transforms;
+    bool valid = false;
+    bool transformsChanged = false;
+    unsigned int dirty = 0;
+
+    std::vector<unsigned int> masks;
+    std::vector<unsigned int> cachedMasks;
+    std::vector<glm::mat4>    cachedModels;
+
+    void rebuildTransforms(const glm::vec3 &lightPos)
+    {
+        transforms[0] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f));
+        transforms[1] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f));
+        transforms[2] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f));
+        transforms[3] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f));
+        transforms[4] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f));
+        transforms[5] = shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f));
+        cachedLightPos = lightPos;
+        transformsChanged = true;
+    }
+
+    // returns the bitmask of the cube faces whose frustum the caster's bounding sphere intersects
+    unsigned int classify(const ShadowCaster &caster) const
+    {
+        const glm::vec3 scale(glm::length(glm::vec3(caster.model[0])), glm::length(glm::vec3(caster.model[1])), glm::length(glm::vec3(caster.model[2])));
+        const float radius = caster.localRadius * std::max(std::max(scale.x, scale.y), scale.z);
+        const glm::vec3 c = glm::vec3(caster.model[3]) - cachedLightPos;
+        // the side planes of a 90 degree face frustum are at 45 degrees, so their distance to a
+        // point is (u -+ v) / sqrt(2); we compare against the scaled radius instead of normalizing.
+        const float r2 = radius * 1.41421356f;
+
+        unsigned int mask = 0;
+        for (unsigned int face = 0; face < 6; ++face)
+        {
+            const int axis = face / 2;
+            const float u = (face % 2 == 0) ? c[axis] : -c[axis]; // distance along the face axis
+            const float v = c[(axis + 1) % 3];
+            const float w = c[(axis + 2) % 3];
+            if (u + radius < nearPlane || u - radius > farPlane)
+                continue;
+            if (u - v < -r2 || u + v < -r2 || u - w < -r2 || u + w < -r2)
+                continue;
+            mask |= 1u << face;
+        }
+        return mask;
+    }
+
+    static unsigned int popcount(unsigned int v)
+    {
+        unsigned int count = 0;
+        for (; v; v &= v - 1)
+            ++count;
+        return count;
+    }
+};
+#endif
@@ -0,0 +1,552 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_resources.h>
+#include <learnopengl/metrics.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+
+// A frame described as passes that declare which textures they render into and which they sample,
+// instead of framebuffers allocated up front and kept for the whole run. Every frame the graph is
+// filled again, then compile() orders the passes by their dependencies, culls the ones nothing visible
+// depends on and gives each transient texture a GL texture from a pool only for the passes between
+// its first and last use. Transients with disjoint lifetimes and the same description share one
+// texture, so e.g. a blur chain of ten passes needs two textures. execute() runs the passes, each with
+// a framebuffer of the textures it writes bound (cached) and the viewport set to their size:
+//
+//   graph.reset();
+//   RGTexture hdr;
+//   graph.addPass("scene", [&](RenderGraph::PassBuilder &pass) {
+//       hdr = pass.create("hdr", { width, height, GL_RGBA16F });
+//       pass.create("depth", { width, height, GL_DEPTH_COMPONENT24 });
+//   }, [&](const RenderGraph::PassContext &) { ... draw the scene ... });
+//   graph.addPass("tonemap", [&](RenderGraph::PassBuilder &pass) {
+//       pass.read(hdr); // writes nothing: renders to the default framebuffer
+//   }, [&](const RenderGraph::PassContext &context) { glBindTexture(GL_TEXTURE_2D, context.texture(hdr)); ... });
+//   graph.compile();
+//   graph.execute();
+//
+// Passes that write no texture render to the default framebuffer and are never culled, like passes
+// writing imported textures or marked with sideEffect(). Textures keep their contents only within
+// their lifetime, so passes clear what they create. GL can't alias memory between differently sized
+// or formatted textures, so sharing happens between equal descriptions only.
+
+struct RGTextureDesc
+{
+    GLsizei width = 0, height = 0;
+    GLenum format = GL_RGBA8;      // sized internal format; depth formats become depth attachments
+    GLenum filter = GL_LINEAR;
+    GLenum wrap = GL_CLAMP_TO_EDGE;
+
+    bool operator==(const RGTextureDesc &other) const
+    {
+        return width == other.width && height == other.height && format == other.format && filter == other.filter && wrap == other.wrap;
+    }
+};
+
+// handle of a texture in a RenderGraph, valid until the next reset()
+struct RGTexture
+{
+    int index = -1;
+
+    bool valid() const { return index >= 0; }
+};
+
+class RenderGraph
+{
+public:
+    // declares what a pass does with the graph's textures
+    class PassBuilder
+    {
+    public:
+        // a new transient texture this pass renders into first
+        RGTexture create(const std::string &name, const RGTextureDesc &desc)
+        {
+            RGTexture texture;
+            texture.index = (int)graph.resources.size();
+            graph.resources.push_back(Resource{ name, desc, nullptr, pass });
+            graph.passes[pass].writes.push_back(texture.index);
+            return texture;
+        }
+        // renders into a texture created (or imported) elsewhere, after the passes before it used it
+        RGTexture write(RGTexture texture)
+        {
+            if (texture.valid())
+                graph.passes[pass].writes.push_back(texture.index);
+            return texture;
+        }
+        // samples a texture
+        RGTexture read(RGTexture texture)
+        {
+            if (texture.valid())
+                graph.passes[pass].reads.push_back(texture.index);
+            return texture;
+        }
+        // keeps the pass even if nothing reads what it writes
+        void sideEffect()
+        {
+            graph.passes[pass].sideEffect = true;
+        }
+
+    private:
+        friend class RenderGraph;
+        RenderGraph &graph;
+        int pass;
+
+        PassBuilder(RenderGraph &graph, int pass) : graph(graph), pass(pass) {}
+    };
+
+    // what a pass sees while it runs
+    class PassContext
+    {
+    public:
+        // the GL texture behind a handle; only valid for textures the pass declared
+        unsigned int texture(RGTexture texture) const
+        {
+            return texture.valid() ? graph.textureName(texture.index) : 0;
+        }
+        const RGTextureDesc &desc(RGTexture texture) const
+        {
+            return graph.resources[texture.index].desc;
+        }
+
+    private:
+        friend class RenderGraph;
+        const RenderGraph &graph;
+
+        explicit PassContext(const RenderGraph &graph) : graph(graph) {}
+    };
+
+    struct Stats
+    {
+        size_t passes = 0, culledPasses = 0;
+        size_t transientTextures = 0, physicalTextures = 0;
+        size_t transientBytes = 0;  // what the transients would take with a texture each
+        size_t physicalBytes = 0;   // what the pooled textures they were given take
+
+        size_t bytesSaved() const { return transientBytes - physicalBytes; }
+    };
+
+    // starts describing a new frame; pooled textures and framebuffers are kept
+    void reset()
+    {
+        passes.clear();
+        resources.clear();
+        order.clear();
+        compiled = false;
+    }
+
+    // a texture owned outside the graph; it lives as long as its owner and writing it is a side effect
+    RGTexture importTexture(const std::string &name, const GLTexture &texture, const RGTextureDesc &desc)
+    {
+        RGTexture handle;
+        handle.index = (int)resources.size();
+        resources.push_back(Resource{ name, desc, &texture, -1 });
+        return handle;
+    }
+
+    void addPass(const std::string &name, const std::function<void(PassBuilder &)> &setup, std::function<void(const PassContext &)> execute)
+    {
+        passes.push_back(Pass{ name, std::move(execute) });
+        PassBuilder builder(*this, (int)passes.size() - 1);
+        setup(builder);
+    }
+
+    // orders and culls the passes and assigns pooled textures to the transients
+    void compile()
+    {
+        static MetricGauge &transientGauge = metrics().gauge("render_graph_transient_bytes", "Render target memory the transients of the last frame would need without aliasing");
+        static MetricGauge &physicalGauge = metrics().gauge("render_graph_physical_bytes", "Render target memory the transients of the last frame were given");
+        static MetricGauge &savedGauge = metrics().gauge("render_graph_bytes_saved", "Render target memory saved by aliasing transients in the last frame");
+
+        sortPasses();
+        cullPasses();
+        allocate();
+        compiled = true;
+
+        transientGauge.set((double)frameStats.transientBytes);
+        physicalGauge.set((double)frameStats.physicalBytes);
+        savedGauge.set((double)frameStats.bytesSaved());
+    }
+
+    // runs the passes that survived compile(), in order
+    void execute()
+    {
+        if (!compiled)
+            compile();
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport); // restored for passes rendering to the default framebuffer
+        const PassContext context(*this);
+        for (int index : order)
+        {
+            Pass &pass = passes[index];
+            if (pass.culled)
+                continue;
+            bindTargets(pass, viewport);
+            pass.execute(context);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    const Stats &stats() const
+    {
+        return frameStats;
+    }
+
+    // prints the compiled frame: pass order, culled passes and which pooled texture every transient got
+    void print(std::ostream &out) const
+    {
+        for (int index : order)
+        {
+            const Pass &pass = passes[index];
+            out << (pass.culled ? "  (culled) " : "  ") << pass.name << ":";
+            for (int r : pass.reads)
+                out << " reads " << resources[r].name;
+            for (int r : pass.writes)
+            {
+                out << " writes " << resources[r].name;
+                if (resources[r].physical >= 0)
+                    out << " [#" << resources[r].physical << "]";
+            }
+            out << '\n';
+        }
+        out << "  transients " << frameStats.transientTextures << " on " << frameStats.physicalTextures << " textures, "
+            << frameStats.transientBytes / 1024 << " KiB -> " << frameStats.physicalBytes / 1024 << " KiB" << std::endl;
+    }
+
+    // rough size of one texel of a sized internal format, with the padding drivers typically add to 3 component formats
+    static size_t texelBytes(GLenum format)
+    {
+        switch (format)
+        {
+        case GL_R8: return 1;
+        case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+        case GL_RGB8: case GL_RGBA8: case GL_SRGB8: case GL_SRGB8_ALPHA8: case GL_RG16F: case GL_R32F: case GL_R11F_G11F_B10F:
+        case GL_RGB10_A2: case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32F: case GL_DEPTH24_STENCIL8: return 4;
+        case GL_RGB16F: case GL_RGBA16F: case GL_RG32F: case GL_DEPTH32F_STENCIL8: return 8;
+        case GL_RGB32F: case GL_RGBA32F: return 16;
+        default: return 4;
+        }
+    }
+
+private:
+    struct Pass
+    {
+        std::string name;
+        std::function<void(const PassContext &)> execute;
+        std::vector<int> reads, writes;
+        bool sideEffect = false;
+        bool culled = false;
+        std::vector<int> after;   // passes that must run first
+        std::vector<int> needs;   // of those, the ones writing something this pass uses
+    };
+    struct Resource
+    {
+        std::string name;
+        RGTextureDesc desc;
+        const GLTexture *imported;
+        int producer;             // pass that created it, -1 if imported
+        int physical = -1;        // pooled texture, transients only
+        int first = -1, last = -1; // position in `order` of the first and last surviving pass using it
+    };
+    struct Physical
+    {
+        RGTextureDesc desc;
+        GLTexture texture;
+        int unusedFrames = 0;
+    };
+
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+    std::vector<int> order;
+    bool compiled = false;
+    Stats frameStats;
+
+    std::vector<Physical> pool;
+    std::map<std::vector<unsigned int>, GLFramebuffer> framebuffers; // keyed by attachment, texture pairs
+    static const int KEEP_UNUSED_FRAMES = 120;
+
+    static bool isDepthFormat(GLenum format)
+    {
+        return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F ||
+               format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8 || format == GL_DEPTH_COMPONENT;
+    }
+
+    static bool hasStencil(GLenum format)
+    {
+        return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+    }
+
+    unsigned int textureName(int resource) const
+    {
+        const Resource &r = resources[resource];
+        if (r.imported)
+            return r.imported->id();
+        return r.physical >= 0 ? pool[r.physical].texture.id() : 0;
+    }
+
+    // dependencies per texture: the creator runs before everyone using it; a pass writing a texture it
+    // didn't create runs after the passes declared before it that use the texture and before the ones
+    // declared after it; readers among themselves are unordered
+    void sortPasses()
+    {
+        for (Pass &pass : passes)
+        {
+            pass.after.clear();
+            pass.needs.clear();
+            pass.culled = false;
+        }
+        std::vector<std::vector<int>> users(resources.size());
+        for (int p = 0; p < (int)passes.size(); p++)
+        {
+            for (int r : passes[p].reads)
+                users[r].push_back(p);
+            for (int r : passes[p].writes)
+                users[r].push_back(p);
+        }
+        auto writes = [this](int p, int r) {
+            return std::find(passes[p].writes.begin(), passes[p].writes.end(), r) != passes[p].writes.end();
+        };
+        auto depend = [this, &writes](int before, int after, int r) {
+            if (before == after)
+                return;
+            passes[after].after.push_back(before);
+            if (writes(before, r))
+                passes[after].needs.push_back(before);
+        };
+        for (int r = 0; r < (int)resources.size(); r++)
+        {
+            std::vector<int> &list = users[r];
+            list.erase(std::unique(list.begin(), list.end()), list.end());
+            for (int p : list)
+            {
+                if (p == resources[r].producer)
+                {
+                    for (int other : list)
+                        depend(p, other, r);
+                    continue;
+                }
+                if (!writes(p, r))
+                    continue;
+                for (int other : list)
+                {
+                    if (other == resources[r].producer)
+                        continue;
+                    if (other < p)
+                        depend(other, p, r);
+                    else if (other > p)
+                        depend(p, other, r);
+                }
+            }
+        }
+
+        // Kahn's algorithm, declaration order among the passes that are ready
+        std::vector<int> pending(passes.size(), 0);
+        std::vector<std::vector<int>> followers(passes.size());
+        for (int p = 0; p < (int)passes.size(); p++)
+        {
+            std::sort(passes[p].after.begin(), passes[p].after.end());
+            passes[p].after.erase(std::unique(passes[p].after.begin(), passes[p].after.end()), passes[p].after.end());
+            pending[p] = (int)passes[p].after.size();
+            for (int before : passes[p].after)
+                followers[before].push_back(p);
+        }
+        std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+        for (int p = 0; p < (int)passes.size(); p++)
+            if (pending[p] == 0)
+                ready.push(p);
+        order.clear();
+        while (!ready.empty())
+        {
+            const int p = ready.top();
+            ready.pop();
+            order.push_back(p);
+            for (int next : followers[p])
+                if (--pending[next] == 0)
+                    ready.push(next);
+        }
+        if (order.size() != passes.size())
+        {
+            std::cout << "ERROR::RENDER_GRAPH:: Passes depend on each other in a cycle, running them in declaration order" << std::endl;
+            order.clear();
+            for (int p = 0; p < (int)passes.size(); p++)
+                order.push_back(p);
+        }
+    }
+
+    // keeps what the default framebuffer, imported textures or side effects depend on
+    void cullPasses()
+    {
+        std::vector<bool> needed(passes.size(), false);
+        std::vector<int> stack;
+        for (int p = 0; p < (int)passes.size(); p++)
+        {
+            bool root = passes[p].sideEffect || passes[p].writes.empty();
+            for (int r : passes[p].writes)
+                root = root || resources[r].imported;
+            if (root)
+                stack.push_back(p), needed[p] = true;
+        }
+        while (!stack.empty())
+        {
+            const int p = stack.back();
+            stack.pop_back();
+            for (int before : passes[p].needs)
+                if (!needed[before])
+                    stack.push_back(before), needed[before] = true;
+        }
+        for (int p = 0; p < (int)passes.size(); p++)
+            passes[p].culled = !needed[p];
+    }
+
+    // walks the surviving passes in order, taking a free pooled texture for each transient at its first
+    // use and giving it back after its last
+    void allocate()
+    {
+        frameStats = Stats();
+        frameStats.passes = passes.size();
+        for (int position = 0; position < (int)order.size(); position++)
+        {
+            const Pass &pass = passes[order[position]];
+            if (pass.culled)
+            {
+                frameStats.culledPasses++;
+                continue;
+            }
+            for (const std::vector<int> *list : { &pass.reads, &pass.writes })
+                for (int r : *list)
+                {
+                    Resource &resource = resources[r];
+                    if (resource.first < 0)
+                        resource.first = position;
+                    resource.last = position;
+                }
+        }
+
+        std::vector<bool> busy(pool.size(), false), used(pool.size(), false);
+        std::vector<std::vector<int>> releaseAfter(order.size());
+        for (int position = 0; position < (int)order.size(); position++)
+        {
+            for (int r = 0; r < (int)resources.size(); r++)
+            {
+                Resource &resource = resources[r];
+                if (resource.imported || resource.first != position)
+                    continue;
+                int physical = -1;
+                for (int i = 0; i < (int)pool.size() && physical < 0; i++)
+                    if (!busy[i] && pool[i].desc == resource.desc)
+                        physical = i;
+                if (physical < 0)
+                {
+                    physical = (int)pool.size();
+                    pool.push_back(Physical{ resource.desc, createTexture(resource.desc), 0 });
+                    busy.push_back(false);
+                    used.push_back(false);
+                }
+                busy[physical] = used[physical] = true;
+                resource.physical = physical;
+                releaseAfter[resource.last].push_back(physical);
+
+                frameStats.transientTextures++;
+                frameStats.transientBytes += bytes(resource.desc);
+            }
+            for (int physical : releaseAfter[position])
+                busy[physical] = false;
+        }
+
+        // textures nothing used for a while (after a resize, say) go, with the framebuffers using them
+        bool released = false;
+        for (int i = (int)pool.size() - 1; i >= 0; i--)
+        {
+            pool[i].unusedFrames = used[i] ? 0 : pool[i].unusedFrames + 1;
+            if (used[i])
+            {
+                frameStats.physicalTextures++;
+                frameStats.physicalBytes += bytes(pool[i].desc);
+            }
+            else if (pool[i].unusedFrames > KEEP_UNUSED_FRAMES)
+            {
+                pool.erase(pool.begin() + i);
+                for (Resource &resource : resources)
+                    if (resource.physical > i)
+                        resource.physical--;
+                released = true;
+            }
+        }
+        if (released)
+            framebuffers.clear();
+    }
+
+    static size_t bytes(const RGTextureDesc &desc)
+    {
+        return (size_t)desc.width * desc.height * texelBytes(desc.format);
+    }
+
+    static GLTexture createTexture(const RGTextureDesc &desc)
+    {
+        GLTexture texture;
+        texture.storage2D(GL_TEXTURE_2D, 1, desc.format, desc.width, desc.height);
+        texture.parameter(GL_TEXTURE_MIN_FILTER, (GLint)desc.filter);
+        texture.parameter(GL_TEXTURE_MAG_FILTER, (GLint)desc.filter);
+        texture.parameter(GL_TEXTURE_WRAP_S, (GLint)desc.wrap);
+        texture.parameter(GL_TEXTURE_WRAP_T, (GLint)desc.wrap);
+        return texture;
+    }
+
+    // binds (creating once) a framebuffer with the pass' textures: colors in the order written, depth
+    void bindTargets(const Pass &pass, const GLint *defaultViewport)
+    {
+        if (pass.writes.empty())
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(defaultViewport[0], defaultViewport[1], defaultViewport[2], defaultViewport[3]);
+            return;
+        }
+        std::vector<unsigned int> key;
+        std::vector<GLenum> colors;
+        GLsizei width = 0, height = 0;
+        for (int r : pass.writes)
+        {
+            const Resource &resource = resources[r];
+            GLenum attachment;
+            if (isDepthFormat(resource.desc.format))
+                attachment = hasStencil(resource.desc.format) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+            else
+                attachment = GL_COLOR_ATTACHMENT0 + (GLenum)colors.size(), colors.push_back(attachment);
+            key.push_back(attachment);
+            key.push_back(textureName(r));
+            width = resource.desc.width;
+            height = resource.desc.height;
+        }
+        auto found = framebuffers.find(key);
+        if (found == framebuffers.end())
+        {
+            GLFramebuffer &framebuffer = framebuffers[key];
+            framebuffer.create();
+            for (size_t i = 0; i < pass.writes.size(); i++)
+            {
+                const Resource &resource = resources[pass.writes[i]];
+                framebuffer.texture(key[2 * i], resource.imported ? *resource.imported : pool[resource.physical].texture);
+            }
+            if (colors.empty())
+                framebuffer.noColorBuffer();
+            else
+                framebuffer.drawBuffers((GLsizei)colors.size(), colors.data());
+            if (!framebuffer.checkComplete())
+                std::cout << "ERROR::RENDER_GRAPH:: Pass " << pass.name << " can't render to its textures" << std::endl;
+            found = framebuffers.find(key);
+        }
+        found->second.bind();
+        glViewport(0, 0, width, height);
+    }
+};
+#endif
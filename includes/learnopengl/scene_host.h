@@ -0,0 +1,275 @@
+#ifndef SCENE_HOST_H
+#define SCENE_HOST_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/asset_cache.h>
+#include <learnopengl/upload_thread.h>
+#include <learnopengl/metrics.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <iostream>
+
+// what a scene gets every frame
+struct SceneFrame
+{
+    int width, height;      // framebuffer size
+    float deltaTime, time;  // seconds
+    Camera &camera;
+    AssetCache &assets;
+};
+
+// one demo inside a SceneHost. A scene is constructed when it's switched to and destroyed when it's left;
+// it takes its models, textures and shaders from the host's AssetCache, so switching back to it (or to
+// another scene using the same assets) finds them resident instead of loading them again. Scenes
+// leave the GL state as they found it: depth testing on, everything else at its default.
+class Scene
+{
+public:
+    virtual ~Scene() = default;
+
+    // takes what the scene needs from the cache and puts the camera where the scene starts
+    virtual void load(AssetCache &assets, Camera &camera) = 0;
+    // renders one frame into the default framebuffer
+    virtual void render(const SceneFrame &frame) = 0;
+};
+
+// One window and GL context that runs registered scenes, one at a time. The number keys (1 - 9) switch
+// to a scene, tab to the next one; WASD and the mouse move the camera, escape quits:
+//
+//   SceneHost host;
+//   if (!host.create("LearnOpenGL", 800, 600))
+//       return -1;
+//   host.add<ModelLoadingScene>("model loading");
+//   host.add<AsteroidsScene>("asteroids");
+//   host.run();
+class SceneHost
+{
+public:
+    ~SceneHost()
+    {
+        // scenes and assets hold GL objects, the context must still exist when they go; the assets wait
+        // for their uploads, so the upload thread goes after them
+        current.reset();
+        assets.reset();
+        uploads.reset();
+        if (window)
+            glfwTerminate();
+    }
+
+    // opens the window and loads GL; false (after printing why) if either fails
+    bool create(const std::string &title, int width, int height)
+    {
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+        window = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
+        if (window == NULL)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return false;
+        }
+        this->title = title;
+        glfwMakeContextCurrent(window);
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+        glfwSetKeyCallback(window, key_callback);
+
+        // tell GLFW to capture our mouse
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+        // glad: load all OpenGL function pointers
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return false;
+        }
+        // textures and meshes are uploaded on a context of their own, a scene loading doesn't stall the frame
+        uploads.reset(new UploadThread(window));
+        assets.reset(new AssetCache());
+        assets->setUploadThread(uploads.get());
+        return true;
+    }
+
+    // registers a scene; the first one registered is shown first
+    void add(const std::string &name, std::function<std::unique_ptr<Scene>()> factory)
+    {
+        scenes.push_back({ name, std::move(factory) });
+    }
+    template<typename T>
+    void add(const std::string &name)
+    {
+        add(name, []() { return std::unique_ptr<Scene>(new T()); });
+    }
+
+    // runs until the window is closed
+    void run()
+    {
+        if (scenes.empty())
+            return;
+        switchTo(0);
+        float lastFrame = static_cast<float>(glfwGetTime());
+        while (!glfwWindowShouldClose(window))
+        {
+            // per-frame time logic
+            float currentFrame = static_cast<float>(glfwGetTime());
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+
+            // upload whatever finished loading in the background
+            assets->poll();
+
+            processInput();
+            if (requested != active)
+                switchTo(requested);
+
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+            SceneFrame frame{ width, height, deltaTime, currentFrame, camera, *assets };
+            current->render(frame);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+    }
+
+    AssetCache &cache()
+    {
+        return *assets;
+    }
+
+private:
+    struct Entry
+    {
+        std::string name;
+        std::function<std::unique_ptr<Scene>()> factory;
+    };
+
+    GLFWwindow *window = nullptr;
+    std::string title;
+    std::unique_ptr<UploadThread> uploads;
+    std::unique_ptr<AssetCache> assets;
+    std::vector<Entry> scenes;
+    std::unique_ptr<Scene> current;
+    int active = -1, requested = 0;
+
+    Camera camera;
+    float deltaTime = 0.0f;
+    float lastX = 0.0f, lastY = 0.0f;
+    bool firstMouse = true;
+
+    // leaves the current scene (its assets stay in the cache) and enters another one
+    void switchTo(int index)
+    {
+        static MetricHistogram &switchSeconds = metrics().histogram("scene_switch_seconds", "Time from leaving a scene to having the next one loaded", { 0.001, 0.01, 0.1, 1.0, 10.0 });
+
+        const auto start = std::chrono::steady_clock::now();
+        const AssetCache::Stats before = assets->stats();
+        current.reset();
+
+        // the state scenes may rely on
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glUseProgram(0);
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glDisable(GL_CULL_FACE);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+        camera = Camera(glm::vec3(0.0f, 0.0f, 3.0f));
+        firstMouse = true;
+        current = scenes[index].factory();
+        current->load(*assets, camera);
+        active = requested = index;
+
+        const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+        switchSeconds.observe(seconds.count());
+        const AssetCache::Stats &after = assets->stats();
+        std::cout << "scene: " << scenes[index].name << " in " << seconds.count() * 1000.0 << " ms | assets reused: "
+                  << after.hits - before.hits << " | loaded: " << after.misses - before.misses << " | resident: " << after.resident << std::endl;
+        glfwSetWindowTitle(window, (title + " - " + scenes[index].name).c_str());
+    }
+
+    // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+    void processInput()
+    {
+        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+            camera.ProcessKeyboard(FORWARD, deltaTime);
+        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+            camera.ProcessKeyboard(BACKWARD, deltaTime);
+        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+            camera.ProcessKeyboard(LEFT, deltaTime);
+        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+            camera.ProcessKeyboard(RIGHT, deltaTime);
+    }
+
+    static SceneHost &host(GLFWwindow *window)
+    {
+        return *static_cast<SceneHost *>(glfwGetWindowUserPointer(window));
+    }
+
+    // glfw: whenever the window size changed (by OS or user resize) this callback function executes
+    static void framebuffer_size_callback(GLFWwindow *window, int width, int height)
+    {
+        glViewport(0, 0, width, height);
+    }
+
+    // glfw: whenever the mouse moves, this callback is called
+    static void mouse_callback(GLFWwindow *window, double xposIn, double yposIn)
+    {
+        SceneHost &self = host(window);
+        float xpos = static_cast<float>(xposIn);
+        float ypos = static_cast<float>(yposIn);
+        if (self.firstMouse)
+        {
+            self.lastX = xpos;
+            self.lastY = ypos;
+            self.firstMouse = false;
+        }
+
+        float xoffset = xpos - self.lastX;
+        float yoffset = self.lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+        self.lastX = xpos;
+        self.lastY = ypos;
+
+        self.camera.ProcessMouseMovement(xoffset, yoffset);
+    }
+
+    // glfw: whenever the mouse scroll wheel scrolls, this callback is called
+    static void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
+    {
+        host(window).camera.ProcessMouseScroll(static_cast<float>(yoffset));
+    }
+
+    // glfw: scene switching, on key presses only so holding a key switches once
+    static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
+    {
+        if (action != GLFW_PRESS)
+            return;
+        SceneHost &self = host(window);
+        const int count = (int)self.scenes.size();
+        if (key >= GLFW_KEY_1 && key <= GLFW_KEY_9 && key - GLFW_KEY_1 < count)
+            self.requested = key - GLFW_KEY_1;
+        else if (key == GLFW_KEY_TAB)
+            self.requested = (self.active + ((mods & GLFW_MOD_SHIFT) ? count - 1 : 1)) % count;
+    }
+};
+#endif
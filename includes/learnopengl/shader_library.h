@@ -0,0 +1,376 @@
+#ifndef SHADER_LIBRARY_H
+#define SHADER_LIBRARY_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/metrics.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/shader_source.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Shader permutations from one set of GLSL files. Sources are expanded like every other shader (see
+// shader_source.h: #include "file", defines after #version), so a feature is an #ifdef instead of a
+// copied file. Every (program, define set) pair is compiled once and cached under the hash of the
+// program name and the sorted defines; the variants are plain learnopengl Shaders owned by the library:
+//
+//   ShaderLibrary shaders;
+//   shaders.add("pbr", "2.2.2.pbr.vs", "2.2.2.pbr.fs");
+//   Shader &plain    = shaders.get("pbr");                      // compiled on first use
+//   Shader &textured = shaders.get("pbr", { "TEXTURED", "LIGHTS=4" });
+//
+// prepare() starts a variant ahead of time: the files are read and expanded on a worker thread, poll()
+// (on the GL thread, once per frame) hands them to the driver and links them once they are compiled.
+// With GL_KHR_parallel_shader_compile the driver compiles on its own threads and poll() never blocks
+// on it. get() on a variant that is still in flight completes it on the spot; a variant that failed to
+// build is a Shader with ID 0.
+//
+// setBinaryCache() keeps the linked program binaries on disk, keyed by the expanded sources and the
+// driver, so the next run skips compiling the variants it has seen before.
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+class ShaderLibrary
+{
+public:
+    ShaderLibrary() = default;
+    ShaderLibrary(const ShaderLibrary &) = delete;
+    ShaderLibrary &operator=(const ShaderLibrary &) = delete;
+
+    ~ShaderLibrary()
+    {
+        for (auto &entry : variants)
+        {
+            Variant &variant = *entry.second;
+            // the workers only read files, but they must be done before their futures go away
+            if (variant.expanding.valid())
+                variant.expanding.wait();
+            for (GLuint shader : variant.shaders)
+                glDeleteShader(shader);
+            if (variant.program)
+                glDeleteProgram(variant.program);
+        }
+    }
+
+    // registers a program; variants are only compiled when they are asked for
+    void add(const std::string &name, const std::vector<ShaderStage> &stages)
+    {
+        programs[name] = stages;
+    }
+    void add(const std::string &name, const std::string &vertexPath, const std::string &fragmentPath, const std::string &geometryPath = "")
+    {
+        std::vector<ShaderStage> stages = { { GL_VERTEX_SHADER, vertexPath }, { GL_FRAGMENT_SHADER, fragmentPath } };
+        if (!geometryPath.empty())
+            stages.push_back({ GL_GEOMETRY_SHADER, geometryPath });
+        add(name, stages);
+    }
+
+    // directory for linked program binaries (must exist), empty to disable; needs GL 4.1
+    void setBinaryCache(const std::string &directory)
+    {
+        binaryDirectory = directory;
+    }
+
+    // starts reading and expanding a variant in the background; poll() continues it
+    void prepare(const std::string &name, std::vector<std::string> defines = {})
+    {
+        variant(name, std::move(defines));
+    }
+
+    // the variant with these defines, compiled and linked before it is returned (ID 0 if it failed)
+    Shader &get(const std::string &name, std::vector<std::string> defines = {})
+    {
+        Variant &found = variant(name, std::move(defines));
+        while (!found.ready())
+            advance(found, true);
+        return *found.shader;
+    }
+
+    // advances every variant in flight without blocking on the driver; returns true when none is left
+    bool poll()
+    {
+        bool done = true;
+        for (auto &entry : variants)
+        {
+            Variant &variant = *entry.second;
+            if (!variant.ready())
+                advance(variant, false);
+            done = done && variant.ready();
+        }
+        return done;
+    }
+
+    size_t variantCount() const
+    {
+        return variants.size();
+    }
+
+    // FNV-1a over the program name and the sorted defines
+    static uint64_t permutationKey(const std::string &name, const std::vector<std::string> &sortedDefines)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const std::string &text) {
+            for (unsigned char c : text)
+                hash = (hash ^ c) * 1099511628211ull;
+            hash = (hash ^ 0xff) * 1099511628211ull; // separator, so {"AB"} != {"A", "B"}
+        };
+        mix(name);
+        for (const std::string &define : sortedDefines)
+            mix(define);
+        return hash;
+    }
+
+private:
+    // one (program, define set) pair on its way from the files to a linked Shader
+    struct Variant
+    {
+        enum State { EXPANDING, COMPILING, LINKING, READY, FAILED };
+        State state = EXPANDING;
+        std::string name;
+        std::vector<std::string> defines; // sorted
+        std::future<std::vector<ExpandedShaderStage>> expanding;
+        std::vector<ExpandedShaderStage> stages;
+        std::vector<GLuint> shaders;
+        GLuint program = 0;
+        std::string binaryPath; // empty without a binary cache
+        std::chrono::steady_clock::time_point started;
+        std::unique_ptr<Shader> shader; // set once the variant is ready
+
+        bool ready() const
+        {
+            return state == READY || state == FAILED;
+        }
+    };
+
+    std::unordered_map<std::string, std::vector<ShaderStage>> programs;
+    std::unordered_map<uint64_t, std::unique_ptr<Variant>> variants;
+    std::string binaryDirectory;
+
+    Variant &variant(const std::string &name, std::vector<std::string> defines)
+    {
+        std::sort(defines.begin(), defines.end());
+        defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+        const uint64_t key = permutationKey(name, defines);
+        auto found = variants.find(key);
+        if (found != variants.end())
+            return *found->second;
+
+        std::unique_ptr<Variant> variant(new Variant());
+        variant->name = name;
+        variant->defines = defines;
+        variant->started = std::chrono::steady_clock::now();
+        auto program = programs.find(name);
+        if (program == programs.end())
+        {
+            std::cout << "ERROR::SHADER_LIBRARY:: Unknown program " << name << std::endl;
+            fail(*variant);
+        }
+        else
+        {
+            const std::vector<ShaderStage> stages = program->second;
+            variant->expanding = std::async(std::launch::async, [stages, defines]() { return expandShaderStages(stages, defines); });
+        }
+        Variant &result = *variant;
+        variants[key] = std::move(variant);
+        return result;
+    }
+
+    static bool parallelCompile()
+    {
+        static const bool supported = [] {
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (GLint i = 0; i < count; ++i)
+            {
+                const char *extension = (const char *)glGetStringi(GL_EXTENSIONS, i);
+                if (extension && (std::string(extension) == "GL_KHR_parallel_shader_compile" || std::string(extension) == "GL_ARB_parallel_shader_compile"))
+                    return true;
+            }
+            return false;
+        }();
+        return supported;
+    }
+
+    // GL thread side: one step further without waiting on the worker or the driver unless block is set
+    void advance(Variant &variant, bool block)
+    {
+        if (variant.state == Variant::EXPANDING)
+        {
+            if (!block && variant.expanding.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return;
+            variant.stages = variant.expanding.get();
+            for (const ExpandedShaderStage &stage : variant.stages)
+            {
+                if (!stage.ok)
+                {
+                    fail(variant);
+                    return;
+                }
+            }
+            if (loadBinary(variant))
+                return;
+            for (const ExpandedShaderStage &stage : variant.stages)
+            {
+                const GLuint shader = glCreateShader(stage.type);
+                const char *code = stage.code.c_str();
+                glShaderSource(shader, 1, &code, NULL);
+                glCompileShader(shader);
+                variant.shaders.push_back(shader);
+            }
+            variant.state = Variant::COMPILING;
+        }
+
+        if (variant.state == Variant::COMPILING)
+        {
+            if (!block && parallelCompile())
+            {
+                for (GLuint shader : variant.shaders)
+                {
+                    GLint complete = GL_FALSE;
+                    glGetShaderiv(shader, GL_COMPLETION_STATUS_KHR, &complete);
+                    if (!complete)
+                        return;
+                }
+            }
+            for (size_t i = 0; i < variant.shaders.size(); ++i)
+            {
+                if (!checkShaderCompile(variant.shaders[i], variant.stages[i], variant.defines))
+                {
+                    fail(variant);
+                    return;
+                }
+            }
+            variant.program = glCreateProgram();
+            for (GLuint shader : variant.shaders)
+                glAttachShader(variant.program, shader);
+            if (!binaryDirectory.empty() && GLAD_GL_VERSION_4_1)
+                glProgramParameteri(variant.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glLinkProgram(variant.program);
+            variant.state = Variant::LINKING;
+        }
+
+        if (variant.state == Variant::LINKING)
+        {
+            if (!block && parallelCompile())
+            {
+                GLint complete = GL_FALSE;
+                glGetProgramiv(variant.program, GL_COMPLETION_STATUS_KHR, &complete);
+                if (!complete)
+                    return;
+            }
+            for (GLuint shader : variant.shaders)
+                glDeleteShader(shader);
+            variant.shaders.clear();
+            if (!checkProgramLink(variant.program, variant.name, variant.defines))
+            {
+                fail(variant);
+                return;
+            }
+            storeBinary(variant);
+            finished(variant, false);
+        }
+    }
+
+    static void fail(Variant &variant)
+    {
+        for (GLuint shader : variant.shaders)
+            glDeleteShader(shader);
+        variant.shaders.clear();
+        if (variant.program)
+            glDeleteProgram(variant.program);
+        variant.program = 0;
+        variant.stages.clear();
+        variant.shader.reset(new Shader(0u));
+        variant.state = Variant::FAILED;
+    }
+
+    static void finished(Variant &variant, bool fromBinary)
+    {
+        static MetricCounter &compiled = metrics().counter("shader_variants_compiled_total", "Shader variants compiled from source");
+        static MetricCounter &cached = metrics().counter("shader_variants_cached_total", "Shader variants loaded from the binary cache");
+        static MetricHistogram &seconds = metrics().histogram("shader_variant_seconds", "Time from request to linked variant",
+                                                              { 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0 });
+        (fromBinary ? cached : compiled).add();
+        seconds.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - variant.started).count());
+        variant.stages.clear();
+        variant.shader.reset(new Shader(variant.program));
+        variant.state = Variant::READY;
+    }
+
+    // binaries are only valid for the driver that produced them and the exact sources
+    std::string binaryFile(const Variant &variant) const
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const char *text) {
+            for (; text && *text; ++text)
+                hash = (hash ^ (unsigned char)*text) * 1099511628211ull;
+            hash = (hash ^ 0xff) * 1099511628211ull;
+        };
+        mix((const char *)glGetString(GL_VENDOR));
+        mix((const char *)glGetString(GL_RENDERER));
+        mix((const char *)glGetString(GL_VERSION));
+        for (const ExpandedShaderStage &stage : variant.stages)
+        {
+            mix(std::to_string(stage.type).c_str());
+            mix(stage.code.c_str());
+        }
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+        return binaryDirectory + "/" + name;
+    }
+
+    bool loadBinary(Variant &variant)
+    {
+        if (binaryDirectory.empty() || !GLAD_GL_VERSION_4_1)
+            return false;
+        variant.binaryPath = binaryFile(variant);
+        std::ifstream file(variant.binaryPath, std::ios::binary);
+        GLenum format = 0;
+        if (!file.read((char *)&format, sizeof(format)))
+            return false;
+        const std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        variant.program = glCreateProgram();
+        glProgramBinary(variant.program, format, binary.data(), (GLsizei)binary.size());
+        GLint success = GL_FALSE;
+        glGetProgramiv(variant.program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            // driver update or corrupt file: compile from source and overwrite it
+            glDeleteProgram(variant.program);
+            variant.program = 0;
+            return false;
+        }
+        finished(variant, true);
+        return true;
+    }
+
+    void storeBinary(const Variant &variant) const
+    {
+        if (variant.binaryPath.empty())
+            return;
+        GLint length = 0;
+        glGetProgramiv(variant.program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(variant.program, length, NULL, &format, binary.data());
+        std::ofstream file(variant.binaryPath, std::ios::binary | std::ios::trunc);
+        file.write((const char *)&format, sizeof(format));
+        file.write(binary.data(), binary.size());
+    }
+};
+#endif
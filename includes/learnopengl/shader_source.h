@@ -0,0 +1,183 @@
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include <glad/glad.h>
+
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+// Reading, expanding and compiling GLSL files; shared by the Shader classes (shader*.h) and by
+// ShaderLibrary (shader_library.h), so every shader in the tree is loaded the same way.
+//
+// Sources may #include "file" (resolved relative to the including file, every file at most once per
+// stage). Defines are inserted right after the #version line, so a feature is an #ifdef instead of a
+// copied file; "NAME=VALUE" becomes "#define NAME VALUE". #line directives keep the driver's error
+// messages pointing at the right file: the log refers to files by their source string number, which
+// is printed next to it.
+
+struct ShaderStage
+{
+    GLenum type;      // GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, ...
+    std::string path;
+};
+
+// one stage after #include and #define expansion
+struct ExpandedShaderStage
+{
+    GLenum type = 0;
+    std::string code;
+    std::vector<std::string> files; // source string numbers of the #line directives
+    bool ok = true;
+};
+
+// "[A B=1]" for log messages, empty without defines
+inline std::string describeShaderDefines(const std::vector<std::string> &defines)
+{
+    if (defines.empty())
+        return "";
+    std::string text = " [";
+    for (size_t i = 0; i < defines.size(); ++i)
+        text += (i > 0 ? " " : "") + defines[i];
+    return text + "]";
+}
+
+inline bool expandShaderFile(const std::string &path, const std::vector<std::string> &defines, ExpandedShaderStage &out,
+                             std::set<std::string> &included, int depth)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+        return false;
+    }
+    if (depth > 32)
+    {
+        std::cout << "ERROR::SHADER:: #include nested too deeply in " << path << std::endl;
+        return false;
+    }
+    included.insert(path);
+    const size_t fileIndex = out.files.size();
+    out.files.push_back(path);
+    const size_t slash = path.find_last_of("/\\");
+    const std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    if (depth > 0)
+        out.code += "#line 1 " + std::to_string(fileIndex) + "\n";
+
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number)
+    {
+        const size_t start = line.find_first_not_of(" \t");
+        const std::string directive = start == std::string::npos ? "" : line.substr(start);
+        if (directive.compare(0, 8, "#include") == 0)
+        {
+            const size_t open = directive.find('"'), close = directive.find('"', open + 1);
+            if (open == std::string::npos || close == std::string::npos)
+            {
+                std::cout << "ERROR::SHADER:: Malformed #include in " << path << ":" << number << std::endl;
+                return false;
+            }
+            const std::string target = directory + directive.substr(open + 1, close - open - 1);
+            if (included.count(target) == 0 && !expandShaderFile(target, defines, out, included, depth + 1))
+                return false;
+            out.code += "#line " + std::to_string(number + 1) + " " + std::to_string(fileIndex) + "\n";
+        }
+        else if (depth == 0 && directive.compare(0, 8, "#version") == 0)
+        {
+            out.code += line + "\n";
+            for (const std::string &define : defines)
+            {
+                const size_t equals = define.find('=');
+                out.code += "#define " + (equals == std::string::npos ? define : define.substr(0, equals) + " " + define.substr(equals + 1)) + "\n";
+            }
+            out.code += "#line " + std::to_string(number + 1) + " 0\n";
+        }
+        else
+            out.code += line + "\n";
+    }
+    return true;
+}
+
+// files only, no GL: safe on a worker thread
+inline std::vector<ExpandedShaderStage> expandShaderStages(const std::vector<ShaderStage> &stages, const std::vector<std::string> &defines = {})
+{
+    std::vector<ExpandedShaderStage> result;
+    for (const ShaderStage &stage : stages)
+    {
+        ExpandedShaderStage expanded;
+        expanded.type = stage.type;
+        std::set<std::string> included;
+        expanded.ok = expandShaderFile(stage.path, defines, expanded, included, 0);
+        result.push_back(std::move(expanded));
+    }
+    return result;
+}
+
+inline bool checkShaderCompile(GLuint shader, const ExpandedShaderStage &stage, const std::vector<std::string> &defines)
+{
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (success)
+        return true;
+    GLchar infoLog[1024];
+    glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+    std::cout << "ERROR::SHADER_COMPILATION_ERROR of: " << stage.files[0] << describeShaderDefines(defines) << "\n";
+    for (size_t i = 0; i < stage.files.size(); ++i)
+        std::cout << "  source " << i << ": " << stage.files[i] << "\n";
+    std::cout << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+    return false;
+}
+
+inline bool checkProgramLink(GLuint program, const std::string &name, const std::vector<std::string> &defines)
+{
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success)
+        return true;
+    GLchar infoLog[1024];
+    glGetProgramInfoLog(program, 1024, NULL, infoLog);
+    std::cout << "ERROR::PROGRAM_LINKING_ERROR of: " << name << describeShaderDefines(defines) << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+    return false;
+}
+
+// compiles and links on the spot; returns the program, or 0 if a file could not be read or a stage
+// failed (the error has been printed)
+inline GLuint buildShaderProgram(const std::vector<ShaderStage> &stages, const std::vector<std::string> &defines = {})
+{
+    const std::vector<ExpandedShaderStage> expanded = expandShaderStages(stages, defines);
+    for (const ExpandedShaderStage &stage : expanded)
+        if (!stage.ok)
+            return 0;
+
+    std::vector<GLuint> shaders;
+    bool compiled = true;
+    for (const ExpandedShaderStage &stage : expanded)
+    {
+        const GLuint shader = glCreateShader(stage.type);
+        const char *code = stage.code.c_str();
+        glShaderSource(shader, 1, &code, NULL);
+        glCompileShader(shader);
+        compiled = checkShaderCompile(shader, stage, defines) && compiled;
+        shaders.push_back(shader);
+    }
+    GLuint program = 0;
+    if (compiled)
+    {
+        program = glCreateProgram();
+        for (GLuint shader : shaders)
+            glAttachShader(program, shader);
+        glLinkProgram(program);
+        if (!checkProgramLink(program, stages[0].path, defines))
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    // the shaders are linked into the program now and no longer necessary
+    for (GLuint shader : shaders)
+        glDeleteShader(shader);
+    return program;
+}
+#endif
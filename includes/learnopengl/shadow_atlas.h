@@ -0,0 +1,362 @@
+#ifndef SHADOW_ATLAS_H
+#define SHADOW_ATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/gl_resources.h>
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// a square region of the shadow atlas, in texels
+struct ShadowAtlasTile
+{
+    unsigned int x = 0;
+    unsigned int y = 0;
+    unsigned int size = 0;
+};
+
+// One large depth texture shared by all shadowed lights. Every frame each light requests a tile,
+// the tile size is chosen from the light's screen coverage and importance, and tiles are handed out
+// by a quadtree allocator (every node is either free, in use, or split into four children of half
+// its size), most important light first. A light keeps its tile and its contents as long as the tile
+// isn't larger than the light's size now asks for (a light that had to fall back to a smaller tile
+// keeps it until there's room for the size it wants), so an unchanged light's shadow map doesn't have
+// to be re-rendered. When the atlas is full, the tiles of less important lights are taken back.
+//
+// usage per frame:
+//   atlas.beginFrame();
+//   atlas.request(lightId, coverage, importance, version); // for every shadowed light
+//   atlas.endFrame();
+//   for every light with atlas.needsRender(id): atlas.bindTile(id); render casters with the light's matrix
+//   sample atlas.texture() with atlas.uvRect(id) in the lighting pass
+class ShadowAtlas
+{
+public:
+    // the default 4096^2 32 bit depth atlas takes 64 MB, room for 16 tiles of the largest size
+    ShadowAtlas(unsigned int atlasSize = 4096, unsigned int minTileSize = 128, unsigned int maxTileSize = 1024)
+        : atlasSize(atlasSize), minTileSize(minTileSize), maxTileSize(std::min(maxTileSize, atlasSize))
+    {
+        levels = 1;
+        for (unsigned int s = atlasSize; s > minTileSize; s /= 2)
+            ++levels;
+        // implicit quadtree: node n has children 4n+1 .. 4n+4
+        unsigned int nodeCount = 0;
+        for (unsigned int l = 0, count = 1; l < levels; ++l, count *= 4)
+            nodeCount += count;
+        nodes.assign(nodeCount, FREE);
+
+        depth.storage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, atlasSize, atlasSize);
+        depth.parameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        depth.parameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        depth.parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        depth.parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        framebuffer.create();
+        framebuffer.texture(GL_DEPTH_ATTACHMENT, depth);
+        framebuffer.noColorBuffer();
+        framebuffer.checkComplete();
+    }
+
+    ShadowAtlas(const ShadowAtlas &) = delete;
+    ShadowAtlas &operator=(const ShadowAtlas &) = delete;
+
+    const GLTexture &texture() const
+    {
+        return depth;
+    }
+
+    void beginFrame()
+    {
+        requests.clear();
+    }
+
+    // screenCoverage: fraction of the screen (0..1) covered by the light's influence volume
+    // importance: user weight (e.g. 1 for regular lights, larger for hero lights)
+    // version: changes whenever the light or its casters moved, i.e. the shadow map content is stale
+    void request(unsigned int lightId, float screenCoverage, float importance, unsigned int version)
+    {
+        requests.push_back({ lightId, glm::clamp(screenCoverage, 0.0f, 1.0f) * importance, version });
+    }
+
+    // assigns tiles to all lights requested this frame; lights that weren't requested lose their tile
+    void endFrame()
+    {
+        // the most important lights pick first so they get their preferred size
+        std::sort(requests.begin(), requests.end(), [](const Request &a, const Request &b) { return a.priority > b.priority; });
+
+        // tiles of lights that are gone are free for the others
+        std::map<unsigned int, Allocation> previous;
+        previous.swap(allocations);
+        for (auto it = previous.begin(); it != previous.end();)
+        {
+            const bool requested = std::any_of(requests.begin(), requests.end(), [&](const Request &r) { return r.lightId == it->first; });
+            if (requested)
+            {
+                ++it;
+                continue;
+            }
+            release(it->second.node);
+            it = previous.erase(it);
+        }
+
+        // in priority order: whatever is left in `previous` belongs to less important lights
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            const Request &r = requests[i];
+            const unsigned int wanted = tileSizeFor(r.priority);
+            auto held = previous.find(r.lightId);
+            if (held != previous.end())
+            {
+                Allocation kept = held->second;
+                previous.erase(held);
+                if (kept.tile.size <= wanted)
+                {
+                    // a fallback tile grows back once the wanted size is free, without taking it from others
+                    int node = kept.tile.size < wanted ? allocate(0, 0, levelFor(wanted)) : -1;
+                    if (node < 0)
+                    {
+                        kept.dirty = kept.version != r.version;
+                        kept.version = r.version;
+                        allocations[r.lightId] = kept;
+                        continue;
+                    }
+                    release(kept.node);
+                    allocations[r.lightId] = newAllocation(node, r.version);
+                    continue;
+                }
+                // the light shrank: give its large tile back before picking a smaller one
+                release(kept.node);
+            }
+
+            // the wanted size, taking tiles from less important lights if that's what it takes, else the
+            // largest smaller size that fits
+            for (unsigned int size = wanted; size >= minTileSize; size /= 2)
+            {
+                int node = allocate(0, 0, levelFor(size));
+                if (node < 0)
+                    node = allocateEvicting(levelFor(size), i + 1, previous);
+                if (node >= 0)
+                {
+                    allocations[r.lightId] = newAllocation(node, r.version);
+                    break;
+                }
+            }
+        }
+
+        tilesReused = 0;
+        for (auto &a : allocations)
+            if (!a.second.dirty)
+                ++tilesReused;
+    }
+
+    // whether the light received a tile this frame (lights without one should be treated as unshadowed)
+    bool hasTile(unsigned int lightId) const
+    {
+        return allocations.count(lightId) != 0;
+    }
+
+    // whether the light's tile is new or its content is stale and must be re-rendered this frame
+    bool needsRender(unsigned int lightId) const
+    {
+        auto it = allocations.find(lightId);
+        return it != allocations.end() && it->second.dirty;
+    }
+
+    const ShadowAtlasTile &tile(unsigned int lightId) const
+    {
+        return allocations.at(lightId).tile;
+    }
+
+    // (offset.x, offset.y, scale.x, scale.y) to map the light's [0, 1] shadow coordinates into the atlas
+    glm::vec4 uvRect(unsigned int lightId) const
+    {
+        const ShadowAtlasTile &t = tile(lightId);
+        const float inv = 1.0f / atlasSize;
+        return glm::vec4(t.x * inv, t.y * inv, t.size * inv, t.size * inv);
+    }
+
+    // binds the atlas framebuffer restricted to the light's tile and clears only that tile
+    void bindTile(unsigned int lightId) const
+    {
+        const ShadowAtlasTile &t = tile(lightId);
+        framebuffer.bind();
+        glViewport(t.x, t.y, t.size, t.size);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(t.x, t.y, t.size, t.size);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    // number of lights that kept an up-to-date tile this frame and need no shadow rendering
+    unsigned int reusedTiles() const
+    {
+        return tilesReused;
+    }
+
+    // fraction of the atlas currently handed out
+    float occupancy() const
+    {
+        unsigned long long used = 0;
+        for (auto &a : allocations)
+            used += (unsigned long long)a.second.tile.size * a.second.tile.size;
+        return (float)((double)used / ((double)atlasSize * atlasSize));
+    }
+
+private:
+    enum NodeState : unsigned char { FREE, USED, SPLIT };
+
+    struct Request
+    {
+        unsigned int lightId;
+        float priority;
+        unsigned int version;
+    };
+
+    struct Allocation
+    {
+        int node = -1;
+        ShadowAtlasTile tile;
+        unsigned int version = 0;
+        bool dirty = true;
+    };
+
+    GLTexture depth;
+    GLFramebuffer framebuffer;
+    unsigned int atlasSize;
+    unsigned int minTileSize;
+    unsigned int maxTileSize;
+    unsigned int levels;
+    unsigned int tilesReused = 0;
+    std::vector<unsigned char> nodes;
+    std::vector<Request> requests;
+    std::map<unsigned int, Allocation> allocations;
+
+    // a light covering the whole screen with importance 1 gets the largest tile; the size falls off with
+    // the square root of the priority so the tile's texel density roughly follows the covered screen area
+    unsigned int tileSizeFor(float priority) const
+    {
+        float wanted = maxTileSize * std::sqrt(std::min(priority, 1.0f));
+        unsigned int size = maxTileSize;
+        while (size > minTileSize && size / 2 >= wanted)
+            size /= 2;
+        return size;
+    }
+
+    // frees the tiles still held by the lights of requests[first..] (least important first) until a node
+    // at `level` fits; leaves them all in place if even freeing every one of them isn't enough
+    int allocateEvicting(unsigned int level, size_t first, std::map<unsigned int, Allocation> &held)
+    {
+        const std::vector<unsigned char> saved = nodes;
+        std::vector<unsigned int> evicted;
+        for (size_t victim = requests.size(); victim-- > first;)
+        {
+            auto it = held.find(requests[victim].lightId);
+            if (it == held.end())
+                continue;
+            release(it->second.node);
+            evicted.push_back(it->first);
+            int node = allocate(0, 0, level);
+            if (node >= 0)
+            {
+                for (unsigned int lightId : evicted)
+                    held.erase(lightId);
+                return node;
+            }
+        }
+        nodes = saved;
+        return -1;
+    }
+
+    Allocation newAllocation(int node, unsigned int version) const
+    {
+        Allocation a;
+        a.node = node;
+        a.tile = tileOf(node);
+        a.version = version;
+        a.dirty = true;
+        return a;
+    }
+
+    unsigned int levelFor(unsigned int size) const
+    {
+        unsigned int level = 0;
+        for (unsigned int s = atlasSize; s > size; s /= 2)
+            ++level;
+        return level;
+    }
+
+    // finds a free node at the target level below node (at level), splitting free nodes on the way
+    int allocate(int node, unsigned int level, unsigned int target)
+    {
+        if (nodes[node] == USED)
+            return -1;
+        if (level == target)
+        {
+            if (nodes[node] != FREE)
+                return -1;
+            nodes[node] = USED;
+            return node;
+        }
+        if (nodes[node] == FREE)
+            nodes[node] = SPLIT; // children are FREE already
+        for (int c = 1; c <= 4; ++c)
+        {
+            int found = allocate(4 * node + c, level + 1, target);
+            if (found >= 0)
+                return found;
+        }
+        // nothing found below, undo the split if it didn't help
+        if (allChildrenFree(node))
+            nodes[node] = FREE;
+        return -1;
+    }
+
+    // frees a node and merges its parents back together while all four siblings are free
+    void release(int node)
+    {
+        nodes[node] = FREE;
+        while (node > 0)
+        {
+            int parent = (node - 1) / 4;
+            if (!allChildrenFree(parent))
+                break;
+            nodes[parent] = FREE;
+            node = parent;
+        }
+    }
+
+    bool allChildrenFree(int node) const
+    {
+        for (int c = 1; c <= 4; ++c)
+            if (nodes[4 * node + c] != FREE)
+                return false;
+        return true;
+    }
+
+    ShadowAtlasTile tileOf(int node) const
+    {
+        // walk up to the root collecting the quadrant at every level
+        ShadowAtlasTile t;
+        unsigned int size = atlasSize;
+        std::vector<int> quadrants;
+        while (node > 0)
+        {
+            quadrants.push_back((node - 1) % 4);
+            node = (node - 1) / 4;
+        }
+        for (auto it = quadrants.rbegin(); it != quadrants.rend(); ++it)
+        {
+            size /= 2;
+            t.x += (*it % 2) * size;
+            t.y += (*it / 2) * size;
+        }
+        t.size = size;
+        return t;
+    }
+};
+#endif
@@ -0,0 +1,325 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <learnopengl/gl_resources.h>
+#include <learnopengl/upload_thread.h>
+#include <learnopengl/metrics.h>
+
+#include <string>
+#include <vector>
+#include <future>
+#include <chrono>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// Loads a batch of textures and cubemaps with the image decoding (and mipmap generation) spread over
+// worker threads. load()/loadCubemap() return the texture right away; it gets its immutable storage
+// and all of its mip levels once every image it needs is decoded, during poll() or finish() on the
+// thread that owns the GL context (or on an UploadThread, see setUploadThread()):
+//
+//   TextureLoader loader;
+//   GLTexture diffuse = loader.load(FileSystem::getPath("resources/textures/container2.png"));
+//   GLTexture skybox  = loader.loadCubemap(faces);
+//   loader.finish(); // or call loader.poll() once per frame until it returns true
+//
+// The returned GLTexture owns the name, the loader only uploads into it, so keep it alive until the
+// batch is done. stbi_set_flip_vertically_on_load is read by the worker threads, so don't change it
+// while a batch is still decoding.
+class TextureLoader
+{
+public:
+    TextureLoader() = default;
+    TextureLoader(const TextureLoader &) = delete;
+    TextureLoader &operator=(const TextureLoader &) = delete;
+
+    ~TextureLoader()
+    {
+        // the workers write into images owned by this loader, completions count down its uploads
+        for (Pending &p : pending)
+            for (std::future<void> &f : p.decodes)
+                f.wait();
+        if (uploading > 0)
+            uploads->finish();
+    }
+
+    // uploads the textures decoded from now on on `thread` (nullptr: on the GL thread, in poll());
+    // the upload thread must outlive the loader
+    void setUploadThread(UploadThread *thread)
+    {
+        uploads = thread;
+    }
+
+    // queues a 2D texture with repeat wrapping and trilinear filtering; gammaCorrection stores it as sRGB
+    GLTexture load(const std::string &path, bool gammaCorrection = false, GLint wrap = GL_REPEAT)
+    {
+        GLTexture texture;
+        Pending p = create(texture, GL_TEXTURE_2D);
+        p.gamma = gammaCorrection;
+        p.wrap = wrap;
+        p.images.push_back(std::make_shared<Image>());
+        p.images[0]->path = path;
+        startDecoding(p);
+        pending.push_back(std::move(p));
+        return texture;
+    }
+
+    // queues a cubemap from 6 faces in the order +X, -X, +Y, -Y, +Z, -Z (single level, linear filtering)
+    GLTexture loadCubemap(const std::vector<std::string> &faces)
+    {
+        GLTexture texture;
+        Pending p = create(texture, GL_TEXTURE_CUBE_MAP);
+        p.wrap = GL_CLAMP_TO_EDGE;
+        for (const std::string &face : faces)
+        {
+            p.images.push_back(std::make_shared<Image>());
+            p.images.back()->path = face;
+        }
+        startDecoding(p);
+        pending.push_back(std::move(p));
+        return texture;
+    }
+
+    // uploads every texture whose images are decoded without waiting for the others;
+    // returns true once the whole batch is uploaded
+    bool poll()
+    {
+        for (size_t i = 0; i < pending.size();)
+        {
+            if (!decoded(pending[i]))
+            {
+                ++i;
+                continue;
+            }
+            if (uploads)
+            {
+                std::shared_ptr<Pending> job = std::make_shared<Pending>(std::move(pending[i]));
+                uploading++;
+                uploads->submit([job]() { upload(*job); }, [this]() { uploading--; });
+            }
+            else
+                upload(pending[i]);
+            pending.erase(pending.begin() + i);
+        }
+        if (uploads)
+            uploads->poll();
+        return pending.empty() && uploading == 0;
+    }
+
+    // blocks until the whole batch is decoded and uploaded
+    void finish()
+    {
+        for (Pending &p : pending)
+            for (std::future<void> &f : p.decodes)
+                f.wait();
+        poll();
+        if (uploading > 0)
+            uploads->finish();
+    }
+
+private:
+    // one decoded image and its mip chain, level 0 first
+    struct Image
+    {
+        std::string path;
+        int width = 0, height = 0, components = 0;
+        std::vector<std::vector<unsigned char>> levels;
+    };
+
+    struct Pending
+    {
+        unsigned int name = 0; // owned by the GLTexture load() returned
+        GLenum target = GL_TEXTURE_2D;
+        bool gamma = false;
+        GLint wrap = GL_REPEAT;
+        std::vector<std::shared_ptr<Image>> images;
+        std::vector<std::future<void>> decodes;
+    };
+
+    std::vector<Pending> pending;
+    UploadThread *uploads = nullptr;
+    size_t uploading = 0; // handed to the upload thread, completion not run yet
+
+    static Pending create(GLTexture &texture, GLenum target)
+    {
+        texture.create(target);
+        Pending p;
+        p.name = texture.id();
+        p.target = target;
+        return p;
+    }
+
+    static void startDecoding(Pending &p)
+    {
+        const bool mipmaps = p.target == GL_TEXTURE_2D;
+        const bool gamma = p.gamma;
+        for (std::shared_ptr<Image> &image : p.images)
+            p.decodes.push_back(std::async(std::launch::async, [image, mipmaps, gamma]() { decode(*image, mipmaps, gamma); }));
+    }
+
+    static bool decoded(const Pending &p)
+    {
+        for (const std::future<void> &f : p.decodes)
+            if (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return false;
+        return true;
+    }
+
+    // runs on a worker thread: decode, then build the mip chain with a 2x2 box filter
+    static void decode(Image &image, bool mipmaps, bool gamma)
+    {
+        static MetricHistogram &decodeTime = metrics().histogram("loader_image_decode_seconds", "Decode and mip chain time per image",
+                                                                 { 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0 });
+        const auto start = std::chrono::steady_clock::now();
+
+        unsigned char *data = stbi_load(image.path.c_str(), &image.width, &image.height, &image.components, 0);
+        if (!data)
+            return;
+        image.levels.emplace_back(data, data + (size_t)image.width * image.height * image.components);
+        stbi_image_free(data);
+
+        int w = image.width, h = image.height;
+        while (mipmaps && (w > 1 || h > 1))
+        {
+            const int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+            image.levels.push_back(downsample(image.levels.back(), w, h, nw, nh, image.components, gamma));
+            w = nw;
+            h = nh;
+        }
+        decodeTime.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    static std::vector<unsigned char> downsample(const std::vector<unsigned char> &src, int w, int h, int nw, int nh, int components, bool gamma)
+    {
+        // sRGB colors are averaged in linear space, alpha and linear data directly
+        static float toLinear[256];
+        static const bool tableReady = [] {
+            for (int i = 0; i < 256; ++i)
+                toLinear[i] = std::pow(i / 255.0f, 2.2f);
+            return true;
+        }();
+        (void)tableReady;
+
+        std::vector<unsigned char> dst((size_t)nw * nh * components);
+        for (int y = 0; y < nh; ++y)
+        {
+            const int y0 = std::min(2 * y, h - 1), y1 = std::min(2 * y + 1, h - 1);
+            for (int x = 0; x < nw; ++x)
+            {
+                const int x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+                for (int c = 0; c < components; ++c)
+                {
+                    const unsigned char a = src[((size_t)y0 * w + x0) * components + c];
+                    const unsigned char b = src[((size_t)y0 * w + x1) * components + c];
+                    const unsigned char d = src[((size_t)y1 * w + x0) * components + c];
+                    const unsigned char e = src[((size_t)y1 * w + x1) * components + c];
+                    unsigned char result;
+                    if (gamma && c < 3)
+                        result = (unsigned char)(std::pow((toLinear[a] + toLinear[b] + toLinear[d] + toLinear[e]) * 0.25f, 1.0f / 2.2f) * 255.0f + 0.5f);
+                    else
+                        result = (unsigned char)((a + b + d + e + 2) / 4);
+                    dst[((size_t)y * nw + x) * components + c] = result;
+                }
+            }
+        }
+        return dst;
+    }
+
+    // runs on the GL thread: immutable storage for all levels, then every level (and face) in one go
+    static void upload(Pending &p)
+    {
+        const Image &first = *p.images[0];
+        for (const std::shared_ptr<Image> &image : p.images)
+        {
+            if (image->levels.empty())
+            {
+                std::cout << (p.target == GL_TEXTURE_CUBE_MAP ? "Cubemap texture" : "Texture") << " failed to load at path: " << image->path << std::endl;
+                return;
+            }
+            if (image->width != first.width || image->height != first.height || image->components != first.components)
+            {
+                std::cout << "ERROR::TEXTURE_LOADER:: Cubemap faces differ in size or format: " << image->path << std::endl;
+                return;
+            }
+        }
+
+        static MetricCounter &textures = metrics().counter("loader_textures_total", "Textures and cubemaps uploaded by TextureLoader");
+        textures.add();
+        size_t bytes = 0;
+        for (const std::shared_ptr<Image> &image : p.images)
+            for (const std::vector<unsigned char> &level : image->levels)
+                bytes += level.size();
+        glUploadedBytes().add(bytes);
+
+        GLenum format = GL_RGBA, internalFormat = p.gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        if (first.components == 1)
+            format = GL_RED, internalFormat = GL_R8;
+        else if (first.components == 2)
+            format = GL_RG, internalFormat = GL_RG8;
+        else if (first.components == 3)
+            format = GL_RGB, internalFormat = p.gamma ? GL_SRGB8 : GL_RGB8;
+        const GLsizei levels = (GLsizei)first.levels.size();
+
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows of RGB images aren't 4 byte aligned
+
+        GLCallStats &stats = glCallStats();
+        if (glHasDirectStateAccess())
+        {
+            glTextureStorage2D(p.name, levels, internalFormat, first.width, first.height);
+            for (GLsizei level = 0; level < levels; ++level)
+            {
+                const GLsizei w = std::max(1, first.width >> level), h = std::max(1, first.height >> level);
+                if (p.target == GL_TEXTURE_CUBE_MAP)
+                    for (size_t face = 0; face < p.images.size(); ++face)
+                        glTextureSubImage3D(p.name, level, 0, 0, (GLint)face, w, h, 1, format, GL_UNSIGNED_BYTE, p.images[face]->levels[level].data());
+                else
+                    glTextureSubImage2D(p.name, level, 0, 0, w, h, format, GL_UNSIGNED_BYTE, first.levels[level].data());
+            }
+            setParameters(p, levels);
+            stats.dsaCalls += 1 + levels * p.images.size();
+        }
+        else
+        {
+            glBindTexture(p.target, p.name);
+            stats.binds++;
+            if (GLAD_GL_VERSION_4_2)
+                glTexStorage2D(p.target, levels, internalFormat, first.width, first.height);
+            for (GLsizei level = 0; level < levels; ++level)
+            {
+                const GLsizei w = std::max(1, first.width >> level), h = std::max(1, first.height >> level);
+                for (size_t face = 0; face < p.images.size(); ++face)
+                {
+                    const GLenum imageTarget = p.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + (GLenum)face : p.target;
+                    const unsigned char *pixels = p.images[face]->levels[level].data();
+                    if (GLAD_GL_VERSION_4_2)
+                        glTexSubImage2D(imageTarget, level, 0, 0, w, h, format, GL_UNSIGNED_BYTE, pixels);
+                    else
+                        glTexImage2D(imageTarget, level, internalFormat, w, h, 0, format, GL_UNSIGNED_BYTE, pixels);
+                }
+            }
+            setParameters(p, levels);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    }
+
+    static void setParameters(const Pending &p, GLsizei levels)
+    {
+        const GLint minFilter = levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+        const GLenum pnames[] = { GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T, GL_TEXTURE_WRAP_R, GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_MAX_LEVEL };
+        const GLint values[] = { p.wrap, p.wrap, p.wrap, minFilter, GL_LINEAR, levels - 1 };
+        for (int i = 0; i < 6; ++i)
+        {
+            if (glHasDirectStateAccess())
+                glTextureParameteri(p.name, pnames[i], values[i]);
+            else
+                glTexParameteri(p.target, pnames[i], values[i]);
+        }
+    }
+};
+#endif
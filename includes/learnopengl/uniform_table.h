@@ -0,0 +1,181 @@
+#ifndef UNIFORM_TABLE_H
+#define UNIFORM_TABLE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Uniform locations without driver lookups. UniformTable asks the program for its active uniforms
+// once after linking and keeps name -> location in an open addressing table; a setter then only hashes
+// the name, which never allocates. Names are hashed where the UniformName is made, so a name kept in a
+// constant is hashed at compile time:
+//
+//   static constexpr UniformName VIEW = "view";
+//   shader.setMat4(VIEW, view);
+//   shader.setMat4("projection", projection);                      // literals work as before
+//   shader.setVec3(UniformElement("lights", i, "Position"), pos);  // "lights[i].Position", no std::string
+//
+// Names the program doesn't use (optimized out, misspelled) get location -1, which glUniform* ignores,
+// just like glGetUniformLocation.
+
+// FNV-1a
+constexpr uint64_t uniformHash(std::string_view name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name)
+        hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+    return hash;
+}
+
+class UniformName
+{
+public:
+    constexpr UniformName(const char *name) : text(name), hashed(uniformHash(text)) {}
+    constexpr UniformName(std::string_view name) : text(name), hashed(uniformHash(text)) {}
+    UniformName(const std::string &name) : text(name), hashed(uniformHash(text)) {}
+
+    constexpr std::string_view view() const { return text; }
+    constexpr uint64_t hash() const { return hashed; }
+
+protected:
+    std::string_view text;
+    uint64_t hashed;
+
+    UniformName() : hashed(0) {}
+};
+
+// element of a uniform array, optionally a member of it: UniformElement("lights", 3, "Color") names
+// "lights[3].Color"; formatted into the object itself, so keep it alive while its name is used
+class UniformElement : public UniformName
+{
+public:
+    UniformElement(std::string_view array, unsigned int index, std::string_view member = {})
+    {
+        char digits[12];
+        int count = 0;
+        for (unsigned int rest = index; count == 0 || rest > 0; rest /= 10)
+            digits[sizeof(digits) - 1 - count++] = char('0' + rest % 10);
+        const size_t length = array.size() + count + 2 + (member.empty() ? 0 : member.size() + 1);
+        if (length > sizeof(buffer))
+        {
+            std::cout << "ERROR::UNIFORM_TABLE:: Uniform name too long: " << array << "[" << index << "]" << member << std::endl;
+            return;
+        }
+        size_t at = 0;
+        auto append = [this, &at](std::string_view part) {
+            part.copy(buffer + at, part.size());
+            at += part.size();
+        };
+        append(array);
+        append("[");
+        append(std::string_view(digits + sizeof(digits) - count, count));
+        append("]");
+        if (!member.empty())
+        {
+            append(".");
+            append(member);
+        }
+        text = std::string_view(buffer, at);
+        hashed = uniformHash(text);
+    }
+
+    UniformElement(const UniformElement &) = delete;
+    UniformElement &operator=(const UniformElement &) = delete;
+
+private:
+    char buffer[128];
+};
+
+class UniformTable
+{
+public:
+    // reads the active uniforms of a linked program; call again after relinking it
+    void build(GLuint program)
+    {
+        slots.clear();
+        if (program == 0) // failed to build; every lookup stays -1
+            return;
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<std::pair<std::string, GLint>> entries;
+        std::vector<GLchar> name(maxLength + 1);
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type;
+            glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+            std::string uniform(name.data(), length);
+            const GLint location = glGetUniformLocation(program, uniform.c_str());
+            if (location < 0)
+                continue; // member of a uniform block
+            entries.emplace_back(uniform, location);
+            // arrays are reported once as "name[0]"; "name" and every element are valid names too
+            if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+            {
+                const std::string base = uniform.substr(0, uniform.size() - 3);
+                entries.emplace_back(base, location);
+                for (GLint element = 1; element < size; ++element)
+                {
+                    const std::string elementName = base + "[" + std::to_string(element) + "]";
+                    entries.emplace_back(elementName, glGetUniformLocation(program, elementName.c_str()));
+                }
+            }
+        }
+
+        // power of two, at most half full, so probe sequences stay short
+        size_t capacity = 8;
+        while (capacity < entries.size() * 2)
+            capacity *= 2;
+        slots.assign(capacity, Slot());
+        mask = capacity - 1;
+        for (auto &entry : entries)
+        {
+            const uint64_t hash = uniformHash(entry.first);
+            size_t index = hash & mask;
+            while (slots[index].location != EMPTY)
+                index = (index + 1) & mask;
+            slots[index] = Slot{ hash, std::move(entry.first), entry.second };
+        }
+    }
+
+    GLint location(const UniformName &name) const
+    {
+        if (slots.empty())
+            return -1;
+        for (size_t index = name.hash() & mask;; index = (index + 1) & mask)
+        {
+            const Slot &slot = slots[index];
+            if (slot.location == EMPTY)
+                return -1;
+            if (slot.hash == name.hash() && slot.name == name.view())
+                return slot.location;
+        }
+    }
+
+    size_t size() const
+    {
+        size_t used = 0;
+        for (const Slot &slot : slots)
+            used += slot.location != EMPTY;
+        return used;
+    }
+
+private:
+    static constexpr GLint EMPTY = -2;
+
+    struct Slot
+    {
+        uint64_t hash = 0;
+        std::string name;
+        GLint location = EMPTY;
+    };
+    std::vector<Slot> slots;
+    size_t mask = 0;
+};
+#endif
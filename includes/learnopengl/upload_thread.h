@@ -0,0 +1,205 @@
+#ifndef UPLOAD_THREAD_H
+#define UPLOAD_THREAD_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <learnopengl/metrics.h>
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <iostream>
+
+// A thread with a GL context of its own that shares objects with the render thread's context, for the
+// uploads that would otherwise stall a frame (textures and meshes arriving mid-session). A job carries
+// its CPU side data and runs on the upload thread; its commands are fenced, and once poll() on the
+// render thread finds the fence signaled, the job's completion runs there. From then on whatever the
+// job created can be used, without the render thread ever having waited for it:
+//
+//   UploadThread uploads(window); // once the window's context is current and GL is loaded
+//   std::shared_ptr<GLTexture> texture = std::make_shared<GLTexture>();
+//   uploads.submit([texture, image]() { *texture = TextureFromPixels(image->data(), 512, 512, 4); },
+//                  [texture, &material]() { material.diffuse = texture->id(); });
+//   while (!glfwWindowShouldClose(window))
+//   {
+//       uploads.poll();
+//       ...
+//
+// Only objects that hold data (buffers, textures, shaders and programs, samplers, sync objects) are
+// shared between contexts; vertex arrays and framebuffers are not, so completions create those. An
+// object must be bound on the render thread after its completion ran for the new contents to show.
+// Without a shared context (creating it failed) jobs run right away in submit(), on the calling thread.
+class UploadThread
+{
+public:
+    // `window`'s context must be current; call on the main thread, the only one GLFW creates windows on.
+    // The upload context is a hidden window made with the window hints currently set
+    explicit UploadThread(GLFWwindow *window)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+        context = glfwCreateWindow(1, 1, "upload", NULL, window);
+        glfwWindowHint(GLFW_VISIBLE, GL_TRUE);
+        if (context == NULL)
+        {
+            std::cout << "ERROR::UPLOAD_THREAD:: Failed to create a shared context, uploading on the render thread" << std::endl;
+            return;
+        }
+        GLFWwindow *shared = context;
+        start([shared]() { glfwMakeContextCurrent(shared); }, []() { glfwMakeContextCurrent(NULL); });
+    }
+
+    // for contexts not made by GLFW: makeCurrent and release (un)bind a context sharing objects with the
+    // render thread's, on the upload thread
+    UploadThread(std::function<void()> makeCurrent, std::function<void()> release)
+    {
+        start(std::move(makeCurrent), std::move(release));
+    }
+
+    // jobs that haven't started are dropped, their completions never run
+    ~UploadThread()
+    {
+        if (worker.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            worker.join();
+        }
+        for (Fenced &job : fenced)
+            if (job.fence)
+                glDeleteSync(job.fence);
+        fenced.clear();
+        if (context)
+            glfwDestroyWindow(context);
+    }
+
+    UploadThread(const UploadThread &) = delete;
+    UploadThread &operator=(const UploadThread &) = delete;
+
+    // queues `upload` to run on the upload thread; `completion` runs in a later poll() on this thread,
+    // once the GPU has executed everything `upload` issued. Jobs complete in the order they're submitted
+    void submit(std::function<void()> upload, std::function<void()> completion = nullptr)
+    {
+        inFlight++;
+        if (!worker.joinable())
+        {
+            upload();
+            std::lock_guard<std::mutex> lock(queueMutex);
+            fenced.push_back({ 0, std::move(completion) });
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back({ std::move(upload), std::move(completion) });
+        }
+        wake.notify_one();
+    }
+
+    // runs the completions of the jobs the GPU is done with, without waiting for the others;
+    // returns true once every job submitted so far has completed
+    bool poll()
+    {
+        for (;;)
+        {
+            std::function<void()> completion;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (fenced.empty())
+                    break;
+                Fenced &job = fenced.front();
+                if (job.fence)
+                {
+                    if (glClientWaitSync(job.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+                        break;
+                    glDeleteSync(job.fence);
+                }
+                completion = std::move(job.completion);
+                fenced.pop_front();
+            }
+            // outside the lock, a completion may submit more work
+            inFlight--;
+            if (completion)
+                completion();
+        }
+        return inFlight == 0;
+    }
+
+    // blocks until every job submitted so far has completed
+    void finish()
+    {
+        while (!poll())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // jobs submitted whose completion hasn't run yet
+    size_t pending() const
+    {
+        return inFlight;
+    }
+
+private:
+    struct Job
+    {
+        std::function<void()> upload, completion;
+    };
+    // a job that ran on the upload thread, complete when its fence is signaled (0: ran without a context)
+    struct Fenced
+    {
+        GLsync fence;
+        std::function<void()> completion;
+    };
+
+    GLFWwindow *context = nullptr;
+    std::thread worker;
+    std::mutex queueMutex;
+    std::condition_variable wake;
+    std::deque<Job> queue;      // not started yet
+    std::deque<Fenced> fenced;  // run, waiting for the GPU
+    bool stopping = false;
+    size_t inFlight = 0;        // render thread only
+
+    void start(std::function<void()> makeCurrent, std::function<void()> release)
+    {
+        worker = std::thread([this, makeCurrent, release]() {
+            makeCurrent();
+            work();
+            release();
+        });
+    }
+
+    void work()
+    {
+        static MetricCounter &jobs = metrics().counter("upload_thread_jobs_total", "Jobs run on the upload thread");
+        static MetricHistogram &jobTime = metrics().histogram("upload_thread_job_seconds", "Time the upload thread spent issuing one job",
+                                                              { 0.0001, 0.001, 0.005, 0.01, 0.05, 0.1 });
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (stopping)
+                    return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            const auto start = std::chrono::steady_clock::now();
+            job.upload();
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            // the render thread only ever polls the fence, so it must reach the GPU without its help
+            glFlush();
+            jobs.add();
+            jobTime.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+            std::lock_guard<std::mutex> lock(queueMutex);
+            fenced.push_back({ fence, std::move(job.completion) });
+        }
+    }
+};
+#endif
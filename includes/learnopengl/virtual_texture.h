@@ -0,0 +1,823 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/gl_resources.h>
+#include <learnopengl/metrics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Software virtual texturing: a texture far larger than one GL allocation (a gigapixel terrain or planet
+// map) lives on disk as a page file, and only the pages the current view needs are resident in a small
+// physical cache texture.
+//
+// BuildVirtualTexture() tiles a source into the page file once: square pages of pageSize texels plus a
+// border copied from the neighbours, for every level of a mip chain down to a single page. At run time
+// VirtualTexture keeps
+//   - the cache: a texture of cacheSize x cacheSize page slots,
+//   - the page table: one RGBA8 texel per page and level, holding the cache slot of the page or, while
+//     it isn't resident, the slot of its nearest resident ancestor (the coarsest page is always resident),
+//   - the feedback pass: the scene drawn at a fraction of the resolution into an R32UI target, every
+//     fragment writing the page it would sample. It is read back through a pixel buffer a few frames
+//     later, so the GPU never waits for it,
+// and update() turns the feedback into page requests, streams them from disk on a worker thread and
+// uploads a few per frame into least recently used slots:
+//
+//   BuildVirtualTexture("terrain.vt", 16384, 16384, source);   // once, offline
+//   VirtualTexture vt("terrain.vt");
+//   while (!glfwWindowShouldClose(window))
+//   {
+//       vt.beginFeedback(width, height);
+//       vt.bind(feedbackShader, 0, true);    // the material shader with VT_FEEDBACK defined
+//       drawScene();
+//       vt.endFeedback();
+//       vt.update();
+//       vt.bind(shader, 0);                  // samples with vtSample() from virtual_texture.glsl
+//       drawScene();
+//       ...
+//
+// The virtual size must be the page size times a power of two on each side. Texels are RGBA8 and
+// filtered as stored, i.e. without gamma conversion.
+
+// fills `rgba` (width * height texels, 4 bytes each, rows in order) with the level 0 texels of the
+// rectangle at (x, y); the rectangle always lies inside the texture. Called from several threads at once
+typedef std::function<void(int x, int y, int width, int height, unsigned char *rgba)> VirtualTextureSource;
+
+// size and page arrangement of a page file; pages are stored level after level, row by row
+struct VirtualTextureLayout
+{
+    int width = 0, height = 0; // level 0 texels
+    int pageSize = 0;          // texels per page side, without the border
+    int border = 0;            // texels on every side copied from the neighbouring pages
+    int levels = 0;
+
+    static const uint32_t Magic = 0x31545656; // "VVT1"
+    // the feedback pass and the page requests pack a page into 32 bits, 12 bits per coordinate
+    static const int MaxPages = 4096;
+    static const int MaxLevels = 16;
+
+    bool init(int w, int h, int page, int borderTexels)
+    {
+        width = w, height = h, pageSize = page, border = borderTexels;
+        if (page <= 0 || w < page || h < page || w % page || h % page || borderTexels < 0 || borderTexels > page / 2)
+            return false;
+        const int px = w / page, py = h / page;
+        if ((px & (px - 1)) || (py & (py - 1)) || px > MaxPages || py > MaxPages)
+            return false;
+        levels = 1;
+        while ((std::max(px, py) >> (levels - 1)) > 1)
+            levels++;
+        return levels <= MaxLevels;
+    }
+
+    int levelWidth(int level) const
+    {
+        return std::max(1, width >> level);
+    }
+    int levelHeight(int level) const
+    {
+        return std::max(1, height >> level);
+    }
+    int pagesX(int level) const
+    {
+        return std::max(1, (width / pageSize) >> level);
+    }
+    int pagesY(int level) const
+    {
+        return std::max(1, (height / pageSize) >> level);
+    }
+    int paddedSize() const
+    {
+        return pageSize + 2 * border;
+    }
+    size_t pageBytes() const
+    {
+        return (size_t)paddedSize() * paddedSize() * 4;
+    }
+    static size_t headerBytes()
+    {
+        return 6 * sizeof(int32_t);
+    }
+    uint64_t pageOffset(int level, int x, int y) const
+    {
+        uint64_t index = 0;
+        for (int l = 0; l < level; ++l)
+            index += (uint64_t)pagesX(l) * pagesY(l);
+        index += (uint64_t)y * pagesX(level) + x;
+        return headerBytes() + index * pageBytes();
+    }
+
+    static uint32_t pageKey(int level, int x, int y)
+    {
+        return (uint32_t)x | ((uint32_t)y << 12) | ((uint32_t)level << 24);
+    }
+    static int keyLevel(uint32_t key)
+    {
+        return (int)(key >> 24);
+    }
+    static int keyX(uint32_t key)
+    {
+        return (int)(key & 0xFFF);
+    }
+    static int keyY(uint32_t key)
+    {
+        return (int)((key >> 12) & 0xFFF);
+    }
+
+    void write(std::ostream &out) const
+    {
+        const int32_t fields[6] = { (int32_t)Magic, width, height, pageSize, border, levels };
+        out.write((const char *)fields, sizeof(fields));
+    }
+    bool read(std::istream &in)
+    {
+        int32_t fields[6] = {};
+        in.read((char *)fields, sizeof(fields));
+        if (!in || (uint32_t)fields[0] != Magic || !init(fields[1], fields[2], fields[3], fields[4]))
+            return false;
+        return levels == fields[5];
+    }
+};
+
+// reads texels of one level back from a page file that is being written, keeping the last few pages
+class VirtualTexturePageReader
+{
+public:
+    VirtualTexturePageReader(std::fstream &file, const VirtualTextureLayout &layout) : file(file), layout(layout)
+    {
+    }
+
+    // copies the rectangle at (x, y) of `level`, which must lie inside the level, into `rgba`
+    void readRect(int level, int x, int y, int w, int h, unsigned char *rgba)
+    {
+        const int P = layout.pageSize, B = layout.border, padded = layout.paddedSize();
+        for (int py = y / P; py <= (y + h - 1) / P; ++py)
+        {
+            for (int px = x / P; px <= (x + w - 1) / P; ++px)
+            {
+                const unsigned char *page = fetch(level, px, py);
+                const int x0 = std::max(x, px * P), x1 = std::min(x + w, px * P + P);
+                const int y0 = std::max(y, py * P), y1 = std::min(y + h, py * P + P);
+                for (int ty = y0; ty < y1; ++ty)
+                {
+                    const unsigned char *src = page + ((size_t)(ty - py * P + B) * padded + (x0 - px * P + B)) * 4;
+                    memcpy(rgba + ((size_t)(ty - y) * w + (x0 - x)) * 4, src, (size_t)(x1 - x0) * 4);
+                }
+            }
+        }
+    }
+
+private:
+    static const size_t Capacity = 32;
+    std::fstream &file;
+    const VirtualTextureLayout &layout;
+    std::list<std::pair<uint32_t, std::vector<unsigned char>>> pages; // most recently used first
+
+    const unsigned char *fetch(int level, int x, int y)
+    {
+        const uint32_t key = VirtualTextureLayout::pageKey(level, x, y);
+        for (auto it = pages.begin(); it != pages.end(); ++it)
+        {
+            if (it->first == key)
+            {
+                pages.splice(pages.begin(), pages, it);
+                return pages.front().second.data();
+            }
+        }
+        if (pages.size() == Capacity)
+            pages.pop_back();
+        pages.emplace_front(key, std::vector<unsigned char>(layout.pageBytes()));
+        file.seekg((std::streamoff)layout.pageOffset(level, x, y));
+        file.read((char *)pages.front().second.data(), (std::streamsize)layout.pageBytes());
+        return pages.front().second.data();
+    }
+};
+
+// fills a padded page of `level` from `fetch`, which reads a rectangle of that level; texels past the
+// edge of the level repeat the edge
+inline void FillVirtualTexturePage(const VirtualTextureLayout &layout, int level, int px, int py, unsigned char *page,
+                                   const std::function<void(int, int, int, int, unsigned char *)> &fetch)
+{
+    const int padded = layout.paddedSize();
+    const int rx = px * layout.pageSize - layout.border, ry = py * layout.pageSize - layout.border;
+    const int x0 = std::max(0, rx), x1 = std::min(layout.levelWidth(level), rx + padded);
+    const int y0 = std::max(0, ry), y1 = std::min(layout.levelHeight(level), ry + padded);
+    std::vector<unsigned char> rect((size_t)(x1 - x0) * (y1 - y0) * 4);
+    fetch(x0, y0, x1 - x0, y1 - y0, rect.data());
+    for (int j = 0; j < padded; ++j)
+    {
+        const int sy = std::min(std::max(ry + j, y0), y1 - 1) - y0;
+        for (int i = 0; i < padded; ++i)
+        {
+            const int sx = std::min(std::max(rx + i, x0), x1 - 1) - x0;
+            memcpy(page + ((size_t)j * padded + i) * 4, &rect[((size_t)sy * (x1 - x0) + sx) * 4], 4);
+        }
+    }
+}
+
+// tiles `source` (width x height texels) into the page file at `path`; level 0 is built from the source
+// on all cores, every further level by box filtering the level below it as read back from the file, so
+// memory use doesn't depend on the size of the texture
+inline bool BuildVirtualTexture(const std::string &path, int width, int height, const VirtualTextureSource &source,
+                                int pageSize = 128, int border = 1)
+{
+    VirtualTextureLayout layout;
+    if (!layout.init(width, height, pageSize, border))
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE:: " << width << "x" << height << " isn't a power of two multiple of the page size "
+                  << pageSize << std::endl;
+        return false;
+    }
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE:: Failed to create " << path << std::endl;
+        return false;
+    }
+    layout.write(file);
+
+    const size_t pageBytes = layout.pageBytes();
+    std::vector<unsigned char> row;
+    for (int py = 0; py < layout.pagesY(0); ++py)
+    {
+        // one row of pages at a time, its pages spread over one task per core
+        const int columns = layout.pagesX(0);
+        const int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+        row.resize(pageBytes * columns);
+        std::vector<std::future<void>> tasks;
+        for (int first = 0; first < std::min(threads, columns); ++first)
+        {
+            tasks.push_back(std::async(std::launch::async, [&layout, &source, &row, pageBytes, first, threads, columns, py]() {
+                for (int px = first; px < columns; px += threads)
+                    FillVirtualTexturePage(layout, 0, px, py, row.data() + pageBytes * px, source);
+            }));
+        }
+        for (std::future<void> &task : tasks)
+            task.get();
+        file.seekp((std::streamoff)layout.pageOffset(0, 0, py));
+        file.write((const char *)row.data(), (std::streamsize)row.size());
+    }
+
+    std::vector<unsigned char> page(pageBytes), lower;
+    for (int level = 1; level < layout.levels; ++level)
+    {
+        file.flush();
+        VirtualTexturePageReader reader(file, layout);
+        const int lowerWidth = layout.levelWidth(level - 1), lowerHeight = layout.levelHeight(level - 1);
+        auto downsample = [&](int x, int y, int w, int h, unsigned char *rgba) {
+            const int lx = 2 * x, ly = 2 * y;
+            const int lw = std::min(2 * w, lowerWidth - lx), lh = std::min(2 * h, lowerHeight - ly);
+            lower.resize((size_t)lw * lh * 4);
+            reader.readRect(level - 1, lx, ly, lw, lh, lower.data());
+            for (int j = 0; j < h; ++j)
+            {
+                const int j0 = std::min(2 * j, lh - 1), j1 = std::min(2 * j + 1, lh - 1);
+                for (int i = 0; i < w; ++i)
+                {
+                    const int i0 = std::min(2 * i, lw - 1), i1 = std::min(2 * i + 1, lw - 1);
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        const int sum = lower[((size_t)j0 * lw + i0) * 4 + c] + lower[((size_t)j0 * lw + i1) * 4 + c] +
+                                        lower[((size_t)j1 * lw + i0) * 4 + c] + lower[((size_t)j1 * lw + i1) * 4 + c];
+                        rgba[((size_t)j * w + i) * 4 + c] = (unsigned char)((sum + 2) / 4);
+                    }
+                }
+            }
+        };
+        for (int py = 0; py < layout.pagesY(level); ++py)
+        {
+            for (int px = 0; px < layout.pagesX(level); ++px)
+            {
+                FillVirtualTexturePage(layout, level, px, py, page.data(), downsample);
+                file.seekp((std::streamoff)layout.pageOffset(level, px, py));
+                file.write((const char *)page.data(), (std::streamsize)pageBytes);
+            }
+        }
+    }
+    file.flush();
+    if (!file)
+    {
+        std::cout << "ERROR::VIRTUAL_TEXTURE:: Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// a source that scales an image in memory (4 components per texel) to the virtual size with bilinear
+// filtering; the image must outlive the source
+inline VirtualTextureSource VirtualTextureSourceFromPixels(const unsigned char *pixels, int imageWidth, int imageHeight,
+                                                           int width, int height)
+{
+    return [=](int x, int y, int w, int h, unsigned char *rgba) {
+        for (int j = 0; j < h; ++j)
+        {
+            const float sy = std::max(0.0f, (y + j + 0.5f) * imageHeight / height - 0.5f);
+            const int y0 = std::min((int)sy, imageHeight - 1), y1 = std::min(y0 + 1, imageHeight - 1);
+            const float fy = sy - (int)sy;
+            for (int i = 0; i < w; ++i)
+            {
+                const float sx = std::max(0.0f, (x + i + 0.5f) * imageWidth / width - 0.5f);
+                const int x0 = std::min((int)sx, imageWidth - 1), x1 = std::min(x0 + 1, imageWidth - 1);
+                const float fx = sx - (int)sx;
+                for (int c = 0; c < 4; ++c)
+                {
+                    const float top = pixels[((size_t)y0 * imageWidth + x0) * 4 + c] * (1.0f - fx) + pixels[((size_t)y0 * imageWidth + x1) * 4 + c] * fx;
+                    const float bottom = pixels[((size_t)y1 * imageWidth + x0) * 4 + c] * (1.0f - fx) + pixels[((size_t)y1 * imageWidth + x1) * 4 + c] * fx;
+                    rgba[((size_t)j * w + i) * 4 + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+                }
+            }
+        }
+    };
+}
+
+// ------------------------------------------------------------------------
+class VirtualTexture
+{
+public:
+    // cacheSize: side of the physical cache in pages; feedbackScale: the feedback pass renders at
+    // 1/feedbackScale of the viewport's resolution
+    explicit VirtualTexture(const std::string &path, int cacheSize = 16, int feedbackScale = 8)
+        : path(path), cacheSize(cacheSize), feedbackScale(feedbackScale)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file || !layout.read(file))
+        {
+            std::cout << "ERROR::VIRTUAL_TEXTURE:: Failed to open page file " << path << std::endl;
+            return;
+        }
+        if (cacheSize < 2 || cacheSize > 256)
+        {
+            std::cout << "ERROR::VIRTUAL_TEXTURE:: Cache size must be between 2 and 256 pages, not " << cacheSize << std::endl;
+            return;
+        }
+        const int padded = layout.paddedSize();
+        cache.storage2D(GL_TEXTURE_2D, 1, GL_RGBA8, cacheSize * padded, cacheSize * padded);
+        cache.parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        cache.parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        cache.parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        cache.parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        pageTable.storage2D(GL_TEXTURE_2D, layout.levels, GL_RGBA8, layout.pagesX(0), layout.pagesY(0));
+        pageTable.parameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        pageTable.parameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        tableLevels.resize(layout.levels);
+        for (int level = 0; level < layout.levels; ++level)
+            tableLevels[level].assign((size_t)layout.pagesX(level) * layout.pagesY(level) * 4, 0);
+
+        slots.resize((size_t)cacheSize * cacheSize);
+        // the coarsest page backs every page that isn't resident, so it's loaded now and never evicted
+        std::vector<unsigned char> root(layout.pageBytes());
+        file.seekg((std::streamoff)layout.pageOffset(layout.levels - 1, 0, 0));
+        file.read((char *)root.data(), (std::streamsize)root.size());
+        if (!file)
+        {
+            std::cout << "ERROR::VIRTUAL_TEXTURE:: Failed to read page file " << path << std::endl;
+            return;
+        }
+        makeResident(VirtualTextureLayout::pageKey(layout.levels - 1, 0, 0), root.data());
+        slots[0].pinned = true;
+        flushPageTable();
+
+        loader = std::thread([this]() { stream(); });
+        open = true;
+    }
+
+    ~VirtualTexture()
+    {
+        if (loader.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(streamMutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            loader.join();
+        }
+        for (Readback &readback : readbacks)
+            if (readback.fence)
+                glDeleteSync(readback.fence);
+    }
+
+    VirtualTexture(const VirtualTexture &) = delete;
+    VirtualTexture &operator=(const VirtualTexture &) = delete;
+
+    bool valid() const
+    {
+        return open;
+    }
+
+    // binds the cache to texture unit `unit` and the page table to `unit + 1`, and sets the uniforms
+    // virtual_texture.glsl reads; `feedback` for the shader variant drawn between begin/endFeedback()
+    template <typename ShaderType>
+    void bind(const ShaderType &shader, GLuint unit, bool feedback = false) const
+    {
+        cache.bindUnit(unit);
+        pageTable.bindUnit(unit + 1);
+        shader.setInt("vtCache", (int)unit);
+        shader.setInt("vtPageTable", (int)unit + 1);
+        shader.setVec4("vtSize", glm::vec4((float)layout.width, (float)layout.height, (float)layout.pageSize, (float)(layout.levels - 1)));
+        const float cacheTexels = (float)(cacheSize * layout.paddedSize());
+        shader.setVec4("vtCacheInfo", glm::vec4((float)layout.paddedSize() / cacheTexels, (float)layout.border / cacheTexels,
+                                                1.0f / cacheTexels, 0.0f));
+        // the feedback target has feedbackScale times fewer pixels on each side, so its derivatives
+        // are that much larger; the bias makes it request the pages the full resolution pass samples
+        shader.setFloat("vtLodBias", feedback ? -std::log2((float)feedbackScale) : 0.0f);
+    }
+
+    // binds the feedback target for a viewport of the given size and clears it to "no page"
+    void beginFeedback(int viewportWidth, int viewportHeight)
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+        const int w = std::max(1, viewportWidth / feedbackScale), h = std::max(1, viewportHeight / feedbackScale);
+        if (w != feedbackWidth || h != feedbackHeight)
+        {
+            feedbackWidth = w, feedbackHeight = h;
+            feedbackColor.storage2D(GL_TEXTURE_2D, 1, GL_R32UI, w, h);
+            feedbackColor.parameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            feedbackColor.parameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            feedbackDepth.storage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, w, h);
+            feedbackTarget.create();
+            feedbackTarget.texture(GL_COLOR_ATTACHMENT0, feedbackColor);
+            feedbackTarget.texture(GL_DEPTH_ATTACHMENT, feedbackDepth);
+            feedbackTarget.checkComplete();
+            for (Readback &readback : readbacks)
+            {
+                if (readback.fence)
+                    glDeleteSync(readback.fence);
+                readback.fence = 0;
+                readback.buffer.storage((GLsizeiptr)w * h * sizeof(uint32_t), nullptr);
+            }
+        }
+        feedbackTarget.bind();
+        glViewport(0, 0, w, h);
+        const GLuint none[4] = { 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu };
+        glClearBufferuiv(GL_COLOR, 0, none);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    // copies the feedback into a pixel buffer, read by update() once the GPU wrote it, and restores the
+    // framebuffer and viewport bound before beginFeedback()
+    void endFeedback()
+    {
+        Readback &readback = readbacks[nextReadback];
+        if (readback.fence)
+        {
+            // every buffer is still in flight: skip this frame's feedback rather than wait
+            feedbackSkipped().add();
+        }
+        else
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.id());
+            glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            readback.frame = frame;
+            nextReadback = (nextReadback + 1) % ReadbackCount;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    }
+
+    // once per frame, on the GL thread: requests the pages of the newest feedback that arrived, and
+    // uploads up to `uploadBudget` streamed pages into the cache
+    void update(int uploadBudget = 8)
+    {
+        static MetricGauge &resident = metrics().gauge("virtual_texture_resident_pages", "Pages in the virtual texture cache");
+        static MetricGauge &requested = metrics().gauge("virtual_texture_missing_pages", "Pages the last feedback asked for that aren't resident");
+        if (!open)
+            return;
+        frame++;
+        std::vector<uint32_t> feedback;
+        if (readFeedback(feedback))
+        {
+            std::vector<uint32_t> missing = collectRequests(feedback);
+            requested.set((double)missing.size());
+            std::lock_guard<std::mutex> lock(streamMutex);
+            // pages no longer visible aren't worth reading any more: the queue is replaced, not appended to
+            requests.clear();
+            for (uint32_t key : missing)
+                if (loadedKeys.count(key) == 0 && key != reading)
+                    requests.push_back(key);
+            if (!requests.empty())
+                wake.notify_one();
+        }
+        uploadPages(uploadBudget);
+        flushPageTable();
+        resident.set((double)residentPages.size());
+    }
+
+    const VirtualTextureLayout &pageLayout() const
+    {
+        return layout;
+    }
+    size_t residentCount() const
+    {
+        return residentPages.size();
+    }
+    size_t slotCount() const
+    {
+        return slots.size();
+    }
+
+private:
+    struct Slot
+    {
+        uint32_t key = 0xFFFFFFFFu; // NoPage: free
+        uint64_t lastUsed = 0; // frame of the last feedback that asked for the page
+        bool used = false, pinned = false;
+    };
+    struct Readback
+    {
+        GLBuffer buffer;
+        GLsync fence = 0;
+        uint64_t frame = 0;
+    };
+    struct LoadedPage
+    {
+        uint32_t key;
+        std::vector<unsigned char> pixels;
+    };
+    static const int ReadbackCount = 3;
+    static const size_t MaxLoadedPages = 64;
+    static const uint32_t NoPage = 0xFFFFFFFFu;
+
+    std::string path;
+    VirtualTextureLayout layout;
+    int cacheSize, feedbackScale;
+    bool open = false;
+    uint64_t frame = 0, feedbackFrame = 0;
+
+    GLTexture cache, pageTable;
+    std::vector<std::vector<unsigned char>> tableLevels; // CPU copy of the page table, RGBA8 per level
+    std::vector<uint32_t> dirtyPages;                     // pages whose residency changed since the last flush
+    std::vector<Slot> slots;
+    std::unordered_map<uint32_t, int> residentPages;      // page key -> slot
+
+    GLTexture feedbackColor, feedbackDepth;
+    GLFramebuffer feedbackTarget;
+    int feedbackWidth = 0, feedbackHeight = 0;
+    Readback readbacks[ReadbackCount];
+    int nextReadback = 0;
+    GLint previousFramebuffer = 0, previousViewport[4] = {};
+
+    // streaming; everything below is guarded by streamMutex
+    std::thread loader;
+    std::mutex streamMutex;
+    std::condition_variable wake;
+    std::deque<uint32_t> requests;       // coarse levels first
+    std::deque<LoadedPage> loaded;       // read, waiting for upload
+    std::unordered_set<uint32_t> loadedKeys;
+    uint32_t reading = NoPage;
+    bool stopping = false;
+
+    static MetricCounter &feedbackSkipped()
+    {
+        static MetricCounter &skipped = metrics().counter("virtual_texture_feedback_skipped_total", "Feedback frames dropped because every readback buffer was busy");
+        return skipped;
+    }
+
+    // takes the newest feedback the GPU has finished copying, if any
+    bool readFeedback(std::vector<uint32_t> &texels)
+    {
+        int newest = -1;
+        for (int i = 0; i < ReadbackCount; ++i)
+        {
+            const Readback &readback = readbacks[i];
+            if (readback.fence && (newest < 0 || readback.frame > readbacks[newest].frame) &&
+                glClientWaitSync(readback.fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+                newest = i;
+        }
+        if (newest < 0)
+            return false;
+        // the GPU executes in order, so the older copies are done too; they're superseded
+        const uint64_t newestFrame = readbacks[newest].frame;
+        for (Readback &readback : readbacks)
+        {
+            if (readback.fence && readback.frame <= newestFrame)
+            {
+                glDeleteSync(readback.fence);
+                readback.fence = 0;
+            }
+        }
+        Readback &readback = readbacks[newest];
+        texels.resize((size_t)feedbackWidth * feedbackHeight);
+        readback.buffer.getSubData(0, (GLsizeiptr)(texels.size() * sizeof(uint32_t)), texels.data());
+        return true;
+    }
+
+    // marks the resident pages the feedback asked for (and their ancestors, which are the fallback while
+    // a page streams in) as used, and returns the ones that aren't resident, coarsest first
+    std::vector<uint32_t> collectRequests(const std::vector<uint32_t> &texels)
+    {
+        for (Slot &slot : slots)
+            slot.used = false;
+        std::unordered_set<uint32_t> pages;
+        uint32_t previous = NoPage;
+        for (uint32_t texel : texels)
+        {
+            // neighbouring pixels mostly want the same page
+            if (texel == NoPage || texel == previous)
+                continue;
+            previous = texel;
+            int level = VirtualTextureLayout::keyLevel(texel);
+            if (level >= layout.levels)
+                continue;
+            int x = std::min(VirtualTextureLayout::keyX(texel), layout.pagesX(level) - 1);
+            int y = std::min(VirtualTextureLayout::keyY(texel), layout.pagesY(level) - 1);
+            for (; level < layout.levels; ++level, x >>= 1, y >>= 1)
+                if (!pages.insert(VirtualTextureLayout::pageKey(level, x, y)).second)
+                    break; // its ancestors are in already
+        }
+        std::vector<uint32_t> missing;
+        for (uint32_t key : pages)
+        {
+            auto it = residentPages.find(key);
+            if (it == residentPages.end())
+            {
+                missing.push_back(key);
+                continue;
+            }
+            slots[it->second].used = true;
+            slots[it->second].lastUsed = frame;
+        }
+        std::sort(missing.begin(), missing.end(), [](uint32_t a, uint32_t b) {
+            return VirtualTextureLayout::keyLevel(a) != VirtualTextureLayout::keyLevel(b) ? VirtualTextureLayout::keyLevel(a) > VirtualTextureLayout::keyLevel(b) : a < b;
+        });
+        return missing;
+    }
+
+    // the loader thread: reads requested pages from the page file
+    void stream()
+    {
+        static MetricHistogram &readTime = metrics().histogram("virtual_texture_page_read_seconds", "Time to read one virtual texture page from disk",
+                                                               { 0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05 });
+        std::ifstream file(path, std::ios::binary);
+        for (;;)
+        {
+            uint32_t key;
+            {
+                std::unique_lock<std::mutex> lock(streamMutex);
+                wake.wait(lock, [this]() { return stopping || (!requests.empty() && loaded.size() < MaxLoadedPages); });
+                if (stopping)
+                    return;
+                key = requests.front();
+                requests.pop_front();
+                reading = key;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            std::vector<unsigned char> pixels(layout.pageBytes());
+            file.seekg((std::streamoff)layout.pageOffset(VirtualTextureLayout::keyLevel(key), VirtualTextureLayout::keyX(key), VirtualTextureLayout::keyY(key)));
+            file.read((char *)pixels.data(), (std::streamsize)pixels.size());
+            const bool ok = (bool)file;
+            file.clear();
+            readTime.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+            std::lock_guard<std::mutex> lock(streamMutex);
+            reading = NoPage;
+            if (!ok)
+            {
+                std::cout << "ERROR::VIRTUAL_TEXTURE:: Failed to read a page from " << path << std::endl;
+                continue;
+            }
+            loaded.push_back({ key, std::move(pixels) });
+            loadedKeys.insert(key);
+        }
+    }
+
+    void uploadPages(int budget)
+    {
+        static MetricCounter &streamed = metrics().counter("virtual_texture_pages_uploaded_total", "Virtual texture pages uploaded into the cache");
+        static MetricCounter &evicted = metrics().counter("virtual_texture_pages_evicted_total", "Virtual texture pages evicted from the cache");
+        static MetricCounter &full = metrics().counter("virtual_texture_cache_full_total", "Uploads postponed because every cache slot held a page in use");
+        for (int uploaded = 0; uploaded < budget;)
+        {
+            LoadedPage page;
+            {
+                std::lock_guard<std::mutex> lock(streamMutex);
+                if (loaded.empty())
+                    break;
+                page = std::move(loaded.front());
+                loaded.pop_front();
+                loadedKeys.erase(page.key);
+            }
+            wake.notify_one();
+            if (residentPages.count(page.key))
+                continue;
+            // a free slot, or else the least recently used one the current feedback doesn't need
+            int victim = -1;
+            for (int i = 0; i < (int)slots.size(); ++i)
+            {
+                const Slot &slot = slots[i];
+                if (slot.key == NoPage)
+                {
+                    victim = i;
+                    break;
+                }
+                if (!slot.pinned && !slot.used && (victim < 0 || slot.lastUsed < slots[victim].lastUsed))
+                    victim = i;
+            }
+            if (victim < 0)
+            {
+                // the cache is too small for the view: the page waits, drawn from its ancestor meanwhile
+                full.add();
+                std::lock_guard<std::mutex> lock(streamMutex);
+                loadedKeys.insert(page.key);
+                loaded.push_front(std::move(page));
+                break;
+            }
+            if (slots[victim].key != NoPage)
+            {
+                residentPages.erase(slots[victim].key);
+                dirtyPages.push_back(slots[victim].key);
+                evicted.add();
+            }
+            makeResident(page.key, page.pixels.data(), victim);
+            slots[victim].lastUsed = frame;
+            streamed.add();
+            uploaded++;
+        }
+    }
+
+    void makeResident(uint32_t key, const unsigned char *pixels, int slot = 0)
+    {
+        const int padded = layout.paddedSize();
+        const int sx = slot % cacheSize, sy = slot / cacheSize;
+        cache.subImage2D(0, sx * padded, sy * padded, padded, padded, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        slots[slot].key = key;
+        residentPages[key] = slot;
+        dirtyPages.push_back(key);
+    }
+
+    // rewrites the page table below every page whose residency changed: each entry points at its own
+    // slot when resident, else inherits its parent's, so only the subtree of a changed page can differ
+    void flushPageTable()
+    {
+        if (dirtyPages.empty())
+            return;
+        // coarse first, so a subtree is rewritten after the parents it inherits from
+        std::sort(dirtyPages.begin(), dirtyPages.end(), [](uint32_t a, uint32_t b) {
+            return VirtualTextureLayout::keyLevel(a) != VirtualTextureLayout::keyLevel(b) ? VirtualTextureLayout::keyLevel(a) > VirtualTextureLayout::keyLevel(b) : a < b;
+        });
+        dirtyPages.erase(std::unique(dirtyPages.begin(), dirtyPages.end()), dirtyPages.end());
+        std::vector<unsigned char> rect;
+        for (uint32_t key : dirtyPages)
+        {
+            const int top = VirtualTextureLayout::keyLevel(key);
+            for (int level = top; level >= 0; --level)
+            {
+                const int shift = top - level;
+                const int columns = layout.pagesX(level);
+                const int x0 = VirtualTextureLayout::keyX(key) << shift, y0 = VirtualTextureLayout::keyY(key) << shift;
+                const int x1 = std::min(x0 + (1 << shift), columns), y1 = std::min(y0 + (1 << shift), layout.pagesY(level));
+                if (x0 >= x1 || y0 >= y1)
+                    break;
+                std::vector<unsigned char> &table = tableLevels[level];
+                rect.resize((size_t)(x1 - x0) * (y1 - y0) * 4);
+                for (int y = y0; y < y1; ++y)
+                {
+                    for (int x = x0; x < x1; ++x)
+                    {
+                        unsigned char *entry = &table[((size_t)y * columns + x) * 4];
+                        auto it = residentPages.find(VirtualTextureLayout::pageKey(level, x, y));
+                        if (it != residentPages.end())
+                        {
+                            entry[0] = (unsigned char)(it->second % cacheSize);
+                            entry[1] = (unsigned char)(it->second / cacheSize);
+                            entry[2] = (unsigned char)level;
+                            entry[3] = 255;
+                        }
+                        else if (level + 1 < layout.levels)
+                        {
+                            const unsigned char *parent = &tableLevels[level + 1][((size_t)(y >> 1) * layout.pagesX(level + 1) + (x >> 1)) * 4];
+                            memcpy(entry, parent, 4);
+                        }
+                        memcpy(&rect[((size_t)(y - y0) * (x1 - x0) + (x - x0)) * 4], entry, 4);
+                    }
+                }
+                pageTable.subImage2D(level, x0, y0, x1 - x0, y1 - y0, GL_RGBA, GL_UNSIGNED_BYTE, rect.data());
+            }
+        }
+        dirtyPages.clear();
+    }
+};
+#endif
@@ -13,4 +13,28 @@ constexpr const char* APP_NAME = "Three Body Problem";
 // Camera settings
 constexpr float FOV = 90.0f;
 
+// Physics backend: false runs the CPU engine (Physics), true the compute
+// shader engine (GpuPhysics). Can be overridden with --gpu / --cpu.
+constexpr bool GPU_PHYSICS = false;
+
+// CPU contact resolution: worker threads per contact batch (0 = one per
+// hardware thread) and solver iterations per physics step.
+constexpr unsigned int PHYSICS_WORKERS = 0;
+constexpr unsigned int CONTACT_ITERATIONS = 1;
+
+// Out-of-core backend (--out-of-core <directory>): megabytes of body state kept
+// resident per block and steps kept in the trace file.
+constexpr unsigned int OUT_OF_CORE_BUDGET_MB = 64;
+constexpr unsigned int OUT_OF_CORE_TRACE_STEPS = 600;
+
+// Input latency: frames the CPU may queue ahead of the GPU before it waits.
+// 0 (the default) adds no wait of its own, though the renderer still never
+// queues more frames than it has camera slots for; 1 - 3 opt in to throttling,
+// which trades CPU/GPU overlap for less input lag. LATE_LATCH samples input
+// after the camera-independent work of a frame, right before its draws, rather
+// than at its start. Can be overridden with --frames-in-flight <n> and
+// --no-late-latch; --latency prints the measured input-to-GPU latency.
+constexpr unsigned int MAX_FRAMES_IN_FLIGHT = 0;
+constexpr bool LATE_LATCH = true;
+
 #endif
\ No newline at end of file
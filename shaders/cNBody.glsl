@@ -0,0 +1,136 @@
+#version 430 core
+
+// N-body step for the GPU physics backend, dispatched twice per timestep:
+// stage 0 evaluates all-pairs gravity and sphere contacts, tile by tile through shared memory,
+// stage 1 integrates every body in place (Euler, same order as Physics::updateState).
+
+#define TILE_SIZE 64
+layout (local_size_x = TILE_SIZE) in;
+
+struct GpuBody {
+    vec4 position; // xyz: position, w: mass
+    vec4 velocity; // xyz: velocity, w: radius (negative for light sources, which neither attract nor move)
+};
+
+struct GpuDelta {
+    vec4 acceleration; // xyz: gravitational acceleration
+    vec4 velocity;     // xyz: velocity change from contacts
+    vec4 correction;   // xyz: position correction from contacts
+};
+
+layout (std430, binding = 0) buffer Bodies { GpuBody bodies[]; };
+layout (std430, binding = 1) buffer Deltas { GpuDelta deltas[]; };
+layout (std430, binding = 2) buffer Impulses { vec4 impulses[]; };
+layout (std430, binding = 3) buffer Trace { vec4 trace[]; };
+
+uniform int stage;
+uniform int bodyCount;
+uniform float dt;
+uniform float gravConst;
+uniform float minDistSq;
+uniform float epsilon;
+uniform float surfaceY;
+uniform bool applyImpulses;
+uniform int traceOffset; // first trace slot written by this step, -1 = no trace
+
+shared vec4 tilePosition[TILE_SIZE];
+shared vec4 tileVelocity[TILE_SIZE];
+
+bool isZero(vec3 v) {
+    return all(lessThanEqual(abs(v), vec3(epsilon)));
+}
+
+void interact() {
+    uint i = gl_GlobalInvocationID.x;
+    bool valid = i < uint(bodyCount);
+
+    vec4 position = valid ? bodies[i].position : vec4(0.0);
+    vec4 velocity = valid ? bodies[i].velocity : vec4(0.0, 0.0, 0.0, -1.0);
+    bool dynamic = valid && velocity.w >= 0.0;
+
+    vec3 acceleration = vec3(0.0);
+    vec3 dv = vec3(0.0);
+    vec3 correction = vec3(0.0);
+
+    for (int tile = 0; tile < bodyCount; tile += TILE_SIZE) {
+        // every invocation loads one body of the tile, the whole group then reads it from shared memory
+        uint j = uint(tile) + gl_LocalInvocationID.x;
+        tilePosition[gl_LocalInvocationID.x] = j < uint(bodyCount) ? bodies[j].position : vec4(0.0);
+        tileVelocity[gl_LocalInvocationID.x] = j < uint(bodyCount) ? bodies[j].velocity : vec4(0.0, 0.0, 0.0, -1.0);
+        barrier();
+
+        if (dynamic) {
+            int count = min(TILE_SIZE, bodyCount - tile);
+            for (int k = 0; k < count; ++k) {
+                vec4 otherVelocity = tileVelocity[k];
+                if (uint(tile + k) == i || otherVelocity.w < 0.0)
+                    continue;
+                vec4 otherPosition = tilePosition[k];
+                vec3 d = otherPosition.xyz - position.xyz;
+                float distSq = dot(d, d);
+
+                // gravity, skipped for very close pairs exactly like Physics::calculateGravForce
+                if (distSq >= minDistSq + epsilon)
+                    acceleration += gravConst * otherPosition.w / distSq * normalize(d);
+
+                // elastic contact along the normal, each body applies its own half of the pair
+                float radiusSum = velocity.w + otherVelocity.w;
+                if (distSq <= radiusSum * radiusSum + epsilon && distSq > 0.0 && !(isZero(velocity.xyz) && isZero(otherVelocity.xyz))) {
+                    float dist = sqrt(distSq);
+                    vec3 normal = d / dist;
+                    float overlap = radiusSum - dist;
+                    if (overlap > 0.0)
+                        correction -= normal * (overlap * 0.5);
+                    float m1 = position.w;
+                    float m2 = otherPosition.w;
+                    dv += ((m1 - m2) * velocity.xyz + 2.0 * m2 * otherVelocity.xyz) / (m1 + m2) - velocity.xyz;
+                }
+            }
+        }
+        barrier();
+    }
+
+    if (valid) {
+        deltas[i].acceleration = vec4(acceleration, 0.0);
+        deltas[i].velocity = vec4(dv, 0.0);
+        deltas[i].correction = vec4(correction, 0.0);
+    }
+}
+
+void integrate() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(bodyCount))
+        return;
+
+    GpuBody body = bodies[i];
+    if (body.velocity.w >= 0.0) {
+        vec3 velocity = body.velocity.xyz + deltas[i].velocity.xyz;
+        if (applyImpulses)
+            velocity += impulses[i].xyz;
+        velocity += deltas[i].acceleration.xyz * dt;
+        vec3 position = body.position.xyz + velocity * dt + deltas[i].correction.xyz;
+
+        // ground plane bounce, see Physics::processSurfaceCollision
+        float radius = body.velocity.w;
+        if (position.y - radius <= surfaceY + epsilon) {
+            velocity.y *= -0.8;
+            position.y = surfaceY + radius;
+            if (abs(velocity.y) < 0.1)
+                velocity.y = 0.0;
+        }
+
+        bodies[i].position.xyz = position;
+        bodies[i].velocity.xyz = velocity;
+        body.position.xyz = position;
+    }
+
+    if (traceOffset >= 0)
+        trace[traceOffset + int(i)] = vec4(body.position.xyz, 1.0);
+}
+
+void main() {
+    if (stage == 0)
+        interact();
+    else
+        integrate();
+}
@@ -8,7 +8,11 @@ uniform bool inactive;
 uniform vec3 inColor;
 uniform vec3 lightPos;
 uniform vec3 lightColor;
-uniform vec3 viewPos;
+layout (std140, binding = 0) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+};
 
 uniform float ambientStrength = 0.12;
 uniform float diffuseStrength = 1.0;
@@ -28,7 +32,7 @@ void main() {
 
     vec3 N = normalize(vNormal);
     vec3 L = normalize(lightPos - vWorldPos);
-    vec3 V = normalize(viewPos - vWorldPos);
+    vec3 V = normalize(viewPos.xyz - vWorldPos);
 
     float diff = max(dot(N, L), 0.0);
 
@@ -1,16 +1,26 @@
 #version 430 core
 
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aBodyPos; // per-instance body position streamed from the GPU physics buffer
+
+// written by the renderer once per frame, as late as possible (see Renderer::setLateLatch)
+layout (std140, binding = 0) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+};
 
-uniform mat4 projection;
-uniform mat4 view;
 uniform mat4 model;
+uniform bool gpuBodies = false; // true: translate by aBodyPos instead of relying on the model matrix alone
 
 out vec3 vWorldPos;
 out vec3 vNormal;
 
 void main() {
     vec4 worldPos = model * vec4(aPos, 1.0);
+    if (gpuBodies) {
+        worldPos.xyz += aBodyPos.xyz;
+    }
     vWorldPos = worldPos.xyz;
 
     vNormal = normalize(mat3(model) * aPos);
@@ -11,6 +11,7 @@
 #include <learnopengl/model.h>
 
 #include <iostream>
+#include <string>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -83,13 +84,16 @@ int main()
     // load models
     // -----------
     Model ourModel(FileSystem::getPath("resources/objects/backpack/backpack.obj"));
-
+    // split the meshes into clusters of up to 124 triangles that can be culled on their own
+    ourModel.buildMeshlets();
+    MeshletCuller culler;
     
     // draw in wireframe
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
     // render loop
     // -----------
+    float lastTitle = 0.0f;
     while (!glfwWindowShouldClose(window))
     {
         // per-frame time logic
@@ -121,8 +125,20 @@ int main()
         model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
         model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));	// it's a bit too big for our scene, so scale it down
         ourShader.setMat4("model", model);
-        ourModel.Draw(ourShader);
-
+        // only the clusters inside the view frustum and facing the camera are drawn
+        culler.resetStats();
+        culler.setTransform(model, view, projection);
+        ourModel.DrawCulled(ourShader, culler);
+
+        if (currentFrame - lastTitle > 0.5f)
+        {
+            lastTitle = currentFrame;
+            const MeshletCuller::Stats &culled = culler.stats();
+            std::string title = "LearnOpenGL: Model Loading (" + std::to_string(culled.triangles) + " triangles, " +
+                                std::to_string(culled.frustumRejected) + " outside the frustum, " +
+                                std::to_string(culled.backfaceRejected) + " facing away)";
+            glfwSetWindowTitle(window, title.c_str());
+        }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
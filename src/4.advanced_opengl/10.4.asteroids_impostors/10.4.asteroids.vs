@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aInstanceMatrix;
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main()
+{
+    TexCoords = aTexCoords;
+    // the asteroids are scaled uniformly, so the instance matrix transforms normals as well
+    Normal = mat3(aInstanceMatrix) * aNormal;
+    gl_Position = projection * view * aInstanceMatrix * vec4(aPos, 1.0f);
+}
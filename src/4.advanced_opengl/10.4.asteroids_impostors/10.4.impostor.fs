@@ -0,0 +1,50 @@
+#version 330 core
+out vec4 FragColor;
+
+flat in vec4 FrameCells01;
+flat in vec4 FrameCells23;
+in vec4 FrameCoords01;
+in vec4 FrameCoords23;
+in vec4 FrameWeights;
+in vec3 ViewPos;
+flat in mat3 NormalMatrix;
+flat in float WorldRadius;
+
+uniform sampler2D impostorAlbedo;
+uniform sampler2D impostorNormalDepth;
+uniform float impostorFrames;
+uniform mat4 projection;
+uniform vec3 lightDir;
+
+// one frame's texel at `coords` within it; nothing outside the frame
+vec4 sampleFrame(sampler2D atlas, vec2 cell, vec2 coords)
+{
+    vec2 inside = step(vec2(0.0), coords) * step(coords, vec2(1.0));
+    return texture(atlas, (cell + clamp(coords, 0.0, 1.0)) / impostorFrames) * (inside.x * inside.y);
+}
+
+vec4 sampleFrames(sampler2D atlas)
+{
+    return sampleFrame(atlas, FrameCells01.xy, FrameCoords01.xy) * FrameWeights.x + sampleFrame(atlas, FrameCells01.zw, FrameCoords01.zw) * FrameWeights.y +
+           sampleFrame(atlas, FrameCells23.xy, FrameCoords23.xy) * FrameWeights.z + sampleFrame(atlas, FrameCells23.zw, FrameCoords23.zw) * FrameWeights.w;
+}
+
+void main()
+{
+    vec4 albedo = sampleFrames(impostorAlbedo);
+    if (albedo.a < 0.5)
+        discard;
+    vec4 normalDepth = sampleFrames(impostorNormalDepth);
+    // empty texels are all zero, so dividing by the coverage undoes the blend with them at silhouettes
+    albedo.rgb /= albedo.a;
+    normalDepth /= albedo.a;
+
+    vec3 normal = normalize(NormalMatrix * (normalDepth.xyz * 2.0 - 1.0));
+    float diffuse = max(dot(normal, -lightDir), 0.0);
+    FragColor = vec4(albedo.rgb * (0.15 + 0.85 * diffuse), 1.0);
+
+    // move the quad's depth to the surface baked into the frames, so impostors intersect like meshes
+    vec3 surface = ViewPos + normalize(-ViewPos) * (normalDepth.a * 2.0 - 1.0) * WorldRadius;
+    vec4 clip = projection * vec4(surface, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+}
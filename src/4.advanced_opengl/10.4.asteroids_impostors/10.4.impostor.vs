@@ -0,0 +1,110 @@
+#version 330 core
+layout (location = 3) in mat4 aInstanceMatrix;
+
+// the four frames nearest to the view direction: their cells in the atlas, where the fragment falls
+// inside each (0 to 1 within the frame) and their weights
+flat out vec4 FrameCells01;
+flat out vec4 FrameCells23;
+out vec4 FrameCoords01;
+out vec4 FrameCoords23;
+out vec4 FrameWeights;
+out vec3 ViewPos;
+flat out mat3 NormalMatrix;
+flat out float WorldRadius;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform vec3 cameraPos;
+
+uniform vec3 impostorCenter;
+uniform float impostorRadius;
+uniform float impostorFrames;
+uniform bool impostorHemisphere;
+
+// Impostor::frameDirection() and OctahedronToDirection()
+vec3 octahedronToDirection(vec2 uv)
+{
+    vec2 p = uv * 2.0 - 1.0;
+    if (impostorHemisphere)
+    {
+        p = vec2(p.x + p.y, p.x - p.y) * 0.5;
+        return normalize(vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y));
+    }
+    vec3 n = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+    if (n.y < 0.0)
+        n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+vec2 directionToOctahedron(vec3 d)
+{
+    if (impostorHemisphere)
+    {
+        d.y = max(d.y, 0.0);
+        d /= abs(d.x) + abs(d.y) + abs(d.z);
+        return vec2(d.x + d.z, d.x - d.z) * 0.5 + 0.5;
+    }
+    d /= abs(d.x) + abs(d.y) + abs(d.z);
+    if (d.y < 0.0)
+        d.xz = (1.0 - abs(d.zx)) * vec2(d.x >= 0.0 ? 1.0 : -1.0, d.z >= 0.0 ? 1.0 : -1.0);
+    return d.xz * 0.5 + 0.5;
+}
+
+// Impostor::frameBasis()
+void impostorFrameBasis(vec3 direction, out vec3 right, out vec3 up)
+{
+    vec3 reference = abs(direction.y) > 0.999 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0);
+    right = normalize(cross(reference, direction));
+    up = cross(direction, right);
+}
+
+// where the ray from the camera through p (object space) hits the image plane of frame `cell`; it is
+// left unclamped, the fragment shader treats the outside of the frame as empty
+vec2 frameCoords(vec2 cell, vec3 cameraObject, vec3 p)
+{
+    vec3 direction = octahedronToDirection(cell / (impostorFrames - 1.0));
+    vec3 right, up;
+    impostorFrameBasis(direction, right, up);
+    vec3 ray = p - cameraObject;
+    float along = dot(ray, direction);
+    float t = dot(impostorCenter - cameraObject, direction) / (abs(along) > 1e-6 ? along : 1e-6);
+    vec3 onPlane = cameraObject + ray * t - impostorCenter;
+    return vec2(dot(onPlane, right), dot(onPlane, up)) / impostorRadius * 0.5 + 0.5;
+}
+
+void main()
+{
+    vec3 centerWorld = vec3(aInstanceMatrix * vec4(impostorCenter, 1.0));
+    float scale = max(length(aInstanceMatrix[0].xyz), max(length(aInstanceMatrix[1].xyz), length(aInstanceMatrix[2].xyz)));
+    WorldRadius = impostorRadius * scale;
+
+    // a quad through the center facing the camera, just large enough to cover the bounding sphere's
+    // silhouette under perspective
+    vec3 toCamera = cameraPos - centerWorld;
+    float distance = length(toCamera);
+    vec3 normal = toCamera / distance;
+    vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 right = normalize(cross(cameraUp, normal));
+    vec3 up = cross(normal, right);
+    float extent = WorldRadius * distance / sqrt(max(distance * distance - WorldRadius * WorldRadius, 1e-6));
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    vec3 worldPos = centerWorld + (corner.x * right + corner.y * up) * extent;
+
+    // the four frames around the direction the instance is seen from, in its own space
+    mat4 toObject = inverse(aInstanceMatrix);
+    vec3 cameraObject = vec3(toObject * vec4(cameraPos, 1.0));
+    vec3 pointObject = vec3(toObject * vec4(worldPos, 1.0));
+    vec2 grid = directionToOctahedron(normalize(cameraObject - impostorCenter)) * (impostorFrames - 1.0);
+    vec2 base = min(floor(grid), vec2(impostorFrames - 2.0));
+    vec2 f = grid - base;
+    FrameCells01 = vec4(base, base + vec2(1.0, 0.0));
+    FrameCells23 = vec4(base + vec2(0.0, 1.0), base + vec2(1.0, 1.0));
+    FrameCoords01 = vec4(frameCoords(base, cameraObject, pointObject), frameCoords(base + vec2(1.0, 0.0), cameraObject, pointObject));
+    FrameCoords23 = vec4(frameCoords(base + vec2(0.0, 1.0), cameraObject, pointObject), frameCoords(base + vec2(1.0, 1.0), cameraObject, pointObject));
+    FrameWeights = vec4((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+
+    NormalMatrix = mat3(aInstanceMatrix) / scale;
+    vec4 viewPos = view * vec4(worldPos, 1.0);
+    ViewPos = viewPos.xyz;
+    gl_Position = projection * viewPos;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) out vec4 Albedo;      // rgb, coverage
+layout (location = 1) out vec4 NormalDepth; // object space normal, distance in front of the frame's plane
+
+in vec2 TexCoords;
+in vec3 Normal;
+in float ViewDepth;
+
+uniform sampler2D texture_diffuse1;
+uniform float impostorRadius;
+
+void main()
+{
+    Albedo = vec4(texture(texture_diffuse1, TexCoords).rgb, 1.0);
+    // the frame's camera sits on the bounding sphere, so its center is impostorRadius away: the
+    // depth is -1 (back of the sphere) to 1 (front), in radii
+    float depth = (ViewDepth + impostorRadius) / impostorRadius;
+    NormalDepth = vec4(normalize(Normal) * 0.5 + 0.5, depth * 0.5 + 0.5);
+}
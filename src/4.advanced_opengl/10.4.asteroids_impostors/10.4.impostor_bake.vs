@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+out vec3 Normal;
+out float ViewDepth;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+
+void main()
+{
+    TexCoords = aTexCoords;
+    Normal = mat3(model) * aNormal;
+    vec4 viewPos = view * model * vec4(aPos, 1.0);
+    ViewDepth = viewPos.z;
+    gl_Position = projection * viewPos;
+}
@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 Normal;
+
+uniform sampler2D texture_diffuse1;
+uniform vec3 lightDir;
+
+void main()
+{
+    vec3 albedo = texture(texture_diffuse1, TexCoords).rgb;
+    float diffuse = max(dot(normalize(Normal), -lightDir), 0.0);
+    FragColor = vec4(albedo * (0.15 + 0.85 * diffuse), 1.0);
+}
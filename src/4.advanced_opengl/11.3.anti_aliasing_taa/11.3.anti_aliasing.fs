@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec2 Velocity;
+
+in vec4 currentPosition;
+in vec4 previousPosition;
+
+void main()
+{
+    FragColor = vec4(0.0, 1.0, 0.0, 1.0);
+    // screen space motion since the last frame, in texture coordinates
+    vec2 current = currentPosition.xy / currentPosition.w;
+    vec2 previous = previousPosition.xy / previousPosition.w;
+    Velocity = (current - previous) * 0.5;
+}
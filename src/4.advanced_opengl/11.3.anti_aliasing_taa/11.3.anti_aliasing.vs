@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+out vec4 currentPosition;
+out vec4 previousPosition;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection; // jittered while TAA is active
+
+// unjittered clip space of this and the previous frame, for the velocity buffer
+uniform mat4 viewProjection;
+uniform mat4 prevViewProjection;
+uniform mat4 prevModel;
+
+void main()
+{
+    vec4 worldPos = model * vec4(aPos, 1.0);
+    currentPosition = viewProjection * worldPos;
+    previousPosition = prevViewProjection * prevModel * vec4(aPos, 1.0);
+    gl_Position = projection * view * worldPos;
+}
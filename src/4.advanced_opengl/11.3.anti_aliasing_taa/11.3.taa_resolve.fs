@@ -0,0 +1,49 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D currentColor;
+uniform sampler2D velocityBuffer;
+uniform sampler2D depthBuffer;
+uniform sampler2D history;
+uniform bool historyValid;
+uniform float feedback; // weight of the current frame
+
+void main()
+{
+    vec2 texel = 1.0 / vec2(textureSize(currentColor, 0));
+    vec3 current = texture(currentColor, TexCoords).rgb;
+
+    // the 3x3 neighbourhood bounds the colors the history may take (rejects stale and disoccluded history),
+    // and its closest depth picks the velocity so edges of moving objects are reprojected with the object
+    vec3 minColor = current;
+    vec3 maxColor = current;
+    float closestDepth = 1.0;
+    vec2 closestOffset = vec2(0.0);
+    for (int y = -1; y <= 1; ++y)
+    {
+        for (int x = -1; x <= 1; ++x)
+        {
+            vec2 offset = vec2(x, y) * texel;
+            vec3 color = texture(currentColor, TexCoords + offset).rgb;
+            minColor = min(minColor, color);
+            maxColor = max(maxColor, color);
+            float depth = texture(depthBuffer, TexCoords + offset).r;
+            if (depth < closestDepth)
+            {
+                closestDepth = depth;
+                closestOffset = offset;
+            }
+        }
+    }
+
+    vec2 previousCoords = TexCoords - texture(velocityBuffer, TexCoords + closestOffset).rg;
+    if (!historyValid || any(lessThan(previousCoords, vec2(0.0))) || any(greaterThan(previousCoords, vec2(1.0))))
+    {
+        FragColor = vec4(current, 1.0);
+        return;
+    }
+    vec3 previous = clamp(texture(history, previousCoords).rgb, minColor, maxColor);
+    FragColor = vec4(mix(previous, current, feedback), 1.0);
+}
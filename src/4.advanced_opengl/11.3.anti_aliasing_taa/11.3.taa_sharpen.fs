@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D resolved;
+uniform float sharpness;
+
+void main()
+{
+    // unsharp mask against the 4 direct neighbours, restores some of the detail the history blend softens
+    vec2 texel = 1.0 / vec2(textureSize(resolved, 0));
+    vec3 center = texture(resolved, TexCoords).rgb;
+    vec3 neighbours = texture(resolved, TexCoords + vec2(texel.x, 0.0)).rgb
+                    + texture(resolved, TexCoords - vec2(texel.x, 0.0)).rgb
+                    + texture(resolved, TexCoords + vec2(0.0, texel.y)).rgb
+                    + texture(resolved, TexCoords - vec2(0.0, texel.y)).rgb;
+    vec3 color = center + sharpness * (4.0 * center - neighbours);
+    FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,522 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb_image.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+
+#include <iostream>
+#include <iomanip>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow *window);
+unsigned int createColorTexture(GLenum internalFormat, GLenum format, GLenum type, GLint filter);
+float halton(int index, int base);
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// camera
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+float lastX = (float)SCR_WIDTH / 2.0;
+float lastY = (float)SCR_HEIGHT / 2.0;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+// anti-aliasing mode, switched with the 1, 2 and 3 keys
+enum AAMode { AA_NONE, AA_MSAA, AA_TAA };
+const char* aaModeNames[] = { "no AA", "MSAA 4x", "TAA" };
+AAMode aaMode = AA_TAA;
+bool historyValid = false; // cleared whenever the accumulated history can't be reused
+
+int main()
+{
+    // glfw: initialize and configure
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // glfw window creation
+    // --------------------
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glad: load all OpenGL function pointers
+    // ---------------------------------------
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // configure global opengl state
+    // -----------------------------
+    glEnable(GL_DEPTH_TEST);
+
+    // build and compile shaders
+    // -------------------------
+    Shader shader("11.3.anti_aliasing.vs", "11.3.anti_aliasing.fs");
+    Shader resolveShader("11.3.aa_post.vs", "11.3.taa_resolve.fs");
+    Shader sharpenShader("11.3.aa_post.vs", "11.3.taa_sharpen.fs");
+    Shader screenShader("11.3.aa_post.vs", "11.3.aa_post.fs");
+
+    // set up vertex data (and buffer(s)) and configure vertex attributes
+    // ------------------------------------------------------------------
+    float cubeVertices[] = {
+        // positions       
+        -0.5f, -0.5f, -0.5f,
+         0.5f, -0.5f, -0.5f,
+         0.5f,  0.5f, -0.5f,
+         0.5f,  0.5f, -0.5f,
+        -0.5f,  0.5f, -0.5f,
+        -0.5f, -0.5f, -0.5f,
+
+        -0.5f, -0.5f,  0.5f,
+         0.5f, -0.5f,  0.5f,
+         0.5f,  0.5f,  0.5f,
+         0.5f,  0.5f,  0.5f,
+        -0.5f,  0.5f,  0.5f,
+        -0.5f, -0.5f,  0.5f,
+
+        -0.5f,  0.5f,  0.5f,
+        -0.5f,  0.5f, -0.5f,
+        -0.5f, -0.5f, -0.5f,
+        -0.5f, -0.5f, -0.5f,
+        -0.5f, -0.5f,  0.5f,
+        -0.5f,  0.5f,  0.5f,
+
+         0.5f,  0.5f,  0.5f,
+         0.5f,  0.5f, -0.5f,
+         0.5f, -0.5f, -0.5f,
+         0.5f, -0.5f, -0.5f,
+         0.5f, -0.5f,  0.5f,
+         0.5f,  0.5f,  0.5f,
+
+        -0.5f, -0.5f, -0.5f,
+         0.5f, -0.5f, -0.5f,
+         0.5f, -0.5f,  0.5f,
+         0.5f, -0.5f,  0.5f,
+        -0.5f, -0.5f,  0.5f,
+        -0.5f, -0.5f, -0.5f,
+
+        -0.5f,  0.5f, -0.5f,
+         0.5f,  0.5f, -0.5f,
+         0.5f,  0.5f,  0.5f,
+         0.5f,  0.5f,  0.5f,
+        -0.5f,  0.5f,  0.5f,
+        -0.5f,  0.5f, -0.5f
+    };
+    float quadVertices[] = {   // vertex attributes for a quad that fills the entire screen in Normalized Device Coordinates.
+        // positions   // texCoords
+        -1.0f,  1.0f,  0.0f, 1.0f,
+        -1.0f, -1.0f,  0.0f, 0.0f,
+         1.0f, -1.0f,  1.0f, 0.0f,
+
+        -1.0f,  1.0f,  0.0f, 1.0f,
+         1.0f, -1.0f,  1.0f, 0.0f,
+         1.0f,  1.0f,  1.0f, 1.0f
+    };
+    // setup cube VAO
+    unsigned int cubeVAO, cubeVBO;
+    glGenVertexArrays(1, &cubeVAO);
+    glGenBuffers(1, &cubeVBO);
+    glBindVertexArray(cubeVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), &cubeVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    // setup screen VAO
+    unsigned int quadVAO, quadVBO;
+    glGenVertexArrays(1, &quadVAO);
+    glGenBuffers(1, &quadVBO);
+    glBindVertexArray(quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+
+
+    // configure MSAA framebuffer
+    // --------------------------
+    unsigned int msaaFBO;
+    glGenFramebuffers(1, &msaaFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
+    // create a multisampled color attachment texture
+    unsigned int textureColorBufferMultiSampled;
+    glGenTextures(1, &textureColorBufferMultiSampled);
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled);
+    glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGB, SCR_WIDTH, SCR_HEIGHT, GL_TRUE);
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled, 0);
+    // the velocity output of the scene shader has nowhere to go here, which is fine
+    unsigned int msaaRBO;
+    glGenRenderbuffers(1, &msaaRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, msaaRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, msaaRBO);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "ERROR::FRAMEBUFFER:: MSAA framebuffer is not complete!" << endl;
+
+    // configure the single sampled scene framebuffer (used by TAA and without AA)
+    // ---------------------------------------------------------------------------
+    unsigned int sceneFBO;
+    glGenFramebuffers(1, &sceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+    unsigned int sceneColor = createColorTexture(GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColor, 0);
+    // screen space motion of every pixel since the previous frame
+    unsigned int sceneVelocity = createColorTexture(GL_RG16F, GL_RG, GL_FLOAT, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, sceneVelocity, 0);
+    unsigned int drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    // depth is a texture so the resolve can look for the closest neighbour
+    unsigned int sceneDepth;
+    glGenTextures(1, &sceneDepth);
+    glBindTexture(GL_TEXTURE_2D, sceneDepth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, sceneDepth, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "ERROR::FRAMEBUFFER:: Scene framebuffer is not complete!" << endl;
+
+    // configure the two history framebuffers, the resolve reads one and writes the other
+    // -----------------------------------------------------------------------------------
+    unsigned int historyFBO[2];
+    unsigned int historyTexture[2];
+    glGenFramebuffers(2, historyFBO);
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, historyFBO[i]);
+        // reprojected history is sampled in between pixels, so bilinear filtering
+        historyTexture[i] = createColorTexture(GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, GL_LINEAR);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, historyTexture[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            cout << "ERROR::FRAMEBUFFER:: History framebuffer is not complete!" << endl;
+    }
+
+    // configure second post-processing framebuffer
+    unsigned int intermediateFBO;
+    glGenFramebuffers(1, &intermediateFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, intermediateFBO);
+    // create a color attachment texture
+    unsigned int screenTexture = createColorTexture(GL_RGB, GL_RGB, GL_UNSIGNED_BYTE, GL_LINEAR);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, screenTexture, 0);	// we only need a color buffer
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "ERROR::FRAMEBUFFER:: Intermediate framebuffer is not complete!" << endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // memory of the offscreen targets each mode renders through (the resolve target is shared)
+    const double pixels = (double)SCR_WIDTH * SCR_HEIGHT / (1024.0 * 1024.0);
+    cout << fixed << setprecision(2);
+    cout << "offscreen memory, MSAA 4x: " << pixels * (4 * 4 + 4 * 4 + 4) << " MB (4 color + 4 depth/stencil samples, resolve)" << endl;
+    cout << "offscreen memory, TAA    : " << pixels * (4 + 4 + 4 + 2 * 4 + 4) << " MB (color, velocity, depth/stencil, 2 history, resolve)" << endl;
+    cout << "press 1 for no AA, 2 for MSAA 4x, 3 for TAA" << endl;
+
+    // shader configuration
+    // --------------------
+    resolveShader.use();
+    resolveShader.setInt("currentColor", 0);
+    resolveShader.setInt("velocityBuffer", 1);
+    resolveShader.setInt("depthBuffer", 2);
+    resolveShader.setInt("history", 3);
+    resolveShader.setFloat("feedback", 0.1f);
+    sharpenShader.use();
+    sharpenShader.setInt("resolved", 0);
+    sharpenShader.setFloat("sharpness", 0.25f);
+    screenShader.use();
+    screenShader.setInt("screenTexture", 0);
+
+    // GPU timer queries, double buffered so reading last frame's result doesn't stall
+    unsigned int timerQueries[2];
+    glGenQueries(2, timerQueries);
+    bool timerPending[2] = { false, false };
+    double gpuTime = 0.0;
+    unsigned int timedFrames = 0;
+    float lastReport = 0.0f;
+
+    glm::mat4 prevViewProjection(1.0f);
+    glm::mat4 prevModel(1.0f);
+    unsigned int frameIndex = 0;
+    unsigned int currentHistory = 0;
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // input
+        // -----
+        processInput(window);
+
+        unsigned int query = frameIndex % 2;
+        if (timerPending[query])
+        {
+            GLuint64 elapsed;
+            glGetQueryObjectui64v(timerQueries[query], GL_QUERY_RESULT, &elapsed);
+            gpuTime += elapsed / 1000000.0;
+            timedFrames++;
+        }
+        glBeginQuery(GL_TIME_ELAPSED, timerQueries[query]);
+
+        // render
+        // ------
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // the cube spins slowly so the velocity buffer also sees object motion, not just camera motion
+        glm::mat4 model = glm::rotate(glm::mat4(1.0f), currentFrame * 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 view = camera.GetViewMatrix();
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
+        glm::mat4 viewProjection = projection * view;
+        if (aaMode == AA_TAA)
+        {
+            // move the projection by a sub-pixel offset every frame (Halton 2,3 sequence, 8 samples);
+            // accumulated over time this samples each pixel at different positions like supersampling
+            float jitterX = halton(frameIndex % 8 + 1, 2) - 0.5f;
+            float jitterY = halton(frameIndex % 8 + 1, 3) - 0.5f;
+            projection[2][0] += jitterX * 2.0f / SCR_WIDTH;
+            projection[2][1] += jitterY * 2.0f / SCR_HEIGHT;
+        }
+
+        // 1. draw scene as normal in the multisampled or in the single sampled buffers
+        glBindFramebuffer(GL_FRAMEBUFFER, aaMode == AA_MSAA ? msaaFBO : sceneFBO);
+        float clearColor[] = { 0.1f, 0.1f, 0.1f, 1.0f };
+        float clearVelocity[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, clearColor);
+        if (aaMode != AA_MSAA)
+            glClearBufferfv(GL_COLOR, 1, clearVelocity);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_DEPTH_TEST);
+
+        // set transformation matrices
+        shader.use();
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", view);
+        shader.setMat4("model", model);
+        shader.setMat4("viewProjection", viewProjection);
+        shader.setMat4("prevViewProjection", frameIndex > 0 ? prevViewProjection : viewProjection);
+        shader.setMat4("prevModel", frameIndex > 0 ? prevModel : model);
+
+        glBindVertexArray(cubeVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+
+        if (aaMode == AA_TAA)
+        {
+            glDisable(GL_DEPTH_TEST);
+            glBindVertexArray(quadVAO);
+
+            // 2. blend the reprojected and clamped history with the new frame into the other history buffer
+            unsigned int previousHistory = currentHistory;
+            currentHistory = 1 - currentHistory;
+            glBindFramebuffer(GL_FRAMEBUFFER, historyFBO[currentHistory]);
+            resolveShader.use();
+            resolveShader.setBool("historyValid", historyValid);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, sceneColor);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, sceneVelocity);
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, sceneDepth);
+            glActiveTexture(GL_TEXTURE3);
+            glBindTexture(GL_TEXTURE_2D, historyTexture[previousHistory]);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            historyValid = true;
+
+            // 3. sharpen the resolved image into screenTexture; the history itself stays unsharpened
+            glBindFramebuffer(GL_FRAMEBUFFER, intermediateFBO);
+            sharpenShader.use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, historyTexture[currentHistory]);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        }
+        else
+        {
+            // 2. now blit multisampled (or plain) buffer(s) to normal colorbuffer of intermediate FBO. Image is stored in screenTexture
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, aaMode == AA_MSAA ? msaaFBO : sceneFBO);
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFBO);
+            glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+
+        // 4. now render quad with scene's visuals as its texture image
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDisable(GL_DEPTH_TEST);
+
+        // draw Screen quad
+        screenShader.use();
+        glBindVertexArray(quadVAO);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, screenTexture); // use the now resolved color attachment as the quad's texture
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        glEndQuery(GL_TIME_ELAPSED);
+        timerPending[query] = true;
+
+        prevViewProjection = viewProjection;
+        prevModel = model;
+        frameIndex++;
+
+        // report the average GPU frame time of the current mode once per second
+        if (currentFrame - lastReport >= 1.0f && timedFrames > 0)
+        {
+            cout << aaModeNames[aaMode] << ": " << gpuTime / timedFrames << " ms GPU per frame" << endl;
+            gpuTime = 0.0;
+            timedFrames = 0;
+            lastReport = currentFrame;
+        }
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    glDeleteQueries(2, timerQueries);
+    glfwTerminate();
+    return 0;
+}
+
+// creates a screen sized texture to render into
+// ---------------------------------------------
+unsigned int createColorTexture(GLenum internalFormat, GLenum format, GLenum type, GLint filter)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, SCR_WIDTH, SCR_HEIGHT, 0, format, type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+// element of the Halton low discrepancy sequence in [0, 1)
+// --------------------------------------------------------
+float halton(int index, int base)
+{
+    float result = 0.0f;
+    float fraction = 1.0f / base;
+    while (index > 0)
+    {
+        result += (index % base) * fraction;
+        index /= base;
+        fraction /= base;
+    }
+    return result;
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    AAMode requested = aaMode;
+    if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
+        requested = AA_NONE;
+    if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
+        requested = AA_MSAA;
+    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS)
+        requested = AA_TAA;
+    if (requested != aaMode)
+    {
+        aaMode = requested;
+        historyValid = false; // the history stopped accumulating while another mode was active
+        std::cout << "anti-aliasing: " << aaModeNames[aaMode] << std::endl;
+    }
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // make sure the viewport matches the new window dimensions; note that width and 
+    // height will be significantly larger than specified on retina displays.
+    glViewport(0, 0, width, height);
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
@@ -0,0 +1,48 @@
+#version 330 core
+#include "10.probe_grid.glsl"
+
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+} fs_in;
+
+uniform vec3 albedo;
+uniform vec3 emission;
+
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+
+uniform bool useProbes;  // indirect light from the probe grid, or a flat ambient term
+uniform bool probeOnly;  // shows the probe grid's irradiance alone (probe visualization)
+
+void main()
+{
+    vec3 normal = normalize(fs_in.Normal);
+    // a little off the surface, so a surface close to a probe doesn't pick up light from behind it
+    vec3 irradiance = probeGridIrradiance(fs_in.FragPos + normal * 0.1, normal);
+    vec3 color;
+    if (probeOnly)
+    {
+        color = irradiance;
+    }
+    else
+    {
+        // diffuse and specular of the point light, attenuated like the baked direct light
+        vec3 lightDir = normalize(lightPos - fs_in.FragPos);
+        float distance = length(lightPos - fs_in.FragPos);
+        float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
+        vec3 diffuse = max(dot(normal, lightDir), 0.0) * albedo;
+        vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        vec3 specular = vec3(0.2) * pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+        vec3 indirect = useProbes ? irradiance * albedo : vec3(0.1) * albedo;
+        color = (diffuse + specular) * lightColor * attenuation + indirect + emission;
+    }
+    // HDR tonemapping and gamma correction
+    color = color / (color + vec3(1.0));
+    color = pow(color, vec3(1.0 / 2.2));
+    FragColor = vec4(color, 1.0);
+}
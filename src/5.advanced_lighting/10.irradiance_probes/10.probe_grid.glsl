@@ -0,0 +1,29 @@
+// irradiance from a grid of L2 spherical harmonic probes (learnopengl/irradiance_probes.h): the 27
+// coefficients of a probe are spread over 7 slabs of the 3D texture, each slab interpolated between
+// the 8 probes around the sample point by the texture unit
+uniform sampler3D probeGrid;
+uniform vec3 probeGridMin;
+uniform vec3 probeGridMax;
+uniform vec3 probeGridCount;
+
+// irradiance / pi at worldPos for a surface facing n; multiplied by the albedo it's the diffuse light
+vec3 probeGridIrradiance(vec3 worldPos, vec3 n)
+{
+    // texel centers of the first slab; clamping keeps the filter from reaching into the next slab
+    vec3 cell = clamp((worldPos - probeGridMin) / (probeGridMax - probeGridMin), 0.0, 1.0) * (probeGridCount - 1.0) + 0.5;
+    vec3 size = vec3(probeGridCount.xy, probeGridCount.z * 7.0);
+    vec4 t[7];
+    for (int slab = 0; slab < 7; ++slab)
+        t[slab] = texture(probeGrid, vec3(cell.xy, cell.z + float(slab) * probeGridCount.z) / size);
+
+    vec3 irradiance = t[0].xyz * 0.282095
+                    + vec3(t[0].w, t[1].xy) * (0.488603 * n.y)
+                    + vec3(t[1].zw, t[2].x) * (0.488603 * n.z)
+                    + t[2].yzw * (0.488603 * n.x)
+                    + t[3].xyz * (1.092548 * n.x * n.y)
+                    + vec3(t[3].w, t[4].xy) * (1.092548 * n.y * n.z)
+                    + vec3(t[4].zw, t[5].x) * (0.315392 * (3.0 * n.z * n.z - 1.0))
+                    + t[5].yzw * (1.092548 * n.x * n.z)
+                    + t[6].xyz * (0.546274 * (n.x * n.x - n.y * n.y));
+    return max(irradiance, vec3(0.0));
+}
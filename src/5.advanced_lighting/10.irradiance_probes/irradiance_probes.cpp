@@ -0,0 +1,500 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader_library.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/irradiance_probes.h>
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// an axis aligned box of the static scene, the walls of the room included
+struct SceneBox
+{
+    glm::vec3 min, max;
+    glm::vec3 albedo;
+};
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow *window);
+std::vector<SceneBox> buildScene();
+glm::vec3 traceScene(const std::vector<SceneBox> &boxes, const glm::vec3 &origin, const glm::vec3 &direction, const IrradianceProbeGrid *previousBounce);
+void renderCube();
+void renderSphere();
+
+// settings
+const unsigned int SCR_WIDTH = 1280;
+const unsigned int SCR_HEIGHT = 720;
+bool useProbes = true;
+bool useProbesKeyPressed = false;
+bool showProbes = false;
+bool showProbesKeyPressed = false;
+
+// the static point light, the one light the probes are baked from
+const glm::vec3 lightPos(0.0f, 4.2f, 0.0f);
+const glm::vec3 lightColor(4.0f);
+
+// camera
+Camera camera(glm::vec3(0.0f, 2.0f, 4.5f));
+float lastX = (float)SCR_WIDTH / 2.0;
+float lastY = (float)SCR_HEIGHT / 2.0;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+int main()
+{
+    // glfw: initialize and configure
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // glfw window creation
+    // --------------------
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glad: load all OpenGL function pointers
+    // ---------------------------------------
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // configure global opengl state
+    // -----------------------------
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    // build and compile shaders
+    // -------------------------
+    ShaderLibrary shaders;
+    shaders.add("scene", "10.irradiance_probes.vs", "10.irradiance_probes.fs");
+    Shader &shader = shaders.get("scene");
+
+    // bake the probes: every probe gathers the direct light bounced off the static scene, then a
+    // second pass adds the light those surfaces receive from the first pass' probes
+    // ----------------------------------------------------------------------------------------------
+    const std::vector<SceneBox> boxes = buildScene();
+    const glm::vec3 gridMin(-4.75f, 0.25f, -4.75f), gridMax(4.75f, 4.75f, 4.75f);
+    const glm::ivec3 gridCounts(8, 4, 8);
+    auto insideGeometry = [&boxes](const glm::vec3 &p) {
+        for (const SceneBox &box : boxes)
+            if (glm::all(glm::greaterThan(p, box.min)) && glm::all(glm::lessThan(p, box.max)))
+                return true;
+        return false;
+    };
+    const auto bakeStart = std::chrono::steady_clock::now();
+    IrradianceProbeGrid firstBounce, probes;
+    firstBounce.bake(gridMin, gridMax, gridCounts, [&boxes](const glm::vec3 &origin, const glm::vec3 &direction) {
+        return traceScene(boxes, origin, direction, nullptr);
+    }, 512, insideGeometry);
+    probes.bake(gridMin, gridMax, gridCounts, [&boxes, &firstBounce](const glm::vec3 &origin, const glm::vec3 &direction) {
+        return traceScene(boxes, origin, direction, &firstBounce);
+    }, 512, insideGeometry);
+    probes.upload();
+    std::cout << "Baked " << probes.probes.size() << " probes in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count() << " ms" << std::endl;
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // input
+        // -----
+        processInput(window);
+
+        // render
+        // ------
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        shader.use();
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", camera.GetViewMatrix());
+        shader.setVec3("viewPos", camera.Position);
+        shader.setVec3("lightPos", lightPos);
+        shader.setVec3("lightColor", lightColor);
+        shader.setBool("useProbes", useProbes); // toggle with 'SPACE' to compare with a flat ambient term
+        shader.setBool("probeOnly", false);
+        shader.setVec3("emission", glm::vec3(0.0f));
+        probes.bind(shader, 0);
+
+        // the static scene: it is lit by the probes as well, though it's what lightmaps are for
+        for (const SceneBox &box : boxes)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), (box.min + box.max) * 0.5f);
+            model = glm::scale(model, (box.max - box.min) * 0.5f);
+            shader.setMat4("model", model);
+            shader.setVec3("albedo", box.albedo);
+            renderCube();
+        }
+
+        // dynamic objects, moving through the color bleeding off the walls
+        const float time = static_cast<float>(glfwGetTime());
+        shader.setVec3("albedo", glm::vec3(0.8f));
+        for (int i = 0; i < 3; ++i)
+        {
+            const float angle = time * (0.4f + 0.15f * i) + i * 2.0944f;
+            const float orbit = 2.0f + 1.0f * i;
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(std::cos(angle) * orbit, 0.6f + 1.1f * i, std::sin(angle) * orbit));
+            model = glm::scale(model, glm::vec3(0.5f));
+            shader.setMat4("model", model);
+            renderSphere();
+        }
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(std::sin(time * 0.3f) * 3.5f, 2.5f, -3.0f));
+        model = glm::rotate(model, time, glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f)));
+        model = glm::scale(model, glm::vec3(0.4f));
+        shader.setMat4("model", model);
+        renderCube();
+
+        // the light
+        model = glm::translate(glm::mat4(1.0f), lightPos);
+        model = glm::scale(model, glm::vec3(0.1f));
+        shader.setMat4("model", model);
+        shader.setVec3("albedo", glm::vec3(0.0f));
+        shader.setVec3("emission", lightColor);
+        renderCube();
+        shader.setVec3("emission", glm::vec3(0.0f));
+
+        // a small sphere per probe showing its irradiance (toggle with 'G')
+        if (showProbes)
+        {
+            shader.setBool("probeOnly", true);
+            for (int i = 0; i < (int)probes.probes.size(); ++i)
+            {
+                model = glm::translate(glm::mat4(1.0f), probes.probePosition(i));
+                model = glm::scale(model, glm::vec3(0.12f));
+                shader.setMat4("model", model);
+                renderSphere();
+            }
+        }
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    glfwTerminate();
+    return 0;
+}
+
+// the static scene: a 10 x 5 x 10 room with a red left and a green right wall, and two boxes
+// ------------------------------------------------------------------------------------------
+std::vector<SceneBox> buildScene()
+{
+    const glm::vec3 white(0.75f), red(0.75f, 0.1f, 0.1f), green(0.1f, 0.6f, 0.15f);
+    const float wall = 0.2f;
+    std::vector<SceneBox> boxes;
+    boxes.push_back({ glm::vec3(-5.0f, -wall, -5.0f), glm::vec3(5.0f, 0.0f, 5.0f), white });       // floor
+    boxes.push_back({ glm::vec3(-5.0f, 5.0f, -5.0f), glm::vec3(5.0f, 5.0f + wall, 5.0f), white });  // ceiling
+    boxes.push_back({ glm::vec3(-5.0f - wall, 0.0f, -5.0f), glm::vec3(-5.0f, 5.0f, 5.0f), red });   // left
+    boxes.push_back({ glm::vec3(5.0f, 0.0f, -5.0f), glm::vec3(5.0f + wall, 5.0f, 5.0f), green });   // right
+    boxes.push_back({ glm::vec3(-5.0f, 0.0f, -5.0f - wall), glm::vec3(5.0f, 5.0f, -5.0f), white }); // back
+    boxes.push_back({ glm::vec3(-5.0f, 0.0f, 5.0f), glm::vec3(5.0f, 5.0f, 5.0f + wall), white });   // front
+    boxes.push_back({ glm::vec3(-2.75f, 0.0f, -2.75f), glm::vec3(-1.25f, 3.0f, -1.25f), white });   // tall box
+    boxes.push_back({ glm::vec3(1.4f, 0.0f, 0.4f), glm::vec3(2.6f, 1.2f, 1.6f), white });          // short box
+    return boxes;
+}
+
+// the nearest box a ray hits (slab test), with the distance to it and the normal of the face hit;
+// returns -1 if there's none within maxDistance
+// ------------------------------------------------------------------------------------------------
+int intersectScene(const std::vector<SceneBox> &boxes, const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                   float &distance, glm::vec3 &normal)
+{
+    const glm::vec3 inverse = 1.0f / direction;
+    int nearest = -1;
+    distance = maxDistance;
+    for (int i = 0; i < (int)boxes.size(); ++i)
+    {
+        const glm::vec3 t0 = (boxes[i].min - origin) * inverse, t1 = (boxes[i].max - origin) * inverse;
+        const glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+        const float enter = std::max(std::max(tNear.x, tNear.y), tNear.z);
+        const float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+        if (enter > exit || enter <= 0.0f || enter >= distance)
+            continue;
+        distance = enter;
+        nearest = i;
+        const int axis = enter == tNear.x ? 0 : (enter == tNear.y ? 1 : 2);
+        normal = glm::vec3(0.0f);
+        normal[axis] = direction[axis] > 0.0f ? -1.0f : 1.0f;
+    }
+    return nearest;
+}
+
+// radiance arriving at origin from direction: the diffuse light the surface hit reflects of the point
+// light (shadowed) and, past the first bounce, of the probes of the bounce before
+// ---------------------------------------------------------------------------------------------------
+glm::vec3 traceScene(const std::vector<SceneBox> &boxes, const glm::vec3 &origin, const glm::vec3 &direction, const IrradianceProbeGrid *previousBounce)
+{
+    float distance;
+    glm::vec3 normal;
+    const int hit = intersectScene(boxes, origin, direction, std::numeric_limits<float>::max(), distance, normal);
+    if (hit < 0)
+        return glm::vec3(0.0f);
+    const glm::vec3 position = origin + direction * distance + normal * 1e-3f;
+    const glm::vec3 albedo = boxes[hit].albedo;
+
+    glm::vec3 radiance(0.0f);
+    glm::vec3 toLight = lightPos - position;
+    const float lightDistance = glm::length(toLight);
+    toLight /= lightDistance;
+    float shadowDistance;
+    glm::vec3 shadowNormal;
+    const float cosine = glm::dot(normal, toLight);
+    if (cosine > 0.0f && intersectScene(boxes, position, toLight, lightDistance, shadowDistance, shadowNormal) < 0)
+    {
+        // the same attenuation as 10.irradiance_probes.fs
+        const float attenuation = 1.0f / (1.0f + 0.09f * lightDistance + 0.032f * lightDistance * lightDistance);
+        radiance += albedo * lightColor * (cosine * attenuation);
+    }
+    if (previousBounce)
+        radiance += albedo * previousBounce->irradiance(position + normal * 0.1f, normal);
+    return radiance;
+}
+
+// renderCube() renders a 1x1 3D cube in NDC.
+// -------------------------------------------------
+unsigned int cubeVAO = 0;
+unsigned int cubeVBO = 0;
+void renderCube()
+{
+    // initialize (if necessary)
+    if (cubeVAO == 0)
+    {
+        float vertices[] = {
+            // back face
+            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+            -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+            // front face
+            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+             1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+            -1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+            // left face
+            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+            -1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+            -1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+            // right face
+             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+             1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+            // bottom face
+            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+            -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+            // top face
+            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+             1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
+             1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+            -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left
+        };
+        glGenVertexArrays(1, &cubeVAO);
+        glGenBuffers(1, &cubeVBO);
+        // fill buffer
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        // link vertex attributes
+        glBindVertexArray(cubeVAO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+    // render Cube
+    glBindVertexArray(cubeVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+}
+
+// renders (and builds at first invocation) a unit sphere; its normals are its positions
+// -------------------------------------------------------------------------------------
+unsigned int sphereVAO = 0;
+unsigned int sphereIndexCount = 0;
+void renderSphere()
+{
+    if (sphereVAO == 0)
+    {
+        const unsigned int X_SEGMENTS = 32;
+        const unsigned int Y_SEGMENTS = 32;
+        const float PI = 3.14159265359f;
+        std::vector<float> data;
+        for (unsigned int y = 0; y <= Y_SEGMENTS; ++y)
+        {
+            for (unsigned int x = 0; x <= X_SEGMENTS; ++x)
+            {
+                float xSegment = (float)x / (float)X_SEGMENTS;
+                float ySegment = (float)y / (float)Y_SEGMENTS;
+                float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
+                float yPos = std::cos(ySegment * PI);
+                float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
+                data.insert(data.end(), { xPos, yPos, zPos, xPos, yPos, zPos });
+            }
+        }
+        // counter-clockwise triangles seen from outside
+        std::vector<unsigned int> indices;
+        for (unsigned int y = 0; y < Y_SEGMENTS; ++y)
+        {
+            for (unsigned int x = 0; x < X_SEGMENTS; ++x)
+            {
+                unsigned int i0 = y * (X_SEGMENTS + 1) + x, i1 = i0 + 1;
+                unsigned int i2 = i0 + X_SEGMENTS + 1, i3 = i2 + 1;
+                indices.insert(indices.end(), { i0, i1, i2, i1, i3, i2 });
+            }
+        }
+        sphereIndexCount = static_cast<unsigned int>(indices.size());
+
+        unsigned int vbo, ebo;
+        glGenVertexArrays(1, &sphereVAO);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+        glBindVertexArray(sphereVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glBindVertexArray(0);
+    }
+    glBindVertexArray(sphereVAO);
+    glDrawElements(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !useProbesKeyPressed)
+    {
+        useProbes = !useProbes;
+        useProbesKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE)
+    {
+        useProbesKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !showProbesKeyPressed)
+    {
+        showProbes = !showProbes;
+        showProbesKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE)
+    {
+        showProbesKeyPressed = false;
+    }
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+    glViewport(0, 0, width, height);
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
@@ -0,0 +1,79 @@
+#version 330 core
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+} fs_in;
+
+#define NR_LIGHTS 16
+
+struct SpotLight {
+    vec3 Position;
+    vec3 Direction;
+    vec3 Color;
+    float InnerCutOff; // cosines of the cone's half angles
+    float OuterCutOff;
+    float Range;
+};
+uniform SpotLight lights[NR_LIGHTS];
+uniform mat4 lightSpaceMatrices[NR_LIGHTS];
+// where the light's shadow map lives in the atlas: offset and scale of its tile, in atlas texture
+// coordinates; a scale of 0 means the light got no tile this frame and casts no shadow
+uniform vec4 atlasRects[NR_LIGHTS];
+
+uniform sampler2D shadowAtlas;
+uniform vec3 albedo;
+uniform vec3 viewPos;
+
+float ShadowCalculation(int light)
+{
+    vec4 rect = atlasRects[light];
+    if (rect.z == 0.0)
+        return 0.0;
+    vec4 fragPosLightSpace = lightSpaceMatrices[light] * vec4(fs_in.FragPos, 1.0);
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w * 0.5 + 0.5;
+    if (projCoords.z > 1.0)
+        return 0.0;
+    // PCF, with every tap kept inside the light's tile so it never reads a neighbouring shadow map
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowAtlas, 0));
+    vec2 tileMin = rect.xy + 0.5 * texelSize;
+    vec2 tileMax = rect.xy + rect.zw - 0.5 * texelSize;
+    vec2 uv = rect.xy + projCoords.xy * rect.zw;
+    float shadow = 0.0;
+    for (int x = -1; x <= 1; ++x)
+    {
+        for (int y = -1; y <= 1; ++y)
+        {
+            float pcfDepth = texture(shadowAtlas, clamp(uv + vec2(x, y) * texelSize, tileMin, tileMax)).r;
+            shadow += projCoords.z > pcfDepth ? 1.0 : 0.0;
+        }
+    }
+    return shadow / 9.0;
+}
+
+void main()
+{
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    vec3 lighting = 0.05 * albedo;
+    for (int i = 0; i < NR_LIGHTS; ++i)
+    {
+        vec3 toLight = lights[i].Position - fs_in.FragPos;
+        float distance = length(toLight);
+        vec3 lightDir = toLight / distance;
+        // spotlight cone (soft edges) and a falloff reaching zero at the light's range
+        float theta = dot(lightDir, normalize(-lights[i].Direction));
+        float intensity = clamp((theta - lights[i].OuterCutOff) / (lights[i].InnerCutOff - lights[i].OuterCutOff), 0.0, 1.0);
+        float falloff = clamp(1.0 - distance / lights[i].Range, 0.0, 1.0);
+        float attenuation = intensity * falloff * falloff;
+        if (attenuation <= 0.0)
+            continue;
+        float diff = max(dot(normal, lightDir), 0.0);
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        float spec = pow(max(dot(normal, halfwayDir), 0.0), 32.0) * 0.3;
+        float shadow = ShadowCalculation(i);
+        lighting += (1.0 - shadow) * attenuation * (diff * albedo + spec) * lights[i].Color;
+    }
+    FragColor = vec4(pow(lighting, vec3(1.0 / 2.2)), 1.0);
+}
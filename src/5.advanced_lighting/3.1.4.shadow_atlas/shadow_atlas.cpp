@@ -0,0 +1,404 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/shadow_atlas.h>
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow *window);
+void renderScene(const Shader &shader);
+void renderCube();
+
+// settings
+const unsigned int SCR_WIDTH = 1280;
+const unsigned int SCR_HEIGHT = 720;
+bool lightsMoving = true;
+bool lightsMovingKeyPressed = false;
+
+// camera
+Camera camera(glm::vec3(0.0f, 12.0f, 22.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -30.0f);
+float lastX = (float)SCR_WIDTH / 2.0;
+float lastY = (float)SCR_HEIGHT / 2.0;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+// a shadowed spotlight; version changes whenever it moves, so the atlas knows its tile is stale
+struct SpotLight
+{
+    glm::vec3 position;
+    glm::vec3 direction;
+    glm::vec3 color;
+    float outerAngle; // half angle of the cone, in degrees
+    float range;
+    unsigned int version;
+};
+const unsigned int NR_LIGHTS = 16; // matches 3.1.4.shadow_atlas.fs
+
+// the part of the screen a light's cone covers, estimated from the bounding sphere of the cone
+float screenCoverage(const SpotLight &light, float aspect)
+{
+    const glm::vec3 center = light.position + light.direction * (light.range * 0.5f);
+    const float radius = light.range * 0.5f;
+    const float distance = glm::length(center - camera.Position);
+    if (distance <= radius)
+        return 1.0f;
+    const float r = radius / (distance * std::tan(glm::radians(camera.Zoom) * 0.5f)); // in NDC
+    return std::min(1.0f, glm::pi<float>() * r * r / (4.0f * aspect));
+}
+
+glm::mat4 lightSpaceMatrix(const SpotLight &light)
+{
+    const glm::vec3 up = std::abs(light.direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightProjection = glm::perspective(glm::radians(2.0f * light.outerAngle + 2.0f), 1.0f, 0.1f, light.range);
+    glm::mat4 lightView = glm::lookAt(light.position, light.position + light.direction, up);
+    return lightProjection * lightView;
+}
+
+int main()
+{
+    // glfw: initialize and configure
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // glfw window creation
+    // --------------------
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glad: load all OpenGL function pointers
+    // ---------------------------------------
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // configure global opengl state
+    // -----------------------------
+    glEnable(GL_DEPTH_TEST);
+
+    // build and compile shaders
+    // -------------------------
+    Shader shader("3.1.4.shadow_atlas.vs", "3.1.4.shadow_atlas.fs");
+    Shader simpleDepthShader("3.1.4.shadow_atlas_depth.vs", "3.1.4.shadow_atlas_depth.fs");
+
+    // one depth texture shared by all lights
+    // --------------------------------------
+    ShadowAtlas atlas;
+    shader.use();
+    shader.setInt("shadowAtlas", 0);
+
+    // lights: a 4 x 4 grid of spotlights over the scene, every fourth one sweeping around
+    // -----------------------------------------------------------------------------------
+    std::vector<SpotLight> lights;
+    for (unsigned int i = 0; i < NR_LIGHTS; ++i)
+    {
+        SpotLight light;
+        light.position = glm::vec3(-12.0f + 8.0f * (i % 4), 6.0f, -12.0f + 8.0f * (i / 4));
+        light.direction = glm::normalize(glm::vec3(0.3f * std::sin(i * 1.7f), -1.0f, 0.3f * std::cos(i * 1.7f)));
+        light.color = glm::vec3(0.5f + 0.5f * std::sin(i * 2.1f), 0.5f + 0.5f * std::sin(i * 2.1f + 2.1f), 0.5f + 0.5f * std::sin(i * 2.1f + 4.2f)) * 1.5f;
+        light.outerAngle = 35.0f;
+        light.range = 14.0f;
+        light.version = 0;
+        lights.push_back(light);
+    }
+    unsigned int statsFrames = 0, statsRendered = 0, statsReused = 0;
+    float statsTime = 0.0f;
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // input
+        // -----
+        processInput(window);
+
+        // sweep the moving lights (toggle with 'SPACE' to see every tile reused)
+        if (lightsMoving)
+        {
+            for (unsigned int i = 0; i < NR_LIGHTS; i += 4)
+            {
+                const float angle = currentFrame * 0.8f + i;
+                lights[i].direction = glm::normalize(glm::vec3(0.5f * std::sin(angle), -1.0f, 0.5f * std::cos(angle)));
+                lights[i].version++;
+            }
+        }
+
+        // 0. hand out atlas tiles, sized by how much of the screen each light covers
+        // ----------------------------------------------------------------------------
+        const float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+        atlas.beginFrame();
+        for (unsigned int i = 0; i < NR_LIGHTS; ++i)
+            atlas.request(i, screenCoverage(lights[i], aspect), 1.0f, lights[i].version);
+        atlas.endFrame();
+
+        // 1. render the shadow maps of the lights whose tile is new or stale; the others keep theirs
+        // ---------------------------------------------------------------------------------------------
+        simpleDepthShader.use();
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.0f, 4.0f);
+        unsigned int rendered = 0;
+        for (unsigned int i = 0; i < NR_LIGHTS; ++i)
+        {
+            if (!atlas.needsRender(i))
+                continue;
+            atlas.bindTile(i);
+            simpleDepthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix(lights[i]));
+            renderScene(simpleDepthShader);
+            rendered++;
+        }
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // report how many shadow maps were re-rendered and how many tiles were reused as they were
+        statsFrames++;
+        statsRendered += rendered;
+        statsReused += atlas.reusedTiles();
+        statsTime += deltaTime;
+        if (statsTime >= 1.0f)
+        {
+            std::cout << "shadow atlas: " << statsRendered / statsFrames << " shadow maps rendered/frame, "
+                      << statsReused / statsFrames << " reused, " << (int)(atlas.occupancy() * 100.0f) << "% occupied" << std::endl;
+            statsFrames = statsRendered = statsReused = 0;
+            statsTime = 0.0f;
+        }
+
+        // 2. render the scene, every light sampling its own tile of the atlas
+        // ---------------------------------------------------------------------
+        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+        glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        shader.use();
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", camera.GetViewMatrix());
+        shader.setVec3("viewPos", camera.Position);
+        for (unsigned int i = 0; i < NR_LIGHTS; ++i)
+        {
+            shader.setVec3(UniformElement("lights", i, "Position"), lights[i].position);
+            shader.setVec3(UniformElement("lights", i, "Direction"), lights[i].direction);
+            shader.setVec3(UniformElement("lights", i, "Color"), lights[i].color);
+            shader.setFloat(UniformElement("lights", i, "InnerCutOff"), std::cos(glm::radians(lights[i].outerAngle - 5.0f)));
+            shader.setFloat(UniformElement("lights", i, "OuterCutOff"), std::cos(glm::radians(lights[i].outerAngle)));
+            shader.setFloat(UniformElement("lights", i, "Range"), lights[i].range);
+            shader.setMat4(UniformElement("lightSpaceMatrices", i), lightSpaceMatrix(lights[i]));
+            shader.setVec4(UniformElement("atlasRects", i), atlas.hasTile(i) ? atlas.uvRect(i) : glm::vec4(0.0f));
+        }
+        atlas.texture().bindUnit(0);
+        renderScene(shader);
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    glfwTerminate();
+    return 0;
+}
+
+// renders the 3D scene: a floor and a field of cubes
+// --------------------------------------------------
+void renderScene(const Shader &shader)
+{
+    // floor
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.5f, 0.0f));
+    model = glm::scale(model, glm::vec3(20.0f, 0.5f, 20.0f));
+    shader.setMat4("model", model);
+    shader.setVec3("albedo", glm::vec3(0.8f));
+    renderCube();
+    // cubes
+    shader.setVec3("albedo", glm::vec3(0.9f, 0.85f, 0.8f));
+    for (int x = -3; x <= 3; ++x)
+    {
+        for (int z = -3; z <= 3; ++z)
+        {
+            const float height = 0.5f + 0.4f * (float)((x * 7 + z * 13 + 21) % 5);
+            model = glm::translate(glm::mat4(1.0f), glm::vec3(x * 4.0f + 1.0f, height * 0.5f, z * 4.0f + 1.0f));
+            model = glm::rotate(model, glm::radians(15.0f * (x + z)), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(0.6f, height * 0.5f, 0.6f));
+            shader.setMat4("model", model);
+            renderCube();
+        }
+    }
+}
+
+// renderCube() renders a 1x1 3D cube in NDC.
+// -------------------------------------------------
+unsigned int cubeVAO = 0;
+unsigned int cubeVBO = 0;
+void renderCube()
+{
+    // initialize (if necessary)
+    if (cubeVAO == 0)
+    {
+        float vertices[] = {
+            // back face
+            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+            -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+            // front face
+            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+             1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+            -1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+            // left face
+            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+            -1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+            -1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+            // right face
+             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+             1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+            // bottom face
+            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+            -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+            // top face
+            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+             1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
+             1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+            -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left
+        };
+        glGenVertexArrays(1, &cubeVAO);
+        glGenBuffers(1, &cubeVBO);
+        // fill buffer
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        // link vertex attributes
+        glBindVertexArray(cubeVAO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+    // render Cube
+    glBindVertexArray(cubeVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !lightsMovingKeyPressed)
+    {
+        lightsMoving = !lightsMoving;
+        lightsMovingKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE)
+    {
+        lightsMovingKeyPressed = false;
+    }
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+    glViewport(0, 0, width, height);
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
@@ -10,6 +10,7 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/point_shadow.h>
 
 #include <iostream>
 
@@ -18,7 +19,8 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path);
-void renderScene(const Shader &shader);
+std::vector<ShadowCaster> buildScene();
+void renderScene(const Shader &shader, const std::vector<ShadowCaster> &casters, const PointShadowCuller *culler = nullptr);
 void renderCube();
 
 // settings
@@ -26,6 +28,8 @@ const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 bool shadows = true;
 bool shadowsKeyPressed = false;
+bool lightMoving = true;
+bool lightMovingKeyPressed = false;
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -122,6 +126,17 @@ int main()
     // lighting info
     // -------------
     glm::vec3 lightPos(0.0f, 0.0f, 0.0f);
+    float near_plane = 1.0f;
+    float far_plane = 25.0f;
+    simpleDepthShader.use();
+    simpleDepthShader.setFloat("far_plane", far_plane);
+
+    // shadow casters of the scene and per-face culling/caching state of the depth cubemap
+    // ------------------------------------------------------------------------------------
+    std::vector<ShadowCaster> casters = buildScene();
+    PointShadowCuller shadowCuller(near_plane, far_plane, (float)SHADOW_WIDTH / (float)SHADOW_HEIGHT);
+    unsigned int statsFrames = 0, statsDraws = 0, statsSaved = 0;
+    float statsTime = 0.0f;
 
     // render loop
     // -----------
@@ -137,39 +152,63 @@ int main()
         // -----
         processInput(window);
 
-        // move light position over time
-        lightPos.z = static_cast<float>(sin(glfwGetTime() * 0.5) * 3.0);
+        // move light position over time (toggle with 'P' to see the cached faces at work)
+        if (lightMoving)
+            lightPos.z = static_cast<float>(sin(glfwGetTime() * 0.5) * 3.0);
 
         // render
         // ------
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // 0. create depth cubemap transformation matrices
-        // -----------------------------------------------
-        float near_plane = 1.0f;
-        float far_plane = 25.0f;
-        glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), (float)SHADOW_WIDTH / (float)SHADOW_HEIGHT, near_plane, far_plane);
-        std::vector<glm::mat4> shadowTransforms;
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-
-        // 1. render scene to depth cubemap
-        // --------------------------------
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        simpleDepthShader.use();
-        for (unsigned int i = 0; i < 6; ++i)
-            simpleDepthShader.setMat4("shadowMatrices[" + std::to_string(i) + "]", shadowTransforms[i]);
-        simpleDepthShader.setFloat("far_plane", far_plane);
-        simpleDepthShader.setVec3("lightPos", lightPos);
-        renderScene(simpleDepthShader);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // 0. cull casters per cube face and find the faces that changed since last frame
+        // --------------------------------------------------------------------------------
+        bool shadowPassNeeded = shadowCuller.update(lightPos, casters);
+
+        // 1. render dirty faces of the depth cubemap, faces that didn't change keep their cached depth
+        // --------------------------------------------------------------------------------------------
+        if (shadowPassNeeded)
+        {
+            glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            if (shadowCuller.dirtyFaces() == 0x3F)
+                glClear(GL_DEPTH_BUFFER_BIT);
+            else
+            {
+                // clearing a layered attachment clears all layers, so clear the dirty faces one by one
+                for (unsigned int i = 0; i < 6; ++i)
+                {
+                    if (!(shadowCuller.dirtyFaces() & (1u << i)))
+                        continue;
+                    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, depthCubemap, 0);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                }
+                glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthCubemap, 0);
+            }
+            simpleDepthShader.use();
+            if (shadowCuller.matricesChanged())
+            {
+                for (unsigned int i = 0; i < 6; ++i)
+                    simpleDepthShader.setMat4(UniformElement("shadowMatrices", i), shadowCuller.shadowTransforms()[i]);
+                simpleDepthShader.setVec3("lightPos", lightPos);
+            }
+            renderScene(simpleDepthShader, casters, &shadowCuller);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        // report how many caster-face draws the culling and caching saved compared to drawing
+        // every caster into all six faces
+        statsFrames++;
+        statsDraws += shadowCuller.casterFaceDraws;
+        statsSaved += shadowCuller.casterFaceSaved;
+        statsTime += deltaTime;
+        if (statsTime >= 1.0f)
+        {
+            std::cout << "point shadows: " << statsDraws / statsFrames << " caster-face draws/frame, "
+                      << statsSaved / statsFrames << " saved (" << 100 * statsSaved / std::max(1u, statsDraws + statsSaved) << "%)" << std::endl;
+            statsFrames = statsDraws = statsSaved = 0;
+            statsTime = 0.0f;
+        }
 
         // 2. render scene as normal 
         // -------------------------
@@ -189,7 +228,7 @@ int main()
         glBindTexture(GL_TEXTURE_2D, woodTexture);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
-        renderScene(shader);
+        renderScene(shader, casters);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -201,46 +240,67 @@ int main()
     return 0;
 }
 
-// renders the 3D scene
-// --------------------
-void renderScene(const Shader &shader)
+// builds the shadow casters of the 3D scene; the first one is the room cube
+// --------------------------------------------------------------------------
+std::vector<ShadowCaster> buildScene()
 {
+    const float cubeRadius = 1.7320508f; // bounding sphere of renderCube()'s [-1, 1] cube
+    std::vector<ShadowCaster> casters;
     // room cube
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::scale(model, glm::vec3(5.0f));
-    shader.setMat4("model", model);
-    glDisable(GL_CULL_FACE); // note that we disable culling here since we render 'inside' the cube instead of the usual 'outside' which throws off the normal culling methods.
-    shader.setInt("reverse_normals", 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
-    renderCube();
-    shader.setInt("reverse_normals", 0); // and of course disable it
-    glEnable(GL_CULL_FACE);
+    casters.push_back({ model, cubeRadius });
     // cubes
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(4.0f, -3.5f, 0.0));
     model = glm::scale(model, glm::vec3(0.5f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, cubeRadius });
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(2.0f, 3.0f, 1.0));
     model = glm::scale(model, glm::vec3(0.75f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, cubeRadius });
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(-3.0f, -1.0f, 0.0));
     model = glm::scale(model, glm::vec3(0.5f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, cubeRadius });
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(-1.5f, 1.0f, 1.5));
     model = glm::scale(model, glm::vec3(0.5f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, cubeRadius });
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(-1.5f, 2.0f, -3.0));
     model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
     model = glm::scale(model, glm::vec3(0.75f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, cubeRadius });
+    return casters;
+}
+
+// renders the 3D scene; when a culler is given (depth cubemap pass) every caster is only emitted
+// into the dirty cube faces it overlaps and skipped entirely if there are none
+// ---------------------------------------------------------------------------------------------
+void renderScene(const Shader &shader, const std::vector<ShadowCaster> &casters, const PointShadowCuller *culler)
+{
+    for (size_t i = 0; i < casters.size(); ++i)
+    {
+        if (culler)
+        {
+            unsigned int faceMask = culler->drawMask(i);
+            if (faceMask == 0)
+                continue;
+            shader.setInt("faceMask", faceMask);
+        }
+        shader.setMat4("model", casters[i].model);
+        if (i == 0)
+        {
+            glDisable(GL_CULL_FACE); // note that we disable culling here since we render 'inside' the cube instead of the usual 'outside' which throws off the normal culling methods.
+            shader.setInt("reverse_normals", 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
+            renderCube();
+            shader.setInt("reverse_normals", 0); // and of course disable it
+            glEnable(GL_CULL_FACE);
+        }
+        else
+            renderCube();
+    }
 }
 
 // renderCube() renders a 1x1 3D cube in NDC.
@@ -343,6 +403,16 @@ void processInput(GLFWwindow *window)
     {
         shadowsKeyPressed = false;
     }
+
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && !lightMovingKeyPressed)
+    {
+        lightMoving = !lightMoving;
+        lightMovingKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE)
+    {
+        lightMovingKeyPressed = false;
+    }
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
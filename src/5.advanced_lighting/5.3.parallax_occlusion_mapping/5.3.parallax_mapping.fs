@@ -15,11 +15,23 @@ uniform sampler2D depthMap;
 
 uniform float heightScale;
 
+// adaptive path: the layer count follows the on-screen footprint of the parallax offset, far away
+// surfaces fade to plain normal mapping and the hit is refined with a binary search
+uniform bool adaptive;
+uniform float lodDistance;  // beyond this distance no parallax is applied at all
+uniform float lodFadeRange; // the parallax offset fades out over this range in front of lodDistance
+uniform bool showLayers;    // visualize the number of layers marched per pixel
+
+const float minLayers = 8;
+const float maxLayers = 32;
+const float texelsPerLayer = 4.0; // linear search step, the binary search resolves the last few texels
+const int refinementSteps = 3;
+
+float layersMarched = 0.0;
+
 vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir)
 { 
     // number of depth layers
-    const float minLayers = 8;
-    const float maxLayers = 32;
     float numLayers = mix(maxLayers, minLayers, abs(dot(vec3(0.0, 0.0, 1.0), viewDir)));  
     // calculate the size of each layer
     float layerDepth = 1.0 / numLayers;
@@ -41,6 +53,7 @@ vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir)
         currentDepthMapValue = texture(depthMap, currentTexCoords).r;  
         // get depth of next layer
         currentLayerDepth += layerDepth;  
+        layersMarched += 1.0;
     }
     
     // get texture coordinates before collision (reverse operations)
@@ -57,13 +70,73 @@ vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir)
     return finalTexCoords;
 }
 
+vec2 AdaptiveParallaxMapping(vec2 texCoords, vec3 viewDir, float viewDistance)
+{
+    // the mip level the hardware would pick here; derivatives are taken before any branching so every
+    // lookup in the (non-uniform) loop below can use an explicit level
+    vec2 texSize = vec2(textureSize(depthMap, 0));
+    vec2 dx = dFdx(texCoords * texSize);
+    vec2 dy = dFdy(texCoords * texSize);
+    float lod = max(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0.0);
+
+    // fade the effect out with distance, past lodDistance this is plain normal mapping
+    float scale = heightScale * (1.0 - smoothstep(lodDistance - lodFadeRange, lodDistance, viewDistance));
+    if (scale <= 0.0)
+        return texCoords;
+
+    // the number of texels of that mip level the offset crosses is small for surfaces seen head on
+    // or from far away and grows towards near, grazing surfaces
+    vec2 P = viewDir.xy / max(viewDir.z, 0.05) * scale;
+    float texelsCrossed = length(P * texSize) / exp2(lod);
+    float numLayers = ceil(clamp(texelsCrossed / texelsPerLayer, minLayers, maxLayers));
+
+    float layerDepth = 1.0 / numLayers;
+    vec2 deltaTexCoords = P / numLayers;
+
+    // linear search for the first layer below the height field
+    float currentLayerDepth = 0.0;
+    vec2  currentTexCoords = texCoords;
+    float currentDepthMapValue = textureLod(depthMap, currentTexCoords, lod).r;
+    while (currentLayerDepth < currentDepthMapValue && currentLayerDepth < 1.0)
+    {
+        currentTexCoords -= deltaTexCoords;
+        currentDepthMapValue = textureLod(depthMap, currentTexCoords, lod).r;
+        currentLayerDepth += layerDepth;
+        layersMarched += 1.0;
+    }
+
+    // binary search between the last layer above and the first layer below the surface
+    vec2 deltaRefine = deltaTexCoords;
+    float depthRefine = layerDepth;
+    for (int i = 0; i < refinementSteps; ++i)
+    {
+        deltaRefine *= 0.5;
+        depthRefine *= 0.5;
+        if (currentLayerDepth < currentDepthMapValue)
+        {
+            currentTexCoords -= deltaRefine;
+            currentLayerDepth += depthRefine;
+        }
+        else
+        {
+            currentTexCoords += deltaRefine;
+            currentLayerDepth -= depthRefine;
+        }
+        currentDepthMapValue = textureLod(depthMap, currentTexCoords, lod).r;
+    }
+    return currentTexCoords;
+}
+
 void main()
 {           
     // offset texture coordinates with Parallax Mapping
     vec3 viewDir = normalize(fs_in.TangentViewPos - fs_in.TangentFragPos);
     vec2 texCoords = fs_in.TexCoords;
     
-    texCoords = ParallaxMapping(fs_in.TexCoords,  viewDir);       
+    if (adaptive)
+        texCoords = AdaptiveParallaxMapping(fs_in.TexCoords, viewDir, length(fs_in.TangentViewPos - fs_in.TangentFragPos));
+    else
+        texCoords = ParallaxMapping(fs_in.TexCoords,  viewDir);       
     if(texCoords.x > 1.0 || texCoords.y > 1.0 || texCoords.x < 0.0 || texCoords.y < 0.0)
         discard;
 
@@ -86,4 +159,6 @@ void main()
 
     vec3 specular = vec3(0.2) * spec;
     FragColor = vec4(ambient + diffuse + specular, 1.0);
+    if (showLayers)
+        FragColor.rgb = mix(vec3(0.0, 0.0, 1.0), vec3(1.0, 0.0, 0.0), layersMarched / maxLayers);
 }
\ No newline at end of file
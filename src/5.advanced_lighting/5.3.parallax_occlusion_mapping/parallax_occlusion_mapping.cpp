@@ -24,6 +24,10 @@ void renderQuad();
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 float heightScale = 0.1f;
+bool adaptiveParallax = true;
+bool adaptiveKeyPressed = false;
+bool showLayers = false;
+bool showLayersKeyPressed = false;
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -96,6 +100,18 @@ int main()
     shader.setInt("diffuseMap", 0);
     shader.setInt("normalMap", 1);
     shader.setInt("depthMap", 2);
+    shader.setFloat("lodDistance", 8.0f);
+    shader.setFloat("lodFadeRange", 3.0f);
+    std::cout << "press P to toggle adaptive parallax occlusion mapping, L to show the layers marched per pixel" << std::endl;
+
+    // GPU time of the parallax mapped quad, double buffered so reading the result doesn't stall
+    unsigned int timerQueries[2];
+    glGenQueries(2, timerQueries);
+    bool timerPending[2] = { false, false };
+    unsigned int frameIndex = 0;
+    double shadingTime = 0.0;
+    unsigned int timedFrames = 0;
+    float lastReport = 0.0f;
 
     // lighting info
     // -------------
@@ -133,14 +149,26 @@ int main()
         shader.setVec3("viewPos", camera.Position);
         shader.setVec3("lightPos", lightPos);
         shader.setFloat("heightScale", heightScale); // adjust with Q and E keys
-        std::cout << heightScale << std::endl;
+        shader.setBool("adaptive", adaptiveParallax); // toggle with P
+        shader.setBool("showLayers", showLayers); // toggle with L
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, diffuseMap);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, normalMap);
         glActiveTexture(GL_TEXTURE2);
         glBindTexture(GL_TEXTURE_2D, heightMap);
+        unsigned int query = frameIndex++ % 2;
+        if (timerPending[query])
+        {
+            GLuint64 elapsed;
+            glGetQueryObjectui64v(timerQueries[query], GL_QUERY_RESULT, &elapsed);
+            shadingTime += elapsed / 1000000.0;
+            timedFrames++;
+        }
+        glBeginQuery(GL_TIME_ELAPSED, timerQueries[query]);
         renderQuad();
+        glEndQuery(GL_TIME_ELAPSED);
+        timerPending[query] = true;
 
         // render light source (simply re-renders a smaller plane at the light's position for debugging/visualization)
         model = glm::mat4(1.0f);
@@ -149,12 +177,23 @@ int main()
         shader.setMat4("model", model);
         renderQuad();
 
+        // report the average shading cost of the parallax mapped quad once per second
+        if (currentFrame - lastReport >= 1.0f && timedFrames > 0)
+        {
+            std::cout << (adaptiveParallax ? "adaptive" : "fixed") << " parallax occlusion mapping: " << shadingTime / timedFrames
+                      << " ms GPU per frame (height scale " << heightScale << ", distance " << glm::length(camera.Position) << ")" << std::endl;
+            shadingTime = 0.0;
+            timedFrames = 0;
+            lastReport = currentFrame;
+        }
+
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    glDeleteQueries(2, timerQueries);
     glfwTerminate();
     return 0;
 }
@@ -285,6 +324,26 @@ void processInput(GLFWwindow *window)
         else
             heightScale = 1.0f;
     }
+
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && !adaptiveKeyPressed)
+    {
+        adaptiveParallax = !adaptiveParallax;
+        adaptiveKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE)
+    {
+        adaptiveKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS && !showLayersKeyPressed)
+    {
+        showLayers = !showLayers;
+        showLayersKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_RELEASE)
+    {
+        showLayersKeyPressed = false;
+    }
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -220,13 +220,13 @@ int main()
         // send light relevant uniforms
         for (unsigned int i = 0; i < lightPositions.size(); i++)
         {
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+            shaderLightingPass.setVec3(UniformElement("lights", i, "Position"), lightPositions[i]);
+            shaderLightingPass.setVec3(UniformElement("lights", i, "Color"), lightColors[i]);
             // update attenuation parameters and calculate radius
             const float linear = 0.7f;
             const float quadratic = 1.8f;
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
+            shaderLightingPass.setFloat(UniformElement("lights", i, "Linear"), linear);
+            shaderLightingPass.setFloat(UniformElement("lights", i, "Quadratic"), quadratic);
         }
         shaderLightingPass.setVec3("viewPos", camera.Position);
         // finally render quad
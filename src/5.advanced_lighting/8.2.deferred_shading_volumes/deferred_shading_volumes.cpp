@@ -220,18 +220,18 @@ int main()
         // send light relevant uniforms
         for (unsigned int i = 0; i < lightPositions.size(); i++)
         {
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+            shaderLightingPass.setVec3(UniformElement("lights", i, "Position"), lightPositions[i]);
+            shaderLightingPass.setVec3(UniformElement("lights", i, "Color"), lightColors[i]);
             // update attenuation parameters and calculate radius
             const float constant = 1.0f; // note that we don't send this to the shader, we assume it is always 1.0 (in our case)
             const float linear = 0.7f;
             const float quadratic = 1.8f;
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
+            shaderLightingPass.setFloat(UniformElement("lights", i, "Linear"), linear);
+            shaderLightingPass.setFloat(UniformElement("lights", i, "Quadratic"), quadratic);
             // then calculate radius of light volume/sphere
             const float maxBrightness = std::fmaxf(std::fmaxf(lightColors[i].r, lightColors[i].g), lightColors[i].b);
             float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Radius", radius);
+            shaderLightingPass.setFloat(UniformElement("lights", i, "Radius"), radius);
         }
         shaderLightingPass.setVec3("viewPos", camera.Position);
         // finally render quad
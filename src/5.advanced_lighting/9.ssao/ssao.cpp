@@ -270,7 +270,7 @@ int main()
             shaderSSAO.use();
             // Send kernel + rotation 
             for (unsigned int i = 0; i < 64; ++i)
-                shaderSSAO.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
+                shaderSSAO.setVec3(UniformElement("samples", i), ssaoKernel[i]);
             shaderSSAO.setMat4("projection", projection);
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, gPosition);
@@ -402,8 +402,8 @@ int main()
         {
             glm::vec3 newPos = lightPositions[i] + glm::vec3(sin(glfwGetTime() * 5.0) * 5.0, 0.0, 0.0);
             newPos = lightPositions[i];
-            pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", newPos);
-            pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
+            pbrShader.setVec3(UniformElement("lightPositions", i), newPos);
+            pbrShader.setVec3(UniformElement("lightColors", i), lightColors[i]);
 
             model = glm::mat4(1.0f);
             model = glm::translate(model, newPos);
@@ -4,12 +4,19 @@ in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
 
-// material parameters
+// material parameters: texture maps in the TEXTURED variant, constants otherwise
+#ifdef TEXTURED
 uniform sampler2D albedoMap;
 uniform sampler2D normalMap;
 uniform sampler2D metallicMap;
 uniform sampler2D roughnessMap;
 uniform sampler2D aoMap;
+#else
+uniform vec3 albedo;
+uniform float metallic;
+uniform float roughness;
+uniform float ao;
+#endif
 
 // IBL
 uniform samplerCube irradianceMap;
@@ -22,8 +29,9 @@ uniform vec3 lightColors[4];
 
 uniform vec3 camPos;
 
-const float PI = 3.14159265359;
+#include "2.2.2.ggx.glsl"
 // ----------------------------------------------------------------------------
+#ifdef TEXTURED
 // Easy trick to get tangent-normals to world-space to keep PBR code simplified.
 // Don't worry if you don't get what's going on; you generally want to do normal 
 // mapping the usual way for performance anyways; I do plan make a note of this 
@@ -44,20 +52,7 @@ vec3 getNormalFromMap()
 
     return normalize(TBN * tangentNormal);
 }
-// ----------------------------------------------------------------------------
-float DistributionGGX(vec3 N, vec3 H, float roughness)
-{
-    float a = roughness*roughness;
-    float a2 = a*a;
-    float NdotH = max(dot(N, H), 0.0);
-    float NdotH2 = NdotH*NdotH;
-
-    float nom   = a2;
-    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
-    denom = PI * denom * denom;
-
-    return nom / denom;
-}
+#endif
 // ----------------------------------------------------------------------------
 float GeometrySchlickGGX(float NdotV, float roughness)
 {
@@ -92,6 +87,7 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
 // ----------------------------------------------------------------------------
 void main()
 {		
+#ifdef TEXTURED
     // material properties
     vec3 albedo = pow(texture(albedoMap, TexCoords).rgb, vec3(2.2));
     float metallic = texture(metallicMap, TexCoords).r;
@@ -100,6 +96,9 @@ void main()
        
     // input lighting data
     vec3 N = getNormalFromMap();
+#else
+    vec3 N = Normal;
+#endif
     vec3 V = normalize(camPos - WorldPos);
     vec3 R = reflect(-V, N); 
 
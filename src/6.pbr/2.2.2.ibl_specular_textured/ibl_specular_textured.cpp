@@ -7,9 +7,10 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <learnopengl/filesystem.h>
-#include <learnopengl/shader.h>
+#include <learnopengl/shader_library.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/texture_loader.h>
 
 #include <iostream>
 
@@ -17,7 +18,6 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
-unsigned int loadTexture(const char *path);
 void renderSphere();
 void renderCube();
 void renderQuad();
@@ -85,62 +85,61 @@ int main()
 
     // build and compile shaders
     // -------------------------
-    Shader pbrShader("2.2.2.pbr.vs", "2.2.2.pbr.fs");
-    Shader equirectangularToCubemapShader("2.2.2.cubemap.vs", "2.2.2.equirectangular_to_cubemap.fs");
-    Shader irradianceShader("2.2.2.cubemap.vs", "2.2.2.irradiance_convolution.fs");
-    Shader prefilterShader("2.2.2.cubemap.vs", "2.2.2.prefilter.fs");
-    Shader brdfShader("2.2.2.brdf.vs", "2.2.2.brdf.fs");
-    Shader backgroundShader("2.2.2.background.vs", "2.2.2.background.fs");
-
-    pbrShader.use();
-    pbrShader.setInt("irradianceMap", 0);
-    pbrShader.setInt("prefilterMap", 1);
-    pbrShader.setInt("brdfLUT", 2);
-    pbrShader.setInt("albedoMap", 3);
-    pbrShader.setInt("normalMap", 4);
-    pbrShader.setInt("metallicMap", 5);
-    pbrShader.setInt("roughnessMap", 6);
-    pbrShader.setInt("aoMap", 7);
-
-    backgroundShader.use();
-    backgroundShader.setInt("environmentMap", 0);
+    // the textured spheres and the plain light spheres are two variants of one pbr program (TEXTURED
+    // defined or not); prefilter and brdf share their sampling code through #include. All variants
+    // are compiled in the background while the textures load.
+    ShaderLibrary shaders;
+    shaders.add("pbr", "2.2.2.pbr.vs", "2.2.2.pbr.fs");
+    shaders.add("equirectangularToCubemap", "2.2.2.cubemap.vs", "2.2.2.equirectangular_to_cubemap.fs");
+    shaders.add("irradiance", "2.2.2.cubemap.vs", "2.2.2.irradiance_convolution.fs");
+    shaders.add("prefilter", "2.2.2.cubemap.vs", "2.2.2.prefilter.fs");
+    shaders.add("brdf", "2.2.2.brdf.vs", "2.2.2.brdf.fs");
+    shaders.add("background", "2.2.2.background.vs", "2.2.2.background.fs");
+    shaders.prepare("pbr", { "TEXTURED" });
+    shaders.prepare("pbr");
+    shaders.prepare("equirectangularToCubemap");
+    shaders.prepare("irradiance");
+    shaders.prepare("prefilter");
+    shaders.prepare("brdf");
+    shaders.prepare("background");
 
     // load PBR material textures
     // --------------------------
+    TextureLoader textureLoader; // decodes all images of the batch in parallel
     // rusted iron
-    unsigned int ironAlbedoMap = loadTexture(FileSystem::getPath("resources/textures/pbr/rusted_iron/albedo.png").c_str());
-    unsigned int ironNormalMap = loadTexture(FileSystem::getPath("resources/textures/pbr/rusted_iron/normal.png").c_str());
-    unsigned int ironMetallicMap = loadTexture(FileSystem::getPath("resources/textures/pbr/rusted_iron/metallic.png").c_str());
-    unsigned int ironRoughnessMap = loadTexture(FileSystem::getPath("resources/textures/pbr/rusted_iron/roughness.png").c_str());
-    unsigned int ironAOMap = loadTexture(FileSystem::getPath("resources/textures/pbr/rusted_iron/ao.png").c_str());
+    GLTexture ironAlbedoMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/rusted_iron/albedo.png"));
+    GLTexture ironNormalMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/rusted_iron/normal.png"));
+    GLTexture ironMetallicMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/rusted_iron/metallic.png"));
+    GLTexture ironRoughnessMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/rusted_iron/roughness.png"));
+    GLTexture ironAOMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/rusted_iron/ao.png"));
 
     // gold
-    unsigned int goldAlbedoMap = loadTexture(FileSystem::getPath("resources/textures/pbr/gold/albedo.png").c_str());
-    unsigned int goldNormalMap = loadTexture(FileSystem::getPath("resources/textures/pbr/gold/normal.png").c_str());
-    unsigned int goldMetallicMap = loadTexture(FileSystem::getPath("resources/textures/pbr/gold/metallic.png").c_str());
-    unsigned int goldRoughnessMap = loadTexture(FileSystem::getPath("resources/textures/pbr/gold/roughness.png").c_str());
-    unsigned int goldAOMap = loadTexture(FileSystem::getPath("resources/textures/pbr/gold/ao.png").c_str());
+    GLTexture goldAlbedoMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/gold/albedo.png"));
+    GLTexture goldNormalMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/gold/normal.png"));
+    GLTexture goldMetallicMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/gold/metallic.png"));
+    GLTexture goldRoughnessMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/gold/roughness.png"));
+    GLTexture goldAOMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/gold/ao.png"));
 
     // grass
-    unsigned int grassAlbedoMap = loadTexture(FileSystem::getPath("resources/textures/pbr/grass/albedo.png").c_str());
-    unsigned int grassNormalMap = loadTexture(FileSystem::getPath("resources/textures/pbr/grass/normal.png").c_str());
-    unsigned int grassMetallicMap = loadTexture(FileSystem::getPath("resources/textures/pbr/grass/metallic.png").c_str());
-    unsigned int grassRoughnessMap = loadTexture(FileSystem::getPath("resources/textures/pbr/grass/roughness.png").c_str());
-    unsigned int grassAOMap = loadTexture(FileSystem::getPath("resources/textures/pbr/grass/ao.png").c_str());
+    GLTexture grassAlbedoMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/grass/albedo.png"));
+    GLTexture grassNormalMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/grass/normal.png"));
+    GLTexture grassMetallicMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/grass/metallic.png"));
+    GLTexture grassRoughnessMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/grass/roughness.png"));
+    GLTexture grassAOMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/grass/ao.png"));
 
     // plastic
-    unsigned int plasticAlbedoMap = loadTexture(FileSystem::getPath("resources/textures/pbr/plastic/albedo.png").c_str());
-    unsigned int plasticNormalMap = loadTexture(FileSystem::getPath("resources/textures/pbr/plastic/normal.png").c_str());
-    unsigned int plasticMetallicMap = loadTexture(FileSystem::getPath("resources/textures/pbr/plastic/metallic.png").c_str());
-    unsigned int plasticRoughnessMap = loadTexture(FileSystem::getPath("resources/textures/pbr/plastic/roughness.png").c_str());
-    unsigned int plasticAOMap = loadTexture(FileSystem::getPath("resources/textures/pbr/plastic/ao.png").c_str());
+    GLTexture plasticAlbedoMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/plastic/albedo.png"));
+    GLTexture plasticNormalMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/plastic/normal.png"));
+    GLTexture plasticMetallicMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/plastic/metallic.png"));
+    GLTexture plasticRoughnessMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/plastic/roughness.png"));
+    GLTexture plasticAOMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/plastic/ao.png"));
 
     // wall
-    unsigned int wallAlbedoMap = loadTexture(FileSystem::getPath("resources/textures/pbr/wall/albedo.png").c_str());
-    unsigned int wallNormalMap = loadTexture(FileSystem::getPath("resources/textures/pbr/wall/normal.png").c_str());
-    unsigned int wallMetallicMap = loadTexture(FileSystem::getPath("resources/textures/pbr/wall/metallic.png").c_str());
-    unsigned int wallRoughnessMap = loadTexture(FileSystem::getPath("resources/textures/pbr/wall/roughness.png").c_str());
-    unsigned int wallAOMap = loadTexture(FileSystem::getPath("resources/textures/pbr/wall/ao.png").c_str());
+    GLTexture wallAlbedoMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/wall/albedo.png"));
+    GLTexture wallNormalMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/wall/normal.png"));
+    GLTexture wallMetallicMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/wall/metallic.png"));
+    GLTexture wallRoughnessMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/wall/roughness.png"));
+    GLTexture wallAOMap = textureLoader.load(FileSystem::getPath("resources/textures/pbr/wall/ao.png"));
 
     // lights
     // ------
@@ -171,6 +170,38 @@ int main()
 
     // pbr: load the HDR environment map
     // ---------------------------------
+    textureLoader.finish(); // the material textures are decoded unflipped, so finish them before changing the flip setting
+
+    // the shaders were compiling meanwhile; get() waits for whatever is left
+    Shader &pbrShader = shaders.get("pbr", { "TEXTURED" });
+    Shader &lightShader = shaders.get("pbr");
+    Shader &equirectangularToCubemapShader = shaders.get("equirectangularToCubemap");
+    Shader &irradianceShader = shaders.get("irradiance");
+    Shader &prefilterShader = shaders.get("prefilter");
+    Shader &brdfShader = shaders.get("brdf");
+    Shader &backgroundShader = shaders.get("background");
+
+    pbrShader.use();
+    pbrShader.setInt("irradianceMap", 0);
+    pbrShader.setInt("prefilterMap", 1);
+    pbrShader.setInt("brdfLUT", 2);
+    pbrShader.setInt("albedoMap", 3);
+    pbrShader.setInt("normalMap", 4);
+    pbrShader.setInt("metallicMap", 5);
+    pbrShader.setInt("roughnessMap", 6);
+    pbrShader.setInt("aoMap", 7);
+
+    lightShader.use();
+    lightShader.setInt("irradianceMap", 0);
+    lightShader.setInt("prefilterMap", 1);
+    lightShader.setInt("brdfLUT", 2);
+    lightShader.setVec3("albedo", 1.0f, 1.0f, 1.0f);
+    lightShader.setFloat("metallic", 0.0f);
+    lightShader.setFloat("roughness", 0.2f);
+    lightShader.setFloat("ao", 1.0f);
+
+    backgroundShader.use();
+    backgroundShader.setInt("environmentMap", 0);
     stbi_set_flip_vertically_on_load(true);
     int width, height, nrComponents;
     float *data = stbi_loadf(FileSystem::getPath("resources/textures/hdr/newport_loft.hdr").c_str(), &width, &height, &nrComponents, 0);
@@ -364,8 +395,16 @@ int main()
     // initialize static shader uniforms before rendering
     // --------------------------------------------------
     glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    pbrShader.use();
-    pbrShader.setMat4("projection", projection);
+    for (Shader *shader : { &pbrShader, &lightShader })
+    {
+        shader->use();
+        shader->setMat4("projection", projection);
+        for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
+        {
+            shader->setVec3(UniformElement("lightPositions", i), lightPositions[i]);
+            shader->setVec3(UniformElement("lightColors", i), lightColors[i]);
+        }
+    }
     backgroundShader.use();
     backgroundShader.setMat4("projection", projection);
 
@@ -411,15 +450,15 @@ int main()
 
         // rusted iron
         glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, ironAlbedoMap);
+        glBindTexture(GL_TEXTURE_2D, ironAlbedoMap.id());
         glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, ironNormalMap);
+        glBindTexture(GL_TEXTURE_2D, ironNormalMap.id());
         glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, ironMetallicMap);
+        glBindTexture(GL_TEXTURE_2D, ironMetallicMap.id());
         glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, ironRoughnessMap);
+        glBindTexture(GL_TEXTURE_2D, ironRoughnessMap.id());
         glActiveTexture(GL_TEXTURE7);
-        glBindTexture(GL_TEXTURE_2D, ironAOMap);
+        glBindTexture(GL_TEXTURE_2D, ironAOMap.id());
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-5.0, 0.0, 2.0));
@@ -429,15 +468,15 @@ int main()
 
         // gold
         glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, goldAlbedoMap);
+        glBindTexture(GL_TEXTURE_2D, goldAlbedoMap.id());
         glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, goldNormalMap);
+        glBindTexture(GL_TEXTURE_2D, goldNormalMap.id());
         glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, goldMetallicMap);
+        glBindTexture(GL_TEXTURE_2D, goldMetallicMap.id());
         glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, goldRoughnessMap);
+        glBindTexture(GL_TEXTURE_2D, goldRoughnessMap.id());
         glActiveTexture(GL_TEXTURE7);
-        glBindTexture(GL_TEXTURE_2D, goldAOMap);
+        glBindTexture(GL_TEXTURE_2D, goldAOMap.id());
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-3.0, 0.0, 2.0));
@@ -447,15 +486,15 @@ int main()
 
         // grass
         glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, grassAlbedoMap);
+        glBindTexture(GL_TEXTURE_2D, grassAlbedoMap.id());
         glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, grassNormalMap);
+        glBindTexture(GL_TEXTURE_2D, grassNormalMap.id());
         glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, grassMetallicMap);
+        glBindTexture(GL_TEXTURE_2D, grassMetallicMap.id());
         glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, grassRoughnessMap);
+        glBindTexture(GL_TEXTURE_2D, grassRoughnessMap.id());
         glActiveTexture(GL_TEXTURE7);
-        glBindTexture(GL_TEXTURE_2D, grassAOMap);
+        glBindTexture(GL_TEXTURE_2D, grassAOMap.id());
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(-1.0, 0.0, 2.0));
@@ -465,15 +504,15 @@ int main()
 
         // plastic
         glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, plasticAlbedoMap);
+        glBindTexture(GL_TEXTURE_2D, plasticAlbedoMap.id());
         glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, plasticNormalMap);
+        glBindTexture(GL_TEXTURE_2D, plasticNormalMap.id());
         glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, plasticMetallicMap);
+        glBindTexture(GL_TEXTURE_2D, plasticMetallicMap.id());
         glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, plasticRoughnessMap);
+        glBindTexture(GL_TEXTURE_2D, plasticRoughnessMap.id());
         glActiveTexture(GL_TEXTURE7);
-        glBindTexture(GL_TEXTURE_2D, plasticAOMap);
+        glBindTexture(GL_TEXTURE_2D, plasticAOMap.id());
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(1.0, 0.0, 2.0));
@@ -483,15 +522,15 @@ int main()
 
         // wall
         glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, wallAlbedoMap);
+        glBindTexture(GL_TEXTURE_2D, wallAlbedoMap.id());
         glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, wallNormalMap);
+        glBindTexture(GL_TEXTURE_2D, wallNormalMap.id());
         glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, wallMetallicMap);
+        glBindTexture(GL_TEXTURE_2D, wallMetallicMap.id());
         glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, wallRoughnessMap);
+        glBindTexture(GL_TEXTURE_2D, wallRoughnessMap.id());
         glActiveTexture(GL_TEXTURE7);
-        glBindTexture(GL_TEXTURE_2D, wallAOMap);
+        glBindTexture(GL_TEXTURE_2D, wallAOMap.id());
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(3.0, 0.0, 2.0));
@@ -499,21 +538,17 @@ int main()
         pbrShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
         renderSphere();
 
-        // render light source (simply re-render sphere at light positions)
-        // this looks a bit off as we use the same shader, but it'll make their positions obvious and 
-        // keeps the codeprint small.
+        // render light source (simply re-render sphere at light positions) with the untextured variant
+        lightShader.use();
+        lightShader.setMat4("view", view);
+        lightShader.setVec3("camPos", camera.Position);
         for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
         {
-            glm::vec3 newPos = lightPositions[i] + glm::vec3(sin(glfwGetTime() * 5.0) * 5.0, 0.0, 0.0);
-            newPos = lightPositions[i];
-            pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", newPos);
-            pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
-
             model = glm::mat4(1.0f);
-            model = glm::translate(model, newPos);
+            model = glm::translate(model, lightPositions[i]);
             model = glm::scale(model, glm::vec3(0.5f));
-            pbrShader.setMat4("model", model);
-            pbrShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
+            lightShader.setMat4("model", model);
+            lightShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
             renderSphere();
         }
 
@@ -803,42 +838,3 @@ void renderQuad()
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     glBindVertexArray(0);
 }
-
-// utility function for loading a 2D texture from file
-// ---------------------------------------------------
-unsigned int loadTexture(char const * path)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
@@ -10,6 +10,7 @@
 #define SHADER_H
 
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -18,7 +19,9 @@
 
 // General purpose shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
-// functions for easy management.
+// functions for easy management. The files are read and compiled
+// by buildShaderProgram (learnopengl/shader_source.h), so they may
+// #include other files and be compiled with defines.
 class Shader
 {
 public:
@@ -28,8 +31,8 @@ public:
     Shader() { }
     // sets the current shader as active
     Shader  &Use();
-    // compiles the shader from given source code
-    void    Compile(const char *vertexSource, const char *fragmentSource, const char *geometrySource = nullptr); // note: geometry source code is optional 
+    // compiles the shader from the given files (ID 0 if that failed)
+    void    Compile(const char *vertexFile, const char *fragmentFile, const char *geometryFile = nullptr, const std::vector<std::string> &defines = {}); // note: geometry shader file is optional 
     // utility functions
     void    SetFloat    (const char *name, float value, bool useShader = false);
     void    SetInteger  (const char *name, int value, bool useShader = false);
@@ -40,9 +43,6 @@ public:
     void    SetVector4f (const char *name, float x, float y, float z, float w, bool useShader = false);
     void    SetVector4f (const char *name, const glm::vec4 &value, bool useShader = false);
     void    SetMatrix4  (const char *name, const glm::mat4 &matrix, bool useShader = false);
-private:
-    // checks if compilation or linking failed and if so, print the error logs
-    void    checkCompileErrors(unsigned int object, std::string type); 
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/scene_host.h>
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+// Several chapters' demos in one executable: they share one window and GL context, and every model
+// and shader goes through the host's asset cache. The backpack is loaded once for the model loading
+// and normal visualization scenes, and all assets stay resident when a scene is left, so switching
+// back and forth (number keys, or tab) doesn't load anything again. The shaders are the chapters' own.
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// 3.1 model loading: the backpack, drawn by meshlets culled against the view
+// --------------------------------------------------------------------------
+class ModelLoadingScene : public Scene
+{
+public:
+    void load(AssetCache &assets, Camera &camera) override
+    {
+        shader = assets.shader(FileSystem::getPath("src/3.model_loading/1.model_loading/1.model_loading.vs"),
+                               FileSystem::getPath("src/3.model_loading/1.model_loading/1.model_loading.fs"));
+        backpack = assets.model(FileSystem::getPath("resources/objects/backpack/backpack.obj"), true);
+        // split the meshes into clusters of up to 124 triangles that can be culled on their own
+        backpack->buildMeshlets();
+    }
+
+    void render(const SceneFrame &frame) override
+    {
+        glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        shader->use();
+        glm::mat4 projection = glm::perspective(glm::radians(frame.camera.Zoom), (float)frame.width / (float)frame.height, 0.1f, 100.0f);
+        glm::mat4 view = frame.camera.GetViewMatrix();
+        glm::mat4 model = glm::mat4(1.0f);
+        shader->setMat4("projection", projection);
+        shader->setMat4("view", view);
+        shader->setMat4("model", model);
+        culler.setTransform(model, view, projection);
+        backpack->DrawCulled(*shader, culler);
+    }
+
+private:
+    std::shared_ptr<Shader> shader;
+    std::shared_ptr<Model> backpack;
+    MeshletCuller culler;
+};
+
+// 4.9.2 geometry shader: the nanosuit's triangles pushed out along their normals over time
+// ----------------------------------------------------------------------------------------
+class ExplodingScene : public Scene
+{
+public:
+    void load(AssetCache &assets, Camera &camera) override
+    {
+        shader = assets.shader(FileSystem::getPath("src/4.advanced_opengl/9.2.geometry_shader_exploding/9.2.geometry_shader.vs"),
+                               FileSystem::getPath("src/4.advanced_opengl/9.2.geometry_shader_exploding/9.2.geometry_shader.fs"),
+                               FileSystem::getPath("src/4.advanced_opengl/9.2.geometry_shader_exploding/9.2.geometry_shader.gs"));
+        nanosuit = assets.model(FileSystem::getPath("resources/objects/nanosuit/nanosuit.obj"));
+    }
+
+    void render(const SceneFrame &frame) override
+    {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        shader->use();
+        shader->setMat4("projection", glm::perspective(glm::radians(45.0f), (float)frame.width / (float)frame.height, 1.0f, 100.0f));
+        shader->setMat4("view", frame.camera.GetViewMatrix());
+        shader->setMat4("model", glm::mat4(1.0f));
+        // add time component to geometry shader in the form of a uniform
+        shader->setFloat("time", frame.time);
+        nanosuit->Draw(*shader);
+    }
+
+private:
+    std::shared_ptr<Shader> shader;
+    std::shared_ptr<Model> nanosuit;
+};
+
+// 4.9.3 geometry shader: the backpack with its normals drawn as lines
+// -------------------------------------------------------------------
+class NormalsScene : public Scene
+{
+public:
+    void load(AssetCache &assets, Camera &camera) override
+    {
+        const std::string directory = "src/4.advanced_opengl/9.3.geometry_shader_normals/";
+        shader = assets.shader(FileSystem::getPath(directory + "9.3.default.vs"), FileSystem::getPath(directory + "9.3.default.fs"));
+        normalShader = assets.shader(FileSystem::getPath(directory + "9.3.normal_visualization.vs"),
+                                     FileSystem::getPath(directory + "9.3.normal_visualization.fs"),
+                                     FileSystem::getPath(directory + "9.3.normal_visualization.gs"));
+        backpack = assets.model(FileSystem::getPath("resources/objects/backpack/backpack.obj"), true);
+    }
+
+    void render(const SceneFrame &frame) override
+    {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)frame.width / (float)frame.height, 1.0f, 100.0f);
+        glm::mat4 view = frame.camera.GetViewMatrix();
+        glm::mat4 model = glm::mat4(1.0f);
+        shader->use();
+        shader->setMat4("projection", projection);
+        shader->setMat4("view", view);
+        shader->setMat4("model", model);
+
+        // draw model as usual
+        backpack->Draw(*shader);
+
+        // then draw model with normal visualizing geometry shader
+        normalShader->use();
+        normalShader->setMat4("projection", projection);
+        normalShader->setMat4("view", view);
+        normalShader->setMat4("model", model);
+
+        backpack->Draw(*normalShader);
+    }
+
+private:
+    std::shared_ptr<Shader> shader, normalShader;
+    std::shared_ptr<Model> backpack;
+};
+
+// 4.10.3 instancing: a planet in an asteroid belt of 100000 instanced rocks
+// -------------------------------------------------------------------------
+class AsteroidsScene : public Scene
+{
+public:
+    void load(AssetCache &assets, Camera &camera) override
+    {
+        const std::string directory = "src/4.advanced_opengl/10.3.asteroids_instanced/";
+        asteroidShader = assets.shader(FileSystem::getPath(directory + "10.3.asteroids.vs"), FileSystem::getPath(directory + "10.3.asteroids.fs"));
+        planetShader = assets.shader(FileSystem::getPath(directory + "10.3.planet.vs"), FileSystem::getPath(directory + "10.3.planet.fs"));
+        rock = assets.model(FileSystem::getPath("resources/objects/rock/rock.obj"));
+        planet = assets.model(FileSystem::getPath("resources/objects/planet/planet.obj"));
+        camera = Camera(glm::vec3(0.0f, 0.0f, 155.0f));
+
+        // generate a large list of semi-random model transformation matrices
+        unsigned int amount = 100000;
+        std::vector<glm::mat4> modelMatrices(amount);
+        srand(static_cast<unsigned int>(glfwGetTime())); // initialize random seed
+        float radius = 150.0;
+        float offset = 25.0f;
+        for (unsigned int i = 0; i < amount; i++)
+        {
+            glm::mat4 model = glm::mat4(1.0f);
+            // 1. translation: displace along circle with 'radius' in range [-offset, offset]
+            float angle = (float)i / (float)amount * 360.0f;
+            float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+            float x = sin(angle) * radius + displacement;
+            displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+            float y = displacement * 0.4f; // keep height of asteroid field smaller compared to width of x and z
+            displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+            float z = cos(angle) * radius + displacement;
+            model = glm::translate(model, glm::vec3(x, y, z));
+
+            // 2. scale: Scale between 0.05 and 0.25f
+            float scale = static_cast<float>((rand() % 20) / 100.0 + 0.05);
+            model = glm::scale(model, glm::vec3(scale));
+
+            // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
+            float rotAngle = static_cast<float>((rand() % 360));
+            model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
+
+            // 4. now add to list of matrices
+            modelMatrices[i] = model;
+        }
+        // the transformation matrices are an instance vertex attribute at locations 3 to 6
+        rock->setInstanceLayout(3);
+        rock->setInstances(modelMatrices);
+    }
+
+    void render(const SceneFrame &frame) override
+    {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)frame.width / (float)frame.height, 0.1f, 1000.0f);
+        glm::mat4 view = frame.camera.GetViewMatrix();
+
+        // draw planet
+        planetShader->use();
+        planetShader->setMat4("projection", projection);
+        planetShader->setMat4("view", view);
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
+        model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
+        planetShader->setMat4("model", model);
+        planet->Draw(*planetShader);
+
+        // draw meteorites
+        asteroidShader->use();
+        asteroidShader->setMat4("projection", projection);
+        asteroidShader->setMat4("view", view);
+        rock->DrawInstanced(*asteroidShader);
+    }
+
+private:
+    std::shared_ptr<Shader> asteroidShader, planetShader;
+    std::shared_ptr<Model> rock, planet;
+};
+
+int main()
+{
+    SceneHost host;
+    if (!host.create("LearnOpenGL", SCR_WIDTH, SCR_HEIGHT))
+        return -1;
+
+    host.add<ModelLoadingScene>("3.1 model loading");
+    host.add<ExplodingScene>("4.9.2 geometry shader: exploding");
+    host.add<NormalsScene>("4.9.3 geometry shader: normals");
+    host.add<AsteroidsScene>("4.10.3 asteroids instanced");
+    host.run();
+    return 0;
+}
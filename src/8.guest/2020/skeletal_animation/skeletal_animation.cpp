@@ -126,7 +126,7 @@ int main()
 
         auto transforms = animator.GetFinalBoneMatrices();
 		for (int i = 0; i < transforms.size(); ++i)
-			ourShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+			ourShader.setMat4(UniformElement("finalBonesMatrices", i), transforms[i]);
 
 
 		// render the loaded model
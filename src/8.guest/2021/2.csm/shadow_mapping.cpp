@@ -263,7 +263,7 @@ int main()
         shader.setInt("cascadeCount", shadowCascadeLevels.size());
         for (size_t i = 0; i < shadowCascadeLevels.size(); ++i)
         {
-            shader.setFloat("cascadePlaneDistances[" + std::to_string(i) + "]", shadowCascadeLevels[i]);
+            shader.setFloat(UniformElement("cascadePlaneDistances", i), shadowCascadeLevels[i]);
         }
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, woodTexture);
@@ -0,0 +1,58 @@
+// sampling a virtual texture (learnopengl/virtual_texture.h): the page table maps every page and level
+// to the cache slot holding it, or holding its nearest resident ancestor
+uniform sampler2D vtCache;
+uniform sampler2D vtPageTable;
+uniform vec4 vtSize;      // virtual width and height in texels, page size, coarsest level
+uniform vec4 vtCacheInfo; // padded page size, border and one texel, in cache texture coordinates
+uniform float vtLodBias;
+
+// level of detail at uv, from the screen space derivatives like the hardware's mip selection
+float vtLevel(vec2 uv)
+{
+    vec2 texels = uv * vtSize.xy;
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float footprint = max(dot(dx, dx), dot(dy, dy));
+    return clamp(0.5 * log2(footprint) + vtLodBias, 0.0, vtSize.w);
+}
+
+ivec2 vtPage(vec2 uv, int level)
+{
+    ivec2 page = ivec2(uv * vtSize.xy / vtSize.z) >> level;
+    return min(page, textureSize(vtPageTable, level) - 1);
+}
+
+vec2 vtClamp(vec2 uv)
+{
+    return clamp(uv, vec2(0.0), vec2(1.0) - 0.5 / vtSize.xy);
+}
+
+vec4 vtSampleLevel(vec2 uv, int level)
+{
+    vec4 entry = floor(texelFetch(vtPageTable, vtPage(uv, level), level) * 255.0 + 0.5);
+    // where uv falls inside the page actually resident, which may be coarser than the one asked for
+    vec2 inPage = fract(uv * vtSize.xy / (vtSize.z * exp2(entry.z)));
+    vec2 cacheCoord = entry.xy * vtCacheInfo.x + vtCacheInfo.y + inPage * vtSize.z * vtCacheInfo.z;
+    return textureLod(vtCache, cacheCoord, 0.0);
+}
+
+// trilinear sample of the virtual texture
+vec4 vtSample(vec2 uv)
+{
+    uv = vtClamp(uv);
+    float level = vtLevel(uv);
+    int fine = int(level);
+    vec4 color = vtSampleLevel(uv, fine);
+    if (fine < int(vtSize.w))
+        color = mix(color, vtSampleLevel(uv, fine + 1), fract(level));
+    return color;
+}
+
+// the page vtSample(uv) wants most, packed for the feedback target; its ancestors are implied
+uint vtFeedback(vec2 uv)
+{
+    uv = vtClamp(uv);
+    int level = int(vtLevel(uv));
+    ivec2 page = vtPage(uv, level);
+    return uint(page.x) | (uint(page.y) << 12) | (uint(level) << 24);
+}
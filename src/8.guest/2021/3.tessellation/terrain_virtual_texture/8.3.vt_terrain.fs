@@ -0,0 +1,21 @@
+#version 410 core
+#include "8.3.virtual_texture.glsl"
+
+in float Height;
+in vec2 TexCoord;
+
+#ifdef VT_FEEDBACK
+// the page this fragment needs, for VirtualTexture::update()
+out uint FragColor;
+#else
+out vec4 FragColor;
+#endif
+
+void main()
+{
+#ifdef VT_FEEDBACK
+    FragColor = vtFeedback(TexCoord);
+#else
+    FragColor = vec4(vtSample(TexCoord).rgb, 1.0);
+#endif
+}
@@ -0,0 +1,454 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <stb_image.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader_library.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/virtual_texture.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int modifiers);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow *window);
+VirtualTextureSource terrainSource(const unsigned char *heightmap, int mapWidth, int mapHeight, int width, int height);
+bool pageFileMatches(const std::string &path, int width, int height);
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+const unsigned int NUM_PATCH_PTS = 4;
+
+// camera - give pretty starting point
+Camera camera(glm::vec3(67.0f, 627.5f, 169.9f),
+              glm::vec3(0.0f, 1.0f, 0.0f),
+              -128.1f, -42.4f);
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+// usage: terrain_virtual_texture [width [image]]
+// the terrain's color is a virtual texture of width x width/2 texels (8192 by default, up to 524288),
+// generated from the heightmap with procedural detail or scaled from a 4 channel image, and tiled
+// into a page file in the working directory the first time it's needed
+int main(int argc, char *argv[])
+{
+    // glfw: initialize and configure
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // glfw window creation
+    // --------------------
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL: Terrain Virtual Texture", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glad: load all OpenGL function pointers
+    // ---------------------------------------
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    GLint maxTessLevel;
+    glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &maxTessLevel);
+    std::cout << "Max available tess level: " << maxTessLevel << std::endl;
+
+    // configure global opengl state
+    // -----------------------------
+    glEnable(GL_DEPTH_TEST);
+
+    // build and compile our shader programs: the terrain, and the variant writing virtual texture feedback
+    // -----------------------------------------------------------------------------------------------------
+    ShaderLibrary shaders;
+    shaders.add("terrain", { { GL_VERTEX_SHADER, "8.3.vt_terrain.vs" },
+                             { GL_TESS_CONTROL_SHADER, "8.3.vt_terrain.tcs" },
+                             { GL_TESS_EVALUATION_SHADER, "8.3.vt_terrain.tes" },
+                             { GL_FRAGMENT_SHADER, "8.3.vt_terrain.fs" } });
+    Shader &tessHeightMapShader = shaders.get("terrain");
+    Shader &feedbackShader = shaders.get("terrain", { "VT_FEEDBACK" });
+
+    // load and create a texture
+    // -------------------------
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture); // all upcoming GL_TEXTURE_2D operations now have effect on this texture object
+    // set the texture wrapping parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	// set texture wrapping to GL_REPEAT (default wrapping method)
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // set texture filtering parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // load image, create texture and generate mipmaps
+    int width, height, nrChannels;
+    // The FileSystem::getPath(...) is part of the GitHub repository so we can find files on any IDE/platform; replace it with your own image path.
+    unsigned char *data = stbi_load(FileSystem::getPath("src/8.guest/2021/3.tessellation/terrain_gpu_dist/heightmaps/iceland_heightmap.png").c_str(),
+                                    &width, &height, &nrChannels, 4);
+    if (!data)
+    {
+        std::cout << "Failed to load texture" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    std::cout << "Loaded heightmap of size " << height << " x " << width << std::endl;
+
+    // tile the color texture into a page file, unless the one from the last run fits
+    // ------------------------------------------------------------------------------
+    const int vtWidth = argc > 1 ? std::atoi(argv[1]) : 8192, vtHeight = vtWidth / 2;
+    const std::string pageFile = "terrain_" + std::to_string(vtWidth) + (argc > 2 ? "_image" : "") + ".vt";
+    if (!pageFileMatches(pageFile, vtWidth, vtHeight))
+    {
+        std::cout << "Building virtual texture " << pageFile << " of " << vtWidth << " x " << vtHeight << " texels" << std::endl;
+        const float start = glfwGetTime();
+        bool built = false;
+        if (argc > 2)
+        {
+            int imageWidth, imageHeight, imageChannels;
+            unsigned char *image = stbi_load(argv[2], &imageWidth, &imageHeight, &imageChannels, 4);
+            if (image)
+                built = BuildVirtualTexture(pageFile, vtWidth, vtHeight, VirtualTextureSourceFromPixels(image, imageWidth, imageHeight, vtWidth, vtHeight));
+            else
+                std::cout << "Failed to load " << argv[2] << std::endl;
+            stbi_image_free(image);
+        }
+        else
+        {
+            built = BuildVirtualTexture(pageFile, vtWidth, vtHeight, terrainSource(data, width, height, vtWidth, vtHeight));
+        }
+        if (!built)
+        {
+            stbi_image_free(data);
+            glfwTerminate();
+            return -1;
+        }
+        std::cout << "Built the page file in " << glfwGetTime() - start << " s" << std::endl;
+    }
+    stbi_image_free(data);
+
+    // 16 x 16 cache slots of 130 x 130 texels: 17 MB of video memory, whatever the size of the texture
+    VirtualTexture virtualTexture(pageFile, 16);
+    if (!virtualTexture.valid())
+    {
+        glfwTerminate();
+        return -1;
+    }
+
+    // set up vertex data (and buffer(s)) and configure vertex attributes
+    // ------------------------------------------------------------------
+    std::vector<float> vertices;
+
+    unsigned rez = 20;
+    for(unsigned i = 0; i <= rez-1; i++)
+    {
+        for(unsigned j = 0; j <= rez-1; j++)
+        {
+            vertices.push_back(-width/2.0f + width*i/(float)rez); // v.x
+            vertices.push_back(0.0f); // v.y
+            vertices.push_back(-height/2.0f + height*j/(float)rez); // v.z
+            vertices.push_back(i / (float)rez); // u
+            vertices.push_back(j / (float)rez); // v
+
+            vertices.push_back(-width/2.0f + width*(i+1)/(float)rez); // v.x
+            vertices.push_back(0.0f); // v.y
+            vertices.push_back(-height/2.0f + height*j/(float)rez); // v.z
+            vertices.push_back((i+1) / (float)rez); // u
+            vertices.push_back(j / (float)rez); // v
+
+            vertices.push_back(-width/2.0f + width*i/(float)rez); // v.x
+            vertices.push_back(0.0f); // v.y
+            vertices.push_back(-height/2.0f + height*(j+1)/(float)rez); // v.z
+            vertices.push_back(i / (float)rez); // u
+            vertices.push_back((j+1) / (float)rez); // v
+
+            vertices.push_back(-width/2.0f + width*(i+1)/(float)rez); // v.x
+            vertices.push_back(0.0f); // v.y
+            vertices.push_back(-height/2.0f + height*(j+1)/(float)rez); // v.z
+            vertices.push_back((i+1) / (float)rez); // u
+            vertices.push_back((j+1) / (float)rez); // v
+        }
+    }
+    std::cout << "Loaded " << rez*rez << " patches of 4 control points each" << std::endl;
+    std::cout << "Processing " << rez*rez*4 << " vertices in vertex shader" << std::endl;
+
+    // first, configure the cube's VAO (and terrainVBO)
+    unsigned int terrainVAO, terrainVBO;
+    glGenVertexArrays(1, &terrainVAO);
+    glBindVertexArray(terrainVAO);
+
+    glGenBuffers(1, &terrainVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, terrainVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
+
+    // position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    // texCoord attribute
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+
+    glPatchParameteri(GL_PATCH_VERTICES, NUM_PATCH_PTS);
+
+    // render loop
+    // -----------
+    float lastTitle = 0.0f;
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // input
+        // -----
+        processInput(window);
+
+        int fbWidth, fbHeight;
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+
+        // view/projection transformations
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100000.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+        // world transformation
+        glm::mat4 model = glm::mat4(1.0f);
+
+        // feedback: which pages the terrain needs, at an eighth of the resolution
+        // ------------------------------------------------------------------------
+        glBindVertexArray(terrainVAO);
+        virtualTexture.beginFeedback(fbWidth, fbHeight);
+        feedbackShader.use();
+        feedbackShader.setInt("heightMap", 0);
+        feedbackShader.setMat4("projection", projection);
+        feedbackShader.setMat4("view", view);
+        feedbackShader.setMat4("model", model);
+        virtualTexture.bind(feedbackShader, 1, true);
+        glDrawArrays(GL_PATCHES, 0, NUM_PATCH_PTS*rez*rez);
+        virtualTexture.endFeedback();
+
+        // request the pages an earlier frame's feedback asked for, upload the ones that arrived
+        virtualTexture.update();
+
+        // render
+        // ------
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // be sure to activate shader when setting uniforms/drawing objects
+        tessHeightMapShader.use();
+        tessHeightMapShader.setInt("heightMap", 0);
+        tessHeightMapShader.setMat4("projection", projection);
+        tessHeightMapShader.setMat4("view", view);
+        tessHeightMapShader.setMat4("model", model);
+        virtualTexture.bind(tessHeightMapShader, 1);
+
+        // render the terrain
+        glDrawArrays(GL_PATCHES, 0, NUM_PATCH_PTS*rez*rez);
+
+        if (currentFrame - lastTitle > 0.5f)
+        {
+            lastTitle = currentFrame;
+            std::string title = "LearnOpenGL: Terrain Virtual Texture (" + std::to_string(virtualTexture.residentCount()) + " / " +
+                                std::to_string(virtualTexture.slotCount()) + " pages resident)";
+            glfwSetWindowTitle(window, title.c_str());
+        }
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    // optional: de-allocate all resources once they've outlived their purpose:
+    // ------------------------------------------------------------------------
+    glDeleteVertexArrays(1, &terrainVAO);
+    glDeleteBuffers(1, &terrainVBO);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+// the terrain's colors at width x height texels: a ramp over the heightmap's elevation and slope, both
+// interpolated between its texels, with value noise adding detail the heightmap doesn't have
+// ---------------------------------------------------------------------------------------------------
+float hashNoise(int x, int y)
+{
+    unsigned int h = (unsigned int)x * 374761393u + (unsigned int)y * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return (float)((h ^ (h >> 16)) & 0xFFFF) / 65535.0f;
+}
+
+float valueNoise(float x, float y)
+{
+    const int x0 = (int)std::floor(x), y0 = (int)std::floor(y);
+    float fx = x - x0, fy = y - y0;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+    const float top = hashNoise(x0, y0) + (hashNoise(x0 + 1, y0) - hashNoise(x0, y0)) * fx;
+    const float bottom = hashNoise(x0, y0 + 1) + (hashNoise(x0 + 1, y0 + 1) - hashNoise(x0, y0 + 1)) * fx;
+    return top + (bottom - top) * fy;
+}
+
+VirtualTextureSource terrainSource(const unsigned char *heightmap, int mapWidth, int mapHeight, int width, int height)
+{
+    auto elevation = [=](float mx, float my) {
+        mx = std::min(std::max(mx, 0.0f), mapWidth - 1.001f);
+        my = std::min(std::max(my, 0.0f), mapHeight - 1.001f);
+        const int x0 = (int)mx, y0 = (int)my;
+        const float fx = mx - x0, fy = my - y0;
+        auto at = [=](int x, int y) { return heightmap[((size_t)y * mapWidth + x) * 4 + 1] / 255.0f; };
+        const float top = at(x0, y0) + (at(x0 + 1, y0) - at(x0, y0)) * fx;
+        const float bottom = at(x0, y0 + 1) + (at(x0 + 1, y0 + 1) - at(x0, y0 + 1)) * fx;
+        return top + (bottom - top) * fy;
+    };
+    return [=](int x, int y, int w, int h, unsigned char *rgba) {
+        const glm::vec3 water(0.10f, 0.22f, 0.35f), grass(0.28f, 0.38f, 0.16f), rock(0.42f, 0.37f, 0.32f), snow(0.92f, 0.93f, 0.95f);
+        for (int j = 0; j < h; ++j)
+        {
+            for (int i = 0; i < w; ++i)
+            {
+                const float tx = (float)(x + i), ty = (float)(y + j);
+                const float mx = (tx + 0.5f) * mapWidth / width - 0.5f, my = (ty + 0.5f) * mapHeight / height - 0.5f;
+                const float e = elevation(mx, my);
+                // elevation spans 64 units of height, a heightmap texel is one unit of the terrain's width
+                const float slope = 64.0f * std::sqrt(std::pow(elevation(mx + 1.0f, my) - elevation(mx - 1.0f, my), 2.0f) +
+                                                      std::pow(elevation(mx, my + 1.0f) - elevation(mx, my - 1.0f), 2.0f)) / 2.0f;
+                float detail = 0.0f, amplitude = 0.5f, period = 256.0f;
+                for (int octave = 0; octave < 6; ++octave, amplitude *= 0.5f, period *= 0.5f)
+                    detail += amplitude * valueNoise(tx / period, ty / period);
+                glm::vec3 color;
+                if (e < 0.01f)
+                    color = water * (0.9f + 0.2f * detail);
+                else
+                {
+                    const float e2 = e + 0.08f * (detail - 0.5f);
+                    color = glm::mix(grass, rock, glm::smoothstep(0.18f, 0.35f, e2));
+                    color = glm::mix(color, rock, glm::smoothstep(0.6f, 1.2f, slope + 0.5f * (detail - 0.5f)));
+                    color = glm::mix(color, snow, glm::smoothstep(0.55f, 0.7f, e2) * (1.0f - glm::smoothstep(1.0f, 1.6f, slope)));
+                    color *= 0.75f + 0.5f * detail;
+                }
+                unsigned char *texel = rgba + ((size_t)j * w + i) * 4;
+                texel[0] = (unsigned char)(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f);
+                texel[1] = (unsigned char)(glm::clamp(color.g, 0.0f, 1.0f) * 255.0f);
+                texel[2] = (unsigned char)(glm::clamp(color.b, 0.0f, 1.0f) * 255.0f);
+                texel[3] = 255;
+            }
+        }
+    };
+}
+
+// whether the page file from an earlier run has the size asked for
+// ----------------------------------------------------------------
+bool pageFileMatches(const std::string &path, int width, int height)
+{
+    std::ifstream file(path, std::ios::binary);
+    VirtualTextureLayout layout;
+    return file && layout.read(file) && layout.width == width && layout.height == height;
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+    glViewport(0, 0, width, height);
+}
+
+// glfw: whenever a key event occurs, this callback is called
+// ---------------------------------------------------------------------------------------------
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int modifiers)
+{
+    if(action == GLFW_PRESS)
+    {
+        switch(key)
+        {
+            default:
+                break;
+        }
+    }
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
\ No newline at end of file
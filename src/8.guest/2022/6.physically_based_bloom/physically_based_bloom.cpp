@@ -489,8 +489,8 @@ int main()
         // set lighting uniforms
         for (unsigned int i = 0; i < lightPositions.size(); i++)
         {
-            shader.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shader.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+            shader.setVec3(UniformElement("lights", i, "Position"), lightPositions[i]);
+            shader.setVec3(UniformElement("lights", i, "Color"), lightColors[i]);
         }
         shader.setVec3("viewPos", camera.Position);
         // create one large cube that acts as the floor
@@ -0,0 +1,514 @@
+#include "Physics/distributed.h"
+#include "Physics/physics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+namespace {
+    constexpr float MIN_DIST_SQ = 1.0f; // same cutoff as Physics::calculateGravForce
+    constexpr float SURFACE_Y = -2.0f;  // same ground as Physics::onSurface
+    constexpr unsigned int LEAF_SIZE = 16; // bodies per octree leaf
+    constexpr unsigned int MAX_DEPTH = 24;
+
+    enum Command : uint32_t { STEP = 1, SCATTER, STOP };
+
+    // wire formats, both ends are the same binary
+    struct Header {
+        uint32_t command;
+        uint32_t count; ///< impulses (STEP) or bodies (SCATTER) that follow
+        float dt;
+    };
+
+    struct Impulse {
+        uint32_t id;
+        glm::vec3 velocity;
+    };
+
+    struct DomainBody {
+        uint32_t id;
+        glm::vec3 position;
+        float mass;
+        glm::vec3 velocity;
+        float radius;
+    };
+
+    struct PointMass {
+        glm::vec3 position;
+        float mass;
+    };
+
+    struct Bounds {
+        glm::vec3 lo;
+        glm::vec3 hi;
+        uint32_t count;
+    };
+
+    struct Reply {
+        uint32_t count; ///< bodies that follow
+        uint32_t ghosts;
+        uint32_t cells;
+        uint64_t interactions;
+    };
+
+    template<typename T>
+    void append(std::vector<char> &message, const T *items, size_t count) {
+        size_t offset = message.size();
+        message.resize(offset + count * sizeof(T));
+        if (count > 0) std::memcpy(message.data() + offset, items, count * sizeof(T));
+    }
+
+    // returns the offset behind the items, or 0 if the message is too short
+    template<typename T>
+    size_t read(const std::vector<char> &message, size_t offset, T *items, size_t count) {
+        if (offset + count * sizeof(T) > message.size()) return 0;
+        if (count > 0) std::memcpy(items, message.data() + offset, count * sizeof(T));
+        return offset + count * sizeof(T);
+    }
+
+    // Owns one domain: receives commands from rank 0, exchanges tree tops and ghosts with the other workers
+    class DomainWorker {
+    public:
+        DomainWorker(Transport &transport, float openingAngle) : transport(transport), openingAngle(openingAngle) {
+            for (unsigned int r = 1; r < transport.size(); ++r)
+                if (r != transport.rank()) peers.push_back(r);
+        }
+
+        void run() {
+            std::vector<char> message;
+            while (transport.receive(0, message)) {
+                Header header{};
+                size_t offset = read(message, 0, &header, 1);
+                if (offset == 0 || header.command == STOP) break;
+                dt = header.dt;
+
+                if (header.command == SCATTER) {
+                    bodies.resize(header.count);
+                    read(message, offset, bodies.data(), bodies.size());
+                } else if (header.command == STEP) {
+                    std::vector<Impulse> impulses(header.count);
+                    read(message, offset, impulses.data(), impulses.size());
+                    applyImpulses(impulses);
+                    if (!step()) break;
+                }
+            }
+        }
+
+    private:
+        struct Cell {
+            glm::vec3 centre;
+            float half;     ///< half edge length of the cube
+            glm::vec3 com;  ///< centre of mass
+            float mass;
+            uint32_t first; ///< bodies order[first, first + count)
+            uint32_t count;
+            int32_t child[8];
+            bool leaf;
+        };
+
+        Transport &transport;
+        float openingAngle;
+        std::vector<unsigned int> peers; ///< the other workers
+        std::vector<DomainBody> bodies;
+        std::vector<Cell> cells;
+        std::vector<uint32_t> order;
+
+        void applyImpulses(const std::vector<Impulse> &impulses) {
+            if (impulses.empty()) return;
+            for (DomainBody &body: bodies)
+                for (const Impulse &impulse: impulses)
+                    if (impulse.id == body.id) body.velocity += impulse.velocity;
+        }
+
+        Bounds bounds() const {
+            Bounds box{glm::vec3(0.0f), glm::vec3(0.0f), static_cast<uint32_t>(bodies.size())};
+            if (bodies.empty()) return box;
+            box.lo = box.hi = bodies[0].position;
+            for (const DomainBody &body: bodies) {
+                box.lo = glm::min(box.lo, body.position);
+                box.hi = glm::max(box.hi, body.position);
+            }
+            return box;
+        }
+
+        int build(uint32_t first, uint32_t count, glm::vec3 centre, float half, unsigned int depth) {
+            int index = static_cast<int>(cells.size());
+            cells.push_back(Cell{});
+            Cell cell{};
+            cell.centre = centre;
+            cell.half = half;
+            cell.first = first;
+            cell.count = count;
+            for (uint32_t i = first; i < first + count; ++i) {
+                const DomainBody &body = bodies[order[i]];
+                cell.mass += body.mass;
+                cell.com += body.mass * body.position;
+            }
+            cell.com = cell.mass > 0.0f ? cell.com / cell.mass : centre;
+            std::fill(std::begin(cell.child), std::end(cell.child), -1);
+            cell.leaf = count <= LEAF_SIZE || depth >= MAX_DEPTH;
+
+            if (!cell.leaf) {
+                // counting sort of the range by octant
+                auto octant = [&](uint32_t b) {
+                    const glm::vec3 &p = bodies[b].position;
+                    return (p.x >= centre.x ? 1 : 0) | (p.y >= centre.y ? 2 : 0) | (p.z >= centre.z ? 4 : 0);
+                };
+                uint32_t start[9] = {};
+                for (uint32_t i = first; i < first + count; ++i) start[octant(order[i]) + 1]++;
+                for (int o = 0; o < 8; ++o) start[o + 1] += start[o];
+                std::vector<uint32_t> sorted(count);
+                uint32_t next[8];
+                std::copy(start, start + 8, next);
+                for (uint32_t i = first; i < first + count; ++i) sorted[next[octant(order[i])]++] = order[i];
+                std::copy(sorted.begin(), sorted.end(), order.begin() + first);
+
+                for (int o = 0; o < 8; ++o) {
+                    if (start[o + 1] == start[o]) continue;
+                    glm::vec3 offset((o & 1) ? 0.5f : -0.5f, (o & 2) ? 0.5f : -0.5f, (o & 4) ? 0.5f : -0.5f);
+                    cell.child[o] = build(first + start[o], start[o + 1] - start[o], centre + offset * half, 0.5f * half, depth + 1);
+                }
+            }
+            cells[index] = cell;
+            return index;
+        }
+
+        void buildTree(const Bounds &box) {
+            cells.clear();
+            order.resize(bodies.size());
+            for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+            if (bodies.empty()) return;
+            glm::vec3 extent = box.hi - box.lo;
+            float half = 0.5f * std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-3f)) * 1.001f;
+            build(0, static_cast<uint32_t>(bodies.size()), 0.5f * (box.lo + box.hi), half, 0);
+        }
+
+        // what a peer whose bodies lie in `box` needs from this domain
+        void essential(int index, const Bounds &box, std::vector<PointMass> &points, uint32_t &ghosts, uint32_t &summaries) const {
+            const Cell &cell = cells[index];
+            glm::vec3 nearest = glm::clamp(cell.com, box.lo, box.hi);
+            float distance = glm::length(cell.com - nearest);
+            if (2.0f * cell.half < openingAngle * distance) {
+                points.push_back({cell.com, cell.mass});
+                summaries++;
+            } else if (cell.leaf) {
+                for (uint32_t i = cell.first; i < cell.first + cell.count; ++i) {
+                    const DomainBody &body = bodies[order[i]];
+                    points.push_back({body.position, body.mass});
+                }
+                ghosts += cell.count;
+            } else {
+                for (int child: cell.child)
+                    if (child >= 0) essential(child, box, points, ghosts, summaries);
+            }
+        }
+
+        bool step() {
+            // 1. domain bounds of all workers
+            Bounds own = bounds();
+            std::vector<std::vector<char>> outgoing(peers.size()), incoming;
+            for (std::vector<char> &message: outgoing) append(message, &own, 1);
+            if (!transport.exchange(peers, outgoing, incoming)) return false;
+
+            // 2. tree tops and ghosts for every peer
+            buildTree(own);
+            for (size_t p = 0; p < peers.size(); ++p) {
+                Bounds box{};
+                read(incoming[p], 0, &box, 1);
+                uint32_t counts[2] = {0, 0}; // ghosts, cells
+                std::vector<PointMass> points;
+                if (box.count > 0 && !cells.empty()) essential(0, box, points, counts[0], counts[1]);
+                outgoing[p].clear();
+                append(outgoing[p], counts, 2);
+                append(outgoing[p], points.data(), points.size());
+            }
+            if (!transport.exchange(peers, outgoing, incoming)) return false;
+
+            Reply reply{static_cast<uint32_t>(bodies.size()), 0, 0, 0};
+            std::vector<PointMass> remote;
+            for (const std::vector<char> &message: incoming) {
+                uint32_t counts[2] = {0, 0};
+                size_t offset = read(message, 0, counts, 2);
+                size_t first = remote.size();
+                remote.resize(first + counts[0] + counts[1]);
+                read(message, offset, remote.data() + first, counts[0] + counts[1]);
+                reply.ghosts += counts[0];
+                reply.cells += counts[1];
+            }
+
+            // 3. semi-implicit Euler as in Physics: gravity from the start-of-step positions
+            const float g = static_cast<float>(GRAV_CONST), cutoff = MIN_DIST_SQ + static_cast<float>(EPSILON);
+            auto attract = [&](const glm::vec3 &position, const glm::vec3 &source, float mass, glm::vec3 &acceleration) {
+                glm::vec3 d = source - position;
+                float distSq = glm::dot(d, d);
+                if (distSq >= cutoff) acceleration += g * mass / (distSq * std::sqrt(distSq)) * d;
+            };
+            std::vector<glm::vec3> accelerations(bodies.size(), glm::vec3(0.0f));
+            for (size_t i = 0; i < bodies.size(); ++i) {
+                for (size_t j = 0; j < bodies.size(); ++j)
+                    if (j != i) attract(bodies[i].position, bodies[j].position, bodies[j].mass, accelerations[i]);
+                for (const PointMass &point: remote)
+                    attract(bodies[i].position, point.position, point.mass, accelerations[i]);
+            }
+            reply.interactions = uint64_t(bodies.size()) * (bodies.size() + remote.size());
+
+            for (size_t i = 0; i < bodies.size(); ++i) {
+                DomainBody &body = bodies[i];
+                body.velocity += accelerations[i] * dt;
+                body.position += body.velocity * dt;
+                // see Physics::processSurfaceCollision
+                if (body.position.y - body.radius <= SURFACE_Y + EPSILON) {
+                    body.velocity.y *= -0.8f;
+                    body.position.y = SURFACE_Y + body.radius;
+                    if (std::abs(body.velocity.y) < 0.1f) body.velocity.y = 0.0f;
+                }
+            }
+
+            std::vector<char> message;
+            append(message, &reply, 1);
+            append(message, bodies.data(), bodies.size());
+            return transport.send(0, message);
+        }
+    };
+
+    // the running executable, which the workers start again in worker mode
+    std::string executablePath() {
+#ifdef __APPLE__
+        uint32_t size = 0;
+        _NSGetExecutablePath(nullptr, &size);
+        std::string path(size, '\0');
+        if (_NSGetExecutablePath(&path[0], &size) != 0) return "";
+        return path.c_str();
+#else
+        return "/proc/self/exe";
+#endif
+    }
+}
+
+int DistributedPhysics::runWorker(int argc, char *argv[]) {
+#ifdef _WIN32
+    return 1;
+#else
+    // <executable> WORKER_FLAG <rank> <opening angle> <socket to rank 0> ... <socket to rank n - 1>
+    if (argc < 5) return 1;
+    unsigned int rank = static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10));
+    float openingAngle = std::strtof(argv[3], nullptr);
+    std::vector<int> sockets;
+    for (int i = 4; i < argc; ++i) sockets.push_back(std::atoi(argv[i]));
+    if (rank == 0 || rank >= sockets.size()) return 1;
+
+    SocketTransport transport(rank, sockets);
+    DomainWorker(transport, openingAngle).run();
+    return 0;
+#endif
+}
+
+bool DistributedPhysics::start(const std::vector<Body *> &bodies, unsigned int workers, float openingAngle) {
+    stop();
+#ifdef _WIN32
+    std::cout << "ERROR::DISTRIBUTED::NOT_SUPPORTED_ON_WINDOWS" << std::endl;
+    return false;
+#else
+    workers = std::max(1u, workers);
+    std::vector<std::vector<int>> mesh = SocketTransport::createMesh(workers + 1);
+    if (mesh.empty()) return false;
+
+    // The workers exec this executable again in worker mode (runWorker()) rather than run on as
+    // forks: by now this process has an OpenGL context and other threads (uploads, metrics), and a
+    // fork only gets the calling thread, with locks and driver state as the others left them. So the
+    // child only closes sockets and calls execv(); its command line is built before fork().
+    const std::string executable = executablePath();
+    char angle[32];
+    std::snprintf(angle, sizeof(angle), "%.9g", openingAngle);
+    std::vector<std::vector<std::string>> arguments(workers + 1);
+    std::vector<std::vector<char *>> argv(workers + 1);
+    for (unsigned int rank = 1; rank <= workers; ++rank) {
+        arguments[rank] = {executable, WORKER_FLAG, std::to_string(rank), angle};
+        for (int socket: mesh[rank]) arguments[rank].push_back(std::to_string(socket));
+        for (std::string &argument: arguments[rank]) argv[rank].push_back(&argument[0]);
+        argv[rank].push_back(nullptr);
+    }
+
+    for (unsigned int rank = 1; rank <= workers; ++rank) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            SocketTransport::release(mesh, rank);
+            execv(argv[rank][0], argv[rank].data());
+            _exit(127); // rank 0 sees the sockets close and reports the worker
+        }
+        if (pid < 0) {
+            std::cout << "ERROR::DISTRIBUTED::FORK_FAILED" << std::endl;
+            // the workers already started see their sockets close and exit
+            SocketTransport::release(mesh, workers + 1);
+            for (int process: processes) waitpid(process, nullptr, 0);
+            processes.clear();
+            return false;
+        }
+        processes.push_back(pid);
+    }
+    SocketTransport::release(mesh, 0);
+    transport = std::make_unique<SocketTransport>(0, mesh[0]);
+
+    stats = DistributedStats();
+    stats.workers = workers;
+    stepsSinceRebalance = 0;
+    impulses.clear();
+    cost.assign(bodies.size(), 1.0f);
+    partition(bodies);
+    return scatter(bodies);
+#endif
+}
+
+void DistributedPhysics::partition(const std::vector<Body *> &bodies) {
+    owner.assign(bodies.size(), 0);
+    std::vector<unsigned int> ids;
+    for (unsigned int i = 0; i < bodies.size(); ++i)
+        if (!bodies[i]->sphere.mesh.source) ids.push_back(i);
+
+    // cut [begin, end) between `ranks` workers starting at `firstRank`
+    std::function<void(size_t, size_t, unsigned int, unsigned int)> bisect =
+            [&](size_t begin, size_t end, unsigned int firstRank, unsigned int ranks) {
+        if (ranks == 1) {
+            for (size_t i = begin; i < end; ++i) owner[ids[i]] = firstRank;
+            return;
+        }
+        glm::vec3 lo(0.0f), hi(0.0f);
+        if (begin < end) lo = hi = bodies[ids[begin]]->Position;
+        for (size_t i = begin; i < end; ++i) {
+            lo = glm::min(lo, bodies[ids[i]]->Position);
+            hi = glm::max(hi, bodies[ids[i]]->Position);
+        }
+        glm::vec3 extent = hi - lo;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        std::sort(ids.begin() + begin, ids.begin() + end, [&](unsigned int a, unsigned int b) {
+            float pa = bodies[a]->Position[axis], pb = bodies[b]->Position[axis];
+            return pa < pb || (pa == pb && a < b);
+        });
+
+        // weighted median, the left half gets its share of the ranks
+        unsigned int leftRanks = ranks / 2;
+        double total = 0.0;
+        for (size_t i = begin; i < end; ++i) total += cost[ids[i]];
+        double target = total * leftRanks / ranks, sum = 0.0;
+        size_t middle = begin;
+        while (middle < end && sum + 0.5 * cost[ids[middle]] < target) sum += cost[ids[middle++]];
+
+        bisect(begin, middle, firstRank, leftRanks);
+        bisect(middle, end, firstRank + leftRanks, ranks - leftRanks);
+    };
+    bisect(0, ids.size(), 1, stats.workers);
+}
+
+bool DistributedPhysics::scatter(const std::vector<Body *> &bodies) {
+    std::vector<std::vector<DomainBody>> domains(stats.workers + 1);
+    for (unsigned int i = 0; i < bodies.size(); ++i) {
+        if (owner[i] == 0) continue;
+        const Body *body = bodies[i];
+        domains[owner[i]].push_back({i, body->Position, body->Mass, body->Velocity, body->sphere.geometry.getRadius()});
+    }
+    for (unsigned int rank = 1; rank <= stats.workers; ++rank) {
+        Header header{SCATTER, static_cast<uint32_t>(domains[rank].size()), dt};
+        std::vector<char> message;
+        append(message, &header, 1);
+        append(message, domains[rank].data(), domains[rank].size());
+        if (!transport->send(rank, message)) {
+            std::cout << "ERROR::DISTRIBUTED::SCATTER_FAILED: worker " << rank << std::endl;
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void DistributedPhysics::processFrame(std::vector<Body *> &bodies) {
+    if (!transport) return;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<Impulse> queued;
+    for (const std::pair<unsigned int, glm::vec3> &impulse: impulses)
+        queued.push_back({impulse.first, impulse.second});
+    impulses.clear();
+    Header header{STEP, static_cast<uint32_t>(queued.size()), dt};
+    std::vector<char> message;
+    append(message, &header, 1);
+    append(message, queued.data(), queued.size());
+    for (unsigned int rank = 1; rank <= stats.workers; ++rank) {
+        if (!transport->send(rank, message)) {
+            std::cout << "ERROR::DISTRIBUTED::STEP_FAILED: worker " << rank << std::endl;
+            stop();
+            return;
+        }
+    }
+
+    // gather every domain back into the Body objects
+    stats.ghosts = stats.cells = 0;
+    double totalLoad = 0.0, maxLoad = 0.0;
+    std::vector<DomainBody> domain;
+    for (unsigned int rank = 1; rank <= stats.workers; ++rank) {
+        Reply reply{};
+        size_t offset = transport->receive(rank, message) ? read(message, 0, &reply, 1) : 0;
+        if (offset > 0) {
+            domain.resize(reply.count);
+            offset = read(message, offset, domain.data(), domain.size());
+        }
+        if (offset == 0) {
+            std::cout << "ERROR::DISTRIBUTED::GATHER_FAILED: worker " << rank << std::endl;
+            stop();
+            return;
+        }
+        float bodyCost = reply.count > 0 ? static_cast<float>(double(reply.interactions) / reply.count) : 1.0f;
+        for (const DomainBody &body: domain) {
+            if (body.id >= bodies.size()) continue;
+            bodies[body.id]->Position = body.position;
+            bodies[body.id]->Velocity = body.velocity;
+            cost[body.id] = bodyCost;
+        }
+        stats.ghosts += reply.ghosts;
+        stats.cells += reply.cells;
+        totalLoad += double(reply.interactions);
+        maxLoad = std::max(maxLoad, double(reply.interactions));
+    }
+    stats.imbalance = totalLoad > 0.0 ? static_cast<float>(maxLoad * stats.workers / totalLoad) : 1.0f;
+
+    // bodies drift out of their cuts, and cost moves with density: cut again once the load is off
+    if (++stepsSinceRebalance >= REBALANCE_INTERVAL && stats.imbalance > REBALANCE_THRESHOLD) {
+        partition(bodies);
+        if (!scatter(bodies)) return;
+        stats.rebalances++;
+        stepsSinceRebalance = 0;
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void DistributedPhysics::push(unsigned int bodyIndex, glm::vec3 impulse) {
+    if (!transport || bodyIndex >= owner.size()) return;
+    impulses.emplace_back(bodyIndex, impulse);
+}
+
+void DistributedPhysics::stop() {
+    if (!transport) return;
+    Header header{STOP, 0, dt};
+    std::vector<char> message;
+    append(message, &header, 1);
+    for (unsigned int rank = 1; rank <= stats.workers; ++rank) transport->send(rank, message);
+    transport.reset();
+#ifndef _WIN32
+    for (int process: processes) waitpid(process, nullptr, 0);
+#endif
+    processes.clear();
+}
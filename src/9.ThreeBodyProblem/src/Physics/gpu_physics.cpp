@@ -0,0 +1,113 @@
+#include "Physics/gpu_physics.h"
+#include "Physics/physics.h"
+#include "config.h"
+
+#include <algorithm>
+
+// Compile the compute program and create the storage buffers from the initial body state
+void GpuPhysics::init(const std::vector<Body *> &bodies) {
+    computeShader.loadCompute(CSHADER_NBODY_PATH);
+
+    bodyCount = static_cast<unsigned int>(bodies.size());
+    stepCount = 0;
+
+    std::vector<GpuBody> state(bodyCount);
+    for (unsigned int i = 0; i < bodyCount; ++i) {
+        const Body *body = bodies[i];
+        float radius = body->sphere.geometry.getRadius();
+        state[i].position = glm::vec4(body->Position, body->Mass);
+        state[i].velocity = glm::vec4(body->Velocity, body->sphere.mesh.source ? -radius : radius);
+    }
+    pendingImpulses.assign(bodyCount, glm::vec4(0.0f));
+    hasImpulses = false;
+
+    // immutable storage; only the GPU writes bodies, deltas and trace after this
+    bodyBuffer.storage(state.size() * sizeof(GpuBody), state.data());
+
+    // acceleration, contact velocity change and position correction (3 x vec4 per body)
+    deltaBuffer.storage(bodyCount * 3 * sizeof(glm::vec4), nullptr);
+
+    impulseBuffer.storage(bodyCount * sizeof(glm::vec4), pendingImpulses.data(), GL_DYNAMIC_STORAGE_BIT);
+
+    traceBuffer.storage(TRACE_CAPACITY * sizeof(glm::vec4), nullptr);
+
+    // constant uniforms
+    computeShader.use();
+    computeShader.setInt("bodyCount", static_cast<int>(bodyCount));
+    computeShader.setFloat("gravConst", static_cast<float>(GRAV_CONST));
+    computeShader.setFloat("minDistSq", 1.0f);
+    computeShader.setFloat("epsilon", static_cast<float>(EPSILON));
+    computeShader.setFloat("surfaceY", -2.0f);
+}
+
+// One fixed timestep: interaction pass, then integration pass
+void GpuPhysics::processFrame() {
+    if (bodyCount == 0) return;
+
+    // upload impulses queued by push() since the last step
+    if (hasImpulses)
+        impulseBuffer.subData(0, bodyCount * sizeof(glm::vec4), pendingImpulses.data());
+
+    bodyBuffer.bindBase(GL_SHADER_STORAGE_BUFFER, 0);
+    deltaBuffer.bindBase(GL_SHADER_STORAGE_BUFFER, 1);
+    impulseBuffer.bindBase(GL_SHADER_STORAGE_BUFFER, 2);
+    traceBuffer.bindBase(GL_SHADER_STORAGE_BUFFER, 3);
+
+    computeShader.use();
+    computeShader.setFloat("dt", dt);
+    computeShader.setBool("applyImpulses", hasImpulses);
+
+    // the trace ring holds a whole number of steps, each step writes one slot per body
+    unsigned int stepsPerRing = TRACE_CAPACITY / bodyCount;
+    int traceOffset = stepsPerRing > 0 ? static_cast<int>((stepCount % stepsPerRing) * bodyCount) : -1;
+    computeShader.setInt("traceOffset", traceOffset);
+
+    unsigned int groups = (bodyCount + TILE_SIZE - 1) / TILE_SIZE;
+
+    computeShader.setInt("stage", 0);
+    glDispatchCompute(groups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    computeShader.setInt("stage", 1);
+    glDispatchCompute(groups, 1, 1);
+    // the next step reads the bodies as storage, the renderer as vertex attributes
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    if (hasImpulses) {
+        std::fill(pendingImpulses.begin(), pendingImpulses.end(), glm::vec4(0.0f));
+        hasImpulses = false;
+    }
+    stepCount++;
+}
+
+void GpuPhysics::push(unsigned int bodyIndex, glm::vec3 impulse) {
+    if (bodyIndex >= bodyCount) return;
+
+    pendingImpulses[bodyIndex] += glm::vec4(impulse, 0.0f);
+    hasImpulses = true;
+}
+
+void GpuPhysics::readBack(std::vector<Body *> &bodies) {
+    std::vector<GpuBody> state(bodyCount);
+    bodyBuffer.getSubData(0, state.size() * sizeof(GpuBody), state.data());
+
+    for (unsigned int i = 0; i < bodyCount && i < bodies.size(); ++i) {
+        bodies[i]->Position = glm::vec3(state[i].position);
+        bodies[i]->Velocity = glm::vec3(state[i].velocity);
+    }
+}
+
+unsigned int GpuPhysics::getTraceCount() const {
+    if (bodyCount == 0) return 0;
+
+    unsigned int stepsPerRing = TRACE_CAPACITY / bodyCount;
+    return std::min(stepCount, stepsPerRing) * bodyCount;
+}
+
+void GpuPhysics::cleanup() {
+    bodyBuffer = GLBuffer();
+    deltaBuffer = GLBuffer();
+    impulseBuffer = GLBuffer();
+    traceBuffer = GLBuffer();
+    computeShader.terminate();
+}
@@ -0,0 +1,194 @@
+#include "Physics/out_of_core.h"
+#include "Physics/physics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+    constexpr float MIN_DIST_SQ = 1.0f; // same cutoff as Physics::calculateGravForce
+    constexpr float SURFACE_Y = -2.0f;  // same ground as Physics::onSurface
+}
+
+// ---------------------------------------------------------------------------------------------
+// OutOfCorePhysics
+// ---------------------------------------------------------------------------------------------
+
+bool OutOfCorePhysics::create(const std::string &directory, unsigned int count, unsigned int steps, size_t memoryBudget) {
+    close();
+    bodyCount = count;
+    tileCount = (count + TILE_SIZE - 1) / TILE_SIZE;
+    traceSteps = steps;
+    stepCount = 0;
+    blockTiles = static_cast<unsigned int>(std::max<size_t>(1, memoryBudget / TILE_BYTES));
+    blockTiles = std::min(blockTiles, std::max(1u, tileCount));
+
+    std::string prefix = directory.empty() ? "" : directory + "/";
+    if (!state.create(directory.empty() ? "" : prefix + "state.bin", tileCount * TILE_BYTES))
+        return false;
+    if (!trace.create(directory.empty() ? "" : prefix + "trace.bin", size_t(traceSteps) * bodyCount * 3 * sizeof(float)))
+        return false;
+    return true;
+}
+
+bool OutOfCorePhysics::start(const std::string &directory, const std::vector<Body *> &bodies, unsigned int steps, size_t memoryBudget) {
+    slots.assign(bodies.size(), -1);
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < bodies.size(); ++i)
+        if (!bodies[i]->sphere.mesh.source) slots[i] = static_cast<int>(count++);
+    if (!create(directory, count, steps, memoryBudget))
+        return false;
+    for (unsigned int i = 0; i < bodies.size(); ++i) {
+        if (slots[i] < 0) continue;
+        const Body &body = *bodies[i];
+        setBody(slots[i], body.Position, body.Velocity, body.Mass, body.sphere.geometry.getRadius());
+    }
+    running = true;
+    return true;
+}
+
+void OutOfCorePhysics::close() {
+    state.close();
+    trace.close();
+    running = false;
+}
+
+float *OutOfCorePhysics::array(unsigned int tile, Array which) const {
+    return reinterpret_cast<float *>(state.data() + tile * TILE_BYTES) + which * TILE_SIZE;
+}
+
+unsigned int OutOfCorePhysics::tileBodies(unsigned int tile) const {
+    return std::min(TILE_SIZE, bodyCount - tile * TILE_SIZE);
+}
+
+void OutOfCorePhysics::setBody(unsigned int index, const glm::vec3 &position, const glm::vec3 &velocity, float mass, float radius) {
+    unsigned int tile = index / TILE_SIZE, i = index % TILE_SIZE;
+    array(tile, PX)[i] = position.x;
+    array(tile, PY)[i] = position.y;
+    array(tile, PZ)[i] = position.z;
+    array(tile, MASS)[i] = mass;
+    array(tile, VX)[i] = velocity.x;
+    array(tile, VY)[i] = velocity.y;
+    array(tile, VZ)[i] = velocity.z;
+    array(tile, RADIUS)[i] = radius;
+}
+
+glm::vec3 OutOfCorePhysics::getPosition(unsigned int index) const {
+    unsigned int tile = index / TILE_SIZE, i = index % TILE_SIZE;
+    return glm::vec3(array(tile, PX)[i], array(tile, PY)[i], array(tile, PZ)[i]);
+}
+
+glm::vec3 OutOfCorePhysics::getVelocity(unsigned int index) const {
+    unsigned int tile = index / TILE_SIZE, i = index % TILE_SIZE;
+    return glm::vec3(array(tile, VX)[i], array(tile, VY)[i], array(tile, VZ)[i]);
+}
+
+std::future<void> OutOfCorePhysics::prefetch(unsigned int tile) const {
+    // positions and masses are the first half of the tile
+    size_t offset = tile * TILE_BYTES, size = 4 * TILE_SIZE * sizeof(float);
+    state.willNeed(offset, size);
+    const char *bytes = state.data() + offset;
+    return std::async(std::launch::async, [bytes, size]() {
+        volatile char sink = 0;
+        for (size_t i = 0; i < size; i += MappedFile::PAGE_BYTES) sink = sink + bytes[i];
+    });
+}
+
+void OutOfCorePhysics::interact(unsigned int target, unsigned int source) const {
+    const float *px = array(source, PX), *py = array(source, PY), *pz = array(source, PZ), *mass = array(source, MASS);
+    const float *tx = array(target, PX), *ty = array(target, PY), *tz = array(target, PZ);
+    float *vx = array(target, VX), *vy = array(target, VY), *vz = array(target, VZ);
+    const unsigned int sources = tileBodies(source), targets = tileBodies(target);
+    const float g = static_cast<float>(GRAV_CONST), cutoff = MIN_DIST_SQ + static_cast<float>(EPSILON);
+
+    for (unsigned int i = 0; i < targets; ++i) {
+        float ax = 0.0f, ay = 0.0f, az = 0.0f;
+        for (unsigned int j = 0; j < sources; ++j) {
+            float dx = px[j] - tx[i], dy = py[j] - ty[i], dz = pz[j] - tz[i];
+            float distSq = dx * dx + dy * dy + dz * dz;
+            // bodies closer than the cutoff (the body itself included) don't attract, as in the Euler path
+            float s = distSq >= cutoff ? g * mass[j] / (distSq * std::sqrt(distSq)) : 0.0f;
+            ax += s * dx;
+            ay += s * dy;
+            az += s * dz;
+        }
+        vx[i] += ax * dt;
+        vy[i] += ay * dt;
+        vz[i] += az * dt;
+    }
+}
+
+void OutOfCorePhysics::processFrame() {
+    if (bodyCount == 0) return;
+
+    // pass 1: gravity. Velocities aren't read by the force evaluation, so every target tile can
+    // take its velocity change as soon as a source tile is done. Odd blocks sweep the sources
+    // backwards, so the tiles the last block ended with are still cached.
+    for (unsigned int block = 0; block * blockTiles < tileCount; ++block) {
+        unsigned int first = block * blockTiles, last = std::min(tileCount, first + blockTiles);
+        state.willNeed(first * TILE_BYTES, (last - first) * TILE_BYTES);
+
+        bool backwards = block % 2 == 1;
+        auto sourceAt = [&](unsigned int k) { return backwards ? tileCount - 1 - k : k; };
+        std::future<void> pending = prefetch(sourceAt(0));
+        for (unsigned int k = 0; k < tileCount; ++k) {
+            pending.wait();
+            std::future<void> next = k + 1 < tileCount ? prefetch(sourceAt(k + 1)) : std::future<void>();
+            for (unsigned int target = first; target < last; ++target)
+                interact(target, sourceAt(k));
+            pending = std::move(next);
+        }
+    }
+
+    // pass 2: move every body, bounce it off the ground and append it to the trace
+    float *traceSlot = traceSteps > 0 ? reinterpret_cast<float *>(trace.data()) + size_t(stepCount % traceSteps) * bodyCount * 3 : nullptr;
+    for (unsigned int tile = 0; tile < tileCount; ++tile) {
+        if (tile + 1 < tileCount) state.willNeed((tile + 1) * TILE_BYTES, TILE_BYTES);
+        float *px = array(tile, PX), *py = array(tile, PY), *pz = array(tile, PZ);
+        float *vx = array(tile, VX), *vy = array(tile, VY), *vz = array(tile, VZ);
+        const float *radius = array(tile, RADIUS);
+        for (unsigned int i = 0; i < tileBodies(tile); ++i) {
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            pz[i] += vz[i] * dt;
+            // see Physics::processSurfaceCollision
+            if (py[i] - radius[i] <= SURFACE_Y + EPSILON) {
+                vy[i] *= -0.8f;
+                py[i] = SURFACE_Y + radius[i];
+                if (std::abs(vy[i]) < 0.1f) vy[i] = 0.0f;
+            }
+            if (traceSlot) {
+                float *slot = traceSlot + (size_t(tile) * TILE_SIZE + i) * 3;
+                slot[0] = px[i];
+                slot[1] = py[i];
+                slot[2] = pz[i];
+            }
+        }
+    }
+    // the trace is written once and not read again, start writing it back right away
+    trace.flush();
+
+    if (coldCache) {
+        state.evict();
+        trace.evict();
+    }
+    stepCount++;
+}
+
+void OutOfCorePhysics::processFrame(std::vector<Body *> &bodies) {
+    processFrame();
+    for (unsigned int i = 0; i < bodies.size() && i < slots.size(); ++i) {
+        if (slots[i] < 0) continue;
+        bodies[i]->Position = getPosition(slots[i]);
+        bodies[i]->Velocity = getVelocity(slots[i]);
+    }
+}
+
+void OutOfCorePhysics::push(unsigned int bodyIndex, glm::vec3 impulse) {
+    if (bodyIndex >= slots.size() || slots[bodyIndex] < 0) return;
+    unsigned int tile = slots[bodyIndex] / TILE_SIZE, i = slots[bodyIndex] % TILE_SIZE;
+    array(tile, VX)[i] += impulse.x;
+    array(tile, VY)[i] += impulse.y;
+    array(tile, VZ)[i] += impulse.z;
+}
@@ -1,61 +1,361 @@
 ﻿#include "Physics/physics.h"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <learnopengl/metrics.h>
+
+namespace {
+    // Contacts or bodies a worker gets at least, smaller batches aren't worth a thread
+    constexpr size_t MIN_ITEMS_PER_WORKER = 64;
+
+    // Run fn(i) for i in [0, count) on up to `workers` threads of `pool` (the caller counts as one)
+    template<typename Function>
+    void parallelFor(WorkerPool &pool, unsigned int workers, size_t count, const Function &fn) {
+        size_t threads = std::min<size_t>(workers, (count + MIN_ITEMS_PER_WORKER - 1) / MIN_ITEMS_PER_WORKER);
+        if (threads <= 1) {
+            for (size_t i = 0; i < count; ++i) fn(i);
+            return;
+        }
+
+        size_t chunk = (count + threads - 1) / threads;
+        pool.run(threads, [&fn, chunk, count](size_t t) {
+            for (size_t i = t * chunk; i < std::min(count, (t + 1) * chunk); ++i) fn(i);
+        });
+    }
+
+    MetricCounter &stepMetric = metrics().counter("physics_steps_total", "Physics::processFrame calls");
+    MetricCounter &pairMetric = metrics().counter("physics_pairs_total", "Gravity pair interactions evaluated");
+    MetricCounter &contactMetric = metrics().counter("physics_contacts_total", "Sphere contacts resolved");
+    MetricHistogram &substepMetric = metrics().histogram("physics_substeps_per_frame", "Integrator substeps per frame",
+                                                         {1, 2, 4, 8, 16, 32, 64, 128, 256, 1024});
+    MetricHistogram &contactTimeMetric = metrics().histogram("physics_contact_seconds", "Contact stage time per frame",
+                                                             {0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1});
+
+    // pairs one gravity evaluation visits (light sources don't take part)
+    uint64_t gravityPairs(const std::vector<Body *> &bodies) {
+        uint64_t active = 0;
+        for (const Body *body: bodies) active += body->sphere.mesh.source ? 0 : 1;
+        return active > 0 ? active * (active - 1) / 2 : 0;
+    }
+}
 
-Physics::Physics() : Speed(3.0f), endSim(false) {
-    dt = 1.0 / 60.0;
+
+Physics::Physics() : Speed(3.0f), endSim(false), timeStep(dt) {
+    setContactSolver(PHYSICS_WORKERS, CONTACT_ITERATIONS);
+}
+
+Physics::Physics(float speed) : Speed(speed), endSim(false), timeStep(dt) {
+    setContactSolver(PHYSICS_WORKERS, CONTACT_ITERATIONS);
 }
 
-Physics::Physics(float speed) : Speed(speed), endSim(false) {
-    dt = 1.0 / 60.0;
+Physics::Physics(float timeStep, float speed) : Speed(speed), endSim(false), timeStep(timeStep) {
+    setContactSolver(PHYSICS_WORKERS, CONTACT_ITERATIONS);
 }
 
-Physics::Physics(float timeStep, float speed) : Speed(speed), endSim(false) {
-    dt = timeStep;
+void Physics::setContactSolver(unsigned int workers, unsigned int iterations) {
+    workerCount = workers > 0 ? workers : std::max(1u, std::thread::hardware_concurrency());
+    pool.resize(workerCount - 1);
+    solverIterations = std::max(1u, iterations);
+}
+
+void Physics::setIntegrator(Integrator scheme, unsigned int substeps) {
+    integrator = scheme;
+    regularizedSubsteps = std::max(1u, substeps);
 }
 
 void Physics::processFrame(std::vector<Body *> bodies) {
-    for (int i = 0; i < bodies.size(); ++i) {
-        Body *body = bodies[i];
-        body->Force = glm::vec3(0);
+    unsigned int substeps = 1;
+    if (integrator == Integrator::Euler) {
+        for (int i = 0; i < bodies.size(); ++i) {
+            Body *body = bodies[i];
+            body->Force = glm::vec3(0);
 
-        if (body->sphere.mesh.source) continue;
+            if (body->sphere.mesh.source) continue;
 
-        // Calculate gravitational forces between this body and all later bodies
-        for (int j = i + 1; j < bodies.size(); ++j) {
-            Body *sBody = bodies[j];
-            // Skip if the other body is a light source
-            if (sBody->sphere.mesh.source) continue;
+            // Calculate gravitational forces between this body and all later bodies
+            for (int j = i + 1; j < bodies.size(); ++j) {
+                Body *sBody = bodies[j];
+                // Skip if the other body is a light source
+                if (sBody->sphere.mesh.source) continue;
 
-            calculateGravForce(*body, *sBody);
-        }
+                calculateGravForce(*body, *sBody);
+            }
 
-        calculateForce(*body);
-        updateState(*body);
+            calculateForce(*body);
+            updateState(*body);
+        }
+        forceEvaluations++;
+        pairMetric.add(gravityPairs(bodies));
+        simulationTime += timeStep;
+    } else if (integrator == Integrator::Verlet) {
+        stepVerlet(bodies);
+    } else {
+        substeps = stepRegularized(bodies);
+    }
+    stepMetric.add();
+    substepMetric.observe(substeps);
 
-        if (onSurface(*body))
+    for (Body *body: bodies) {
+        if (!body->sphere.mesh.source && onSurface(*body))
             processSurfaceCollision(*body);
+    }
 
-        for (int j = i + 1; j < bodies.size(); ++j) {
-            Body *colBody = bodies[j];
-            if (colBody->sphere.mesh.source == true) continue;
-
-            if (areColliding(*colBody, *body) && !((isZero(body->Velocity) && isZero(colBody->Velocity)))) {
-                // endSim = true;
+    // Contacts are resolved once every body has moved, batch by batch
+    resolveContacts(bodies);
 
-                processCollision(*colBody, *body);
-            }
-        }
+    for (Body *body: bodies) {
+        if (body->sphere.mesh.source) continue;
 
         // Natural exponential velocity decay: v(t) = v₀ * e^(-λt)
         // λ (lambda) controls decay rate: higher = faster decay
         if (!isZero(body->Velocity)) {
             float vLambda = 0.0f; // Adjust this for desired decay speed (0.1 = slow, 1.0 = fast)
-            float vDecayFactor = glm::exp(-vLambda * dt);
+            float vDecayFactor = glm::exp(-vLambda * timeStep);
             body->Velocity *= vDecayFactor;
         }
     }
 }
 
+double Physics::calculateAccelerations(std::vector<Body *> &bodies) {
+    double potential = 0.0;
+    for (Body *body: bodies) {
+        body->Acceleration = GRAV_FORCE;
+    }
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        Body &one = *bodies[i];
+        if (one.sphere.mesh.source) continue;
+        for (size_t j = i + 1; j < bodies.size(); ++j) {
+            Body &two = *bodies[j];
+            if (two.sphere.mesh.source) continue;
+
+            glm::vec3 d = two.Position - one.Position;
+            float distSq = glm::dot(d, d);
+            if (distSq <= 0.0f) continue;
+            float dist = std::sqrt(distSq);
+            // G / r³ · d, applied with the other body's mass
+            float factor = static_cast<float>(GRAV_CONST) / (distSq * dist);
+            one.Acceleration += factor * two.Mass * d;
+            two.Acceleration -= factor * one.Mass * d;
+            potential -= GRAV_CONST * one.Mass * two.Mass / dist;
+        }
+    }
+    for (Body *body: bodies) {
+        body->Force = body->Mass * body->Acceleration;
+    }
+    forceEvaluations++;
+    pairMetric.add(gravityPairs(bodies));
+    return potential;
+}
+
+double Physics::kineticEnergy(std::vector<Body *> &bodies) {
+    double kinetic = 0.0;
+    for (Body *body: bodies) {
+        if (!body->sphere.mesh.source)
+            kinetic += 0.5 * body->Mass * glm::dot(body->Velocity, body->Velocity);
+    }
+    return kinetic;
+}
+
+void Physics::stepVerlet(std::vector<Body *> &bodies) {
+    auto drift = [&](float h) {
+        for (Body *body: bodies) {
+            if (!body->sphere.mesh.source) body->Position += body->Velocity * h;
+        }
+    };
+
+    drift(0.5f * timeStep);
+    calculateAccelerations(bodies);
+    for (Body *body: bodies) {
+        if (!body->sphere.mesh.source) body->Velocity += body->Acceleration * timeStep;
+    }
+    drift(0.5f * timeStep);
+    simulationTime += timeStep;
+}
+
+unsigned int Physics::stepRegularized(std::vector<Body *> &bodies) {
+    targetTime += timeStep;
+
+    // the binding energy is only constant between frames: collisions and pushes change it
+    double potential = calculateAccelerations(bodies);
+    double binding = -(kineticEnergy(bodies) + potential);
+    if (-potential <= 0.0) {
+        // nothing attracts anything, the time transformation is undefined
+        stepVerlet(bodies);
+        targetTime = simulationTime;
+        return 1;
+    }
+
+    // Drift: dt = h / (T + B), kick: dt = h / -U. With B = -(T + U) both equal 1 / -U on the exact
+    // solution, but the drift uses the kinetic energy, which is what regularizes the pericenter passage.
+    auto drift = [&](double h) {
+        double step = h / (kineticEnergy(bodies) + binding);
+        for (Body *body: bodies) {
+            if (!body->sphere.mesh.source) body->Position += body->Velocity * static_cast<float>(step);
+        }
+        simulationTime += step;
+    };
+
+    // On average -U = 2B over a bound orbit (virial theorem), so with h = 2B · dt / substeps a substep
+    // lasts dt / substeps on average, wherever in the orbit the frame starts. Near apocenter (-U < 2B)
+    // and for unbound systems the current potential is used instead.
+    double scale = binding > 0.0 ? std::min(2.0 * binding, -potential) : -potential;
+    double h = scale * timeStep / regularizedSubsteps;
+    // bounded so a collapse can't stall the frame
+    unsigned int substep = 0;
+    for (; simulationTime < targetTime && substep < 1000 * regularizedSubsteps; ++substep) {
+        drift(0.5 * h);
+        potential = calculateAccelerations(bodies);
+        float step = static_cast<float>(h / -potential);
+        for (Body *body: bodies) {
+            if (!body->sphere.mesh.source) body->Velocity += body->Acceleration * step;
+        }
+        drift(0.5 * h);
+    }
+    return substep;
+}
+
+void Physics::findContacts(std::vector<Body *> &bodies) {
+    // broad phase: a hash grid with cells as wide as the largest sphere, so touching
+    // bodies are always in the same or in neighbouring cells
+    float maxRadius = 0.0f;
+    for (Body *body: bodies) {
+        if (!body->sphere.mesh.source) maxRadius = std::max(maxRadius, body->sphere.geometry.getRadius());
+    }
+    // areColliding() accepts distances up to sqrt(r² + EPSILON)
+    const float cellSize = 2.0f * maxRadius + static_cast<float>(std::sqrt(EPSILON));
+    unsigned int tableSize = 1;
+    while (tableSize < 2 * bodies.size()) tableSize *= 2;
+    auto cellOf = [&](const Body *body) { return glm::ivec3(glm::floor(body->Position / cellSize)); };
+    auto bucketOf = [&](glm::ivec3 cell) {
+        return (static_cast<unsigned int>(cell.x) * 73856093u ^ static_cast<unsigned int>(cell.y) * 19349663u ^
+                static_cast<unsigned int>(cell.z) * 83492791u) & (tableSize - 1);
+    };
+
+    // counting sort of the bodies into their buckets
+    bodyCell.resize(bodies.size());
+    cellStart.assign(tableSize + 1, 0);
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        if (bodies[i]->sphere.mesh.source) continue;
+        bodyCell[i] = bucketOf(cellOf(bodies[i]));
+        cellStart[bodyCell[i] + 1]++;
+    }
+    for (unsigned int b = 0; b < tableSize; ++b) cellStart[b + 1] += cellStart[b];
+    cellBodies.resize(cellStart[tableSize]);
+    std::vector<unsigned int> next(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        if (!bodies[i]->sphere.mesh.source) cellBodies[next[bodyCell[i]]++] = static_cast<unsigned int>(i);
+    }
+
+    // narrow phase: every body tests the later bodies of its 27 surrounding cells, in parallel
+    touching.resize(bodies.size());
+    parallelFor(pool, workerCount, bodies.size(), [&](size_t i) {
+        touching[i].clear();
+        if (bodies[i]->sphere.mesh.source) return;
+
+        // neighbouring cells may share a bucket, visit each bucket once
+        unsigned int buckets[27];
+        unsigned int bucketCount = 0;
+        glm::ivec3 cell = cellOf(bodies[i]);
+        for (int z = -1; z <= 1; ++z)
+            for (int y = -1; y <= 1; ++y)
+                for (int x = -1; x <= 1; ++x) {
+                    unsigned int bucket = bucketOf(cell + glm::ivec3(x, y, z));
+                    if (std::find(buckets, buckets + bucketCount, bucket) == buckets + bucketCount)
+                        buckets[bucketCount++] = bucket;
+                }
+
+        for (unsigned int b = 0; b < bucketCount; ++b) {
+            for (unsigned int k = cellStart[buckets[b]]; k < cellStart[buckets[b] + 1]; ++k) {
+                unsigned int j = cellBodies[k];
+                if (j > i && areColliding(*bodies[j], *bodies[i]))
+                    touching[i].push_back({j, static_cast<unsigned int>(i)});
+            }
+        }
+    });
+
+    // pairs in body order, as the serial loop visited them, so the batches (and therefore the
+    // results) don't depend on the number of workers
+    contacts.clear();
+    for (std::vector<Contact> &found: touching) {
+        std::sort(found.begin(), found.end(), [](const Contact &a, const Contact &b) { return a.one < b.one; });
+        contacts.insert(contacts.end(), found.begin(), found.end());
+    }
+}
+
+bool Physics::colorContacts(size_t bodyCount) {
+    // greedy coloring: each contact takes the lowest color neither of its bodies uses yet,
+    // contacts beyond 64 colors per body share one last batch which is resolved serially
+    constexpr unsigned int SERIAL_BATCH = 64;
+    usedColors.assign(bodyCount, 0);
+    std::vector<unsigned int> colors(contacts.size());
+    std::vector<unsigned int> batchSizes(SERIAL_BATCH + 1, 0);
+    for (size_t c = 0; c < contacts.size(); ++c) {
+        uint64_t used = usedColors[contacts[c].one] | usedColors[contacts[c].two];
+        unsigned int color = SERIAL_BATCH;
+        if (~used != 0) {
+            color = 0;
+            while (used & (uint64_t(1) << color)) ++color;
+            usedColors[contacts[c].one] |= uint64_t(1) << color;
+            usedColors[contacts[c].two] |= uint64_t(1) << color;
+        }
+        colors[c] = color;
+        batchSizes[color]++;
+    }
+
+    // counting sort by color keeps the detection order inside every batch
+    batchOffsets.assign(1, 0);
+    for (unsigned int size: batchSizes) {
+        if (size > 0) batchOffsets.push_back(batchOffsets.back() + size);
+    }
+    std::vector<unsigned int> batchOf(SERIAL_BATCH + 1, 0), next(SERIAL_BATCH + 1, 0);
+    for (unsigned int color = 0, batch = 0; color <= SERIAL_BATCH; ++color) {
+        if (batchSizes[color] > 0) next[color] = batchOffsets[batch++];
+    }
+    std::vector<Contact> sorted(contacts.size());
+    for (size_t c = 0; c < contacts.size(); ++c)
+        sorted[next[colors[c]]++] = contacts[c];
+    contacts.swap(sorted);
+
+    return batchSizes[SERIAL_BATCH] > 0;
+}
+
+void Physics::resolveContacts(std::vector<Body *> &bodies) {
+    auto start = std::chrono::steady_clock::now();
+
+    findContacts(bodies);
+    bool serialTail = colorContacts(bodies.size());
+    size_t batchCount = batchOffsets.size() - 1;
+
+    for (unsigned int iteration = 0; iteration < solverIterations; ++iteration) {
+        for (size_t batch = 0; batch < batchCount; ++batch) {
+            size_t first = batchOffsets[batch];
+            size_t count = batchOffsets[batch + 1] - first;
+            // no two contacts of a batch share a body, except in the overflow batch
+            unsigned int workers = serialTail && batch + 1 == batchCount ? 1 : workerCount;
+
+            parallelFor(pool, workers, count, [&](size_t c) {
+                Body &one = *bodies[contacts[first + c].one];
+                Body &two = *bodies[contacts[first + c].two];
+                // earlier contacts may have moved the pair apart already
+                if (!areColliding(one, two)) return;
+                if (iteration == 0) {
+                    if (!(isZero(two.Velocity) && isZero(one.Velocity)))
+                        processCollision(one, two);
+                } else {
+                    separate(one, two);
+                }
+            });
+        }
+    }
+
+    contactStats.contacts = static_cast<unsigned int>(contacts.size());
+    contactStats.batches = static_cast<unsigned int>(batchCount);
+    contactStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    contactMetric.add(contacts.size());
+    contactTimeMetric.observe(contactStats.seconds);
+}
+
 void Physics::wait(float sec) {
 }
 
@@ -80,10 +380,10 @@ void Physics::updateState(Body &body) {
     body.Acceleration = body.Force / body.Mass;
 
     // Euler integration to update vecloty vector
-    body.Velocity += body.Acceleration * dt;
+    body.Velocity += body.Acceleration * timeStep;
 
     // Euler integration to update position vector
-    body.Position += body.Velocity * dt;
+    body.Position += body.Velocity * timeStep;
 }
 
 float Physics::calculateDistanceSquare(Body &sphereOne, Body &sphereTwo) {
@@ -158,6 +458,22 @@ bool Physics::areColliding(Body &sphereOne, Body &sphereTwo) {
 }
 
 void Physics::processCollision(Body &sphereOne, Body &sphereTwo) {
+    separate(sphereOne, sphereTwo);
+
+    // 弹性碰撞公式
+    //模糊处理让速度默认沿碰撞法线方向变化，忽略切向分量
+    glm::vec3 velOne = (((sphereOne.Mass - sphereTwo.Mass) * sphereOne.Velocity) + (
+                            (sphereTwo.Mass + sphereTwo.Mass) * sphereTwo.Velocity)) / (
+                           sphereOne.Mass + sphereTwo.Mass);
+    glm::vec3 velTwo = (((sphereOne.Mass + sphereTwo.Mass) * sphereOne.Velocity) + (
+                            (sphereTwo.Mass - sphereOne.Mass) * sphereTwo.Velocity)) / (
+                           sphereOne.Mass + sphereTwo.Mass);
+
+    sphereOne.Velocity = velOne;
+    sphereTwo.Velocity = velTwo;
+}
+
+void Physics::separate(Body &sphereOne, Body &sphereTwo) {
     // Calculate collision normal (direction from one to two)
     glm::vec3 collisionNormal = glm::normalize(sphereTwo.Position - sphereOne.Position);
 
@@ -173,18 +489,6 @@ void Physics::processCollision(Body &sphereOne, Body &sphereTwo) {
         sphereOne.Position -= correction; // Push sphere one away
         sphereTwo.Position += correction; // Push sphere two away
     }
-
-    // 弹性碰撞公式
-    //模糊处理让速度默认沿碰撞法线方向变化，忽略切向分量
-    glm::vec3 velOne = (((sphereOne.Mass - sphereTwo.Mass) * sphereOne.Velocity) + (
-                            (sphereTwo.Mass + sphereTwo.Mass) * sphereTwo.Velocity)) / (
-                           sphereOne.Mass + sphereTwo.Mass);
-    glm::vec3 velTwo = (((sphereOne.Mass + sphereTwo.Mass) * sphereOne.Velocity) + (
-                            (sphereTwo.Mass - sphereOne.Mass) * sphereTwo.Velocity)) / (
-                           sphereOne.Mass + sphereTwo.Mass);
-
-    sphereOne.Velocity = velOne;
-    sphereTwo.Velocity = velTwo;
 }
 
 double Physics::getDistance(Body &sphereOne, Body &sphereTwo) {
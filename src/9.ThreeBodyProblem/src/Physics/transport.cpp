@@ -0,0 +1,171 @@
+#include "Physics/transport.h"
+
+#include <cstdint>
+#include <future>
+#include <iostream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+namespace {
+    bool writeAll(int socket, const char *data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::send(socket, data, size, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return false;
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool readAll(int socket, char *data, size_t size) {
+        while (size > 0) {
+            ssize_t got = ::recv(socket, data, size, 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            data += got;
+            size -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+}
+#endif
+
+std::vector<std::vector<int>> SocketTransport::createMesh(unsigned int size) {
+    std::vector<std::vector<int>> mesh(size, std::vector<int>(size, -1));
+#ifdef _WIN32
+    std::cout << "ERROR::TRANSPORT::SOCKETS_NOT_SUPPORTED" << std::endl;
+    return {};
+#else
+    for (unsigned int a = 0; a < size; ++a) {
+        for (unsigned int b = a + 1; b < size; ++b) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                std::cout << "ERROR::TRANSPORT::SOCKETPAIR_FAILED" << std::endl;
+                release(mesh, size);
+                return {};
+            }
+            mesh[a][b] = pair[0];
+            mesh[b][a] = pair[1];
+        }
+    }
+    return mesh;
+#endif
+}
+
+void SocketTransport::release(std::vector<std::vector<int>> &mesh, unsigned int rank) {
+#ifndef _WIN32
+    for (unsigned int r = 0; r < mesh.size(); ++r) {
+        if (r == rank) continue;
+        for (int &socket: mesh[r]) {
+            if (socket >= 0) ::close(socket);
+            socket = -1;
+        }
+    }
+#endif
+}
+
+SocketTransport::SocketTransport(unsigned int rank, std::vector<int> peerSockets)
+    : self(rank), sockets(std::move(peerSockets)) {
+}
+
+SocketTransport::~SocketTransport() {
+#ifndef _WIN32
+    for (int socket: sockets)
+        if (socket >= 0) ::close(socket);
+#endif
+}
+
+bool SocketTransport::send(unsigned int peer, const std::vector<char> &message) {
+#ifdef _WIN32
+    return false;
+#else
+    if (peer >= sockets.size() || sockets[peer] < 0) return false;
+    uint64_t length = message.size();
+    return writeAll(sockets[peer], reinterpret_cast<const char *>(&length), sizeof(length)) &&
+           writeAll(sockets[peer], message.data(), message.size());
+#endif
+}
+
+bool SocketTransport::receive(unsigned int peer, std::vector<char> &message) {
+#ifdef _WIN32
+    return false;
+#else
+    if (peer >= sockets.size() || sockets[peer] < 0) return false;
+    uint64_t length = 0;
+    if (!readAll(sockets[peer], reinterpret_cast<char *>(&length), sizeof(length))) return false;
+    message.resize(length);
+    return readAll(sockets[peer], message.data(), length);
+#endif
+}
+
+bool SocketTransport::exchange(const std::vector<unsigned int> &peers, const std::vector<std::vector<char>> &outgoing,
+                               std::vector<std::vector<char>> &incoming) {
+#ifdef _WIN32
+    return false;
+#else
+    incoming.assign(peers.size(), std::vector<char>());
+    std::future<bool> sent = std::async(std::launch::async, [&]() {
+        bool ok = true;
+        for (size_t i = 0; i < peers.size(); ++i) ok = send(peers[i], outgoing[i]) && ok;
+        return ok;
+    });
+
+    // per peer: bytes of the length prefix and of the payload read so far
+    std::vector<uint64_t> lengths(peers.size(), 0);
+    std::vector<size_t> received(peers.size(), 0);
+    std::vector<bool> done(peers.size(), false);
+    size_t remaining = peers.size();
+    bool ok = true;
+    while (remaining > 0 && ok) {
+        std::vector<pollfd> waiting;
+        std::vector<size_t> owners;
+        for (size_t i = 0; i < peers.size(); ++i) {
+            if (done[i]) continue;
+            waiting.push_back({sockets[peers[i]], POLLIN, 0});
+            owners.push_back(i);
+        }
+        if (poll(waiting.data(), waiting.size(), -1) < 0) {
+            ok = errno == EINTR;
+            continue;
+        }
+
+        for (size_t w = 0; w < waiting.size(); ++w) {
+            if (!(waiting[w].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            size_t i = owners[w];
+            // the length prefix first, then the payload straight into the message
+            char *target;
+            size_t wanted;
+            if (received[i] < sizeof(uint64_t)) {
+                target = reinterpret_cast<char *>(&lengths[i]) + received[i];
+                wanted = sizeof(uint64_t) - received[i];
+            } else {
+                target = incoming[i].data() + (received[i] - sizeof(uint64_t));
+                wanted = lengths[i] - (received[i] - sizeof(uint64_t));
+            }
+            ssize_t got = ::recv(waiting[w].fd, target, wanted, MSG_DONTWAIT);
+            if (got < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+            if (got <= 0) {
+                ok = false;
+                break;
+            }
+            received[i] += static_cast<size_t>(got);
+            if (received[i] == sizeof(uint64_t)) incoming[i].resize(lengths[i]);
+            if (received[i] >= sizeof(uint64_t) && received[i] - sizeof(uint64_t) == lengths[i]) {
+                done[i] = true;
+                remaining--;
+            }
+        }
+    }
+
+    if (!sent.get()) ok = false;
+    if (!ok) std::cout << "ERROR::TRANSPORT::EXCHANGE_FAILED: rank " << self << std::endl;
+    return ok;
+#endif
+}
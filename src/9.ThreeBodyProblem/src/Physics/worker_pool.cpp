@@ -0,0 +1,68 @@
+#include "Physics/worker_pool.h"
+
+#include <algorithm>
+
+void WorkerPool::resize(unsigned int threads) {
+    if (threads == workers.size()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker: workers) worker.join();
+    workers.clear();
+
+    stopping = false;
+    for (unsigned int i = 0; i < threads; ++i) workers.emplace_back([this]() { loop(); });
+}
+
+void WorkerPool::run(size_t chunks, const std::function<void(size_t)> &work) {
+    if (workers.empty() || chunks <= 1) {
+        for (size_t c = 0; c < chunks; ++c) work(c);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &work;
+        chunkCount = chunks;
+        nextChunk.store(0, std::memory_order_relaxed);
+        // the caller takes chunks as well, more helpers than chunks - 1 would only wake up for nothing
+        helpers = static_cast<unsigned int>(std::min<size_t>(workers.size(), chunks - 1));
+        joined = 0;
+        busy = helpers;
+        ++generation;
+    }
+    wake.notify_all();
+    take(work, chunks);
+
+    // every helper must be done with `work` (not just out of chunks) before it goes out of scope
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return busy == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::loop() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [&]() { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        if (joined == helpers) continue; // enough threads on this run already
+        ++joined;
+        const std::function<void(size_t)> &work = *job;
+        size_t chunks = chunkCount;
+
+        lock.unlock();
+        take(work, chunks);
+        lock.lock();
+        if (--busy == 0) idle.notify_one();
+    }
+}
+
+void WorkerPool::take(const std::function<void(size_t)> &work, size_t chunks) {
+    for (size_t c = nextChunk.fetch_add(1, std::memory_order_relaxed); c < chunks;
+         c = nextChunk.fetch_add(1, std::memory_order_relaxed))
+        work(c);
+}
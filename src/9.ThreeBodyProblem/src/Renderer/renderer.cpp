@@ -1,5 +1,23 @@
 #include "Renderer/renderer.h"
 
+#include <learnopengl/metrics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    MetricCounter &frameMetric = metrics().counter("renderer_frames_total", "Frames rendered");
+    MetricCounter &drawCallMetric = metrics().counter("renderer_draw_calls_total", "Draw calls issued");
+    MetricGauge &tracePointMetric = metrics().gauge("renderer_trace_points", "Trace points stored and drawn");
+    MetricHistogram &frameTimeMetric = metrics().histogram("renderer_frame_seconds", "Time between two frames",
+                                                           {0.004, 0.008, 0.0167, 0.0333, 0.05, 0.1, 0.25});
+    MetricHistogram &throttleMetric = metrics().histogram("renderer_throttle_seconds", "Time a frame waited for earlier frames on the GPU",
+                                                          {0.0005, 0.001, 0.002, 0.004, 0.008, 0.0167, 0.0333});
+    MetricHistogram &latencyMetric = metrics().histogram("renderer_input_latency_seconds", "Time from sampling the camera to the GPU finishing the frame (--latency)",
+                                                         {0.002, 0.004, 0.008, 0.0167, 0.0333, 0.05, 0.1});
+}
+
 // Constructor: set initial camera position and timing values
 Renderer::Renderer()
     : camera(glm::vec3(0.0f, 24.0f, 15.0f), glm::vec3(0.0f, 24.0f, -1.0f)),
@@ -16,6 +34,10 @@ Renderer::Renderer()
     ourShader.load(VSHADER_PATH, FSHADER_PATH);
 
     setupTraceBuffer();
+    setupCameraBuffer();
+
+    // Buffer uploads go to a second context, created with the hints of the window's
+    uploads.reset(new UploadThread(window));
 }
 
 bool Renderer::shouldClose() const {
@@ -41,6 +63,7 @@ void Renderer::drawSphere(Body &body) {
 
 void Renderer::drawSurface(Surface &surface) {
     baseSurface = &surface;
+    surfaces.push_back(&surface);
     setupSurfaceVertexBuffer(surface);
 }
 
@@ -49,6 +72,12 @@ void Renderer::RenderFrame(std::vector<Body *> bodies) {
     //tracePoins wait to be used
     std::vector<glm::vec3> allTracePoints;
 
+    // Wait for the GPU first: input sampled before a wait would be stale by the time it is drawn
+    throttleFrames();
+
+    // Attach the meshes whose buffers the upload thread has finished
+    uploads->poll();
+
     // Frame timing
 
     float currentFrame = (float) glfwGetTime();
@@ -56,21 +85,32 @@ void Renderer::RenderFrame(std::vector<Body *> bodies) {
     lastFrame = currentFrame;
 
     displayFrameRate(deltaTime);
-    processKeyboardInput(window);
-
-    // Clear frame
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    frameMetric.add();
+    frameTimeMetric.observe(deltaTime);
+    glCallStats().reset(); // count the GL binds of this frame only
+    if (latencyMode) collectLatency(deltaTime);
+
+    // Sample input now rather than after the previous swap, so the time spent between
+    // frames (physics) no longer sits between the input and the frame that shows it
+    if (!lateLatch) sampleInput();
+
+    // Everything that doesn't depend on the camera comes first: the trace points (the
+    // compute backend writes its trace buffer itself) and the light
+    if (!gpuPhysics) {
+        for (Body *body: bodies) {
+            body->tracePoints.push_back(body->Position);
+            allTracePoints.insert(allTracePoints.end(),
+                                  body->tracePoints.begin(),
+                                  body->tracePoints.end());
+        }
+        traceVBO.subData(0, allTracePoints.size() * sizeof(glm::vec3), allTracePoints.data());
+    }
 
-    // Bind shader + upload camera matrices
     ourShader.use();
-    generateCameraView();
 
-    // Provide light + view uniforms
+    // Provide light uniforms
     glm::vec3 lightPos = lightSphere ? lightSphere->Position : glm::vec3(5.0f, 5.0f, 5.0f);
     ourShader.setVec3("lightPos", lightPos);
-    ourShader.setVec3("viewPos", camera.Position);
-
 
     // set the emissive sphere color if one exists, default to 1 if not
     if (lightSphere) {
@@ -80,30 +120,47 @@ void Renderer::RenderFrame(std::vector<Body *> bodies) {
         ourShader.setVec3("lightColor", glm::vec3(1.0f));
     }
 
-    // Draw all spheres
-    for (Body *body: bodies) {
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), body->Position);
+    // Late latch: the newest input goes into this frame's camera slot right before the draws
+    if (lateLatch) sampleInput();
+    generateCameraView();
+    glBindBufferRange(GL_UNIFORM_BUFFER, 0, cameraUBO.id(), (frameIndex % CAMERA_SLOTS) * cameraSlotSize, sizeof(CameraBlock));
+    glCallStats().binds++;
+
+    // Clear frame
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        body->tracePoints.push_back(body->Position);
-        allTracePoints.insert(allTracePoints.end(),
-                              body->tracePoints.begin(),
-                              body->tracePoints.end());
+    // Draw all spheres
+    for (unsigned int i = 0; i < bodies.size(); ++i) {
+        Body *body = bodies[i];
+        if (body->sphere.mesh.indexCount == 0) continue; // first upload not in yet
 
         ourShader.setBool("source", body->sphere.mesh.source);
         ourShader.setBool("inactive", body->sphere.mesh.inactive);
         ourShader.setVec3("inColor", body->sphere.Color);
+        body->sphere.mesh.VAO.bind();
+
+        if (gpuPhysics) {
+            // position comes from the body buffer: body i is instance i of the per-instance attribute
+            ourShader.setBool("gpuBodies", true);
+            ourShader.setMat4("model", glm::mat4(1.0f));
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, body->sphere.mesh.indexCount, GL_UNSIGNED_INT, 0, 1, i);
+            continue;
+        }
+
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), body->Position);
         ourShader.setMat4("model", model);
-        glBindVertexArray(body->sphere.mesh.VAO);
         glDrawElements(GL_TRIANGLES, body->sphere.mesh.indexCount, GL_UNSIGNED_INT, 0);
     }
+    ourShader.setBool("gpuBodies", false);
 
-    if (baseSurface) {
+    if (baseSurface && baseSurface->mesh.indexCount > 0) {
         Surface *s = baseSurface;
         ourShader.setVec3("inColor", s->color);
         ourShader.setBool("source", false);
         ourShader.setBool("inactive", s->mesh.inactive);
         ourShader.setMat4("model", glm::mat4(1.0f));
-        glBindVertexArray(s->mesh.VAO);
+        s->mesh.VAO.bind();
         if (s->mesh.isWireframe) {
             // draw as lines (each index pair is a segment)
             glDrawElements(GL_LINES, s->mesh.indexCount, GL_UNSIGNED_INT, 0);
@@ -112,9 +169,6 @@ void Renderer::RenderFrame(std::vector<Body *> bodies) {
         }
     }
 
-    // 上传到 GPU
-    glBindBuffer(GL_ARRAY_BUFFER, traceVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, allTracePoints.size() * sizeof(glm::vec3), allTracePoints.data());
     // ---------- 绘制轨迹点 ----------
 
     glEnable(GL_PROGRAM_POINT_SIZE);
@@ -128,12 +182,26 @@ void Renderer::RenderFrame(std::vector<Body *> bodies) {
     ourShader.setVec3("inColor", glm::vec3(1.0f, 1.0f, 0.2f));
 
     glPointSize(3.0f); // 可调大小
-    glBindVertexArray(traceVAO);
-    glDrawArrays(GL_POINTS, 0, allTracePoints.size());
+    if (gpuPhysics) {
+        gpuTraceVAO.bind();
+        glDrawArrays(GL_POINTS, 0, gpuPhysics->getTraceCount());
+        tracePointMetric.set(gpuPhysics->getTraceCount());
+    } else {
+        traceVAO.bind();
+        glDrawArrays(GL_POINTS, 0, allTracePoints.size());
+        tracePointMetric.set(static_cast<double>(allTracePoints.size()));
+    }
+    // one per body, the surface and the trace points
+    drawCallMetric.add(bodies.size() + (baseSurface ? 1 : 0) + 1);
 
     glBindVertexArray(0);
+
+    // Fence the frame for throttleFrames() (and the reuse of its camera slot)
+    if (latencyMode) glQueryCounter(latencyQueries[frameIndex % CAMERA_SLOTS], GL_TIMESTAMP);
+    frameFences[frameIndex % CAMERA_SLOTS] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frameIndex++;
+
     glfwSwapBuffers(window);
-    glfwPollEvents();
 }
 
 GLFWwindow *Renderer::getWindow() {
@@ -175,86 +243,87 @@ void Renderer::loadGLAD() {
     }
 }
 
-// Upload projection + view matrices
+// Write projection + view matrices into this frame's camera slot
 void Renderer::generateCameraView() {
-    glm::mat4 projection = glm::perspective(glm::radians(FOV),
-                                            (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
-    ourShader.setMat4("projection", projection);
-
-    glm::mat4 view = camera.getViewMatrix();
-    ourShader.setMat4("view", view);
+    CameraBlock block;
+    block.projection = glm::perspective(glm::radians(FOV),
+                                        (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
+    block.view = camera.getViewMatrix();
+    block.viewPos = glm::vec4(camera.Position, 1.0f);
+
+    const unsigned int slot = frameIndex % CAMERA_SLOTS;
+    const GLintptr offset = slot * cameraSlotSize;
+    if (cameraMapped) {
+        std::memcpy(cameraMapped + offset, &block, sizeof(block));
+    } else {
+        cameraUBO.subData(offset, sizeof(block), &block);
+    }
+    if (latencyMode) glGetInteger64v(GL_TIMESTAMP, &inputSampleTime[slot]);
 }
 
 // Create / update sphere mesh buffers (only when first created or remake flag true)
 void Renderer::setupSphereVertexBuffer(Sphere &sphere) {
-    if (sphere.mesh.VAO != 0 && !sphere.mesh.remake) return; // already uploaded and valid
-
-    if (sphere.mesh.VAO == 0) {
-        glGenBuffers(1, &sphere.mesh.VBO);
-        glGenVertexArrays(1, &sphere.mesh.VAO);
-        glGenBuffers(1, &sphere.mesh.EBO);
+    if (sphere.mesh.VAO.id() != 0 && !sphere.mesh.remake) return; // already uploaded and valid
+
+    // The VAO is kept across remakes (it may carry the per-instance body attribute set up by
+    // attachGpuPhysics); the buffers are re-created on the upload thread
+    if (sphere.mesh.VAO.id() == 0) {
+        sphere.mesh.VAO.create();
+        // Vertex positions only (3 floats) – normals derived in shader from position
+        sphere.mesh.VAO.attribute(0, 0, 3, GL_FLOAT, 0);
     }
 
-    glBindVertexArray(sphere.mesh.VAO);
-
-    // Vertex positions only (3 floats) – normals derived in shader from position
-    glBindBuffer(GL_ARRAY_BUFFER, sphere.mesh.VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sphere.geometry.getVertexDataSize(),
-                 sphere.geometry.getVertexData(),
-                 GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere.mesh.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 sphere.geometry.getIndexDataSize(),
-                 sphere.geometry.getIndexData(),
-                 GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(0);
-
-    glBindVertexArray(0);
-
-    sphere.mesh.indexCount = sphere.geometry.getIndexCount();
-    sphere.mesh.remake = false; // mesh up-to-date
+    const float *vertices = sphere.geometry.getVertexData();
+    const unsigned int *indices = sphere.geometry.getIndexData();
+    uploadMesh(sphere.mesh,
+               std::vector<float>(vertices, vertices + sphere.geometry.getVertexDataSize() / sizeof(float)),
+               std::vector<unsigned int>(indices, indices + sphere.geometry.getIndexCount()));
+    sphere.mesh.remake = false; // mesh up-to-date once the upload completes
 }
 
 void Renderer::setupSurfaceVertexBuffer(Surface &surface) {
-    if (surface.mesh.VAO != 0 && !surface.mesh.remake) return;
-
-    if (surface.mesh.VAO == 0) {
-        glGenBuffers(1, &surface.mesh.VBO);
-        glGenVertexArrays(1, &surface.mesh.VAO);
-        glGenBuffers(1, &surface.mesh.EBO);
-    }
+    if (surface.mesh.VAO.id() != 0 && !surface.mesh.remake) return;
 
     // propagate wireframe flag from CPU geometry to GPU mesh metadata
     surface.mesh.isWireframe = surface.geometry.isWireframe();
 
-    glBindVertexArray(surface.mesh.VAO);
-
-    // Vertex positions only (3 floats) – normals derived in shader from position
-    glBindBuffer(GL_ARRAY_BUFFER, surface.mesh.VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-                 surface.geometry.getVertexSize(),
-                 surface.geometry.getVertices(),
-                 GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, surface.mesh.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 surface.geometry.getIndexSize(),
-                 surface.geometry.getIndices(),
-                 GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(0);
-
-    glBindVertexArray(0);
+    if (surface.mesh.VAO.id() == 0) {
+        surface.mesh.VAO.create();
+        // Vertex positions only (3 floats) – normals derived in shader from position
+        surface.mesh.VAO.attribute(0, 0, 3, GL_FLOAT, 0);
+    }
 
-    surface.mesh.indexCount = surface.geometry.getIndexCount();
+    const float *vertices = surface.geometry.getVertices();
+    const unsigned int *indices = surface.geometry.getIndices();
+    uploadMesh(surface.mesh,
+               std::vector<float>(vertices, vertices + surface.geometry.getVertexSize() / sizeof(float)),
+               std::vector<unsigned int>(indices, indices + surface.geometry.getIndexCount()));
     surface.mesh.remake = false;
 }
 
+// Buffers are filled on the upload thread, the VAO (not shared between contexts) is re-pointed here
+void Renderer::uploadMesh(Mesh &mesh, std::vector<float> vertices, std::vector<unsigned int> indices) {
+    struct Upload {
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        GLBuffer VBO, EBO;
+    };
+    std::shared_ptr<Upload> upload = std::make_shared<Upload>();
+    upload->vertices = std::move(vertices);
+    upload->indices = std::move(indices);
+
+    uploads->submit([upload]() {
+        upload->VBO.storage(upload->vertices.size() * sizeof(float), upload->vertices.data());
+        upload->EBO.storage(upload->indices.size() * sizeof(unsigned int), upload->indices.data());
+    }, [upload, &mesh]() {
+        mesh.VBO = std::move(upload->VBO);
+        mesh.EBO = std::move(upload->EBO);
+        mesh.VAO.vertexBuffer(0, mesh.VBO, 0, 3 * sizeof(float));
+        mesh.VAO.elementBuffer(mesh.EBO);
+        mesh.indexCount = static_cast<int>(upload->indices.size());
+    });
+}
+
 // Update window title with FPS (throttled)
 void Renderer::displayFrameRate(float deltaTime) const {
     static bool first = true;
@@ -275,7 +344,7 @@ void Renderer::displayFrameRate(float deltaTime) const {
         unsigned int frameRate = deltaTime > 0.0f ? (unsigned int) (1.0f / deltaTime) : 0;
         oss.clear();
         oss.str("");
-        oss << APP_NAME << " | FPS : " << frameRate;
+        oss << APP_NAME << " | FPS : " << frameRate << " | binds : " << glCallStats().binds;
         title = oss.str();
         glfwSetWindowTitle(window, title.c_str());
         timeSinceLastDisplay = 0.0f;
@@ -332,21 +401,134 @@ void Renderer::processKeyboardInput(GLFWwindow *window) {
 
 // Cleanup GL resources and terminate GLFW
 void Renderer::cleanup() {
+    // Uploads still in flight complete into the meshes, before those are released
+    uploads->finish();
+    uploads.reset();
+
+    // Meshes are owned by the bodies / surfaces, which outlive the context
+    for (Sphere *sphere: spheres) sphere->mesh.release();
+    for (Surface *surface: surfaces) surface->mesh.release();
+    traceVAO = GLVertexArray();
+    traceVBO = GLBuffer();
+    gpuTraceVAO = GLVertexArray();
+
+    for (GLsync &fence: frameFences) {
+        if (fence) glDeleteSync(fence);
+        fence = 0;
+    }
+    glDeleteQueries(CAMERA_SLOTS, latencyQueries);
+    cameraUBO = GLBuffer(); // deleting the buffer unmaps it
+    cameraMapped = nullptr;
+
     ourShader.terminate();
     glfwTerminate();
 }
 
 // trace Buffer setup
 void Renderer::setupTraceBuffer() {
-    glGenVertexArrays(1, &traceVAO);
-    glGenBuffers(1, &traceVBO);
+    // 预分配空间, rewritten every frame
+    traceVBO.storage(20000000 * sizeof(glm::vec3), nullptr, GL_DYNAMIC_STORAGE_BIT);
 
-    glBindVertexArray(traceVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, traceVBO);
-    glBufferData(GL_ARRAY_BUFFER, 20000000 * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW); // 预分配空间
+    traceVAO.create();
+    traceVAO.attribute(0, 0, 3, GL_FLOAT, 0);
+    traceVAO.vertexBuffer(0, traceVBO, 0, sizeof(glm::vec3));
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(0);
+// Point sphere VAOs and a trace VAO at the compute backend's storage buffers
+void Renderer::attachGpuPhysics(GpuPhysics &gpu) {
+    gpuPhysics = &gpu;
 
-    glBindVertexArray(0);
+    for (Sphere *sphere: spheres) {
+        // binding 1: one body position per instance
+        sphere->mesh.VAO.attribute(1, 1, 4, GL_FLOAT, offsetof(GpuBody, position));
+        sphere->mesh.VAO.vertexBuffer(1, gpu.getBodyBuffer(), 0, sizeof(GpuBody));
+        sphere->mesh.VAO.bindingDivisor(1, 1);
+    }
+
+    if (gpuTraceVAO.id() == 0) {
+        gpuTraceVAO.create();
+        gpuTraceVAO.attribute(0, 0, 3, GL_FLOAT, 0);
+    }
+    gpuTraceVAO.vertexBuffer(0, gpu.getTraceBuffer(), 0, sizeof(glm::vec4));
+}
+
+void Renderer::setMaxFramesInFlight(unsigned int frames) {
+    maxFramesInFlight = std::min(frames, CAMERA_SLOTS - 1);
+}
+
+void Renderer::setLateLatch(bool enabled) {
+    lateLatch = enabled;
+}
+
+void Renderer::setLatencyMode(bool enabled) {
+    latencyMode = enabled;
+}
+
+// Camera slots: persistently mapped, written in place once the GPU is done with a slot
+void Renderer::setupCameraBuffer() {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    cameraSlotSize = (sizeof(CameraBlock) + alignment - 1) / alignment * alignment;
+
+    if (GLAD_GL_VERSION_4_4) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        cameraUBO.storage(CAMERA_SLOTS * cameraSlotSize, nullptr, flags);
+        cameraMapped = static_cast<char *>(cameraUBO.mapRange(0, CAMERA_SLOTS * cameraSlotSize, flags));
+    } else {
+        cameraUBO.storage(CAMERA_SLOTS * cameraSlotSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    glGenQueries(CAMERA_SLOTS, latencyQueries);
+}
+
+// Wait for the frame maxFramesInFlight back and for the last frame that used this frame's slot
+void Renderer::throttleFrames() {
+    auto waitFor = [](GLsync &fence) {
+        if (!fence) return;
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    if (maxFramesInFlight > 0 && frameIndex >= maxFramesInFlight) {
+        waitFor(frameFences[(frameIndex - maxFramesInFlight) % CAMERA_SLOTS]);
+    }
+    waitFor(frameFences[frameIndex % CAMERA_SLOTS]);
+    std::chrono::duration<double> waited = std::chrono::steady_clock::now() - start;
+    throttleMetric.observe(waited.count());
+}
+
+// Poll events (mouse look) and apply the keyboard to the camera
+void Renderer::sampleInput() {
+    glfwPollEvents();
+    processKeyboardInput(window);
+}
+
+// Read back the timestamp queries of finished frames; print the average once per second
+void Renderer::collectLatency(float deltaTime) {
+    for (unsigned int slot = 0; slot < CAMERA_SLOTS; ++slot) {
+        if (inputSampleTime[slot] == 0 || slot == frameIndex % CAMERA_SLOTS) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(latencyQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        GLint64 finished = 0;
+        glGetQueryObjecti64v(latencyQueries[slot], GL_QUERY_RESULT, &finished);
+        double latency = (finished - inputSampleTime[slot]) * 1e-9;
+        inputSampleTime[slot] = 0;
+        latencyMetric.observe(latency);
+        latencySum += latency;
+        latencyCount++;
+    }
+
+    timeSinceLatencyPrint += deltaTime;
+    if (timeSinceLatencyPrint > 1.0f && latencyCount > 0) {
+        std::cout << "latency | input -> GPU done: " << 1000.0 * latencySum / latencyCount << " ms"
+                  << " | frames in flight: " << maxFramesInFlight
+                  << " | late latch: " << (lateLatch ? "on" : "off") << std::endl;
+        latencySum = 0.0;
+        latencyCount = 0;
+        timeSinceLatencyPrint = 0.0f;
+    }
 }
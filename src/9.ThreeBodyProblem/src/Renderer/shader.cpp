@@ -66,6 +66,42 @@ void Shader::load(const char* vertexPath, const char* fragmentPath) {
     glDeleteShader(fragment);
 }
 
+// Loads, compiles, and links a compute shader into a program
+void Shader::loadCompute(const char* computePath) {
+    std::string computeCode;
+    std::ifstream cShaderFile;
+
+    // Enable exception flags on the file stream
+    cShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+
+    try {
+        // Read the whole shader source file
+        cShaderFile.open(computePath);
+        std::stringstream computeStream;
+        computeStream << cShaderFile.rdbuf();
+        cShaderFile.close();
+        computeCode = computeStream.str();
+    } catch (std::ifstream::failure &e) {
+        std::cout << "ERROR::SHADER_FILE::NOT_SUCCESSFULLY_READ" << std::endl;
+    }
+
+    const char* cCode = computeCode.c_str();
+
+    // Create and compile compute shader
+    unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &cCode, NULL);
+    glCompileShader(compute);
+    checkCompileErrors(compute, "COMPUTE");
+
+    // Create and link program
+    ID = glCreateProgram();
+    glAttachShader(ID, compute);
+    glLinkProgram(ID);
+    checkCompileErrors(ID, "PROGRAM");
+
+    glDeleteShader(compute);
+}
+
 // Activates the shader program
 void Shader::use() {
     glUseProgram(ID);
@@ -86,11 +122,21 @@ void Shader::setInt(std::string &name, int value) const {
     glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+// Sets an integer uniform
+void Shader::setInt(const char* name, int value) const {
+    glUniform1i(glGetUniformLocation(ID, name), value);
+}
+
 // Sets a float uniform
 void Shader::setFloat(std::string &name, float value) const {
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+// Sets a float uniform
+void Shader::setFloat(const char* name, float value) const {
+    glUniform1f(glGetUniformLocation(ID, name), value);
+}
+
 // Sets a vec3 uniform
 void Shader::setVec3(const char* name, const glm::vec3& vec3) const {
     glUniform3fv(glGetUniformLocation(ID, name), 1, &vec3[0]);
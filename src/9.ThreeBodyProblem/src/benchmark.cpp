@@ -0,0 +1,279 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glm/gtc/constants.hpp>
+
+#include "Renderer/renderer.h"
+#include "Physics/physics.h"
+#include "Physics/gpu_physics.h"
+#include "Physics/out_of_core.h"
+#include "Physics/distributed.h"
+
+void Benchmark::backends(unsigned int bodyCount, unsigned int steps) {
+    std::vector<Body> cluster(bodyCount);
+    std::vector<Body *> clusterBodies;
+    std::mt19937 rng(1234);
+    float extent = 4.0f * std::cbrt(static_cast<float>(bodyCount));
+    std::uniform_real_distribution<float> coord(-extent, extent);
+    for (Body &body: cluster) {
+        body.setRadius(0.25f);
+        body.Mass = 30e11f;
+        body.Position = glm::vec3(coord(rng), coord(rng) + extent, coord(rng));
+        clusterBodies.push_back(&body);
+    }
+
+    double pairs = 0.5 * bodyCount * (bodyCount - 1.0) * steps;
+    auto report = [&](const char *name, double seconds) {
+        std::cout << name << " | bodies: " << bodyCount
+                  << " | " << 1000.0 * seconds / steps << " ms/step"
+                  << " | " << pairs / seconds / 1e6 << " M pairs/s" << std::endl;
+    };
+
+    // GPU first, it only copies the initial state
+    Renderer renderer;
+    GpuPhysics gpu;
+    gpu.init(clusterBodies);
+    gpu.processFrame(); // warm up (shader compilation, buffer residency)
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < steps; ++i)
+        gpu.processFrame();
+    glFinish();
+    std::chrono::duration<double> gpuTime = std::chrono::steady_clock::now() - start;
+    gpu.cleanup();
+    renderer.cleanup();
+
+    Physics physics;
+    start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < steps; ++i)
+        physics.processFrame(clusterBodies);
+    std::chrono::duration<double> cpuTime = std::chrono::steady_clock::now() - start;
+
+    report("CPU (Physics)   ", cpuTime.count());
+    report("GPU (GpuPhysics)", gpuTime.count());
+}
+
+void Benchmark::contacts(unsigned int bodyCount, unsigned int steps) {
+    unsigned int side = static_cast<unsigned int>(std::ceil(std::cbrt(static_cast<float>(bodyCount))));
+    std::vector<Body> cluster(bodyCount);
+    std::vector<Body *> clusterBodies;
+    for (Body &body: cluster) {
+        body.setRadius(0.25f);
+        body.Mass = 1.0f;
+        clusterBodies.push_back(&body);
+    }
+    auto reset = [&]() {
+        for (unsigned int i = 0; i < bodyCount; ++i) {
+            // 0.45 apart, slightly closer than two radii
+            glm::vec3 cell(i % side, (i / side) % side, i / (side * side));
+            cluster[i].Position = cell * 0.45f + glm::vec3(0.0f, 10.0f, 0.0f);
+            cluster[i].Velocity = glm::vec3(0.1f, 0.0f, 0.0f) * static_cast<float>(i % 3);
+        }
+    };
+
+    unsigned int maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+    double baseline = 0.0;
+    for (unsigned int workers = 1; ; workers = std::min(workers * 2, maxWorkers)) {
+        reset();
+        Physics physics;
+        physics.setContactSolver(workers, CONTACT_ITERATIONS);
+        double contactTime = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < steps; ++i) {
+            physics.processFrame(clusterBodies);
+            contactTime += physics.getContactStats().seconds;
+        }
+        std::chrono::duration<double> stepTime = std::chrono::steady_clock::now() - start;
+        if (workers == 1) baseline = contactTime;
+
+        const ContactStats &stats = physics.getContactStats();
+        std::cout << "workers: " << workers
+                  << " | contacts: " << stats.contacts << " in " << stats.batches << " batches"
+                  << " | contacts " << 1000.0 * contactTime / steps << " ms/step"
+                  << " (x" << baseline / contactTime << ")"
+                  << " | total " << 1000.0 * stepTime.count() / steps << " ms/step" << std::endl;
+
+        if (workers == maxWorkers) break;
+    }
+}
+
+void Benchmark::integrators(double eccentricity) {
+    const double a = 60.0;
+    const double e = std::min(std::max(eccentricity, 0.0), 0.999);
+    const float mass = 30e11f;
+    const double mu = GRAV_CONST * 2.0 * mass;
+    const double period = 2.0 * glm::pi<double>() * std::sqrt(a * a * a / mu);
+    const double tolerance = 1e-3 * a;
+
+    // separation vector (two - one) on the analytic orbit at time t after apocenter
+    auto kepler = [&](double t) {
+        double meanAnomaly = glm::pi<double>() + 2.0 * glm::pi<double>() * t / period;
+        double E = meanAnomaly;
+        for (int i = 0; i < 50; ++i) {
+            double correction = (E - e * std::sin(E) - meanAnomaly) / (1.0 - e * std::cos(E));
+            E -= correction;
+            if (std::abs(correction) < 1e-12) break;
+        }
+        return glm::dvec3(a * (std::cos(E) - e), 0.0, a * std::sqrt(1.0 - e * e) * std::sin(E));
+    };
+
+    std::cout << "binary a = " << a << ", e = " << e << ", pericenter " << a * (1.0 - e)
+              << ", period " << period << " s, tolerance " << tolerance << std::endl;
+
+    const Integrator schemes[] = {Integrator::Euler, Integrator::Verlet, Integrator::Regularized};
+    const char *names[] = {"Euler      ", "Verlet     ", "Regularized"};
+    for (int s = 0; s < 3; ++s) {
+        bool solved = false;
+        for (unsigned int steps = 64; steps <= (1u << 22) && !solved; steps *= 2) {
+            Body one, two;
+            for (Body *body: {&one, &two}) {
+                body->setRadius(0.1f);
+                body->Mass = mass;
+            }
+            // relative orbit in the x/z plane above the ground, centre of mass at rest
+            // (close to the origin, positions are single precision)
+            glm::vec3 centre(0.0f, 10.0f, 0.0f);
+            glm::vec3 separation(static_cast<float>(-a * (1.0 + e)), 0.0f, 0.0f);
+            glm::vec3 velocity(0.0f, 0.0f, static_cast<float>(-std::sqrt(mu * (1.0 - e) / (a * (1.0 + e)))));
+            one.Position = centre - 0.5f * separation;
+            two.Position = centre + 0.5f * separation;
+            one.Velocity = -0.5f * velocity;
+            two.Velocity = 0.5f * velocity;
+            std::vector<Body *> pair = {&one, &two};
+
+            // Euler and Verlet take `steps` steps per period, the regularized scheme
+            // 64 frames with enough substeps for the same nominal step count
+            unsigned int frames = schemes[s] == Integrator::Regularized ? 64 : steps;
+            Physics physics(static_cast<float>(period / frames), 3.0f);
+            physics.setIntegrator(schemes[s], schemes[s] == Integrator::Regularized ? steps / 64 : 1);
+
+            double error = 0.0;
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned int i = 0; i < frames; ++i) {
+                physics.processFrame(pair);
+                if ((i + 1) % (frames / 64) == 0) {
+                    glm::dvec3 expected = kepler(physics.getSimulationTime());
+                    error = std::max(error, glm::length(glm::dvec3(two.Position - one.Position) - expected));
+                }
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            if (error < tolerance) {
+                std::cout << names[s] << " | " << physics.getForceEvaluations() << " force evaluations"
+                          << " | " << 1000.0 * elapsed.count() << " ms | max error " << error << std::endl;
+                solved = true;
+            }
+        }
+        if (!solved)
+            std::cout << names[s] << " | not within tolerance after " << (1u << 22) << " steps" << std::endl;
+    }
+}
+
+void Benchmark::outOfCore(unsigned int bodyCount, unsigned int steps, const std::string &directory) {
+    const unsigned int traceSteps = 16;
+    std::vector<Body> cluster(bodyCount);
+    std::vector<Body *> clusterBodies;
+    auto reset = [&]() {
+        std::mt19937 rng(1234);
+        float extent = 4.0f * std::cbrt(static_cast<float>(bodyCount));
+        std::uniform_real_distribution<float> coord(-extent, extent);
+        for (Body &body: cluster) {
+            body.setRadius(0.01f);
+            body.Mass = 30e11f;
+            body.Position = glm::vec3(coord(rng), coord(rng) + extent, coord(rng));
+            body.Velocity = glm::vec3(0.0f);
+        }
+    };
+    for (Body &body: cluster) clusterBodies.push_back(&body);
+
+    // reference: the in-memory CPU backend
+    reset();
+    Physics physics;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < steps; ++i)
+        physics.processFrame(clusterBodies);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::vector<glm::vec3> reference;
+    for (const Body &body: cluster) reference.push_back(body.Position);
+    std::cout << "Physics    | bodies: " << bodyCount << " | " << 1000.0 * elapsed.count() / steps << " ms/step" << std::endl;
+
+    const char *names[] = {"memory    ", "file, warm", "file, cold"};
+    for (int run = 0; run < 3; ++run) {
+        reset();
+        OutOfCorePhysics outOfCore;
+        size_t stateSize = (bodyCount + OutOfCorePhysics::TILE_SIZE - 1) / OutOfCorePhysics::TILE_SIZE * OutOfCorePhysics::TILE_BYTES;
+        if (!outOfCore.start(run == 0 ? "" : directory, clusterBodies, traceSteps, stateSize / 4))
+            return;
+        outOfCore.setColdCache(run == 2);
+
+        start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < steps; ++i)
+            outOfCore.processFrame();
+        elapsed = std::chrono::steady_clock::now() - start;
+
+        float difference = 0.0f;
+        for (unsigned int i = 0; i < bodyCount; ++i)
+            difference = std::max(difference, glm::length(outOfCore.getPosition(i) - reference[i]));
+
+        std::cout << names[run] << " | bodies: " << bodyCount
+                  << " | " << 1000.0 * elapsed.count() / steps << " ms/step"
+                  << " | state " << outOfCore.getStateSize() / 1024 << " KB, trace "
+                  << outOfCore.getTraceSize() / 1024 << " KB"
+                  << " | max difference " << difference << std::endl;
+    }
+}
+
+void Benchmark::distributed(unsigned int bodyCount, unsigned int steps, unsigned int maxWorkers) {
+    std::vector<Body> cluster(bodyCount);
+    std::vector<Body *> clusterBodies;
+    auto reset = [&]() {
+        std::mt19937 rng(1234);
+        float extent = 4.0f * std::cbrt(static_cast<float>(bodyCount));
+        std::uniform_real_distribution<float> coord(-extent, extent);
+        for (Body &body: cluster) {
+            body.setRadius(0.01f);
+            body.Mass = 30e11f;
+            body.Position = glm::vec3(coord(rng), coord(rng) + extent, coord(rng));
+            body.Velocity = glm::vec3(0.0f);
+        }
+    };
+    for (Body &body: cluster) clusterBodies.push_back(&body);
+
+    // single process reference; the radius is small enough that Physics resolves no contacts
+    reset();
+    Physics physics;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < steps; ++i)
+        physics.processFrame(clusterBodies);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::vector<glm::vec3> reference;
+    for (const Body &body: cluster) reference.push_back(body.Position);
+    std::cout << "Physics      | bodies: " << bodyCount << " | " << 1000.0 * elapsed.count() / steps << " ms/step" << std::endl;
+
+    for (unsigned int workers = 1; workers <= std::max(1u, maxWorkers); workers *= 2) {
+        reset();
+        DistributedPhysics distributed;
+        if (!distributed.start(clusterBodies, workers))
+            break;
+        start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < steps; ++i)
+            distributed.processFrame(clusterBodies);
+        elapsed = std::chrono::steady_clock::now() - start;
+
+        float difference = 0.0f;
+        for (unsigned int i = 0; i < bodyCount; ++i)
+            difference = std::max(difference, glm::length(cluster[i].Position - reference[i]));
+        const DistributedStats &stats = distributed.getStats();
+        std::cout << "workers: " << workers
+                  << " | " << 1000.0 * elapsed.count() / steps << " ms/step"
+                  << " | ghosts " << stats.ghosts << ", cells " << stats.cells
+                  << " | imbalance " << stats.imbalance << ", " << stats.rebalances << " repartitions"
+                  << " | max difference " << difference << std::endl;
+    }
+}
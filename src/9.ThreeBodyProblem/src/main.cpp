@@ -1,7 +1,79 @@
+#include <cstring>
+#include <cstdlib>
+
 #include "application.h"
+#include "benchmark.h"
+
+// Usage: ThreeBodyProblem [--gpu | --cpu] [--benchmark <bodies> [steps]] [--benchmark-contacts <bodies> [steps]]
+//                        [--integrator euler | verlet | regularized] [--benchmark-integrators [eccentricity]]
+//                        [--out-of-core <directory>] [--benchmark-out-of-core <bodies> [steps] [directory]]
+//                        [--processes <workers>] [--benchmark-distributed <bodies> [steps] [workers]]
+//                        [--metrics <file.prom | file.jsonl>]
+//                        [--frames-in-flight <n>] [--no-late-latch] [--latency]
+int main(int argc, char *argv[]) {
+    // worker processes of --processes and --benchmark-distributed start here, before App opens a window
+    if (argc > 1 && std::strcmp(argv[1], DistributedPhysics::WORKER_FLAG) == 0)
+        return DistributedPhysics::runWorker(argc, argv);
+
+    // benchmarks build their own scenes and don't need the app
+    Benchmark benchmark;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--benchmark") == 0) {
+            unsigned int bodyCount = i + 1 < argc ? std::atoi(argv[i + 1]) : 1024;
+            unsigned int steps = i + 2 < argc ? std::atoi(argv[i + 2]) : 20;
+            benchmark.backends(bodyCount, steps);
+            return 0;
+        } else if (std::strcmp(argv[i], "--benchmark-integrators") == 0) {
+            benchmark.integrators(i + 1 < argc ? std::atof(argv[i + 1]) : 0.98);
+            return 0;
+        } else if (std::strcmp(argv[i], "--benchmark-contacts") == 0) {
+            unsigned int bodyCount = i + 1 < argc ? std::atoi(argv[i + 1]) : 8000;
+            unsigned int steps = i + 2 < argc ? std::atoi(argv[i + 2]) : 20;
+            benchmark.contacts(bodyCount, steps);
+            return 0;
+        } else if (std::strcmp(argv[i], "--benchmark-distributed") == 0) {
+            unsigned int bodyCount = i + 1 < argc ? std::atoi(argv[i + 1]) : 4096;
+            unsigned int steps = i + 2 < argc ? std::atoi(argv[i + 2]) : 20;
+            unsigned int workers = i + 3 < argc ? std::atoi(argv[i + 3]) : 4;
+            benchmark.distributed(bodyCount, steps, workers);
+            return 0;
+        } else if (std::strcmp(argv[i], "--benchmark-out-of-core") == 0) {
+            unsigned int bodyCount = i + 1 < argc ? std::atoi(argv[i + 1]) : 16384;
+            unsigned int steps = i + 2 < argc ? std::atoi(argv[i + 2]) : 3;
+            benchmark.outOfCore(bodyCount, steps, i + 3 < argc ? argv[i + 3] : ".");
+            return 0;
+        }
+    }
 
-int main() {
     App app;
 
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--gpu") == 0) {
+            app.setGpuPhysics(true);
+        } else if (std::strcmp(argv[i], "--cpu") == 0) {
+            app.setGpuPhysics(false);
+        } else if (std::strcmp(argv[i], "--integrator") == 0 && i + 1 < argc) {
+            const char *scheme = argv[++i];
+            if (std::strcmp(scheme, "verlet") == 0)
+                app.setIntegrator(Integrator::Verlet);
+            else if (std::strcmp(scheme, "regularized") == 0)
+                app.setIntegrator(Integrator::Regularized);
+            else
+                app.setIntegrator(Integrator::Euler);
+        } else if (std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            app.setMetricsFile(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+            app.setMaxFramesInFlight(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-late-latch") == 0) {
+            app.setLateLatch(false);
+        } else if (std::strcmp(argv[i], "--latency") == 0) {
+            app.setLatencyMode(true);
+        } else if (std::strcmp(argv[i], "--processes") == 0 && i + 1 < argc) {
+            app.setProcesses(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--out-of-core") == 0 && i + 1 < argc) {
+            app.setOutOfCore(argv[++i]);
+        }
+    }
+
     app.run();
-}
\ No newline at end of file
+}